@@ -15,33 +15,113 @@ enum class ACMode {
   DEHUMID_MINUS_1_5  // 除湿-1.5
 };
 
+// コマンドの優先度（同時に送信を待っている場合は、優先度の高いコマンドだけを送信）
+enum class ACPriority : uint8_t {
+  POLICY,    // 制御方策（DIによる自動判定）
+  SCHEDULE,  // スケジュール
+  USER,      // 利用者の操作（Web API・MQTT）
+  STOP       // 停止（OFFはどこからの要求でもこの優先度）
+};
+
+// 赤外線送受信の計測値
+struct ACStats {
+  uint32_t irSendCount;     // 赤外線送信回数
+  uint32_t irReceiveCount;  // 赤外線受信回数
+};
+
+// コマンドの送信待ちの計測値
+struct ACQueueStats {
+  uint32_t requested;       // 受け付けたコマンド数（現在のモードと同じものを除く）
+  uint32_t coalesced;       // 送信前に新しいコマンド・優先度の高いコマンドで置き換えられた数
+  uint32_t sent;            // 送信したコマンド数
+  uint8_t depth;            // 送信待ちのコマンド数（優先度ごとに最大1件）
+  uint8_t maxDepth;         // 送信待ちのコマンド数の最大
+  uint32_t lastLatencyMs;   // 最後に送信したコマンドの受け付けから送信完了までの時間
+  uint32_t maxLatencyMs;    // 同（最大）
+  uint64_t totalLatencyMs;  // 同（合計、平均の計算用）
+};
+
 // エアコン制御クラス
 class AirConditionerController {
 public:
+  // 赤外線の受信通知関数（context は onIRReceive() で指定したポインタ）
+  typedef void (*IRReceiveCallback)(const decode_results& results, void* context);
+
   AirConditionerController(uint8_t sendPin, uint8_t recvPin);
 
   // 初期化
   void begin();
 
-  // 指定されたモードでエアコンを制御
-  void setMode(ACMode mode);
+  // モードの変更を要求（送信は update() で行う）
+  // 送信待ちの同じ優先度のコマンドは置き換え、送信時には優先度の高いコマンドだけを送信します。
+  // 現在のモードと同じ要求は送信しませんが、それより低い優先度の送信待ちは取り消します。
+  void request(ACMode mode, ACPriority priority);
+
+  // 送信待ちのコマンドを送信（loop()から呼び出す。前回の送信から MIN_FRAME_SPACING_MS 空ける）
+  void update();
 
-  // 現在のモードを取得
+  // 現在のモード（最後に送信したモード）を取得
   ACMode getCurrentMode() const { return currentMode_; }
 
+  // 送信待ちのコマンドがすべて送信された後のモード（送信待ちがなければ現在のモード）
+  ACMode getTargetMode() const;
+
+  // 再起動前に送信したモードを復元（送信はしない。StateStore から復元する時に使用）
+  void restoreMode(ACMode mode);
+
   // 温度と湿度に基づいて最適なモードを決定
-  ACMode determineOptimalMode(float temperature, float humidity);
+  ACMode determineOptimalMode(int16_t temperature, int16_t humidity);
 
   // 不快指数（DI）を計算
-  float calculateDiscomfortIndex(float temperature, float humidity);
+  int16_t calculateDiscomfortIndex(int16_t temperature, int16_t humidity);
 
   // 赤外線信号の受信処理
   void handleIRReceive();
 
+  // 赤外線の受信時の通知先を設定（トレース記録などに使用）
+  void onIRReceive(IRReceiveCallback callback, void* context = nullptr);
+
+  // 計測値を取得
+  const ACStats& getStats() const { return stats_; }
+  const ACQueueStats& getQueueStats() const { return queueStats_; }
+
+  // 赤外線の送信の最短間隔（エアコンが前の信号を処理し終える前に次の信号を送らない）
+  static constexpr unsigned long MIN_FRAME_SPACING_MS = 1000;
+
+  // 優先度の数・名前（"policy", "schedule", "user", "stop"。メトリクスで使用）
+  static constexpr uint8_t PRIORITY_COUNT = 4;
+  static const char* priorityToKey(ACPriority priority);
+
+  // モードの識別名（"off", "cool_20" など。MQTT・メトリクスで使用）
+  static const char* modeToKey(ACMode mode);
+
+  // 識別名からモードを取得（不明な名前の場合はACMode::NONE）
+  static ACMode modeFromKey(const char* key);
+
+  // 運転中のモードか（NONE・OFF以外）
+  static bool isRunning(ACMode mode) { return mode != ACMode::NONE && mode != ACMode::OFF; }
+
 private:
   IRDaikinESP daikinAC_;
   IRrecv irRecv_;
   ACMode currentMode_;
+  ACStats stats_;
+  IRReceiveCallback receiveCallback_;
+  void* receiveContext_;
+
+  // 送信待ちのコマンド（優先度ごとに最新の1件）
+  struct PendingCommand {
+    ACMode mode;
+    unsigned long requestedMs;
+    bool pending;
+  };
+  PendingCommand pending_[PRIORITY_COUNT];
+  unsigned long lastSendMs_;
+  bool hasSent_;
+  ACQueueStats queueStats_;
+
+  void updateDepth();
+  bool transmit(ACMode mode);
 
   // 各モードの送信関数
   void sendOff();              // エアコン停止（電源オフ）
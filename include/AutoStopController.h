@@ -9,8 +9,7 @@
 #define AUTO_STOP_CONTROLLER_H
 
 #include <Arduino.h>
-#include "AirConditionerController.h"
-#include "TimeManager.h"
+#include "ScheduleEngine.h"
 
 /**
  * エアコン自動停止制御クラス
@@ -18,24 +17,23 @@
  * 主な機能:
  * - 指定時刻（デフォルト23時）にエアコンを自動停止
  * - 7〜9月（夏季）は自動停止をスキップ
- * - 1日1回のみ停止（翌日0時にリセット）
+ *
+ * 停止はScheduleEngineのルール（10〜6月の毎日、指定時刻に停止）として登録され、
+ * 実行タイミングの管理・再起動時の取りこぼし対応はScheduleEngineが行います。
  */
 class AutoStopController {
 public:
   /**
    * コンストラクタ
-   * @param ac エアコンコントローラーの参照
-   * @param timeMgr 時刻管理クラスの参照
+   * @param scheduler 停止ルールを登録するスケジュール実行クラスの参照
    * @param stopHour 自動停止する時刻（0-23、デフォルト23時）
    */
-  AutoStopController(AirConditionerController& ac, TimeManager& timeMgr, int stopHour = 23);
+  AutoStopController(ScheduleEngine& scheduler, int stopHour = 23);
 
   /**
-   * 自動停止チェックを実行
-   * loop関数内で定期的に呼び出してください。
-   * @return true: 停止を実行した, false: 停止不要または既に停止済み
+   * 停止ルールを登録（setup関数内で1回呼び出してください）
    */
-  bool check();
+  void begin();
 
   /**
    * 自動停止機能の有効/無効を設定
@@ -50,12 +48,10 @@ public:
   bool isEnabled() const { return enabled_; }
 
 private:
-  AirConditionerController& ac_;   // エアコンコントローラーの参照
-  TimeManager& timeMgr_;           // 時刻管理クラスの参照
+  ScheduleEngine& scheduler_;      // スケジュール実行クラスの参照
   int stopHour_;                   // 自動停止する時刻（0-23）
   bool enabled_;                   // 自動停止機能の有効/無効
-  bool stoppedToday_;              // 今日既に停止したかのフラグ
-  int lastPrintedHour_;            // 最後に時刻を表示した時（デバッグ用）
+  int ruleId_;                     // 登録した停止ルールのID
 };
 
 #endif // AUTO_STOP_CONTROLLER_H
@@ -0,0 +1,144 @@
+/**
+ * BoardConfig.h
+ *
+ * ボードの構成（ピン・センサーの種類・ディスプレイ・DIの閾値）と、機能の有効・無効
+ * ボードの構成は型（Board::DevKit など）で表し、platformio.ini の環境ごとに
+ * build_flags の -D BOARD_xxx で選びます。値はすべてコンパイル時定数で、
+ * DisplayController などはテンプレート引数で受け取ってボードごとに特殊化されます。
+ *
+ * 機能（Web API・MQTT・メトリクス・テレメトリ・トレース・予測制御）は FEATURE_xxx で切り替えます。
+ * 0 を指定した機能は main.cpp からコンパイル時に除去され、ライブラリもリンクされません。
+ *
+ * ボード・機能によらない設定（接続先・間隔・センサーの補正値など）は main.cpp の各 namespace にあります。
+ */
+
+#ifndef BOARD_CONFIG_H
+#define BOARD_CONFIG_H
+
+#include <stdint.h>
+#include <DHT.h>
+
+// ========================================
+// 機能の有効・無効（1: 有効、0: コンパイル時に除去）
+// ========================================
+
+#ifndef FEATURE_WEB
+#define FEATURE_WEB 1        // Web API・ダッシュボード（WebApi）
+#endif
+
+#ifndef FEATURE_MQTT
+#define FEATURE_MQTT 1       // MQTT連携（MqttBridge）
+#endif
+
+#ifndef FEATURE_METRICS
+#define FEATURE_METRICS 1    // メトリクス公開（MetricsServer）
+#endif
+
+#ifndef FEATURE_TELEMETRY
+#define FEATURE_TELEMETRY 1  // テレメトリ収集サーバーへの蓄積送信（TelemetryBuffer）
+#endif
+
+#ifndef FEATURE_TRACE
+#define FEATURE_TRACE 1      // 制御ループのトレース記録（TraceRecorder）
+#endif
+
+#ifndef FEATURE_PREDICT
+#define FEATURE_PREDICT 1    // 熱モデルによる予測制御（ThermalModel）
+#endif
+
+namespace Board {
+
+  // ========================================
+  // ディスプレイ
+  // ========================================
+
+  /**
+   * ディスプレイなし（DisplayController の何もしない特殊化が使われる）
+   */
+  struct NoDisplay {
+    static constexpr bool ENABLED = false;
+    static constexpr uint8_t WIDTH = 0;
+    static constexpr uint8_t HEIGHT = 0;
+  };
+
+  /**
+   * 0.96インチ SSD1306 128×64
+   */
+  struct Ssd1306_128x64 {
+    static constexpr bool ENABLED = true;
+    static constexpr uint8_t WIDTH = 128;
+    static constexpr uint8_t HEIGHT = 64;
+    static constexpr uint8_t ADDRESS = 0x3C;  // I2Cアドレス（裏面のジャンパーで0x3Dの製品もある）
+    static constexpr int8_t RESET_PIN = -1;   // リセットピンなし（電源投入時にリセット）
+  };
+
+  /**
+   * 0.91インチ SSD1306 128×32（1画面に収まるよう表示を詰める）
+   */
+  struct Ssd1306_128x32 {
+    static constexpr bool ENABLED = true;
+    static constexpr uint8_t WIDTH = 128;
+    static constexpr uint8_t HEIGHT = 32;
+    static constexpr uint8_t ADDRESS = 0x3C;
+    static constexpr int8_t RESET_PIN = -1;
+  };
+
+  // ========================================
+  // 快適さの閾値
+  // ========================================
+
+  /**
+   * 不快指数（DI）の閾値（0.01単位、7000 = DI 70.00）
+   * 目標: DI 70〜75を維持（寒がり向けの設定）
+   */
+  struct StandardComfort {
+    static constexpr int16_t TARGET_MIN = 7000;         // 目標DI最小値（これより下がったら暖める）
+    static constexpr int16_t TARGET_MAX = 7500;         // 目標DI最大値（これより上がったら対策）
+    static constexpr int16_t COOLING_THRESHOLD = 7700;  // 冷房開始閾値（強力な冷房が必要）
+    static constexpr int16_t HEATING_THRESHOLD = 6800;  // 暖房開始閾値（肌寒い）
+  };
+
+  // ========================================
+  // ボード
+  // ========================================
+
+  /**
+   * ESP32-DevKitC ＋ AM2302（DHT22）＋ 0.96インチOLED（README のピン接続）
+   */
+  struct DevKit {
+    static constexpr const char* NAME = "devkit";
+    static constexpr uint8_t DHT_PIN = 32;
+    static constexpr uint8_t SENSOR_TYPE = DHT22;
+    static constexpr uint8_t IR_RECV_PIN = 18;
+    static constexpr uint8_t IR_SEND_PIN = 5;
+    using Display = Ssd1306_128x64;
+    using Comfort = StandardComfort;
+  };
+
+  /**
+   * DevKit の0.91インチOLED版
+   */
+  struct DevKitOled32 : DevKit {
+    static constexpr const char* NAME = "devkit-oled32";
+    using Display = Ssd1306_128x32;
+  };
+
+  /**
+   * DevKit のディスプレイなし版（状態はWeb API・MQTTで確認する）
+   */
+  struct DevKitHeadless : DevKit {
+    static constexpr const char* NAME = "devkit-headless";
+    using Display = NoDisplay;
+  };
+
+#if defined(BOARD_DEVKIT_OLED32)
+  using Current = DevKitOled32;
+#elif defined(BOARD_DEVKIT_HEADLESS)
+  using Current = DevKitHeadless;
+#else
+  using Current = DevKit;  // 指定がなければ標準の構成（シミュレーターもこの閾値を使う）
+#endif
+
+}  // namespace Board
+
+#endif // BOARD_CONFIG_H
@@ -0,0 +1,118 @@
+/**
+ * BootSequence.h
+ *
+ * 起動処理の段階管理クラス
+ * 依存関係のある起動ステージを順不同・並行に進め、各ステージの所要時間を記録します。
+ */
+
+#ifndef BOOT_SEQUENCE_H
+#define BOOT_SEQUENCE_H
+
+#include <Arduino.h>
+
+/**
+ * 起動処理の段階管理クラス
+ *
+ * 主な機能:
+ * - 依存関係（ビットマスク）を満たしたステージから順に開始
+ * - 完了待ちのステージはloop()から毎回確認（ブロックしない）
+ * - 期限を過ぎたステージは警告して記録するが、完了を待ち続ける
+ *   （WiFiのように遅れて完了するステージでも、依存するステージは完了した時点で開始する）
+ * - ステージごとの開始時刻・所要時間の記録と表示
+ *
+ * 使い方:
+ *   int wifi = boot.addStage("wifi", startWiFi, isWiFiConnected);
+ *   boot.addStage("weather", nullptr, isWeatherFetched, BootSequence::bit(wifi));
+ *   boot.poll();  // setup() と loop() から呼び出す
+ */
+class BootSequence {
+public:
+  /**
+   * ステージ開始関数（依存ステージの完了後に1回だけ呼ばれる）
+   */
+  typedef void (*StartFunc)();
+
+  /**
+   * ステージ完了判定関数（完了するまでpoll()のたびに呼ばれる）
+   * nullptrの場合は開始関数の実行直後に完了とみなします。
+   */
+  typedef bool (*DoneFunc)();
+
+  /**
+   * ステージの状態
+   */
+  enum class StageState {
+    PENDING,   // 依存ステージの完了待ち
+    RUNNING,   // 完了待ち
+    DONE       // 完了
+  };
+
+  static constexpr uint8_t MAX_STAGES = 16;
+
+  /**
+   * ステージIDから依存関係ビットを作成
+   */
+  static uint32_t bit(int stageId) { return stageId >= 0 ? (1u << stageId) : 0; }
+
+  BootSequence();
+
+  /**
+   * ステージを追加
+   * @param name ステージ名（ログ表示用）
+   * @param start 開始関数（nullptr可）
+   * @param isDone 完了判定関数（nullptrなら開始直後に完了）
+   * @param dependsOn 依存するステージのビットマスク（bit() で作成）
+   * @param timeoutMs 開始からの報告期限（0なら無制限）。過ぎても失敗にはせず、期限超過として記録する
+   * @return ステージID、登録数上限の場合は-1
+   */
+  int addStage(const char* name, StartFunc start, DoneFunc isDone = nullptr,
+               uint32_t dependsOn = 0, unsigned long timeoutMs = 0);
+
+  /**
+   * 実行可能なステージを進める（ブロックしない）
+   * 全ステージが終わるまでloop()から毎回呼び出してください。
+   */
+  void poll();
+
+  /**
+   * 全ステージが完了したか
+   */
+  bool isFinished() const { return finished_; }
+
+  /**
+   * ステージの状態を取得
+   */
+  StageState getState(int stageId) const;
+
+  /**
+   * ステージが報告期限を過ぎたか（完了後も true のまま）
+   */
+  bool isLate(int stageId) const;
+
+  /**
+   * 全ステージの所要時間を表示
+   */
+  void printReport() const;
+
+private:
+  struct Stage {
+    const char* name;
+    StartFunc start;
+    DoneFunc isDone;
+    uint32_t dependsOn;
+    unsigned long timeoutMs;
+    StageState state;
+    bool late;                 // 報告期限を過ぎた
+    unsigned long startedAt;   // 開始時刻（millis）
+    unsigned long finishedAt;  // 完了時刻（millis）
+  };
+
+  Stage stages_[MAX_STAGES];
+  uint8_t stageCount_;
+  uint32_t doneMask_;     // 完了したステージ
+  bool finished_;
+
+  void finish(uint8_t id);
+};
+
+#endif // BOOT_SEQUENCE_H
@@ -0,0 +1,44 @@
+/**
+ * ComfortIndex.h
+ *
+ * 不快指数（DI）の計算式
+ * エアコン制御と天気予報の両方から同じ式を使うために共通化しています。
+ */
+
+#ifndef COMFORT_INDEX_H
+#define COMFORT_INDEX_H
+
+#include <stdint.h>
+#include "FixedPoint.h"
+
+namespace Comfort {
+
+/**
+ * 不快指数（Discomfort Index: DI）を計算
+ * 計算式: DI = 0.81T + 0.01H(0.99T - 14.3) + 46.3
+ * @param temperature 温度（摂氏）
+ * @param humidity    湿度（%）
+ * @return 不快指数（DI値）
+ */
+inline float discomfortIndex(float temperature, float humidity) {
+  return 0.81f * temperature + 0.01f * humidity * (0.99f * temperature - 14.3f) + 46.3f;
+}
+
+/**
+ * 不快指数を固定小数点で計算（整数演算のみ）
+ * 上の式を 1/100 単位に直し、1回の割り算で四捨五入します:
+ *   DI×100 = 4630 + (810000t + h(99t - 143000)) / 10^6  （t: 温度×100、h: 湿度×100）
+ * floatで計算して100倍・四捨五入した値との差は、丸めの境界での±1以内です。
+ * @param temperature 温度（0.01℃単位）
+ * @param humidity    湿度（0.01%単位）
+ * @return 不快指数（0.01単位）
+ */
+inline int16_t discomfortIndex(int16_t temperature, int16_t humidity) {
+  int64_t t = temperature;
+  int64_t h = humidity;
+  return (int16_t)(4630 + Fixed::divRound(810000 * t + h * (99 * t - 143000), 1000000));
+}
+
+}  // namespace Comfort
+
+#endif // COMFORT_INDEX_H
@@ -6,11 +6,16 @@
 #include <Adafruit_SSD1306.h>
 #include "EnvironmentSensor.h"
 #include "WeatherForecast.h"
+#include "BoardConfig.h"
 
 // ディスプレイコントローラークラス
+// Panel はディスプレイの構成（BoardConfig.h の Board::Ssd1306_128x64 など）。
+// 画面の大きさ・I2Cアドレスはコンパイル時定数で、高さ32ドットのパネルでは表示を詰めます。
+// 実装は DisplayController.cpp で、BoardConfig.h のパネルごとに明示的に実体化しています。
+template <class Panel>
 class DisplayController {
 public:
-  DisplayController(uint8_t width, uint8_t height, TwoWire* wire, int8_t resetPin, uint8_t address);
+  explicit DisplayController(TwoWire* wire);
 
   // 初期化
   bool begin();
@@ -29,8 +34,27 @@ public:
 
 private:
   Adafruit_SSD1306 display_;
-  uint8_t width_;
-  uint8_t height_;
+
+  // 高さ32ドットのパネル用の表示（温湿度・DI・天気を4行に詰める）
+  void showCompact(const SensorData& data, const String datetime, const WeatherData* weather);
+
+  // 1/100単位の整数を表示（センサー値・DI）
+  void printFixed(int16_t centi, uint8_t decimals);
+
+  // DIの状態（Hot・Warm・Comfy・Cool）
+  static const char* comfortLabel(int16_t discomfortIndex);
+};
+
+// ディスプレイなしのボード用（何もしない。SSD1306・GFXのライブラリはリンクされない）
+template <>
+class DisplayController<Board::NoDisplay> {
+public:
+  explicit DisplayController(TwoWire*) {}
+  bool begin() { return true; }
+  void showStartupScreen() {}
+  void showSensorData(const SensorData&, const String) {}
+  void showSensorDataWithWeather(const SensorData&, const String, const WeatherData&) {}
+  void showError(const char*) {}
 };
 
 #endif // DISPLAY_CONTROLLER_H
@@ -3,21 +3,91 @@
 
 #include <Arduino.h>
 #include <DHT.h>
+#include "FixedPoint.h"
 
-// センサーデータ構造体
+// センサーデータ構造体（値はすべて1/100単位の整数、FixedPoint.h）
 struct SensorData {
-  float temperature;
-  float humidity;
-  float discomfortIndex;  // 不快指数（DI）
+  int16_t temperature;      // 温度（0.01℃）
+  int16_t humidity;         // 湿度（0.01%）
+  int16_t discomfortIndex;  // 不快指数（DI、0.01）
   bool isValid;
 
-  SensorData() : temperature(0.0f), humidity(0.0f), discomfortIndex(0.0f), isValid(false) {}
-  SensorData(float temp, float hum, bool valid)
-    : temperature(temp), humidity(hum), discomfortIndex(0.0f), isValid(valid) {}
-  SensorData(float temp, float hum, float di, bool valid)
+  SensorData() : temperature(0), humidity(0), discomfortIndex(0), isValid(false) {}
+  SensorData(int16_t temp, int16_t hum, bool valid)
+    : temperature(temp), humidity(hum), discomfortIndex(0), isValid(valid) {}
+  SensorData(int16_t temp, int16_t hum, int16_t di, bool valid)
     : temperature(temp), humidity(hum), discomfortIndex(di), isValid(valid) {}
 };
 
+// センサー読み取りの計測値
+struct SensorStats {
+  uint32_t readCount;   // 読み取り回数
+  uint32_t readErrors;  // 読み取りエラー回数
+};
+
+// 適応サンプリングの計測値
+struct SamplerStats {
+  uint32_t samples;                 // 読み取り回数
+  uint32_t shortened;               // 変化が速く間隔を縮めた回数
+  uint32_t lengthened;              // 安定していて間隔を延ばした回数
+  uint32_t transitions;             // エアコンのモードの変更で最短に戻した回数
+  unsigned long averageIntervalMs;  // 実際の読み取り間隔（指数移動平均）
+};
+
+// 適応サンプリング（読み取り間隔を部屋の変化の速さに合わせる）
+// - 前回からの変化が分解能（温度0.1℃・不快指数0.2）以下なら間隔を1.5倍に延ばす
+//   （最長はエアコンの停止中 maxMs、運転中 activeMaxMs。運転中は制御の判定を遅らせないため）
+// - 温度0.3℃・不快指数0.5以上変化していたら半分に縮める（最短 minMs）
+// - エアコンのモードが変わった時は最短に戻し、HOLD_MS の間は延ばさない
+// - 読み取りに失敗した時は最短の間隔で再試行する
+class AdaptiveSampler {
+public:
+  static constexpr int16_t STEADY_TEMPERATURE = 10;  // 0.1℃（DHT22の分解能）
+  static constexpr int16_t STEADY_DI = 20;           // 0.2
+  static constexpr int16_t FAST_TEMPERATURE = 30;    // 0.3℃
+  static constexpr int16_t FAST_DI = 50;             // 0.5
+  static constexpr unsigned long HOLD_MS = 600000;   // モード変更後に間隔を延ばさない時間（10分）
+
+  AdaptiveSampler(unsigned long minMs, unsigned long maxMs, unsigned long activeMaxMs);
+
+  // 間隔の範囲を設定（minMs == maxMs == activeMaxMs なら固定間隔）
+  void setLimits(unsigned long minMs, unsigned long maxMs, unsigned long activeMaxMs);
+
+  // 次の読み取りの時刻になったか
+  bool isDue(unsigned long nowMs) const { return nowMs - lastSampleMs_ >= intervalMs_; }
+
+  // 読み取り結果から次の間隔を決める
+  void onSample(unsigned long nowMs, const SensorData& data);
+
+  // エアコンのモードが変わった（部屋の状態が速く変わり始める）
+  // @param running 変更後のモードで運転中（最長の間隔を activeMaxMs にする）
+  void notifyTransition(unsigned long nowMs, bool running);
+
+  // 現在の読み取り間隔
+  unsigned long getInterval() const { return intervalMs_; }
+
+  // 実際の読み取り頻度（1時間あたりの回数）
+  float getSamplesPerHour() const {
+    return stats_.averageIntervalMs > 0 ? 3600000.0f / stats_.averageIntervalMs : 0.0f;
+  }
+
+  const SamplerStats& getStats() const { return stats_; }
+
+private:
+  unsigned long minMs_;
+  unsigned long maxMs_;
+  unsigned long activeMaxMs_;
+  unsigned long ceilingMs_;     // 現在の最長の間隔（maxMs_ か activeMaxMs_）
+  unsigned long intervalMs_;
+  unsigned long lastSampleMs_;
+  unsigned long transitionMs_;
+  bool holding_;                // モード変更後の HOLD_MS の間
+  bool hasLast_;
+  int16_t lastTemperature_;
+  int16_t lastDiscomfortIndex_;
+  SamplerStats stats_;
+};
+
 // 環境センサークラス
 class EnvironmentSensor {
 public:
@@ -26,17 +96,43 @@ public:
   // 初期化
   void begin();
 
-  // センサーデータを読み取る
+  // センサーデータを読み取る（結果は適応サンプリングにも渡す）
   SensorData read();
 
+  // 読み取り間隔の範囲を設定（DHT22の測定周期は2秒以上、activeMaxMs はエアコンの運転中の最長）
+  void setSampleInterval(unsigned long minMs, unsigned long maxMs, unsigned long activeMaxMs) {
+    sampler_.setLimits(minMs, maxMs, activeMaxMs);
+  }
+
+  // 次の読み取りの時刻になったか
+  bool isDue(unsigned long nowMs) const { return sampler_.isDue(nowMs); }
+
+  // エアコンのモードが変わったことを通知（読み取り間隔を最短に戻す）
+  void notifyTransition(bool running) { sampler_.notifyTransition(millis(), running); }
+
+  // 適応サンプリングの状態
+  const AdaptiveSampler& getSampler() const { return sampler_; }
+
+  // 最後に成功した読み取り結果（未読み取りの場合はisValid=false）
+  const SensorData& getLastData() const { return lastData_; }
+
+  // 再起動前の読み取り結果を復元（最初の読み取りまでの表示・API応答用）
+  void restoreLastData(const SensorData& data) { lastData_ = data; }
+
+  // 計測値を取得
+  const SensorStats& getStats() const { return stats_; }
+
   // オフセットを設定
-  void setTemperatureOffset(float offset) { temperatureOffset_ = offset; }
-  void setHumidityOffset(float offset) { humidityOffset_ = offset; }
+  void setTemperatureOffset(float offset) { temperatureOffset_ = Fixed::fromFloat(offset); }
+  void setHumidityOffset(float offset) { humidityOffset_ = Fixed::fromFloat(offset); }
 
 private:
   DHT dht_;
-  float temperatureOffset_;
-  float humidityOffset_;
+  int16_t temperatureOffset_;  // 0.01℃
+  int16_t humidityOffset_;     // 0.01%
+  SensorData lastData_;
+  SensorStats stats_;
+  AdaptiveSampler sampler_;
 };
 
 #endif // ENVIRONMENT_SENSOR_H
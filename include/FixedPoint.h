@@ -0,0 +1,113 @@
+/**
+ * FixedPoint.h
+ *
+ * センサー値の固定小数点表現（1/100単位の整数）と、整数だけで行う文字列への変換
+ * 温度（0.01℃）・湿度（0.01%）・不快指数（0.01）を int16_t で扱います。
+ * DHT22の分解能（0.1）に対して十分な精度で、floatの半分の大きさです。
+ * 時間別予報（HourlyForecast）・テレメトリ・MQTT・トレースも同じ単位です。
+ */
+
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+namespace Fixed {
+
+  constexpr int32_t SCALE = 100;   // 1/100単位
+
+  /**
+   * 実数から変換（四捨五入、int16_t の範囲に丸める）
+   * センサーの読み取り値など、外部から来た値の入口でだけ使います。
+   */
+  inline int16_t fromFloat(float value) {
+    float scaled = value * SCALE;
+    if (scaled >= 32767.0f) return 32767;
+    if (scaled <= -32768.0f) return -32768;
+    return (int16_t)lroundf(scaled);
+  }
+
+  /**
+   * 実数に変換（メトリクス・熱モデルなど、実数で計算する処理に渡す時だけ使う）
+   */
+  inline float toFloat(int32_t centi) {
+    return centi / (float)SCALE;
+  }
+
+  /**
+   * 整数の割り算（四捨五入。0から遠い方へ丸める）
+   */
+  inline int64_t divRound(int64_t numerator, int64_t denominator) {
+    return numerator >= 0 ? (numerator + denominator / 2) / denominator
+                          : -((-numerator + denominator / 2) / denominator);
+  }
+
+  /**
+   * 文字列に変換（整数演算のみ、小数点以下 decimals 桁に四捨五入）
+   * 例: format(buf, sizeof(buf), 2635, 1) → "26.4"、format(buf, sizeof(buf), -50, 1) → "-0.5"
+   * @param decimals 小数点以下の桁数（0〜2）
+   * @return 書き込んだ文字数（終端を除く）
+   */
+  inline size_t format(char* buf, size_t size, int32_t centi, uint8_t decimals) {
+    if (size == 0) {
+      return 0;
+    }
+    if (decimals > 2) {
+      decimals = 2;
+    }
+    int32_t unit = decimals == 0 ? 100 : (decimals == 1 ? 10 : 1);
+    bool negative = centi < 0;
+    uint32_t magnitude = (uint32_t)(negative ? -(int64_t)centi : centi);
+    uint32_t rounded = (magnitude + unit / 2) / unit;   // 小数点以下 decimals 桁の整数
+    uint32_t whole = rounded;
+    uint32_t fraction = 0;
+    if (decimals > 0) {
+      uint32_t divisor = decimals == 1 ? 10 : 100;
+      whole = rounded / divisor;
+      fraction = rounded % divisor;
+    }
+
+    // 後ろから書いて反転させる（最大: 符号 + 10桁 + 小数点 + 2桁）
+    char tmp[16];
+    size_t n = 0;
+    for (uint8_t i = 0; i < decimals; i++) {
+      tmp[n++] = (char)('0' + fraction % 10);
+      fraction /= 10;
+    }
+    if (decimals > 0) {
+      tmp[n++] = '.';
+    }
+    do {
+      tmp[n++] = (char)('0' + whole % 10);
+      whole /= 10;
+    } while (whole > 0);
+    if (negative && rounded > 0) {
+      tmp[n++] = '-';
+    }
+
+    size_t length = 0;
+    while (n > 0 && length + 1 < size) {
+      buf[length++] = tmp[--n];
+    }
+    buf[length] = '\0';
+    return length;
+  }
+
+  /**
+   * 文字列に変換した値（ログ・printf の引数にそのまま渡すための一時オブジェクト）
+   * 例: LOG_D("温度: %s℃", Fixed::Text(data.temperature, 1).c_str());
+   */
+  class Text {
+  public:
+    Text(int32_t centi, uint8_t decimals) { format(buf_, sizeof(buf_), centi, decimals); }
+    const char* c_str() const { return buf_; }
+
+  private:
+    char buf_[16];
+  };
+
+}  // namespace Fixed
+
+#endif // FIXED_POINT_H
@@ -0,0 +1,147 @@
+/**
+ * HttpSession.h
+ *
+ * HTTP接続共有クラス
+ * 同一ホストへのリクエストでTCP（TLS）接続とDNS解決結果を再利用します。
+ */
+
+#ifndef HTTP_SESSION_H
+#define HTTP_SESSION_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <HTTPClient.h>
+
+/**
+ * HTTP通信の計測値
+ * バイト数はボディのみ（HTTPヘッダーは含まない）
+ */
+struct HttpStats {
+  uint32_t requests;            // リクエスト数
+  uint32_t errors;              // 失敗数（接続失敗・HTTPエラー含む）
+  uint32_t connects;            // 新規接続数
+  uint32_t reusedConnections;   // 既存接続を再利用した回数
+  uint32_t dnsLookups;          // DNS問い合わせ回数
+  uint32_t dnsCacheHits;        // DNSキャッシュヒット数
+  unsigned long lastConnectMs;  // 直近の接続確立時間
+  unsigned long totalConnectMs; // 接続確立時間の累計
+  uint32_t bytesSent;           // 送信ボディバイト数
+  uint32_t bytesReceived;       // 受信ボディバイト数
+};
+
+/**
+ * HTTP接続共有クラス
+ *
+ * 主な機能:
+ * - keep-alive接続の再利用（切断されていれば自動で再接続）
+ * - DNS解決結果のキャッシュ（平文HTTPのみ）
+ * - 複数エンドポイントへのリクエストを1回の接続でまとめて実行
+ * - chunked転送のデコード（ボディはStreamとしてそのまま渡す）
+ * - 接続確立時間・送受信バイト数の計測
+ */
+class HttpSession {
+public:
+  /**
+   * レスポンスボディ処理関数
+   * @param status HTTPステータスコード
+   * @param body レスポンスボディ（chunked転送はデコード済み）
+   * @param context 呼び出し側が指定した任意のポインタ
+   * @return true: 処理成功, false: 処理失敗
+   */
+  typedef bool (*BodyHandler)(int status, Stream& body, void* context);
+
+  /**
+   * 1件分のリクエスト
+   * execute() に配列で渡すと、同じ接続上で順番に実行されます。
+   */
+  struct Request {
+    const char* method;        // "GET" / "POST" など
+    const char* path;          // パス＋クエリ（例: "/v1/forecast?..."）
+    const char* contentType;   // 送信ボディのContent-Type（ボディなしならnullptr）
+    const uint8_t* body;       // 送信ボディ（なしならnullptr）
+    size_t bodyLength;         // 送信ボディ長
+    BodyHandler handler;       // レスポンスボディ処理（不要ならnullptr）
+    void* context;             // handlerに渡すポインタ
+    int status;                // 結果: HTTPステータス、負数は通信エラー
+    uint32_t bytesReceived;    // 結果: 受信ボディバイト数
+  };
+
+  /**
+   * コンストラクタ
+   * @param host 接続先ホスト名
+   * @param port 接続先ポート
+   * @param secure true: TLS（HTTPS）で接続
+   */
+  HttpSession(const char* host, uint16_t port = 80, bool secure = false);
+  ~HttpSession();
+
+  /**
+   * TLS接続時に使うルートCA証明書を設定（PEM形式）
+   * secure=true の場合は必須です。
+   */
+  void setCACert(const char* rootCA) { rootCA_ = rootCA; }
+
+  /**
+   * GETリクエストを送信
+   * @return HTTPステータスコード、負数は通信エラー
+   */
+  int get(const char* path, BodyHandler handler, void* context);
+
+  /**
+   * POSTリクエストを送信
+   * @return HTTPステータスコード、負数は通信エラー
+   */
+  int post(const char* path, const char* contentType, const uint8_t* body, size_t length,
+           BodyHandler handler = nullptr, void* context = nullptr);
+
+  /**
+   * 複数のリクエストを1回の接続でまとめて実行
+   * @param requests リクエスト配列（結果は各要素のstatusに格納）
+   * @param count 件数
+   * @return 2xxで完了した件数
+   */
+  size_t execute(Request* requests, size_t count);
+
+  /**
+   * 接続を閉じる（DNSキャッシュは保持）
+   */
+  void close();
+
+  /**
+   * 計測値を取得
+   */
+  const HttpStats& getStats() const { return stats_; }
+
+  const char* getHost() const { return host_; }
+
+private:
+  static constexpr unsigned long DNS_TTL_MS = 600000;     // DNSキャッシュの有効期間（10分）
+  static constexpr uint16_t TIMEOUT_MS = 5000;            // 通信タイムアウト
+
+  const char* host_;
+  uint16_t port_;
+  bool secure_;
+  const char* rootCA_;
+
+  WiFiClient plainClient_;
+  WiFiClientSecure* secureClient_;  // secure=true の場合のみ生成
+  WiFiClient* client_;              // 実際に使うクライアント
+  HTTPClient http_;
+
+  IPAddress cachedIp_;
+  unsigned long dnsResolvedAt_;
+  bool dnsCached_;
+
+  HttpStats stats_;
+
+  bool ensureConnected(bool& reused);
+  bool resolve(IPAddress& ip);
+  bool perform(Request& request);
+
+  // コピー禁止（接続を所有するため）
+  HttpSession(const HttpSession&) = delete;
+  HttpSession& operator=(const HttpSession&) = delete;
+};
+
+#endif // HTTP_SESSION_H
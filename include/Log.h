@@ -0,0 +1,158 @@
+/**
+ * Log.h
+ *
+ * ログ出力
+ * レベル別のログをバイナリ形式でリングバッファに積み、バックグラウンドタスクがシリアルへ出力します。
+ *
+ * 使い方:
+ *   LOG_I("[AC] 温度:%s℃, 湿度:%s%%", Fixed::Text(data.temperature, 1).c_str(), Fixed::Text(data.humidity, 1).c_str());
+ *   LOG_E("[Weather] HTTPエラー: %d", status);
+ *
+ * - 書式文字列の末尾に改行は不要です（出力時に付加されます）
+ * - LOG_LEVEL（platformio.ini の build_flags）より詳細なレベルはコンパイル時に除去され、
+ *   引数も評価されません
+ * - 有効なレベルは書式文字列のアドレスと引数の値（文字列は内容をコピー）を記録するだけで、
+ *   文字列の整形とUART送信は出力タスクで行われます
+ * - 書式文字列は文字列リテラルを渡してください（出力時までアドレスを参照するため）
+ * - Stringは渡せません（.c_str() を渡すと、その時点の内容がコピーされます）
+ */
+
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+namespace Log {
+
+  enum Level : uint8_t {
+    LEVEL_ERROR = LOG_LEVEL_ERROR,
+    LEVEL_WARN = LOG_LEVEL_WARN,
+    LEVEL_INFO = LOG_LEVEL_INFO,
+    LEVEL_DEBUG = LOG_LEVEL_DEBUG
+  };
+
+  /**
+   * ログの計測値
+   */
+  struct Stats {
+    uint32_t written;    // リングバッファに積んだ件数
+    uint32_t dropped;    // バッファ不足で捨てた件数
+    uint32_t truncated;  // 引数が多すぎる・文字列が長すぎるため切り詰めた件数
+    uint32_t highWater;  // リングバッファ使用量の最大値（バイト）
+  };
+
+  /**
+   * 出力タスクを開始（setup関数の最初、Serial.begin() の直後に呼び出す）
+   * 開始前に積まれたログも出力されます。
+   */
+  void begin();
+
+  /**
+   * 積まれているログをすべて出力するまで待つ
+   * 再起動の直前など、ログを確実に出力したい場合に使用します。
+   */
+  void flush();
+
+  /**
+   * 計測値を取得
+   */
+  Stats getStats();
+
+  /**
+   * 1件分のログを組み立てるクラス（LOG_* マクロから使用）
+   * スタック上のバッファに書式文字列のアドレスと引数を詰め、commit() でリングバッファにコピーします。
+   */
+  class Record {
+  public:
+    static constexpr size_t MAX_SIZE = 128;   // 1件の最大サイズ（バイト）
+    static constexpr size_t MAX_STRING = 48;  // 文字列引数1つの最大長（超えた分は切り詰め）
+
+    Record(Level level, const char* format);
+
+    void add(bool v)               { addInt((int64_t)v); }
+    void add(char v)               { addInt((int64_t)v); }
+    void add(signed char v)        { addInt((int64_t)v); }
+    void add(unsigned char v)      { addInt((int64_t)v); }
+    void add(short v)              { addInt((int64_t)v); }
+    void add(unsigned short v)     { addInt((int64_t)v); }
+    void add(int v)                { addInt((int64_t)v); }
+    void add(unsigned int v)       { addInt((int64_t)v); }
+    void add(long v)               { addInt((int64_t)v); }
+    void add(unsigned long v)      { addInt((int64_t)v); }
+    void add(long long v)          { addInt((int64_t)v); }
+    void add(unsigned long long v) { addInt((int64_t)v); }
+    void add(float v)              { addDouble(v); }
+    void add(double v)             { addDouble(v); }
+    void add(const char* v);
+    void add(const void* v);
+
+    void commit();
+
+  private:
+    uint8_t data_[MAX_SIZE];
+    Level level_;
+    size_t length_;
+    bool truncated_;
+
+    void addInt(int64_t v);
+    void addDouble(double v);
+    bool reserve(size_t bytes);
+  };
+
+  inline void pack(Record&) {}
+
+  template <typename T, typename... Rest>
+  inline void pack(Record& record, T first, Rest... rest) {
+    record.add(first);
+    pack(record, rest...);
+  }
+
+  /**
+   * 書式文字列と引数の型をコンパイル時に検査するための宣言（呼び出されない）
+   */
+  inline void checkFormat(const char*, ...) __attribute__((format(printf, 1, 2)));
+  inline void checkFormat(const char*, ...) {}
+
+  template <typename... Args>
+  inline void write(Level level, const char* format, Args... args) {
+    Record record(level, format);
+    pack(record, args...);
+    record.commit();
+  }
+}
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_E(...) do { if (false) Log::checkFormat(__VA_ARGS__); Log::write(Log::LEVEL_ERROR, __VA_ARGS__); } while (0)
+#else
+#define LOG_E(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_W(...) do { if (false) Log::checkFormat(__VA_ARGS__); Log::write(Log::LEVEL_WARN, __VA_ARGS__); } while (0)
+#else
+#define LOG_W(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_I(...) do { if (false) Log::checkFormat(__VA_ARGS__); Log::write(Log::LEVEL_INFO, __VA_ARGS__); } while (0)
+#else
+#define LOG_I(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_D(...) do { if (false) Log::checkFormat(__VA_ARGS__); Log::write(Log::LEVEL_DEBUG, __VA_ARGS__); } while (0)
+#else
+#define LOG_D(...) do {} while (0)
+#endif
+
+#endif // LOG_H
@@ -0,0 +1,130 @@
+/**
+ * LoopWatchdog.h
+ *
+ * 制御ループの停止の監視と、リセットをまたいで残る処理段階の足跡
+ * loop() の各処理（WiFi再接続・HTTP・DHT・I2Cなど）の開始・終了をRTCメモリ（リセット後も保持）の
+ * リングバッファに記録し、タスクウォッチドッグ・パニックでリセットされた場合は、
+ * 次の起動時に直前の足跡と、実行中だった（止まっていた）段階を表示します。
+ *
+ * 段階ごとにソフトの期限を設定でき、期限を超えた段階は終了を待たずに警告をログに出します
+ * （100msごとのタイマーで確認するため、ハードウェアのウォッチドッグでリセットされる前に分かります）。
+ *
+ * 使い方（loop() の中）:
+ *   watchdog.enter(STAGE_WEATHER);   // 次の enter() か exit() までを1つの段階として記録
+ *   weatherForecast.update();
+ *   watchdog.enter(STAGE_SENSOR);
+ *   ...
+ *   watchdog.exit();
+ */
+
+#ifndef LOOP_WATCHDOG_H
+#define LOOP_WATCHDOG_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <atomic>
+
+/**
+ * 処理段階の定義
+ */
+struct LoopStage {
+  const char* name;           // 表示名（ログ・メトリクスのラベル）
+  uint32_t softDeadlineMs;    // これより長くかかったら警告する
+};
+
+class LoopWatchdog {
+public:
+  static constexpr uint8_t MAX_STAGES = 24;
+  static constexpr uint8_t NO_STAGE = 0xFF;
+  static constexpr uint8_t HISTORY = 48;         // RTCメモリに残す足跡の数（開始・終了で1件ずつ）
+  static constexpr uint8_t REPORT = 12;          // リセット後に表示する足跡の数
+  static constexpr uint32_t CHECK_INTERVAL_MS = 100;  // ソフトの期限の確認間隔
+
+  /**
+   * 段階ごとの計測値
+   */
+  struct StageStats {
+    uint32_t overruns;        // ソフトの期限を超えた回数
+    uint32_t maxUs;           // 最長の所要時間（マイクロ秒）
+  };
+
+  /**
+   * コンストラクタ
+   * @param stages 段階の一覧（配列の位置が段階の番号。プログラムの実行中は保持してください）
+   * @param count 段階の数（MAX_STAGES以下）
+   * @param timeoutSec タスクウォッチドッグのタイムアウト（この間 feed() がなければリセット）
+   */
+  LoopWatchdog(const LoopStage* stages, uint8_t count, uint32_t timeoutSec);
+
+  /**
+   * 前回のリセットの報告と、ループタスクのタスクウォッチドッグへの登録（setup関数の最初に呼び出す）
+   */
+  void begin();
+
+  /**
+   * タスクウォッチドッグをリセット（loop関数の先頭で毎回呼び出す）
+   */
+  void feed();
+
+  /**
+   * 段階の開始（実行中の段階があれば、その終了も記録する）
+   */
+  void enter(uint8_t stage);
+
+  /**
+   * 実行中の段階の終了
+   */
+  void exit();
+
+  /**
+   * スコープの間を1つの段階として記録する
+   */
+  class Scope {
+  public:
+    Scope(LoopWatchdog& watchdog, uint8_t stage) : watchdog_(watchdog) { watchdog_.enter(stage); }
+    ~Scope() { watchdog_.exit(); }
+
+  private:
+    LoopWatchdog& watchdog_;
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+  };
+
+  /**
+   * 前回のリセットがウォッチドッグ・パニックによるものだった場合、その時に実行中だった段階の番号
+   * （該当しない・分からない場合は NO_STAGE）
+   */
+  uint8_t getCrashStage() const { return crashStage_; }
+
+  /**
+   * 段階の数・名前・計測値
+   */
+  uint8_t getStageCount() const { return count_; }
+  const char* stageName(uint8_t stage) const { return stage < count_ ? stages_[stage].name : "?"; }
+  const StageStats& getStageStats(uint8_t stage) const { return stats_[stage < count_ ? stage : 0]; }
+
+private:
+  const LoopStage* stages_;
+  uint8_t count_;
+  uint32_t timeoutSec_;
+  uint8_t crashStage_;
+  esp_timer_handle_t timer_;
+
+  // 実行中の段階（タイマーのタスクからも読むため atomic）
+  std::atomic<uint8_t> current_;
+  std::atomic<uint32_t> enteredMs_;
+  std::atomic<uint32_t> entry_;         // 段階を開始するたびに増える番号
+  std::atomic<uint32_t> reportedEntry_; // 期限超過を報告済みの entry_
+  unsigned long enteredUs_;
+
+  StageStats stats_[MAX_STAGES];
+
+  void record(uint8_t stage, uint8_t event, uint32_t durationMs);
+  void reportPreviousReset();
+  void reportOverrun(uint32_t entry, uint8_t stage, uint32_t elapsedMs);
+  uint32_t layoutHash() const;
+  static void onCheckTimer(void* arg);
+  void check();
+};
+
+#endif // LOOP_WATCHDOG_H
@@ -0,0 +1,177 @@
+/**
+ * MetricsServer.h
+ *
+ * メトリクス公開サーバー
+ * Prometheus形式（テキスト）の /metrics エンドポイントを提供します。
+ */
+
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+/**
+ * Prometheusテキスト形式の書き込みクラス
+ * 固定長バッファに行単位で追記し、満杯になったら送出関数に渡して空にします（ヒープ確保なし）。
+ * 送出関数がない場合、または1行がバッファに収まらない場合はその行を捨ててoverflowを記録します。
+ */
+class MetricsWriter {
+public:
+  /**
+   * バッファの内容の送出関数
+   * @return false: 送出失敗（以降の書き込みは捨てる）
+   */
+  typedef bool (*FlushFunc)(const char* data, size_t length, void* context);
+
+  MetricsWriter(char* buffer, size_t capacity, FlushFunc flush = nullptr, void* context = nullptr);
+
+  /**
+   * メトリクスの説明と型（gauge / counter / summary）を書き込む
+   */
+  void header(const char* name, const char* help, const char* type);
+
+  /**
+   * 値を書き込む
+   * @param labels ラベル（例: "mode=\"off\""、なしの場合はnullptr）
+   */
+  void sample(const char* name, const char* labels, double value);
+  void sample(const char* name, const char* labels, uint32_t value);
+
+  /**
+   * 説明・型・値をまとめて書き込む（ラベルなし）
+   */
+  void gauge(const char* name, const char* help, double value);
+  void counter(const char* name, const char* help, uint32_t value);
+
+  /**
+   * バッファに残っている分を送出する（送出関数がある場合、書き込みの最後に呼び出す）
+   * @return false: 送出失敗
+   */
+  bool finish();
+
+  size_t length() const { return length_; }      // バッファ内の長さ
+  size_t total() const { return total_; }        // 書き込んだ全体の長さ（送出済みを含む）
+  bool overflowed() const { return overflow_; }
+  bool failed() const { return failed_; }
+
+private:
+  char* buffer_;
+  size_t capacity_;
+  size_t length_;
+  size_t total_;
+  bool overflow_;
+  bool failed_;
+  FlushFunc flush_;
+  void* flushContext_;
+
+  void append(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+/**
+ * メトリクス公開の計測値
+ */
+struct MetricsServerStats {
+  uint32_t scrapes;            // /metrics の応答回数
+  uint32_t notFound;           // /metrics 以外へのリクエスト数
+  uint32_t overflows;          // 行がバッファに収まらず出力を欠落させた回数
+  uint32_t writeErrors;        // 応答の送信に失敗した回数
+  unsigned long lastRenderUs;  // 直近の生成・送信時間（マイクロ秒）
+  size_t lastBytes;            // 直近の応答本文のサイズ（バイト）
+};
+
+/**
+ * メトリクス公開サーバー
+ *
+ * 主な機能:
+ * - GET /metrics にPrometheusテキスト形式で応答
+ * - ループ処理時間・ヒープ残量・稼働時間を標準で出力
+ * - 各モジュールのメトリクスは登録した収集関数から出力
+ * - 応答は固定長バッファに生成し、満杯になるたびにchunked転送で送出（本文の長さに上限なし、
+ *   リクエストごとのヒープ確保なし）
+ *
+ * handle() はloop()から毎回呼び出します。接続がなければすぐに戻ります。
+ * リクエスト行は届いた分だけ読み進め、揃うまで次の handle() に持ち越します（待たない）。
+ */
+class MetricsServer {
+public:
+  /**
+   * メトリクス収集関数
+   * @param writer 書き込み先
+   * @param context addCollector() で指定したポインタ
+   */
+  typedef void (*Collector)(MetricsWriter& writer, void* context);
+
+  static constexpr uint8_t MAX_COLLECTORS = 16;
+  static constexpr size_t BUFFER_SIZE = 1400;   // 1回に送出する大きさ（TCPの1セグメントに収まる）
+
+  /**
+   * コンストラクタ
+   * @param port 待ち受けポート（Prometheus exporterの慣例に合わせて9100など）
+   */
+  explicit MetricsServer(uint16_t port = 9100);
+
+  /**
+   * 待ち受けを開始
+   */
+  void begin();
+
+  /**
+   * リクエストがあれば応答する（接続がなければすぐに戻る）
+   */
+  void handle();
+
+  /**
+   * 収集関数を登録（最大 MAX_COLLECTORS 件）
+   * @return true: 登録成功, false: 登録数上限
+   */
+  bool addCollector(Collector collector, void* context = nullptr);
+
+  /**
+   * ループ1回の処理時間を記録（loop()の最後で呼び出す）
+   * @param durationUs 処理時間（マイクロ秒）
+   */
+  void recordLoop(unsigned long durationUs);
+
+  /**
+   * 計測値を取得
+   */
+  const MetricsServerStats& getStats() const { return stats_; }
+
+private:
+  static constexpr unsigned long REQUEST_TIMEOUT_MS = 2000;  // 接続からリクエスト行が揃うまでの上限
+  static constexpr size_t REQUEST_LINE_SIZE = 64;
+
+  WiFiServer server_;
+  uint16_t port_;
+  bool started_;
+
+  struct CollectorEntry {
+    Collector callback;
+    void* context;
+  };
+  CollectorEntry collectors_[MAX_COLLECTORS];
+  uint8_t collectorCount_;
+
+  // ループ処理時間（前回の応答以降の最大値と、起動以降の累計）
+  uint32_t loopCount_;
+  uint64_t loopTotalUs_;
+  unsigned long loopMaxUs_;
+
+  MetricsServerStats stats_;
+
+  // 受信途中のリクエスト（1件ずつ処理する）
+  WiFiClient client_;
+  char requestLine_[REQUEST_LINE_SIZE];
+  size_t requestLength_;
+  unsigned long acceptedAt_;   // 接続を受け付けた時刻（millis）
+
+  char buffer_[BUFFER_SIZE];   // 応答本文の送出待ち（使い回す）
+
+  bool readRequestLine();
+  void respond();
+  void render(MetricsWriter& writer);
+  static bool writeChunk(const char* data, size_t length, void* context);
+};
+
+#endif // METRICS_SERVER_H
@@ -0,0 +1,179 @@
+/**
+ * MqttBridge.h
+ *
+ * MQTT連携クラス
+ * センサー値・エアコンの状態・稼働状況をMQTTブローカーへ送信し、
+ * コマンドトピックからエアコンの操作を受け付けます。
+ */
+
+#ifndef MQTT_BRIDGE_H
+#define MQTT_BRIDGE_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <PubSubClient.h>
+#include "AirConditionerController.h"
+#include "AutoStopController.h"
+#include "EnvironmentSensor.h"
+#include "TimeManager.h"
+
+/**
+ * MQTT連携の計測値
+ */
+struct MqttStats {
+  uint32_t connectAttempts;    // 接続試行回数
+  uint32_t connectFailures;    // 接続失敗回数
+  uint32_t publishCount;       // 送信成功回数
+  uint32_t publishFailures;    // 送信失敗回数
+  uint32_t batchCount;         // 送信したセンサー値のまとまりの数
+  uint32_t samplesSent;        // 送信したセンサー値の件数
+  uint32_t samplesDropped;     // 送信待ちが上限に達したため捨てた件数
+  uint32_t commandsReceived;   // 受信したコマンド数
+  uint32_t commandsRejected;   // 解釈できなかったコマンド数
+  unsigned long lastPublishUs; // 直近の送信にかかった時間（マイクロ秒）
+  unsigned long maxPublishUs;  // 送信にかかった最長時間（マイクロ秒）
+  uint8_t maxQueueDepth;       // 送信待ちセンサー値の最大件数
+};
+
+/**
+ * MQTT連携クラス
+ *
+ * トピック（<base> = "aircon/<デバイスID>"）:
+ * - <base>/telemetry  センサー値をまとめて送信（flushInterval ごと）
+ * - <base>/state      エアコンのモード・自動停止の有効/無効（変化時、retain）
+ * - <base>/health     稼働状況（healthInterval ごと）
+ * - <base>/status     "online" / "offline"（切断時はブローカーがLast Willで "offline" を送信、retain）
+ * - <base>/cmd        コマンド受信（例: {"mode":"cool_20"}, {"autoStop":false}）
+ *
+ * センサー値は読み取りごとに送信せず、固定長の配列に溜めてから1つのメッセージにまとめます。
+ * 値は100倍した整数で送信します（26.5℃ → 2650）。
+ *
+ * 未接続の間はバックオフしながら再接続し、送信待ちのセンサー値は上限（MAX_BATCH）まで保持します。
+ * 接続処理（TCP接続・CONNECT）はloop()を数秒ブロックする場合があるため、間隔を空けて試行します。
+ */
+class MqttBridge {
+public:
+  static constexpr uint8_t MAX_BATCH = 60;  // 送信待ちセンサー値の上限（2秒間隔で2分ぶん）
+
+  /**
+   * コンストラクタ
+   * @param airConditioner コマンドで操作するエアコン制御クラスの参照
+   * @param autoStop コマンドで操作する自動停止制御クラスの参照
+   * @param timeManager センサー値の時刻に使う時刻管理クラスの参照
+   * @param host ブローカーのホスト名またはIPアドレス
+   * @param port ブローカーのポート番号
+   * @param deviceId クライアントIDとトピック名に使うデバイスID
+   */
+  MqttBridge(AirConditionerController& airConditioner, AutoStopController& autoStop,
+             TimeManager& timeManager, const char* host, uint16_t port, const char* deviceId);
+
+  /**
+   * 認証情報を設定（begin() の前に呼び出す。未設定の場合は匿名で接続）
+   */
+  void setCredentials(const char* user, const char* password);
+
+  /**
+   * センサー値の送信間隔を設定（ミリ秒）
+   */
+  void setFlushInterval(unsigned long intervalMs) { flushIntervalMs_ = intervalMs; }
+
+  /**
+   * 稼働状況の送信間隔を設定（ミリ秒）
+   */
+  void setHealthInterval(unsigned long intervalMs) { healthIntervalMs_ = intervalMs; }
+
+  /**
+   * 初期化（setup関数内で1回呼び出す。接続はupdate()で行う）
+   */
+  void begin();
+
+  /**
+   * 接続の維持・コマンド受信・送信処理（ブロックしない。接続試行時を除く）
+   * loop関数内で毎回呼び出してください。
+   */
+  void update();
+
+  /**
+   * センサー値を送信待ちに追加
+   * @return true: 追加した, false: 無効な値、または送信待ちが上限に達したため捨てた
+   */
+  bool addSample(const SensorData& data);
+
+  /**
+   * ブローカーに接続中かどうか
+   */
+  bool isConnected() { return client_.connected(); }
+
+  /**
+   * 送信待ちのセンサー値の件数
+   */
+  uint8_t getQueueDepth() const { return sampleCount_; }
+
+  /**
+   * 計測値を取得
+   */
+  const MqttStats& getStats() const { return stats_; }
+
+private:
+  static constexpr unsigned long BACKOFF_BASE_MS = 2000;   // 初回の再接続待ち
+  static constexpr unsigned long BACKOFF_MAX_MS = 60000;   // 再接続待ちの上限
+  static constexpr size_t PAYLOAD_SIZE = 1600;             // 送信メッセージの最大長（MAX_BATCH件が収まる大きさ）
+  static constexpr size_t TOPIC_SIZE = 64;
+
+  // 送信待ちのセンサー値（100倍した整数）
+  struct Sample {
+    uint16_t offsetSec;   // 最初のセンサー値からの経過秒
+    int16_t temperature;
+    uint16_t humidity;
+    int16_t discomfortIndex;
+  };
+
+  AirConditionerController& airConditioner_;
+  AutoStopController& autoStop_;
+  TimeManager& timeManager_;
+  WiFiClient net_;
+  PubSubClient client_;
+
+  const char* host_;
+  uint16_t port_;
+  const char* deviceId_;
+  const char* user_;
+  const char* password_;
+
+  char baseTopic_[TOPIC_SIZE];
+  char topic_[TOPIC_SIZE];       // 送信先トピックの組み立て用
+  char payload_[PAYLOAD_SIZE];   // 送信メッセージの組み立て用
+
+  Sample samples_[MAX_BATCH];
+  uint8_t sampleCount_;
+  unsigned long batchStartMs_;   // 送信待ちの最初のセンサー値の時刻（millis）
+  time_t batchStartEpoch_;       // 同（UNIX時刻、時刻が未確定の場合は0）
+
+  unsigned long flushIntervalMs_;
+  unsigned long healthIntervalMs_;
+  unsigned long lastHealthMs_;
+  unsigned long nextConnectMs_;
+  unsigned long backoffMs_;
+  bool started_;
+  bool overflowLogged_;          // 送信待ちの上限に達したことを記録済みか（送信で解除）
+
+  // 最後に送信した状態（変化の検出用）
+  ACMode publishedMode_;
+  bool publishedAutoStop_;
+  bool stateDirty_;
+
+  MqttStats stats_;
+
+  static MqttBridge* instance_;   // 受信コールバックから参照するインスタンス
+  static void onMessage(char* topic, uint8_t* payload, unsigned int length);
+
+  bool connect();
+  void handleCommand(const uint8_t* payload, unsigned int length);
+  void flushSamples();
+  void publishState();
+  void publishHealth();
+  bool publish(const char* suffix, size_t length, bool retained);
+  const char* topic(const char* suffix);
+};
+
+#endif // MQTT_BRIDGE_H
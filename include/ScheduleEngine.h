@@ -0,0 +1,150 @@
+/**
+ * ScheduleEngine.h
+ *
+ * カレンダー型スケジュール実行クラス
+ * 曜日・月を指定した時刻ルールに従ってエアコンのモードを切り替えます。
+ */
+
+#ifndef SCHEDULE_ENGINE_H
+#define SCHEDULE_ENGINE_H
+
+#include <Arduino.h>
+#include <time.h>
+#include "AirConditionerController.h"
+#include "TimeManager.h"
+
+/**
+ * スケジュールのルール（cron形式に近い指定）
+ * 例: 10〜6月の毎日23:00に停止
+ *   { ACMode::OFF, 23, 0, Schedule::EVERY_DAY, Schedule::monthRange(10, 6), true }
+ */
+struct ScheduleRule {
+  ACMode mode;          // 実行するモード（OFFで停止）
+  uint8_t hour;         // 時（0-23）
+  uint8_t minute;       // 分（0-59）
+  uint8_t daysOfWeek;   // 曜日マスク（bit0: 日曜 〜 bit6: 土曜）
+  uint16_t months;      // 月マスク（bit0: 1月 〜 bit11: 12月）
+  bool enabled;         // ルールの有効/無効
+};
+
+namespace Schedule {
+  constexpr uint8_t EVERY_DAY = 0x7F;
+  constexpr uint8_t WEEKDAYS = 0x3E;    // 月〜金
+  constexpr uint8_t WEEKENDS = 0x41;    // 土日
+  constexpr uint16_t ALL_MONTHS = 0x0FFF;
+
+  /**
+   * 月（1-12）のビット
+   */
+  constexpr uint16_t monthBit(int month) { return (uint16_t)(1u << (month - 1)); }
+
+  /**
+   * 月の範囲のマスクを作成（年をまたぐ範囲も可、例: 10月〜6月）
+   */
+  inline uint16_t monthRange(int from, int to) {
+    uint16_t mask = 0;
+    for (int m = from; ; m = m % 12 + 1) {
+      mask |= monthBit(m);
+      if (m == to) {
+        break;
+      }
+    }
+    return mask;
+  }
+}
+
+/**
+ * カレンダー型スケジュール実行クラス
+ *
+ * 主な機能:
+ * - 複数ルールのうち次に実行する時刻を1回だけ計算し、それまでは時刻比較のみ（O(1)）
+ * - 停電・再起動で実行しそびれたイベントは、猶予時間内なら起動後に1回だけ実行
+ * - 時刻が進んだ場合（NTP補正など）は、飛び越えたイベントのうち最新の1件のみ実行
+ * - 時刻が戻った場合は、実行済みのイベントを再実行しない
+ *
+ * 同じ時刻に複数のルールがある場合は、登録順にすべて実行します。
+ * 日付の計算は1日=86400秒を前提とします（サマータイムのない地域向け）。
+ */
+class ScheduleEngine {
+public:
+  static constexpr uint8_t MAX_RULES = 8;
+
+  /**
+   * コンストラクタ
+   * @param ac エアコンコントローラーの参照
+   * @param timeMgr 時刻管理クラスの参照
+   */
+  ScheduleEngine(AirConditionerController& ac, TimeManager& timeMgr);
+
+  /**
+   * ルールを追加
+   * @return ルールID、登録数上限の場合は-1
+   */
+  int addRule(const ScheduleRule& rule);
+
+  /**
+   * ルールの有効/無効を設定（次回実行時刻を再計算）
+   */
+  void setRuleEnabled(int ruleId, bool enabled);
+
+  /**
+   * ルールを取得
+   */
+  const ScheduleRule* getRule(int ruleId) const;
+
+  /**
+   * 実行しそびれたイベントを後から実行する猶予時間を設定（最大24時間）
+   * @param seconds 猶予時間（秒、デフォルト1時間）
+   */
+  void setCatchUpWindow(uint32_t seconds);
+
+  /**
+   * スケジュールを確認し、時刻になったルールを実行
+   * loop関数内で毎回呼び出してください（次回実行時刻までは時刻比較のみ）。
+   */
+  void update();
+
+  /**
+   * 次回の実行時刻（エポック秒、未計算・ルールなしの場合は0）
+   */
+  time_t getNextFireTime() const { return armed_ ? nextFire_ : 0; }
+
+  /**
+   * 最後に実行した時刻（エポック秒、未実行の場合は0）
+   */
+  time_t getLastFireTime() const { return lastFired_; }
+
+  /**
+   * 再起動前に最後に実行した時刻を復元（最初の update() より前に呼び出してください）
+   * 猶予時間内のイベントでも、この時刻までに実行済みのものは再起動後にもう一度実行しません。
+   */
+  void restoreLastFireTime(time_t lastFired);
+
+private:
+  static constexpr time_t SECONDS_PER_DAY = 86400;
+  static constexpr time_t CLOCK_BACK_TOLERANCE_SEC = 2;   // これ以上時刻が戻ったら再計算
+  static constexpr int MAX_SEARCH_DAYS = 400;             // 次回実行時刻の探索範囲（日）
+
+  AirConditionerController& ac_;
+  TimeManager& timeMgr_;
+
+  ScheduleRule rules_[MAX_RULES];
+  uint8_t ruleCount_;
+
+  bool armed_;              // 次回実行時刻が計算済みか
+  bool dirty_;              // ルール変更により再計算が必要か
+  time_t nextFire_;         // 次回実行時刻
+  time_t lastFired_;        // 最後に実行したイベントの時刻
+  time_t lastCheck_;        // 前回update()時の時刻（時刻の巻き戻り検出用）
+  time_t catchUpSec_;       // 実行しそびれたイベントの猶予時間
+
+  void arm(time_t after);
+  void fire(time_t eventTime);
+  time_t nextFireAfter(const ScheduleRule& rule, time_t after) const;
+  time_t latestFireBetween(const ScheduleRule& rule, time_t from, time_t to) const;
+  bool matchesDay(const ScheduleRule& rule, time_t candidate, int wday) const;
+  static time_t startOfDay(time_t t, int& wday);
+  static void printEpoch(const char* label, time_t t);
+};
+
+#endif // SCHEDULE_ENGINE_H
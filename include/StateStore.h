@@ -0,0 +1,95 @@
+/**
+ * StateStore.h
+ *
+ * 再起動をまたいで制御の状態（エアコンのモード・スケジュールの実行記録など）を引き継ぐための保存領域
+ * RTCメモリ（ソフトリセット・ウォッチドッグ・パニック後も保持）の2つの枠に交互に書き込み、
+ * 書き込み途中でリセットされても、もう一方の枠の前回の状態から復元できるようにします。
+ * 電源断に備えてNVSにもコピーしますが、フラッシュの書き換え回数を抑えるため、
+ * 重要な変化（モード・自動停止・スケジュールの実行）の時と、一定間隔ごとにだけ書き込みます。
+ *
+ * 保存する内容は呼び出し側の固定長の構造体（MAX_BYTES以下）で、このクラスは中身を解釈しません。
+ * 構造体の形式を変えた場合は version を変えてください（形式の違う記録は復元しません）。
+ */
+
+#ifndef STATE_STORE_H
+#define STATE_STORE_H
+
+#include <Arduino.h>
+
+/**
+ * 状態の保存の計測値
+ */
+struct StateStoreStats {
+  uint32_t commits;         // RTCメモリへの書き込み回数
+  uint32_t nvsWrites;       // NVSへの書き込み回数
+  uint32_t nvsFailures;     // NVSへの書き込みの失敗回数
+  uint32_t restoreUs;       // 起動時の復元にかかった時間（マイクロ秒）
+};
+
+class StateStore {
+public:
+  static constexpr size_t MAX_BYTES = 256;  // 保存できる構造体の大きさの上限
+
+  // 復元元
+  enum class Source : uint8_t {
+    NONE,   // 有効な記録なし（初回起動・形式の変更後）
+    RTC,    // RTCメモリ（ソフトリセット後）
+    NVS     // NVS（電源断後）
+  };
+
+  /**
+   * コンストラクタ
+   * @param nvsNamespace NVSの名前空間
+   * @param version 保存する構造体の形式の版数
+   * @param nvsIntervalMs 重要でない変化をNVSに書き込む最短の間隔
+   */
+  StateStore(const char* nvsNamespace, uint16_t version, unsigned long nvsIntervalMs);
+
+  /**
+   * 保存した状態を読み込む（RTCメモリ → NVS の順、setup関数内で1回呼び出してください）
+   * NVSから読み込んだ場合は、次回のソフトリセットに備えてRTCメモリにも書き戻します。
+   * @param data 読み込み先
+   * @param size 構造体の大きさ（保存時と異なる場合は復元しない）
+   * @return 復元元（NONE の場合 data は変更しない）
+   */
+  Source restore(void* data, size_t size);
+
+  /**
+   * 状態を記録（RTCメモリは毎回、NVSは durable の時か nvsIntervalMs ごと）
+   * 内容が前回と同じ場合は何もしません。
+   * @param durable true: 電源断でも失いたくない変化を含む（すぐにNVSにも書き込む）
+   */
+  void commit(const void* data, size_t size, bool durable);
+
+  /**
+   * 復元元を取得
+   */
+  Source getRestoreSource() const { return restoreSource_; }
+
+  /**
+   * 計測値を取得
+   */
+  const StateStoreStats& getStats() const { return stats_; }
+
+  /**
+   * 復元元の名前（ログ・メトリクス用: "none", "rtc", "nvs"）
+   */
+  static const char* sourceName(Source source);
+
+private:
+  const char* nvsNamespace_;
+  uint16_t version_;
+  unsigned long nvsIntervalMs_;
+
+  uint8_t activeSlot_;        // 最新の記録があるRTCメモリの枠（0/1）
+  uint32_t sequence_;         // 最新の記録の通し番号（0: 記録なし）
+  unsigned long lastNvsWrite_;
+  bool nvsPending_;           // RTCメモリの記録がNVSより新しい
+  bool durablePending_;       // NVSに未反映の重要な変化がある
+  Source restoreSource_;
+  StateStoreStats stats_;
+
+  bool writeNvs(uint8_t slot);
+};
+
+#endif // STATE_STORE_H
@@ -0,0 +1,161 @@
+/**
+ * TelemetryBuffer.h
+ *
+ * テレメトリ蓄積送信クラス
+ * センサー値を収集サーバーへHTTPで送信し、ネットワーク切断中はフラッシュに蓄積して
+ * 接続回復後にまとめて送信（バックフィル）します。
+ */
+
+#ifndef TELEMETRY_BUFFER_H
+#define TELEMETRY_BUFFER_H
+
+#include <Arduino.h>
+#include "HttpSession.h"
+#include "TimeManager.h"
+#include "EnvironmentSensor.h"
+#include "AirConditionerController.h"
+
+/**
+ * 1件分のテレメトリ（センサー値は100倍した整数）
+ */
+struct TelemetryRecord {
+  uint32_t time;            // UNIX時刻（時刻が未確定の場合は0）
+  int16_t temperature;
+  uint16_t humidity;
+  int16_t discomfortIndex;
+  uint8_t mode;             // ACMode
+};
+
+/**
+ * テレメトリ蓄積送信の計測値
+ */
+struct TelemetryStats {
+  uint32_t recordsAdded;          // 追加した件数
+  uint32_t recordsSent;           // 送信した件数
+  uint32_t recordsDropped;        // 蓄積の上限に達したため捨てた件数（古いものから）
+  uint32_t segmentsWritten;       // フラッシュへの書き込み回数
+  uint32_t uploads;               // 送信成功回数
+  uint32_t uploadFailures;        // 送信失敗回数
+  uint32_t bytesSent;             // 送信したボディのバイト数（圧縮後）
+  uint32_t rawBytesSent;          // 同（圧縮前の換算）
+  unsigned long lastUploadMs;     // 直近の送信にかかった時間
+  uint32_t lastBytesPerSec;       // 直近の送信のスループット（バイト/秒）
+  uint32_t lastRecordsPerSec;     // 直近の送信のスループット（件/秒）
+};
+
+/**
+ * テレメトリ蓄積送信クラス
+ *
+ * センサー値は SEGMENT_RECORDS 件ずつRAM上にまとめ、差分＋可変長整数で圧縮した「セグメント」にしてから送信します。
+ * - 接続中: flushInterval ごと（または SEGMENT_RECORDS 件に達した時）にセグメントをPOST
+ * - 切断中・送信失敗時: セグメントをフラッシュ（LittleFS）に1ファイルとして書き込む
+ *   （件数が少なくても MAX_HOLD_MS 経てば書き込み、電源断で失うのは最大 MAX_HOLD_MS ぶん）
+ * - 接続回復後: 古い順に複数のセグメントを1回のPOSTにまとめて送信し、送信済みのファイルを削除
+ *
+ * メモリ使用量は固定（RAM上のセグメント＋送信バッファ）で、フラッシュは最大 MAX_SEGMENTS ファイルのリングです。
+ * 上限に達した場合は最も古いセグメントを捨てます。切断中は SEGMENT_RECORDS 件ごと（または MAX_HOLD_MS ごと）に
+ * 1回しか書き込まないため、フラッシュの書き込み回数も抑えられます。
+ *
+ * 送信形式（Content-Type: application/octet-stream、セグメントの連結）:
+ *   'T' '1' 件数(1バイト) + 件数 ×（時刻, 温度, 湿度, DI, モード）
+ *   各値は直前のレコードとの差分をzigzag符号化した可変長整数（最初のレコードは0との差分）
+ */
+class TelemetryBuffer {
+public:
+  static constexpr uint8_t SEGMENT_RECORDS = 64;    // 1セグメントの件数（2秒間隔で約2分、5分間隔では約5時間）
+  static constexpr unsigned long MAX_HOLD_MS = 1800000;  // 切断中もRAMに溜めておく上限（30分、超えたら件数によらず蓄積）
+  static constexpr uint16_t MAX_SEGMENTS = 256;     // フラッシュに蓄積するセグメントの上限（約9時間ぶん）
+
+  /**
+   * コンストラクタ
+   * @param http 収集サーバーへの接続
+   * @param timeManager レコードの時刻に使う時刻管理クラスの参照
+   * @param path 送信先のパス（例: "/telemetry?device=living"）
+   */
+  TelemetryBuffer(HttpSession& http, TimeManager& timeManager, const char* path);
+
+  /**
+   * 接続中にセグメントを送信する間隔を設定（ミリ秒）
+   */
+  void setFlushInterval(unsigned long intervalMs) { flushIntervalMs_ = intervalMs; }
+
+  /**
+   * フラッシュをマウントし、蓄積済みのセグメントを確認（setup関数内で1回呼び出す）
+   * @return true: 成功, false: マウント失敗（蓄積せずに送信のみ行う）
+   */
+  bool begin();
+
+  /**
+   * センサー値を追加（無効な値は無視）
+   */
+  void add(const SensorData& data, ACMode mode);
+
+  /**
+   * 送信・蓄積・バックフィルを進める
+   * loop関数内で毎回呼び出してください。送信時はHTTPの応答までブロックします。
+   */
+  void update();
+
+  /**
+   * 未送信の件数（RAM上とフラッシュ上の合計）
+   */
+  uint32_t getPendingRecords() const { return count_ + storedRecords_; }
+
+  /**
+   * フラッシュに蓄積しているバイト数
+   */
+  uint32_t getStoredBytes() const { return storedBytes_; }
+
+  /**
+   * フラッシュに蓄積しているセグメント数
+   */
+  uint32_t getStoredSegments() const { return tailSeq_ - headSeq_; }
+
+  /**
+   * 計測値を取得
+   */
+  const TelemetryStats& getStats() const { return stats_; }
+
+private:
+  static constexpr size_t BATCH_SIZE = 4096;                // 送信バッファ（1回のPOSTの最大長）
+  static constexpr uint8_t HEADER_BYTES = 3;                // 'T' '1' 件数
+  static constexpr unsigned long DRAIN_INTERVAL_MS = 500;   // バックフィル中の送信間隔（loop()を占有しない）
+  static constexpr unsigned long BACKOFF_BASE_MS = 5000;    // 送信失敗後の初回の再試行待ち
+  static constexpr unsigned long BACKOFF_MAX_MS = 300000;   // 再試行待ちの上限
+
+  HttpSession& http_;
+  TimeManager& timeManager_;
+  const char* path_;
+
+  TelemetryRecord records_[SEGMENT_RECORDS];  // 送信前のレコード
+  uint8_t count_;
+  unsigned long segmentStartMs_;              // 最初のレコードを追加した時刻
+
+  uint8_t batch_[BATCH_SIZE];                 // セグメントの圧縮・送信用
+
+  bool mounted_;
+  uint32_t headSeq_;        // フラッシュ上の最も古いセグメントの番号
+  uint32_t tailSeq_;        // 次に書き込むセグメントの番号（head == tail なら空）
+  uint32_t storedRecords_;
+  uint32_t storedBytes_;
+
+  unsigned long flushIntervalMs_;
+  unsigned long nextUploadMs_;   // 送信失敗後、次に送信を試みる時刻
+  unsigned long lastDrainMs_;    // 直近のバックフィル送信の時刻
+  unsigned long backoffMs_;
+
+  TelemetryStats stats_;
+
+  bool canUpload() const;
+  void seal();
+  size_t encodeSegment(uint8_t* out);
+  void spill(const uint8_t* data, size_t length, uint8_t records);
+  void dropOldest();
+  void drainStored();
+  bool upload(const uint8_t* body, size_t length, uint32_t records);
+  void forget(size_t bytes, uint32_t records);
+  void recount();
+  static void segmentPath(uint32_t seq, char* path, size_t size);
+};
+
+#endif // TELEMETRY_BUFFER_H
@@ -0,0 +1,161 @@
+/**
+ * ThermalModel.h
+ *
+ * 部屋の熱モデルのオンライン学習と予測
+ * センサー値とエアコンのモードから部屋の熱の出入りを逐次最小二乗法（RLS）で学習し、
+ * 天気予報の最高・最低気温と組み合わせて室温を予測します。
+ * DIが閾値を超えるのを待たずに、予測した室温に合うモードを先に選ぶために使います。
+ */
+
+#ifndef THERMAL_MODEL_H
+#define THERMAL_MODEL_H
+
+#include <Arduino.h>
+#include "AirConditionerController.h"
+
+/**
+ * 熱モデルの計測値
+ */
+struct ThermalStats {
+  uint32_t samples;         // 学習したサンプル数
+  uint32_t skipped;         // モードの切り替えなどで捨てた区間の数
+  float stepErrorC;         // 1区間先の予測誤差（℃、二乗平均平方根の指数移動平均）
+  float horizonErrorC;      // 予測時間先の予測誤差（同）
+  uint32_t horizonChecks;   // 予測時間先の予測を答え合わせした回数
+  uint32_t anticipations;   // 予測で先回りしてモードを選んだ回数
+};
+
+/**
+ * 部屋の熱モデル
+ *
+ * 室温の変化（℃/時）を次の式で表し、係数 θ を学習します。
+ *   dT/dt = θ0 (T外 - T) + θ1 [冷房20度] + θ2 [除湿] + θ3 [自動] + θ4
+ * θ0 は外気との熱の通りやすさ、θ1〜θ3 はモードごとのエアコンの効き、θ4 は室内の発熱・日射です。
+ * 外気温は天気予報の最高・最低気温から日変化を仮定して求めます（outdoorTemperature()）。
+ *
+ * 係数の数が固定のため、メモリは一定（約200バイト）で、1サンプルの計算量も一定です。
+ * 忘却係数で古いサンプルの重みを下げ、季節・家具の配置などの変化に追従します。
+ */
+class ThermalModel {
+public:
+  static constexpr uint8_t PARAMS = 5;
+
+  /**
+   * 学習した状態（再起動後に学習を引き継ぐために StateStore に保存する分）
+   * 学習中の区間・答え合わせ待ちの予測は millis() 基準のため含みません。
+   */
+  struct Snapshot {
+    float theta[PARAMS];
+    float p[PARAMS][PARAMS];
+    ThermalStats stats;
+  };
+
+  /**
+   * コンストラクタ
+   * @param sampleIntervalSec 学習する区間の長さ（秒、センサーの分解能0.1℃に対して室温が十分に変化する長さ）
+   * @param horizonSec どれだけ先を予測してモードを選ぶか（秒）
+   */
+  ThermalModel(uint32_t sampleIntervalSec, uint32_t horizonSec);
+
+  /**
+   * 学習した係数を捨てて初期状態に戻す
+   */
+  void reset();
+
+  /**
+   * センサー値を渡して学習（制御間隔ごとに呼び出す）
+   * 同じモードが sampleIntervalSec 続いた区間ごとに係数を更新します。
+   * @param nowMs 現在時刻（millis）
+   * @param temperature 室温（0.01℃単位、SensorData と同じ）
+   * @param mode 現在のエアコンのモード（ACMode::NONE の間は学習しない）
+   * @param outdoorNow 現在の外気温（℃）
+   * @param outdoorLater horizonSec 後の外気温（℃、予測の答え合わせ用）
+   */
+  void update(unsigned long nowMs, int16_t temperature, ACMode mode, float outdoorNow, float outdoorLater);
+
+  /**
+   * 予測に使えるだけ学習したか（サンプル数と、予測時間先の予測誤差で判定）
+   */
+  bool isReady() const;
+
+  /**
+   * 同じモードを続けた場合の室温を予測（係数の推定・予測は実数で計算します）
+   * @param temperature 現在の室温（℃）
+   * @param seconds 何秒後を予測するか
+   * @return 予測した室温（℃）
+   */
+  float predict(float temperature, ACMode mode, float outdoorNow, float outdoorLater, uint32_t seconds) const;
+
+  /**
+   * 予測した室温でもう一度モードを判定し、現在の判定より強く冷やす必要があればそのモードを返す
+   * 予測に使えない間（isReady() が false）や、冷やす必要がない場合は reactive をそのまま返します。
+   * @param reactive 現在の室温での判定結果（determineOptimalMode()）
+   * @param temperature 室温（0.01℃単位）
+   * @param humidity 湿度（0.01%単位）
+   * @param current 現在のエアコンのモード（このモードを続けた場合を予測する）
+   */
+  ACMode anticipate(AirConditionerController& ac, ACMode reactive, int16_t temperature, int16_t humidity,
+                    ACMode current, float outdoorNow, float outdoorLater);
+
+  /**
+   * 天気予報の最高・最低気温から、指定した時刻の外気温を推定
+   * 5時に最低、14時に最高となる日変化（余弦曲線）を仮定します。
+   * @param hour 現地時刻（0〜24、小数で分を表す。24以上は翌日の同じ時刻として扱う）
+   */
+  static float outdoorTemperature(float tempMax, float tempMin, float hour);
+
+  /**
+   * 学習した係数（θ0〜θ4、℃/時）
+   */
+  float coefficient(uint8_t index) const { return index < PARAMS ? theta_[index] : 0.0f; }
+
+  /**
+   * 予測時間（秒）
+   */
+  uint32_t getHorizonSec() const { return horizonSec_; }
+
+  /**
+   * 計測値を取得
+   */
+  const ThermalStats& getStats() const { return stats_; }
+
+  /**
+   * 学習した状態を取得
+   */
+  void save(Snapshot& out) const;
+
+  /**
+   * 保存した学習の状態を復元（学習中の区間は捨てて、次の update() から測り直す）
+   * @return false: 値が壊れている（数値でない係数を含む）ため復元しなかった
+   */
+  bool restore(const Snapshot& snapshot);
+
+private:
+  uint32_t sampleMs_;
+  uint32_t horizonSec_;
+
+  // 逐次最小二乗法の状態
+  float theta_[PARAMS];          // 係数
+  float p_[PARAMS][PARAMS];      // 係数の誤差共分散
+
+  // 学習中の区間の始点
+  bool hasStart_;
+  unsigned long startMs_;
+  float startTemperature_;
+  float startOutdoor_;
+  ACMode startMode_;
+
+  // 答え合わせ待ちの予測（予測時間先）
+  bool hasPending_;
+  unsigned long pendingMs_;
+  float pendingTemperature_;
+  ACMode pendingMode_;
+
+  ThermalStats stats_;
+
+  void learn(const float (&x)[PARAMS], float y, float hours);
+  void regressors(float temperature, ACMode mode, float outdoor, float (&x)[PARAMS]) const;
+  void restart(unsigned long nowMs, float temperature, ACMode mode, float outdoor);
+};
+
+#endif // THERMAL_MODEL_H
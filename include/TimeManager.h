@@ -15,9 +15,10 @@
  * 時刻管理クラス
  *
  * 主な機能:
- * - NTPサーバーからの時刻同期
+ * - NTPサーバーからの時刻同期（非同期、1時間ごとに再同期してドリフトを計測）
+ * - リセット・ディープスリープ後もRTCメモリの時刻から即座に動作
  * - 日本時間（JST）への自動変換
- * - 現在時刻の取得
+ * - 現在時刻の取得（1分ごとに更新するキャッシュから、ブロックしない）
  */
 class TimeManager {
 public:
@@ -30,33 +31,104 @@ public:
   TimeManager(const char* ntpServer, long gmtOffsetSec, int daylightOffsetSec);
 
   /**
-   * NTPサーバーから時刻を同期
-   * @return true: 同期成功, false: 同期失敗
+   * 時刻の同期元
    */
-  bool syncTime();
+  enum class TimeSource {
+    NONE,      // 時刻不明
+    RESTORED,  // リセット前の時刻をRTCメモリから復元（NTP同期待ち）
+    NTP        // NTPで同期済み
+  };
 
   /**
-   * 現在の時刻情報を取得
+   * 同期完了時の通知関数
+   * @param context onSync() で指定したポインタ
+   */
+  typedef void (*SyncCallback)(void* context);
+
+  /**
+   * 初期化（setup関数の最初に呼び出す）
+   * タイムゾーンを設定してバックグラウンドでNTP同期を開始し、
+   * システム時刻が失われている場合はRTCメモリに保存した時刻を復元します。
+   * ネットワーク接続を待たずに戻ります。
+   */
+  void begin();
+
+  /**
+   * NTP同期をすぐに再実行（完了を待たない）
+   * WiFi再接続時などに呼び出します。
+   */
+  void startSync();
+
+  /**
+   * 同期完了の処理（loop関数内で毎回呼び出してください）
+   * 同期完了時のキャッシュ更新・ドリフト計測・通知はここで行われます。
+   */
+  void update();
+
+  /**
+   * 同期完了時の通知先を設定
+   */
+  void onSync(SyncCallback callback, void* context = nullptr);
+
+  /**
+   * 現在の時刻の同期元を取得
+   */
+  TimeSource getTimeSource() const { return source_; }
+
+  /**
+   * NTP同期回数を取得
+   */
+  uint32_t getSyncCount() const { return syncCount_; }
+
+  /**
+   * 直近の同期で補正された時刻のずれ（ミリ秒、正: 時計が遅れていた）
+   * 前回のNTP同期時刻からmillis()で進めた予測値との差です（初回同期では0）。
+   */
+  long getLastDriftMs() const { return lastDriftMs_; }
+
+  /**
+   * 直近の同期で計測したドリフト率（ppm）
+   */
+  float getDriftPpm() const { return driftPpm_; }
+
+  /**
+   * 時刻が有効（NTP同期済み）かどうか
+   * 以下の時刻取得関数は、これがtrueの時のみ意味のある値を返します。
+   */
+  bool isTimeValid();
+
+  /**
+   * 現在の時刻情報を取得（キャッシュから、ブロックしない）
    * @param timeinfo 時刻情報を格納する構造体（出力）
-   * @return true: 取得成功, false: 取得失敗
+   * @return true: 取得成功, false: 時刻未同期
    */
   bool getCurrentTime(struct tm& timeinfo);
 
+  /**
+   * 現在の時刻情報への参照を取得（キャッシュから、ブロックしない）
+   * isTimeValid() がfalseの場合は内容は未定義です。
+   */
+  const struct tm& now();
+
+  /**
+   * 現在のエポック秒を取得（キャッシュから、ブロックしない）
+   * @return エポック秒、時刻未同期時は0
+   */
+  time_t epoch();
+
   /**
    * 現在の時（0-23）を取得
-   * @return 時（0-23）、取得失敗時は -1
    */
   int getCurrentHour();
 
   /**
    * 現在の月（1-12）を取得
-   * @return 月（1-12）、取得失敗時は -1
    */
   int getCurrentMonth();
 
   /**
    * 7〜9月（夏季）かどうかを判定
-   * @return true: 7〜9月, false: それ以外
+   * @return true: 7〜9月, false: それ以外（時刻未同期時もfalse）
    */
   bool isSummerSeason();
 
@@ -68,14 +140,59 @@ public:
   /**
    * フォーマットされた日時文字列を取得
    * @param format フォーマット文字列（strftime形式、例: "%Y-%m-%d %H:%M"）
-   * @return フォーマットされた日時文字列、取得失敗時は空文字列
+   * @return フォーマットされた日時文字列、時刻未同期時は空文字列
    */
   String getFormattedTime(const char* format);
 
+  /**
+   * キャッシュを破棄して次回アクセス時にシステム時刻から読み直す
+   * NTP同期などで時刻が飛んだ場合に呼び出します。
+   */
+  void invalidateCache();
+
 private:
+  static constexpr time_t VALID_EPOCH_MIN = 1577836800;   // 2020-01-01 これより前は未同期とみなす
+  static constexpr unsigned long INVALID_RETRY_MS = 1000;  // 未同期時にシステム時刻を確認する間隔
+  static constexpr uint32_t RESYNC_INTERVAL_MS = 3600000;  // バックグラウンド再同期の間隔（1時間）
+
   const char* ntpServer_;         // NTPサーバーアドレス
   long gmtOffsetSec_;             // GMTオフセット（秒）
   int daylightOffsetSec_;         // サマータイムオフセット（秒）
+
+  // 時刻キャッシュ
+  // 分の境界でのみシステム時刻から暦（struct tm）を作り直し、
+  // それ以外はmillis()を基準に秒だけを進める
+  struct tm cached_;               // キャッシュした暦（tm_secは随時更新）
+  bool timeValid_;                 // キャッシュが有効か
+  time_t baseEpoch_;               // 基準時刻（エポック秒）
+  unsigned long baseMillis_;       // 基準時刻に対応するmillis()
+  time_t nextMinuteEpoch_;         // 次に暦を作り直す時刻（次の分の0秒）
+  unsigned long lastCheckMillis_;  // 未同期時に最後にシステム時刻を確認した時刻
+
+  // NTP同期状態
+  TimeSource source_;
+  uint32_t syncCount_;
+  long lastDriftMs_;
+  float driftPpm_;
+  // ドリフト計測の基準（NTP同期の時だけ更新する。キャッシュの基準は分ごとにシステム時刻から
+  // 作り直され、同期直後に読み直すと補正後の時刻になってしまうため別に持つ）
+  unsigned long lastSyncMillis_;   // 前回同期時のmillis()
+  int64_t lastSyncEpochMs_;        // 前回同期時の時刻（エポックミリ秒）
+  SyncCallback syncCallback_;
+  void* syncContext_;
+
+  // SNTPタスクから設定される値（update()で処理する）
+  volatile bool syncPending_;
+  volatile unsigned long syncMillis_;  // 同期した瞬間のmillis()
+  volatile int64_t syncEpochMs_;       // 同期後の時刻（エポックミリ秒）
+
+  static TimeManager* instance_;   // SNTPコールバックから参照するインスタンス
+  static void onSntpSync(struct timeval* tv);
+
+  void refresh();
+  void reloadFromSystem();
+  void saveToRtc(time_t epoch);
+  bool restoreFromRtc();
 };
 
 #endif // TIME_MANAGER_H
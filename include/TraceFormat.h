@@ -0,0 +1,380 @@
+/**
+ * TraceFormat.h
+ *
+ * 制御ループのトレース（入力の記録）の形式
+ * 実機の TraceRecorder が書き込み、PC上の再生ツール（sim/TraceReplay.cpp）が読み込みます。
+ * Arduinoに依存しないため、どちらからも同じ定義を使います。
+ *
+ * ファイル: "ACTR" + 版数(1バイト) + レコードの並び
+ * レコード: 種類(1バイト) + 時刻 + 内容
+ * - 時刻はSTARTのみ起動からのミリ秒、それ以外は直前のレコードからの差分（ミリ秒）
+ * - 整数は可変長（7ビットずつ、最上位ビットが継続）、符号付きはzigzag符号化
+ * - センサー値は直前のセンサー値との差分（ファイル先頭・STARTの直後は0との差分）
+ */
+
+#ifndef TRACE_FORMAT_H
+#define TRACE_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+namespace Trace {
+
+  constexpr uint8_t VERSION = 1;
+  constexpr size_t FILE_HEADER_BYTES = 5;   // "ACTR" + 版数
+  constexpr size_t MAX_RECORD_BYTES = 64;   // 1レコードの最大長
+  constexpr size_t MAX_BUILD = 32;          // ファームウェアの識別文字列の最大長（終端を含む）
+
+  /**
+   * レコードの種類
+   */
+  enum Type : uint8_t {
+    START = 1,      // 記録開始（起動ごと・ファイルごと）
+    CLOCK = 2,      // 時刻（同期・補正で予測とずれた時）
+    SENSOR = 3,     // センサー値（読み取りごと）
+    IR = 4,         // 赤外線の受信
+    WEATHER = 5,    // 天気予報（取得ごと）
+    WIFI = 6,       // WiFiの接続・切断
+    COMMAND = 7,    // 外部（Web API・MQTT）からの操作
+    DECISION = 8    // 制御の判定結果（再生結果との照合用）
+  };
+
+  /**
+   * 操作の送信元
+   */
+  enum Source : uint8_t {
+    SOURCE_WEB = 1,
+    SOURCE_MQTT = 2,
+    SOURCE_RESTORE = 3   // 起動時に StateStore から復元した状態（モードは送信せずに復元）
+  };
+
+  /**
+   * 操作の内容
+   */
+  enum Command : uint8_t {
+    COMMAND_MODE = 0,       // value: ACMode
+    COMMAND_AUTO_STOP = 1   // value: 0/1
+  };
+
+  /**
+   * 1件分のレコード（種類に応じて使う項目が異なる）
+   */
+  struct Record {
+    Type type;
+    uint64_t millis;            // 起動からのミリ秒（読み込み時は49日の桁あふれを補正）
+
+    // START
+    uint32_t bootId;            // 起動ごとに異なる値
+    uint32_t sequence;          // 同じ起動の中でのファイルの通し番号
+    char build[MAX_BUILD];      // ファームウェアの識別文字列
+
+    // START・CLOCK
+    uint32_t epoch;             // UNIX時刻（時刻不明の場合は0）
+
+    // SENSOR・WEATHER
+    bool valid;
+    int32_t temperature;        // 温度×100
+    int32_t humidity;           // 湿度×100
+
+    // IR
+    uint16_t protocol;
+    uint16_t bits;
+    uint64_t value;
+
+    // WEATHER
+    int16_t tempMax;            // ×10
+    int16_t tempMin;            // ×10
+    int16_t weatherCode;
+
+    // WIFI
+    bool connected;
+
+    // COMMAND・DECISION（DECISIONはmodeのみ）
+    uint8_t source;
+    uint8_t command;
+    uint8_t mode;               // ACMode、またはCOMMAND_AUTO_STOPの値
+  };
+
+  /**
+   * 新しいレコードを作成（すべての項目を0で初期化）
+   */
+  inline Record make(Type type, uint64_t millis) {
+    Record record;
+    memset(&record, 0, sizeof(record));
+    record.type = type;
+    record.millis = millis;
+    return record;
+  }
+
+  /**
+   * レコードをバッファに書き込むクラス
+   * バッファは呼び出し側が用意し、書き出した後に clear() で空にして使い続けます。
+   */
+  class Writer {
+  public:
+    Writer(uint8_t* buffer, size_t capacity)
+      : buffer_(buffer), capacity_(capacity), length_(0),
+        lastMillis_(0), lastTemperature_(0), lastHumidity_(0) {}
+
+    const uint8_t* data() const { return buffer_; }
+    size_t length() const { return length_; }
+
+    /**
+     * 次のレコードを書き込める空きがあるか
+     */
+    bool hasRoom() const { return capacity_ - length_ >= MAX_RECORD_BYTES; }
+
+    /**
+     * バッファを空にする（時刻・センサー値の差分の基準は保持）
+     */
+    void clear() { length_ = 0; }
+
+    /**
+     * ファイルの先頭（STARTの前に書き込む）
+     */
+    void fileHeader() {
+      put('A'); put('C'); put('T'); put('R'); put(VERSION);
+    }
+
+    /**
+     * レコードを書き込む
+     * @return false: 空きが足りない（hasRoom() を確認してから呼び出す）
+     */
+    bool write(const Record& r) {
+      if (!hasRoom()) {
+        return false;
+      }
+      put(r.type);
+      if (r.type == START) {
+        putVarint(r.millis);
+        lastTemperature_ = 0;
+        lastHumidity_ = 0;
+      } else {
+        putVarint((uint32_t)(r.millis - lastMillis_));
+      }
+      lastMillis_ = r.millis;
+
+      switch (r.type) {
+        case START: {
+          putVarint(r.bootId);
+          putVarint(r.sequence);
+          putVarint(r.epoch);
+          size_t len = strnlen(r.build, MAX_BUILD - 1);
+          put((uint8_t)len);
+          for (size_t i = 0; i < len; i++) {
+            put((uint8_t)r.build[i]);
+          }
+          break;
+        }
+        case CLOCK:
+          putVarint(r.epoch);
+          break;
+        case SENSOR:
+          put(r.valid ? 1 : 0);
+          if (r.valid) {
+            putSigned(r.temperature - lastTemperature_);
+            putSigned(r.humidity - lastHumidity_);
+            lastTemperature_ = r.temperature;
+            lastHumidity_ = r.humidity;
+          }
+          break;
+        case IR:
+          putVarint(r.protocol);
+          putVarint(r.bits);
+          putVarint(r.value);
+          break;
+        case WEATHER:
+          put(r.valid ? 1 : 0);
+          putSigned(r.tempMax);
+          putSigned(r.tempMin);
+          putSigned(r.weatherCode);
+          break;
+        case WIFI:
+          put(r.connected ? 1 : 0);
+          break;
+        case COMMAND:
+          put(r.source);
+          put(r.command);
+          put(r.mode);
+          break;
+        case DECISION:
+          put(r.mode);
+          break;
+      }
+      return true;
+    }
+
+  private:
+    uint8_t* buffer_;
+    size_t capacity_;
+    size_t length_;
+    uint64_t lastMillis_;
+    int32_t lastTemperature_;
+    int32_t lastHumidity_;
+
+    void put(uint8_t b) { buffer_[length_++] = b; }
+
+    void putVarint(uint64_t v) {
+      while (v >= 0x80) {
+        put((uint8_t)(v | 0x80));
+        v >>= 7;
+      }
+      put((uint8_t)v);
+    }
+
+    void putSigned(int32_t v) {
+      putVarint(((uint32_t)v << 1) ^ (uint32_t)(v >> 31));
+    }
+  };
+
+  /**
+   * レコードを読み込むクラス
+   */
+  class Reader {
+  public:
+    Reader(const uint8_t* data, size_t length)
+      : data_(data), length_(length), pos_(0), error_(false),
+        millis_(0), lastTemperature_(0), lastHumidity_(0) {}
+
+    /**
+     * ファイルの先頭を確認
+     * @return false: トレースのファイルではない、または版数が異なる
+     */
+    bool readHeader() {
+      if (length_ < FILE_HEADER_BYTES || memcmp(data_, "ACTR", 4) != 0 || data_[4] != VERSION) {
+        error_ = true;
+        return false;
+      }
+      pos_ = FILE_HEADER_BYTES;
+      return true;
+    }
+
+    /**
+     * 次のレコードを読み込む
+     * @return false: 終端、または壊れている（error() で区別）
+     */
+    bool next(Record& r) {
+      if (pos_ >= length_ || error_) {
+        return false;
+      }
+      size_t start = pos_;
+      uint8_t type = get();
+      r = make((Type)type, 0);
+      if (type == START) {
+        millis_ = getVarint();
+        lastTemperature_ = 0;
+        lastHumidity_ = 0;
+      } else {
+        millis_ += (uint32_t)getVarint();
+      }
+      r.millis = millis_;
+
+      switch (type) {
+        case START: {
+          r.bootId = (uint32_t)getVarint();
+          r.sequence = (uint32_t)getVarint();
+          r.epoch = (uint32_t)getVarint();
+          uint8_t len = get();
+          for (uint8_t i = 0; i < len; i++) {
+            uint8_t c = get();
+            if (i < MAX_BUILD - 1) {
+              r.build[i] = (char)c;
+            }
+          }
+          break;
+        }
+        case CLOCK:
+          r.epoch = (uint32_t)getVarint();
+          break;
+        case SENSOR:
+          r.valid = get() != 0;
+          if (r.valid) {
+            lastTemperature_ += getSigned();
+            lastHumidity_ += getSigned();
+            r.temperature = lastTemperature_;
+            r.humidity = lastHumidity_;
+          }
+          break;
+        case IR:
+          r.protocol = (uint16_t)getVarint();
+          r.bits = (uint16_t)getVarint();
+          r.value = getVarint();
+          break;
+        case WEATHER:
+          r.valid = get() != 0;
+          r.tempMax = (int16_t)getSigned();
+          r.tempMin = (int16_t)getSigned();
+          r.weatherCode = (int16_t)getSigned();
+          break;
+        case WIFI:
+          r.connected = get() != 0;
+          break;
+        case COMMAND:
+          r.source = get();
+          r.command = get();
+          r.mode = get();
+          break;
+        case DECISION:
+          r.mode = get();
+          break;
+        default:
+          error_ = true;
+      }
+
+      if (error_) {
+        // 途中で切れたレコード（書き込み中の電源断など）は読まない
+        pos_ = start;
+        return false;
+      }
+      return true;
+    }
+
+    /**
+     * 壊れたデータ・未知のレコードで読み込みを中断したか
+     */
+    bool error() const { return error_; }
+
+    /**
+     * 読み込んだ位置（バイト）
+     */
+    size_t position() const { return pos_; }
+
+  private:
+    const uint8_t* data_;
+    size_t length_;
+    size_t pos_;
+    bool error_;
+    uint64_t millis_;
+    int32_t lastTemperature_;
+    int32_t lastHumidity_;
+
+    uint8_t get() {
+      if (pos_ >= length_) {
+        error_ = true;
+        return 0;
+      }
+      return data_[pos_++];
+    }
+
+    uint64_t getVarint() {
+      uint64_t v = 0;
+      for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t b = get();
+        v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+          return v;
+        }
+      }
+      error_ = true;
+      return 0;
+    }
+
+    int32_t getSigned() {
+      uint32_t v = (uint32_t)getVarint();
+      return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+    }
+  };
+}
+
+#endif // TRACE_FORMAT_H
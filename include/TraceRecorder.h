@@ -0,0 +1,139 @@
+/**
+ * TraceRecorder.h
+ *
+ * 制御ループのトレース記録クラス
+ * ループが使う入力（センサー値・時刻・赤外線の受信・天気予報・WiFiの接続状態・外部からの操作）と
+ * 制御の判定結果をフラッシュに記録します。PC上の再生ツールで同じ制御コードに流し直せます。
+ */
+
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <Arduino.h>
+#include "TraceFormat.h"
+#include "TimeManager.h"
+#include "WeatherForecast.h"
+#include "EnvironmentSensor.h"
+#include "AirConditionerController.h"
+
+/**
+ * トレース記録の計測値
+ */
+struct TraceStats {
+  uint32_t records;          // 記録した件数
+  uint32_t bytesWritten;     // フラッシュに書き込んだバイト数
+  uint32_t flashWrites;      // フラッシュへの書き込み回数
+  uint32_t fileSwitches;     // ファイルを切り替えた回数
+  uint32_t writeErrors;      // 書き込みに失敗した回数（失敗した分は捨てる）
+};
+
+/**
+ * 制御ループのトレース記録クラス
+ *
+ * 形式は TraceFormat.h を参照してください。レコードはRAM上のバッファにまとめ、
+ * バッファが一杯になった時か FLUSH_INTERVAL_MS ごとにフラッシュへ追記します（書き込み回数を抑える）。
+ *
+ * フラッシュは /trace/0.bin・/trace/1.bin の2ファイルのリングで、1ファイルが MAX_FILE_BYTES に
+ * 達したらもう一方を消して書き始めます。起動時も新しいファイルから書き始めるため、
+ * 直前の起動（クラッシュ前など）の記録がもう一方のファイルに残ります。
+ * ファイルは Web API の /trace/0.bin・/trace/1.bin から取得できます（未書き込みの分は含まない）。
+ *
+ * 時刻は毎回は記録せず、millis()から予測した時刻とずれた時（NTP同期など）だけ記録します。
+ */
+class TraceRecorder {
+public:
+  static constexpr uint32_t MAX_FILE_BYTES = 192 * 1024;   // 1ファイルの上限（センサー値のみで約18時間ぶん）
+
+  /**
+   * コンストラクタ
+   * @param timeManager 時刻を記録する時刻管理クラスの参照
+   * @param weather 取得ごとに記録する天気予報クラスの参照
+   */
+  TraceRecorder(TimeManager& timeManager, WeatherForecast& weather);
+
+  /**
+   * フラッシュをマウントして記録を開始（setup関数内で1回呼び出す）
+   * @return true: 成功, false: マウント失敗（記録しない）
+   */
+  bool begin();
+
+  /**
+   * 時刻・天気予報の変化の記録と、定期的なフラッシュへの書き込み
+   * loop関数内で毎回呼び出してください。
+   */
+  void update();
+
+  /**
+   * センサー値を記録（読み取りごと）
+   * @param readMs 読み取りを始めた時刻（loop()が制御間隔の判定に使う millis() の値。再生時も同じ判定になる）
+   */
+  void recordSensor(const SensorData& data, unsigned long readMs);
+
+  /**
+   * 赤外線の受信を記録
+   */
+  void recordIR(uint16_t protocol, uint16_t bits, uint64_t value);
+
+  /**
+   * WiFiの接続・切断を記録
+   */
+  void recordWiFi(bool connected);
+
+  /**
+   * 外部（Web API・MQTT）からの操作を記録
+   * @param value COMMAND_MODEはACMode、COMMAND_AUTO_STOPは0/1
+   */
+  void recordCommand(Trace::Source source, Trace::Command command, uint8_t value);
+
+  /**
+   * 制御の判定結果を記録
+   */
+  void recordDecision(ACMode mode);
+
+  /**
+   * バッファの内容をフラッシュに書き込む
+   */
+  void flush();
+
+  /**
+   * 記録中かどうか
+   */
+  bool isRecording() const { return recording_; }
+
+  /**
+   * 計測値を取得
+   */
+  const TraceStats& getStats() const { return stats_; }
+
+private:
+  static constexpr size_t BUFFER_SIZE = 1024;
+  static constexpr unsigned long FLUSH_INTERVAL_MS = 60000;   // 書き込みの最大間隔（電源断で失う記録の上限）
+
+  TimeManager& timeManager_;
+  WeatherForecast& weather_;
+
+  uint8_t buffer_[BUFFER_SIZE];
+  Trace::Writer writer_;
+
+  bool recording_;
+  uint8_t fileIndex_;           // 書き込み中のファイル（0/1）
+  uint32_t sequence_;           // ファイルの通し番号（起動をまたいで増加）
+  uint32_t bootId_;
+  uint32_t fileBytes_;          // 書き込み中のファイルの長さ（バッファ分を含まない）
+  bool truncatePending_;        // 次の書き込みでファイルを作り直すか
+  unsigned long firstPendingMs_; // バッファの最初のレコードの時刻
+
+  bool clockKnown_;             // 時刻を記録済みか
+  uint32_t lastEpoch_;          // 最後に記録した時刻
+  unsigned long lastEpochMs_;   // 同じく millis()
+  uint32_t weatherVersion_;     // 最後に記録した天気予報の版（getDataVersion()）
+
+  TraceStats stats_;
+
+  bool append(const Trace::Record& record);
+  void startFile();
+  uint32_t readSequence(uint8_t index);
+  static void filePath(uint8_t index, char* path, size_t size);
+};
+
+#endif // TRACE_RECORDER_H
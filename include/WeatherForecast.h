@@ -2,8 +2,10 @@
 #define WEATHER_FORECAST_H
 
 #include <Arduino.h>
-#include <HTTPClient.h>
 #include <ArduinoJson.h>
+#include "HttpSession.h"
+#include <atomic>
+#include <time.h>
 
 // 天気予報データ構造体
 struct WeatherData {
@@ -13,36 +15,163 @@ struct WeatherData {
   int weatherCode;           // 天気コード
   String weatherString;      // 天気の文字列表現
   unsigned long lastUpdate;  // 最終更新時刻 (millis)
+  time_t fetchedAt;          // 取得時刻（エポック秒、時刻未同期時は0）
+};
+
+// 再起動後に引き継ぐ天気予報（日次の最高・最低気温と天気。NVSキャッシュ・StateStore に保存）
+struct WeatherSnapshot {
+  float tempMax;
+  float tempMin;
+  int32_t weatherCode;
+  uint32_t fetchedAt;  // 取得時刻（エポック秒）
+};
+
+// 時間別予報の1時間分（固定小数点から変換した値）
+struct HourlySample {
+  float temperature;      // 気温 (°C)
+  float humidity;         // 相対湿度 (%)
+  float discomfortIndex;  // 不快指数（取得時に計算済み）
+};
+
+// 時間別予報（48時間分）
+// JsonDocumentを保持せず、1/100単位のint16固定小数点で固定長配列に格納する（約300バイト）
+struct HourlyForecast {
+  static constexpr uint8_t HOURS = 48;             // 今日0時から48時間分
+  static constexpr int16_t MISSING = INT16_MIN;    // 欠損値
+
+  int16_t temperature[HOURS];      // 気温 (0.01°C単位)
+  int16_t humidity[HOURS];         // 相対湿度 (0.01%単位)
+  int16_t discomfortIndex[HOURS];  // 不快指数 (0.01単位)
+  uint8_t count;                   // 格納済みの時間数
+  uint16_t startYear;              // インデックス0の日付（予報初日）
+  uint8_t startMonth;
+  uint8_t startDay;
+};
+
+// 天気予報取得の計測値
+struct WeatherFetchStats {
+  uint32_t fetchCount;          // 取得試行回数
+  uint32_t failureCount;        // 失敗回数
+  unsigned long lastFetchMs;    // 直近の取得所要時間（接続〜パース完了）
+  unsigned long lastParseUs;    // 直近のJSONパース時間
+  uint32_t lastParseHeapBytes;  // 直近のパースで使用したヒープ量
+  int lastPayloadBytes;         // 直近のレスポンスボディのバイト数
 };
 
 // 天気予報管理クラス
 class WeatherForecast {
 public:
-  // コンストラクタ
-  WeatherForecast(float latitude, float longitude);
+  // コンストラクタ（httpはapi.open-meteo.com向けの共有セッション）
+  WeatherForecast(HttpSession& http, float latitude, float longitude);
+
+  // NVSに保存された前回の天気予報を復元（WiFi接続前に呼び出し可能）
+  bool restoreCache();
+
+  // 保存用の天気予報を取得（未取得・取得時刻不明・前日以前の場合は false）
+  bool getSnapshot(WeatherSnapshot& out) const;
+
+  // 保存した天気予報を復元（restoreCache() と同じく、次回の取得までの表示・予測用）
+  // @return false: 取得時刻が不明、または今日以外に取得した予報のため破棄した
+  bool restoreSnapshot(const WeatherSnapshot& snapshot);
 
-  // 初期化（起動時の天気予報取得）
+  // 取得タスクを開始し、次の update() で初回の取得を要求する（取得の完了は待たない）
+  // @return false: タスクを作成できなかった（以降の取得は update() 内で同期的に行う）
   bool begin();
 
-  // 定期更新チェック（1時間ごとに更新）
+  // 定期更新チェック（成功時は1時間ごと、失敗時はバックオフして再試行）
+  // HTTP取得とパースは取得タスクで行い、ここでは要求と結果の反映だけを行う（ブロックしない）
   void update();
 
-  // 最新の天気予報データを取得
+  // 取得タスクで取得中かどうか（結果は次の update() で反映される）
+  bool isFetching() const { return fetching_; }
+
+  // ネットワーク復帰時に呼び出す: 取得失敗中ならバックオフを待たずに再取得する
+  void requestRefresh();
+
+  // 最新の天気予報データを取得（前日以前に取得した予報は isValid = false）
   WeatherData getData() const;
 
+  // getData() の内容の版（取得の完了・復元・日付による無効化のたびに増える）
+  // 取得回数（fetchCount）は要求時に増えるため、表示の更新判定にはこちらを使う
+  uint32_t getDataVersion() const { return dataVersion_; }
+
+  // 時間別予報を取得（hourIndex: 予報初日0時からの経過時間、O(1)）
+  // @return false: 範囲外または欠損
+  bool getHourly(uint8_t hourIndex, HourlySample& out) const;
+
+  // 指定日時に対応する時間インデックスを取得（範囲外は-1）
+  int hourIndexFor(const struct tm& timeinfo) const;
+
+  // 格納済みの時間別予報の時間数を取得
+  uint8_t getHourlyCount() const { return hourly_.count; }
+
+  // 取得の計測値を取得
+  const WeatherFetchStats& getFetchStats() const { return stats_; }
+
+  // 連続失敗回数を取得
+  uint8_t getConsecutiveFailures() const { return consecutiveFailures_; }
+
+  // サーキットブレーカーが開いている（取得を休止中）かどうか
+  bool isCircuitOpen() const { return circuitOpen_; }
+
 private:
+  // 取得タスクからloop()へ渡す1回分の取得結果
+  struct FetchResult {
+    bool success;
+    int status;                 // HTTPステータス（負の値は接続エラー）
+    float tempMax;
+    float tempMin;
+    int weatherCode;
+    bool hourlyValid;
+    HourlyForecast hourly;
+    unsigned long fetchMs;
+    unsigned long parseUs;
+    uint32_t parseHeapBytes;
+    int payloadBytes;
+  };
+
+  static constexpr uint32_t TASK_STACK_SIZE = 8192;  // HTTP・TLSとJSONパース用
+
   // API設定
-  String apiUrl_;
+  HttpSession& http_;
+  String apiPath_;
 
   // 更新管理
   static constexpr unsigned long UPDATE_INTERVAL_MS = 3600000;  // 1時間 = 3600秒 = 3600000ミリ秒
+  static constexpr unsigned long RETRY_BASE_MS = 30000;         // 初回リトライ待ち（30秒）
+  static constexpr unsigned long RETRY_MAX_MS = 900000;         // リトライ待ちの上限（15分）
+  static constexpr uint8_t CIRCUIT_BREAK_FAILURES = 5;          // この回数連続で失敗したら休止
+  static constexpr unsigned long CIRCUIT_OPEN_MS = 1800000;     // 休止時間（30分）
   unsigned long lastUpdateTime_;
+  unsigned long nextAttemptTime_;   // 次回取得を試みる時刻 (millis)
+  uint8_t consecutiveFailures_;     // 連続失敗回数
+  bool circuitOpen_;                // サーキットブレーカー状態
+
+  // 取得タスク（http_ と result_ は取得中はタスク側だけが触る）
+  TaskHandle_t task_;
+  std::atomic<bool> fetching_;      // 取得を要求してから結果を反映するまで true
+  std::atomic<bool> resultReady_;   // 取得タスクが result_ を書き終えた
+  FetchResult result_;
 
   // 天気データ
   WeatherData weatherData_;
+  HourlyForecast hourly_;
+  WeatherFetchStats stats_;
+  uint32_t dataVersion_;            // getData() の内容が変わるたびに増やす（loop側だけで更新）
+  bool stale_;                      // 前回の update() で isStale() だったか
 
   // 内部処理関数
-  bool fetchWeatherData();
+  static void fetchTask(void* arg);
+  void startFetch();
+  void fetchWeatherData(FetchResult& out) const;
+  void applyResult(const FetchResult& result);
+  void buildFilter(JsonDocument& filter) const;
+  static bool ingestHourly(JsonDocument& doc, HourlyForecast& out);
+  void scheduleNextAttempt(bool success);
+  unsigned long backoffDelay() const;
+  void saveCache() const;
+  bool isStale() const;  // 取得日が今日でない（時刻未同期の間は false）
+  static bool isSameDay(time_t a, time_t b);
   String weatherCodeToString(int code) const;
 };
 
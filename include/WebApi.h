@@ -0,0 +1,160 @@
+/**
+ * WebApi.h
+ *
+ * Web API・ダッシュボード
+ * 非同期HTTPサーバー（ESPAsyncWebServer）でセンサー値・エアコンの状態を返し、
+ * モード変更・自動停止の切り替えを受け付けます。
+ * WebSocketで接続中のクライアントには、値が変化した時だけ差分を送信します。
+ */
+
+#ifndef WEB_API_H
+#define WEB_API_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <ESPAsyncWebServer.h>
+#include "AirConditionerController.h"
+#include "AutoStopController.h"
+#include "EnvironmentSensor.h"
+#include "WeatherForecast.h"
+
+/**
+ * Web APIの計測値
+ * リクエスト処理はAsyncTCPタスクで行われるため、loop()から読む値は多少古い場合があります。
+ */
+struct WebApiStats {
+  uint32_t requests;          // リクエスト数
+  uint32_t notFound;          // 404の件数
+  uint32_t badRequests;       // 400の件数
+  uint32_t notModified;       // ダッシュボードを304（キャッシュ有効）で返した件数
+  uint32_t commandsQueued;    // 受け付けたコマンド数
+  uint32_t commandsApplied;   // loop()で実行したコマンド数
+  unsigned long maxHandlerUs; // リクエスト処理にかかった最長時間（マイクロ秒）
+  uint32_t wsConnects;        // WebSocketの接続数（累計）
+  uint32_t wsMessages;        // WebSocketで送信した差分の数（クライアント数によらず1回1件）
+  uint32_t wsBytes;           // 同（バイト数）
+  uint32_t wsDroppedClients;  // 送信が追いつかないクライアントを切断した回数（1回の送信で複数でも1）
+  unsigned long lastFanoutUs; // 直近の差分を全クライアントのキューに積むのにかかった時間（マイクロ秒）
+};
+
+/**
+ * Web API・ダッシュボードクラス
+ *
+ * エンドポイント:
+ * - GET  /                ダッシュボード（gzip圧縮済みのHTMLをフラッシュから送信）
+ * - GET  /api/sensor      最新のセンサー値
+ * - GET  /api/ac          エアコンのモード・自動停止の有効/無効
+ * - POST /api/ac/mode     モード変更（mode=off|cool_20|auto_plus_1|dry_minus_1_5）
+ * - POST /api/autostop    自動停止の切り替え（enabled=true|false）
+ * - GET  /ws              WebSocket（状態の差分を受信）
+ * - GET  /trace/0.bin     制御ループのトレース（TraceRecorder、/trace/1.bin も同様）
+ *
+ * リクエストはloop()とは別のタスク（AsyncTCP）で処理されるため、制御ループを止めません。
+ * 逆にエアコン制御クラスなどを直接操作すると競合するため、
+ * - 状態はloop()がupdate()で更新するスナップショットから返す
+ * - コマンドは受け付けるだけ（202）で、実行はloop()のupdate()で行う（連続した場合は最後のものが有効）
+ *
+ * WebSocket:
+ * - 接続時に全項目（"full":true）、以降は前回の送信から変化した項目だけをJSONで送信
+ *   例: {"seq":42,"temp":26.6,"di":75.2}（温湿度・DIは0.1単位で変化した場合のみ）
+ * - 1つの送信バッファを全クライアントで共有（クライアント数ぶんのコピーをしない）
+ * - 送信は AsyncWebSocket::textAll() でライブラリのロックの下で行う（クライアント一覧はAsyncTCPタスクも
+ *   変更するため、loop()から直接たどらない）
+ * - クライアントごとの送信キューが WS_MAX_QUEUED_MESSAGES 件（platformio.ini）に達した場合（受信が追いつかない）は、
+ *   ライブラリが待たずにそのクライアントを切断する（loop()を止めない）
+ */
+class WebApi {
+public:
+  /**
+   * コンストラクタ
+   * @param airConditioner エアコン制御クラスの参照
+   * @param autoStop 自動停止制御クラスの参照
+   * @param sensor 環境センサークラスの参照
+   * @param weather 天気予報クラスの参照
+   * @param port 待ち受けポート
+   */
+  WebApi(AirConditionerController& airConditioner, AutoStopController& autoStop,
+         EnvironmentSensor& sensor, WeatherForecast& weather, uint16_t port = 80);
+
+  /**
+   * ルートを登録して待ち受けを開始（WiFi接続後に呼び出す）
+   */
+  void begin();
+
+  /**
+   * 受け付けたコマンドの実行・スナップショットの更新・WebSocketへの差分送信
+   * loop関数内で毎回呼び出してください。
+   */
+  void update();
+
+  /**
+   * WebSocketの接続中クライアント数
+   */
+  size_t getClientCount() const { return ws_.count(); }
+
+  /**
+   * 計測値を取得
+   */
+  const WebApiStats& getStats() const { return stats_; }
+
+private:
+  // リクエスト処理から参照する状態（loop()で更新）
+  struct Snapshot {
+    SensorData sensor;
+    ACMode mode;
+    bool autoStop;
+    bool weatherValid;
+    float tempMax;
+    float tempMin;
+    int weatherCode;
+    char weather[32];
+  };
+
+  static constexpr int8_t NO_COMMAND = -1;
+  static constexpr uint8_t MAX_CLIENTS = 8;                 // WebSocketの同時接続数の上限（超えた分は古い順に切断）
+  static constexpr unsigned long CLEANUP_INTERVAL_MS = 1000;
+  static constexpr size_t MESSAGE_SIZE = 384;
+
+  AirConditionerController& airConditioner_;
+  AutoStopController& autoStop_;
+  EnvironmentSensor& sensor_;
+  WeatherForecast& weather_;
+  AsyncWebServer server_;
+  AsyncWebSocket ws_;
+  uint16_t port_;
+  bool started_;
+
+  portMUX_TYPE lock_;
+  Snapshot snapshot_;                  // lock_ で保護
+  uint32_t snapshotSeq_;               // snapshot_ の時点の差分の通し番号（lock_ で保護）
+
+  std::atomic<int8_t> pendingMode_;       // 実行待ちのモード（ACMode、なければNO_COMMAND）
+  std::atomic<int8_t> pendingAutoStop_;   // 実行待ちの自動停止設定（0/1、なければNO_COMMAND）
+
+  // loop()側の状態
+  Snapshot current_;                 // 最新の状態（update()で更新し、snapshot_にコピー）
+  Snapshot pushed_;                  // WebSocketで最後に送信した状態
+  uint32_t seq_;                     // 差分の通し番号（AsyncTCPタスクは snapshotSeq_ を読む）
+  uint32_t weatherVersion_;          // 最後に読み込んだ天気予報の版（getDataVersion()）
+  bool weatherLoaded_;
+  unsigned long lastCleanupMs_;
+
+  WebApiStats stats_;
+
+  Snapshot readSnapshot(uint32_t* seq = nullptr);
+  void loadWeather();
+  void push(const Snapshot& latest);
+  void onWsEvent(AsyncWebSocketClient* client, AwsEventType type);
+  static size_t buildMessage(char* out, size_t size, uint32_t seq,
+                             const Snapshot& current, const Snapshot* previous);
+  void handleIndex(AsyncWebServerRequest* request);
+  void handleSensor(AsyncWebServerRequest* request);
+  void handleAc(AsyncWebServerRequest* request);
+  void handleSetMode(AsyncWebServerRequest* request);
+  void handleAutoStop(AsyncWebServerRequest* request);
+  void handleNotFound(AsyncWebServerRequest* request);
+  void finish(unsigned long startUs);
+  static const char* param(AsyncWebServerRequest* request, const char* name);
+};
+
+#endif // WEB_API_H
@@ -0,0 +1,151 @@
+/**
+ * WebAssets.h
+ *
+ * ダッシュボードの静的ファイル（gzip圧縮済み）
+ * tools/embed_web.py が web/ 以下から自動生成します。直接編集しないでください。
+ */
+
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <Arduino.h>
+
+namespace WebAssets {
+  // index.html（4439 バイト → gzip 2075 バイト）
+  const char INDEX_HTML_ETAG[] = "\"6067ec670eddabca\"";
+  const size_t INDEX_HTML_GZ_LEN = 2075;
+  const uint8_t INDEX_HTML_GZ[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xa5, 0x58, 0xed, 0x8f, 0x13, 0xc7,
+    0x19, 0xff, 0xee, 0xbf, 0x62, 0x19, 0xd2, 0x68, 0x57, 0x67, 0xaf, 0xed, 0x03, 0xd2, 0xd3, 0xee,
+    0xed, 0x21, 0x85, 0x50, 0x89, 0x4a, 0x0d, 0x48, 0x77, 0x52, 0x55, 0xa1, 0x13, 0x1a, 0xef, 0xce,
+    0x9e, 0xe7, 0x6e, 0x5f, 0xac, 0x99, 0xf1, 0xad, 0x5d, 0x9f, 0x25, 0x7c, 0x97, 0xc2, 0x91, 0x02,
+    0x55, 0xd3, 0x12, 0x92, 0x42, 0xd5, 0x80, 0x68, 0x43, 0x82, 0xa0, 0x54, 0x91, 0x12, 0x12, 0x11,
+    0xee, 0x7f, 0xe9, 0x62, 0x13, 0x3e, 0xe5, 0x5f, 0xe8, 0x33, 0xb3, 0xbb, 0x7e, 0xe1, 0x5e, 0x1a,
+    0xb5, 0x1f, 0x8e, 0xdd, 0x9d, 0x79, 0xe6, 0x79, 0xfd, 0x3d, 0xbf, 0x67, 0xcc, 0xe2, 0xb1, 0xf7,
+    0xce, 0x9f, 0x59, 0xf9, 0xcd, 0x85, 0xb3, 0x5a, 0x53, 0x84, 0xc1, 0x52, 0x69, 0x51, 0x3e, 0xb4,
+    0x00, 0x47, 0x6b, 0x0e, 0x5a, 0xc7, 0x48, 0x2e, 0x10, 0xec, 0xc1, 0x23, 0x24, 0x02, 0x6b, 0x6e,
+    0x13, 0x33, 0x4e, 0x84, 0x83, 0xda, 0xc2, 0xaf, 0x2c, 0xa0, 0x62, 0x39, 0xc2, 0x21, 0x71, 0xd0,
+    0x26, 0x25, 0x49, 0x2b, 0x66, 0x02, 0x69, 0x6e, 0x1c, 0x09, 0x12, 0x81, 0x58, 0x42, 0x3d, 0xd1,
+    0x74, 0x3c, 0xb2, 0x49, 0x5d, 0x52, 0x51, 0x1f, 0x65, 0x1a, 0x51, 0x41, 0x71, 0x50, 0xe1, 0x2e,
+    0x0e, 0x88, 0x53, 0x97, 0x3a, 0x04, 0x15, 0x01, 0x59, 0x4a, 0xb7, 0x1f, 0xa6, 0xdb, 0xf7, 0xd3,
+    0xed, 0xaf, 0xd2, 0x9d, 0xaf, 0x7e, 0xb8, 0xfa, 0xe5, 0xf0, 0xf7, 0xb7, 0x86, 0xbb, 0x5f, 0x0f,
+    0x5f, 0xdc, 0x5b, 0xac, 0x66, 0xfb, 0xa5, 0x45, 0x2e, 0xba, 0xf2, 0xd9, 0x88, 0xbd, 0x6e, 0xcf,
+    0x07, 0x13, 0x15, 0x1f, 0x87, 0x34, 0xe8, 0x5a, 0xbc, 0xcb, 0x05, 0x09, 0x2b, 0x6d, 0x5a, 0xe6,
+    0x38, 0xe2, 0x15, 0x4e, 0x18, 0xf5, 0xed, 0x10, 0xb3, 0x35, 0x1a, 0x59, 0x35, 0xbb, 0x85, 0x3d,
+    0x8f, 0x46, 0x6b, 0x56, 0xfd, 0x9d, 0x56, 0xc7, 0x6e, 0x60, 0x77, 0x63, 0x8d, 0xc5, 0xed, 0xc8,
+    0xb3, 0x8e, 0xfb, 0x27, 0xfd, 0x53, 0xfe, 0xcf, 0x6d, 0x37, 0x0e, 0x62, 0x66, 0x1d, 0x9f, 0x9f,
+    0x9f, 0xef, 0x97, 0x9a, 0xf5, 0x4c, 0x31, 0xa7, 0xbf, 0x25, 0x56, 0xdd, 0x9c, 0x27, 0xe1, 0x58,
+    0x8f, 0x56, 0xd3, 0xea, 0xf3, 0xad, 0x4e, 0xbf, 0x64, 0xba, 0x98, 0x79, 0xbd, 0x19, 0x45, 0xbe,
+    0x6f, 0x37, 0x62, 0xe6, 0x11, 0x56, 0x61, 0xd8, 0xa3, 0x6d, 0x6e, 0x2d, 0x80, 0xa9, 0xb1, 0x5d,
+    0x38, 0xa5, 0x29, 0xe3, 0x99, 0xaa, 0x4a, 0x23, 0x16, 0x22, 0x0e, 0xd5, 0x3a, 0x1c, 0xeb, 0x54,
+    0x78, 0x13, 0x7b, 0x71, 0x02, 0x16, 0xea, 0x20, 0x78, 0x02, 0xfe, 0x8e, 0xd7, 0x6a, 0x35, 0x70,
+    0xc6, 0x64, 0x71, 0xd2, 0xf3, 0x28, 0x6f, 0x05, 0xb8, 0x6b, 0xf9, 0x01, 0xe9, 0xd8, 0xeb, 0x6d,
+    0x2e, 0xa8, 0xdf, 0xad, 0xe4, 0xf9, 0xb5, 0x78, 0x0b, 0x43, 0x5e, 0x1b, 0x44, 0x24, 0x84, 0x44,
+    0x63, 0x83, 0x27, 0x41, 0x45, 0x0d, 0x8e, 0x6f, 0x66, 0xb1, 0x24, 0x84, 0xae, 0x35, 0x85, 0xd5,
+    0x88, 0x03, 0xcf, 0x56, 0x0b, 0x9b, 0x98, 0x51, 0x0c, 0xcf, 0xa8, 0x1d, 0x42, 0xa6, 0x5c, 0x4b,
+    0xe0, 0x46, 0x3b, 0xc0, 0x4c, 0x7e, 0xf3, 0x7e, 0xa9, 0xd1, 0x06, 0xef, 0xa2, 0x5e, 0x1e, 0xb6,
+    0xd4, 0xa5, 0xf4, 0x69, 0x93, 0x44, 0x2e, 0xc8, 0x78, 0x32, 0xe7, 0x65, 0xcc, 0x96, 0x74, 0x9b,
+    0xc7, 0x01, 0xf5, 0xb4, 0xe3, 0x0b, 0x0b, 0x0b, 0x6f, 0x64, 0x62, 0x5f, 0xd2, 0x7d, 0xbf, 0xb0,
+    0x61, 0x82, 0x99, 0xe9, 0xad, 0x79, 0xfc, 0x8e, 0xe7, 0x9f, 0x2c, 0xea, 0x31, 0x95, 0xd4, 0xa2,
+    0x42, 0x6a, 0xbf, 0x5f, 0x3a, 0x4e, 0x18, 0xeb, 0xe5, 0x6b, 0x6e, 0xad, 0x66, 0x87, 0x90, 0xd3,
+    0x66, 0x16, 0xa4, 0x2a, 0x59, 0xbf, 0xb4, 0x58, 0xcd, 0xa1, 0xb2, 0x58, 0xcd, 0xd1, 0x2b, 0x31,
+    0x23, 0xb1, 0x5c, 0x3f, 0x02, 0x66, 0xb0, 0x59, 0x5a, 0xf4, 0xe8, 0xa6, 0xe6, 0x06, 0x98, 0x73,
+    0x07, 0xc9, 0x3a, 0xa3, 0xd9, 0x25, 0xa8, 0x08, 0x5a, 0x5a, 0x84, 0xb4, 0x47, 0x4b, 0xa3, 0x67,
+    0x5f, 0x0c, 0xbf, 0xfb, 0x07, 0x58, 0x92, 0x1f, 0x6a, 0xa9, 0x10, 0xda, 0x44, 0x1a, 0xf5, 0x1c,
+    0x04, 0x90, 0x6c, 0xa1, 0xa5, 0x4a, 0x21, 0x51, 0x05, 0x35, 0x87, 0x2b, 0xfb, 0x76, 0xef, 0x68,
+    0x65, 0xcd, 0x76, 0xf8, 0x53, 0x75, 0xbd, 0x7c, 0x76, 0x63, 0xb8, 0xf7, 0x68, 0x74, 0xfd, 0xea,
+    0xe8, 0xd6, 0xd3, 0x23, 0x34, 0x7a, 0x74, 0xbf, 0xc2, 0xfd, 0x7a, 0x8f, 0xce, 0xc1, 0xf0, 0xc1,
+    0x17, 0xa3, 0xa7, 0xb7, 0x8f, 0x30, 0x92, 0x74, 0x7e, 0x72, 0x06, 0xee, 0x5e, 0x7e, 0xfd, 0xe8,
+    0x13, 0xad, 0xaa, 0xc1, 0xcb, 0xcb, 0xef, 0x6f, 0x1e, 0xa9, 0x73, 0xe5, 0xff, 0xf7, 0x3c, 0xdd,
+    0xb9, 0x9f, 0xee, 0x3c, 0x4f, 0x77, 0xae, 0x1d, 0x61, 0x28, 0x8c, 0x3d, 0x72, 0xb0, 0xfb, 0xc5,
+    0x2e, 0x47, 0xff, 0xb3, 0x03, 0xf3, 0x27, 0x46, 0x9f, 0x6e, 0xe7, 0xf8, 0x1b, 0xdc, 0x1d, 0x3d,
+    0xbe, 0x7f, 0x84, 0x23, 0x98, 0xef, 0x77, 0x23, 0x6b, 0xa1, 0x7c, 0xfb, 0x5d, 0x11, 0xa1, 0xa5,
+    0xe1, 0xee, 0xd5, 0x74, 0xfb, 0xc3, 0xd1, 0x9d, 0xbd, 0x74, 0xb0, 0xbb, 0x58, 0xcd, 0xf6, 0x67,
+    0x1d, 0x93, 0xc2, 0xd0, 0x3b, 0x13, 0xa7, 0xb9, 0xcb, 0x68, 0x4b, 0x2c, 0x95, 0x80, 0x11, 0xb4,
+    0x5f, 0x9d, 0x7f, 0xef, 0xec, 0xb2, 0xd3, 0x8b, 0x7d, 0xdf, 0x42, 0x99, 0x47, 0xa8, 0xec, 0xc6,
+    0x71, 0x70, 0x69, 0xbe, 0x06, 0x0b, 0x57, 0xbe, 0x19, 0xed, 0xee, 0xcd, 0xd7, 0xfe, 0xfd, 0xc1,
+    0x0e, 0x2a, 0xe3, 0xb6, 0x88, 0x2f, 0xb5, 0x82, 0x36, 0xbf, 0x54, 0xb7, 0x50, 0x16, 0xc2, 0x5c,
+    0x1d, 0x95, 0x3d, 0xd6, 0xbd, 0x04, 0xad, 0x28, 0x97, 0x2f, 0x9d, 0xb2, 0xd0, 0xeb, 0x4f, 0x1f,
+    0x00, 0xaa, 0x2b, 0x75, 0xf3, 0x14, 0x2a, 0xb7, 0xa3, 0x8d, 0x28, 0x4e, 0x22, 0x0b, 0x01, 0x36,
+    0x47, 0x9f, 0xdc, 0x44, 0x7d, 0x5b, 0x99, 0xe4, 0x02, 0x0b, 0xe2, 0xf4, 0xfa, 0xe5, 0x84, 0x3b,
+    0x51, 0x3b, 0x08, 0xca, 0xad, 0x38, 0x08, 0x56, 0x28, 0xb0, 0x92, 0xfa, 0xb4, 0x4b, 0x7e, 0x3b,
+    0x72, 0x05, 0x85, 0x30, 0xdf, 0xd2, 0xa9, 0x67, 0xf4, 0x18, 0x11, 0x6d, 0x16, 0x69, 0x5e, 0xec,
+    0x02, 0x73, 0x45, 0xc2, 0x5c, 0x23, 0xe2, 0x6c, 0x40, 0xe4, 0xeb, 0xbb, 0xdd, 0x73, 0x9e, 0x14,
+    0xe9, 0x4f, 0x8e, 0xb4, 0x62, 0x2e, 0xf4, 0x36, 0x0b, 0xca, 0xb2, 0xf5, 0x8d, 0x5e, 0x49, 0xd3,
+    0xf2, 0xe3, 0x3e, 0x11, 0x6e, 0x53, 0xed, 0xf4, 0x60, 0x78, 0x35, 0x63, 0xcf, 0x42, 0x17, 0xce,
+    0x2f, 0xaf, 0xa0, 0xb2, 0xa4, 0x0a, 0xc2, 0xb8, 0xd5, 0x43, 0x67, 0x32, 0x7e, 0xad, 0xac, 0x74,
+    0x5b, 0x04, 0x59, 0x08, 0xb7, 0x5a, 0x01, 0x75, 0xb1, 0x54, 0x5b, 0xed, 0x54, 0x92, 0x24, 0xa9,
+    0xf8, 0x31, 0x83, 0x79, 0xc3, 0x02, 0x12, 0xb9, 0x00, 0x03, 0x0f, 0xf5, 0x95, 0x15, 0x4b, 0xfe,
+    0xd3, 0x37, 0xc0, 0x94, 0xa6, 0x99, 0xa2, 0x49, 0x22, 0xbd, 0xf0, 0x46, 0x67, 0x46, 0x8f, 0xfa,
+    0xfa, 0x31, 0x66, 0xc6, 0x1b, 0x86, 0x68, 0x02, 0x0e, 0xb4, 0x88, 0x24, 0xda, 0x59, 0xc6, 0x62,
+    0xa6, 0x33, 0x53, 0x26, 0xa2, 0xcd, 0x0d, 0x5b, 0x8a, 0x24, 0x7c, 0x6b, 0x2b, 0xe1, 0x26, 0x03,
+    0x67, 0xba, 0xcb, 0x32, 0x41, 0xc7, 0x1c, 0xa7, 0x6e, 0xc0, 0xd0, 0x95, 0x89, 0x89, 0xdb, 0x42,
+    0x67, 0xc4, 0x67, 0x84, 0x37, 0xcb, 0x27, 0x6a, 0x35, 0xa3, 0x30, 0x06, 0xce, 0x41, 0x4c, 0x63,
+    0x6b, 0xc4, 0xe8, 0xbd, 0xa5, 0xab, 0x52, 0x1b, 0xa6, 0x20, 0x1d, 0x71, 0xa6, 0x98, 0xc7, 0xaf,
+    0x2f, 0x0f, 0x5e, 0xee, 0xdd, 0x1b, 0x3e, 0xf8, 0xd7, 0xe8, 0xd6, 0x6d, 0x4b, 0x43, 0x73, 0xc4,
+    0x0c, 0x09, 0xe7, 0x78, 0x8d, 0xf4, 0x0d, 0xbb, 0x34, 0x95, 0x3c, 0x46, 0x22, 0x48, 0x85, 0xae,
+    0xd2, 0xa6, 0x2a, 0xe5, 0xa8, 0x5a, 0x99, 0x9c, 0x44, 0x3c, 0x66, 0x65, 0x9c, 0x7f, 0x62, 0xd7,
+    0x06, 0x01, 0xf0, 0x9a, 0x2b, 0x49, 0x0d, 0xea, 0x94, 0xd1, 0xde, 0xac, 0x59, 0x6e, 0x6e, 0x62,
+    0x18, 0x0f, 0xa7, 0xb9, 0x29, 0x37, 0x09, 0x83, 0x60, 0x19, 0x31, 0x45, 0xfc, 0x0b, 0xda, 0x21,
+    0x9e, 0x5e, 0x37, 0xe6, 0x90, 0x26, 0x81, 0x65, 0xa1, 0x0a, 0xb2, 0x0b, 0x35, 0x92, 0xf0, 0x0e,
+    0xd3, 0x02, 0x7b, 0xd4, 0xa3, 0xa2, 0x3b, 0xab, 0xe2, 0x67, 0xb3, 0x0a, 0x80, 0xdf, 0x0e, 0x3b,
+    0x0f, 0x33, 0xd5, 0x8d, 0x43, 0xa8, 0xa1, 0x38, 0x07, 0x61, 0x76, 0xa6, 0xd4, 0x14, 0x1a, 0xfa,
+    0x59, 0x58, 0x78, 0x12, 0x96, 0x22, 0x83, 0x59, 0x85, 0xaa, 0x63, 0x2e, 0x62, 0x53, 0x6e, 0xad,
+    0x6e, 0x6d, 0x65, 0x2f, 0x63, 0xfb, 0xd0, 0xb4, 0xb3, 0xe2, 0xd8, 0x94, 0x8d, 0xb3, 0x2c, 0xe2,
+    0xd6, 0x69, 0x34, 0xba, 0x7b, 0x6d, 0xf8, 0xe1, 0xb7, 0xe0, 0xf0, 0xab, 0x0f, 0xee, 0xc9, 0x97,
+    0xec, 0x94, 0xcc, 0x74, 0xc3, 0xc9, 0x8d, 0xc9, 0xe3, 0x6e, 0x93, 0x06, 0x1e, 0xd4, 0x22, 0xdb,
+    0x06, 0x87, 0x75, 0x29, 0x42, 0x9d, 0x9a, 0x4d, 0x17, 0x1b, 0x26, 0xa0, 0x6f, 0x4d, 0x34, 0x6d,
+    0x3a, 0x37, 0x67, 0x34, 0x2e, 0xd2, 0x55, 0x53, 0x91, 0xc6, 0xfb, 0xf2, 0x2a, 0xa6, 0x3e, 0x3d,
+    0x2c, 0x30, 0xc0, 0x46, 0x79, 0xe5, 0x38, 0x4e, 0xe6, 0xde, 0x69, 0x14, 0x47, 0x60, 0x76, 0x1c,
+    0xa4, 0xd4, 0x97, 0xe4, 0xd5, 0x4c, 0x08, 0x06, 0xd0, 0xb2, 0xbc, 0xa4, 0xc9, 0x24, 0x76, 0x60,
+    0xf1, 0xd9, 0x50, 0x12, 0xf5, 0x65, 0x4f, 0xf6, 0x57, 0xf6, 0x09, 0x84, 0xb8, 0x33, 0x5b, 0x9e,
+    0x2a, 0xc0, 0x0d, 0x96, 0x69, 0xb4, 0xbf, 0xf0, 0x99, 0x33, 0xfd, 0x52, 0xb5, 0xaa, 0xfd, 0x9a,
+    0x34, 0x96, 0x63, 0x77, 0x83, 0x88, 0x74, 0xf0, 0x64, 0xf8, 0xcd, 0x93, 0xe1, 0xee, 0x95, 0x1f,
+    0x9f, 0xef, 0x0e, 0x1f, 0x5c, 0x1b, 0x5e, 0xff, 0x38, 0x1d, 0xdc, 0x4e, 0x07, 0x7f, 0x7b, 0xfd,
+    0xd9, 0xef, 0x5e, 0xdd, 0x79, 0x02, 0xbb, 0xe9, 0x60, 0xef, 0xc7, 0xe7, 0xd7, 0xd2, 0xed, 0x8f,
+    0x94, 0xf3, 0xe9, 0xe0, 0xd1, 0xf0, 0x0f, 0xc0, 0x2d, 0x9f, 0x4d, 0x30, 0x2c, 0xbb, 0xb6, 0xab,
+    0x87, 0x2a, 0x0c, 0x88, 0x27, 0x34, 0x7d, 0xe0, 0x14, 0xa3, 0x37, 0x0d, 0x64, 0xa7, 0xa7, 0x20,
+    0x61, 0xf9, 0x38, 0xe0, 0xa4, 0x6f, 0x17, 0xa0, 0x06, 0x4a, 0xea, 0x1f, 0x08, 0xfc, 0xad, 0x2d,
+    0xfd, 0xf0, 0xe3, 0xc6, 0x54, 0x5b, 0x8c, 0x05, 0x95, 0x32, 0x23, 0x4f, 0x69, 0xd6, 0x1b, 0x1a,
+    0x8d, 0x34, 0xf0, 0x6a, 0xa6, 0x19, 0x9c, 0x50, 0x7d, 0xd9, 0x39, 0x46, 0x1d, 0xc1, 0xda, 0x24,
+    0xc7, 0xa0, 0xea, 0x84, 0xf1, 0x99, 0x02, 0xfa, 0x70, 0x00, 0x5e, 0x0f, 0x94, 0x07, 0xe0, 0x8f,
+    0xc5, 0xdf, 0x40, 0x3a, 0x9c, 0xf2, 0xe8, 0x81, 0x87, 0x14, 0xbc, 0xb3, 0x63, 0x19, 0x50, 0x40,
+    0xb4, 0x80, 0xb3, 0xdc, 0x2f, 0xa0, 0x3b, 0x96, 0x29, 0x16, 0x40, 0xae, 0x78, 0xb5, 0x8b, 0x44,
+    0xe7, 0x40, 0x32, 0x66, 0x60, 0xe5, 0x84, 0xd3, 0x00, 0x2b, 0x08, 0xc6, 0xde, 0x57, 0xf6, 0x47,
+    0xa3, 0x9b, 0x7f, 0x7f, 0xf5, 0xf5, 0x5f, 0x64, 0xd9, 0x77, 0xaf, 0x8e, 0x3e, 0x7e, 0xfc, 0xf2,
+    0xd9, 0xe3, 0x74, 0xf0, 0xcf, 0x53, 0xaf, 0x3e, 0xff, 0x28, 0x1d, 0xfc, 0x39, 0x1d, 0x3c, 0x94,
+    0xa5, 0xdf, 0xf9, 0xab, 0x1a, 0xde, 0x5f, 0xc2, 0x15, 0x2e, 0xdd, 0x7e, 0x9a, 0x0e, 0x3e, 0xff,
+    0xe1, 0xde, 0xc3, 0x57, 0x0f, 0xbe, 0x03, 0x30, 0xc0, 0xc9, 0x74, 0xf0, 0xc7, 0xf4, 0xf2, 0xe0,
+    0x04, 0x1c, 0x18, 0xbe, 0xb8, 0x2e, 0x71, 0x71, 0xe5, 0x46, 0xa1, 0xf2, 0xda, 0x04, 0x1d, 0x70,
+    0x85, 0x8e, 0x88, 0x2b, 0x32, 0x8a, 0x93, 0xf3, 0x07, 0xe8, 0x78, 0xec, 0x85, 0xae, 0x07, 0x71,
+    0xc6, 0xf7, 0x66, 0x8b, 0xc5, 0x22, 0x86, 0xcb, 0x26, 0x74, 0x10, 0x6a, 0x0a, 0xd1, 0xe2, 0x16,
+    0x3a, 0x8d, 0x12, 0xce, 0xad, 0x6a, 0x15, 0xfa, 0x28, 0x51, 0x4f, 0x63, 0x6e, 0x2c, 0xde, 0x84,
+    0xa9, 0x33, 0x87, 0xaa, 0x09, 0x74, 0xaf, 0xad, 0x14, 0xc3, 0x25, 0x37, 0x6e, 0x91, 0xc8, 0x19,
+    0x73, 0xf3, 0x61, 0xd4, 0x8c, 0x24, 0xfb, 0x8f, 0x07, 0xa0, 0xd1, 0x73, 0x03, 0x82, 0xd9, 0x39,
+    0xd8, 0x64, 0x50, 0xad, 0xa9, 0x0d, 0x7b, 0x76, 0x48, 0xf6, 0xfb, 0x63, 0x3b, 0x39, 0x95, 0x3b,
+    0xd3, 0x63, 0x40, 0xb0, 0x6e, 0x2f, 0x6b, 0x84, 0x5f, 0x2e, 0x9f, 0x7f, 0xdf, 0x6c, 0xc9, 0x9f,
+    0x6f, 0x3a, 0x51, 0xdc, 0x60, 0x18, 0xfd, 0x6c, 0x6c, 0x74, 0x8c, 0xde, 0x94, 0x16, 0x37, 0x88,
+    0x39, 0x99, 0x76, 0x57, 0x75, 0x79, 0x3e, 0xa1, 0xb3, 0x96, 0x97, 0x63, 0x6a, 0xca, 0xd3, 0x7c,
+    0x20, 0xe9, 0xd3, 0xae, 0x01, 0xf1, 0x8c, 0x7d, 0x2f, 0x06, 0xd6, 0xa9, 0x9a, 0x9c, 0x58, 0x4a,
+    0xc3, 0xd4, 0x38, 0xcb, 0x0b, 0x21, 0xc7, 0x59, 0x4d, 0xe5, 0xac, 0xff, 0xc6, 0x24, 0xca, 0x95,
+    0x4b, 0x3f, 0x2e, 0xb0, 0x38, 0xa4, 0x1c, 0xba, 0x2a, 0x08, 0xf4, 0x8b, 0xd9, 0x1c, 0x47, 0x55,
+    0xdc, 0xa2, 0xd5, 0xac, 0x1f, 0x91, 0x51, 0x9e, 0x5e, 0xc4, 0x2e, 0x32, 0x56, 0x0f, 0x9b, 0xc6,
+    0xf9, 0x65, 0x60, 0x5a, 0x23, 0x03, 0xd2, 0x6a, 0x4d, 0x84, 0x3a, 0x63, 0xa1, 0x8e, 0xb9, 0xce,
+    0x65, 0x2a, 0xfa, 0x86, 0x71, 0xf0, 0x74, 0x5f, 0x7f, 0x83, 0x56, 0xd6, 0x2f, 0xd6, 0x56, 0x27,
+    0x6c, 0xb2, 0x7e, 0xb1, 0xbe, 0x6a, 0x1f, 0x56, 0xf4, 0xa2, 0x11, 0x0e, 0x99, 0xe4, 0x87, 0xa1,
+    0x25, 0x43, 0x34, 0x20, 0x3f, 0x1d, 0xdc, 0x48, 0x07, 0x2f, 0xd2, 0xc1, 0x9d, 0x74, 0xfb, 0x4f,
+    0x28, 0x9b, 0xe2, 0xe7, 0x1b, 0xeb, 0x90, 0x50, 0x73, 0x83, 0x74, 0xb9, 0xae, 0x66, 0x94, 0x61,
+    0x02, 0x03, 0x9c, 0xc5, 0xd3, 0x7a, 0x27, 0xb4, 0x28, 0x81, 0x9d, 0xdf, 0xcf, 0x90, 0x91, 0x05,
+    0x6c, 0x97, 0x8a, 0x59, 0x34, 0xbe, 0x6a, 0xb9, 0x70, 0x1f, 0x11, 0x24, 0xbf, 0x6d, 0xe9, 0x28,
+    0xbb, 0x5d, 0x66, 0x18, 0x6f, 0x1c, 0x30, 0x14, 0xc3, 0x55, 0xbb, 0x31, 0x3b, 0x80, 0xc2, 0x4c,
+    0x54, 0xe2, 0x8b, 0xba, 0x1b, 0xd3, 0xf8, 0x52, 0x17, 0xb5, 0xa2, 0x62, 0x55, 0x45, 0x44, 0x65,
+    0xc5, 0x47, 0x0e, 0x9a, 0x0b, 0x0d, 0x05, 0xcc, 0xa9, 0x91, 0x08, 0x60, 0x86, 0x8c, 0x9d, 0x91,
+    0x83, 0x51, 0x6f, 0xc8, 0x70, 0xe1, 0x4f, 0x4d, 0x5b, 0x79, 0x07, 0x36, 0xfe, 0x9b, 0x7e, 0x60,
+    0x2a, 0x2e, 0x59, 0xac, 0x8c, 0x48, 0x84, 0x1b, 0x01, 0x81, 0x0b, 0xf1, 0xdc, 0x98, 0xa9, 0xdf,
+    0x7e, 0xbb, 0x78, 0x9b, 0x9a, 0xd4, 0x8a, 0xdb, 0xa1, 0xd3, 0x25, 0x59, 0x22, 0x43, 0xba, 0x33,
+    0x66, 0x0e, 0x5b, 0xfe, 0xce, 0xcc, 0x6f, 0xd0, 0x70, 0xe1, 0xce, 0x7e, 0x61, 0x56, 0xb3, 0xff,
+    0x46, 0xf9, 0x0f, 0xc1, 0x44, 0x61, 0xfa, 0x57, 0x11, 0x00, 0x00,
+  };
+}
+
+#endif // WEB_ASSETS_H
@@ -10,34 +10,78 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
+#include <atomic>
+
+/**
+ * WiFi接続の計測値
+ */
+struct WiFiStats {
+  uint32_t connectAttempts;       // 接続試行回数
+  uint32_t disconnectCount;       // 接続中からの切断回数
+  uint32_t reconnectCount;        // 切断後の再接続成功回数
+  unsigned long lastReconnectMs;  // 直近の切断〜再接続までの時間
+  unsigned long maxReconnectMs;   // 切断〜再接続までの最長時間
+  uint8_t lastDisconnectReason;   // 直近の切断理由（ESP-IDFの理由コード）
+  unsigned long lastConnectMs;    // 直近の接続試行開始〜IP取得までの時間
+  bool lastConnectWasFast;        // 直近の接続がキャッシュ（BSSID・チャンネル指定）による高速接続か
+  uint32_t fastJoinAttempts;      // 高速接続の試行回数
+  uint32_t fastJoinFailures;      // 高速接続の失敗回数（フルスキャンにフォールバック）
+  uint32_t eventOverflows;        // イベントキューがあふれた回数（実際の接続状態に合わせ直した回数）
+};
 
 /**
  * WiFi接続管理クラス
  *
  * 主な機能:
  * - WiFiアクセスポイントへの接続
- * - 接続状態の監視
- * - 切断時の自動再接続
+ * - WiFi.onEvent によるイベント駆動の接続状態監視
+ * - 切断時のノンブロッキング再接続（指数バックオフ）
+ * - 接続状態変化の通知（天気予報・時刻管理など）
+ * - 前回接続したAPのBSSID・チャンネル・IP設定をRTCメモリとNVSに保存し、
+ *   次回はスキャンせずに直接接続（失敗時はフルスキャンにフォールバック）
  */
 class WiFiManager {
 public:
+  /**
+   * 接続状態の変化通知関数
+   * @param connected true: 接続した, false: 切断された
+   * @param context addListener() で指定したポインタ
+   */
+  typedef void (*ConnectionListener)(bool connected, void* context);
+
+  /**
+   * 接続状態
+   */
+  enum class State {
+    IDLE,        // 未開始
+    CONNECTING,  // 接続試行中
+    CONNECTED,   // 接続中（IPアドレス取得済み）
+    BACKOFF      // 再試行待ち
+  };
+
   /**
    * コンストラクタ
    * @param ssid WiFiのSSID
    * @param password WiFiのパスワード
-   * @param timeoutMs 接続タイムアウト時間（ミリ秒）
+   * @param timeoutMs 1回の接続試行のタイムアウト時間（ミリ秒）
    */
   WiFiManager(const char* ssid, const char* password, unsigned long timeoutMs = 10000);
 
   /**
-   * WiFiに接続
-   * @return true: 接続成功, false: 接続失敗
+   * イベントハンドラーを登録し、接続を開始（ブロックしない）
+   */
+  void begin();
+
+  /**
+   * WiFiに接続（接続完了またはタイムアウトまで待機）
+   * 起動直後など、接続を待つ必要がある場合に使用します。
+   * @return true: 接続成功, false: 接続失敗（以降はバックオフして再試行）
    */
   bool connect();
 
   /**
-   * WiFi接続状態を確認し、切断時は再接続を試みる
-   * loop関数内で定期的に呼び出してください。
+   * 接続状態を更新し、必要なら再接続を進める（ブロックしない）
+   * loop関数内で毎回呼び出してください。
    * @return true: 接続中, false: 切断中
    */
   bool checkConnection();
@@ -48,15 +92,94 @@ public:
    */
   bool isConnected();
 
+  /**
+   * 接続状態の変化通知先を登録（最大 MAX_LISTENERS 件）
+   * 通知はloop()のコンテキスト（checkConnection内）で呼ばれます。
+   * @return true: 登録成功, false: 登録数上限
+   */
+  bool addListener(ConnectionListener listener, void* context = nullptr);
+
+  /**
+   * 前回取得したDHCPリースを静的IP設定として再利用するか設定
+   * DHCPの待ち時間を省けますが、ルーター側でアドレスが再割り当てされる環境では無効にしてください。
+   * @param enabled true: 再利用する, false: 毎回DHCP（デフォルト）
+   */
+  void setReuseLease(bool enabled) { reuseLease_ = enabled; }
+
+  /**
+   * 現在の接続状態を取得
+   */
+  State getState() const { return state_; }
+
+  /**
+   * 計測値を取得
+   */
+  const WiFiStats& getStats() const { return stats_; }
+
   /**
    * 接続情報を表示
    */
   void printConnectionInfo();
 
 private:
+  static constexpr uint8_t MAX_LISTENERS = 4;
+  static constexpr unsigned long BACKOFF_BASE_MS = 1000;   // 初回の再試行待ち
+  static constexpr unsigned long BACKOFF_MAX_MS = 60000;   // 再試行待ちの上限
+  static constexpr unsigned long FAST_JOIN_TIMEOUT_MS = 3000;   // 高速接続のタイムアウト
+  static constexpr unsigned long FALLBACK_DELAY_MS = 200;       // 高速接続失敗後、フルスキャンまでの待ち
+  static constexpr uint8_t EVENT_QUEUE_SIZE = 8;                // イベントキューの長さ（2の累乗）
+
   const char* ssid_;              // WiFi SSID
   const char* password_;          // WiFiパスワード
   unsigned long timeoutMs_;       // 接続タイムアウト時間
+
+  State state_;
+  unsigned long attemptStartTime_;   // 現在の接続試行の開始時刻
+  unsigned long nextAttemptTime_;    // 次回接続試行の時刻（BACKOFF中）
+  unsigned long disconnectedAt_;     // 切断を検出した時刻
+  uint8_t consecutiveFailures_;      // 連続失敗回数
+  bool eventsRegistered_;
+  bool reuseLease_;                  // DHCPリースを静的IPとして再利用するか
+  bool attemptIsFast_;               // 現在の試行がキャッシュによる高速接続か
+  bool fastJoinDisabled_;            // 高速接続が失敗したため次回はフルスキャン
+
+  // WiFiイベントタスクから積まれるイベント（loop側で発生順に処理する）
+  // 書き込みはイベントタスク（head_）、読み出しはloop（tail_）だけが行う単一生産者・単一消費者のリング
+  enum class EventType : uint8_t {
+    GOT_IP,
+    DISCONNECTED
+  };
+  struct Event {
+    EventType type;
+    uint8_t reason;  // 切断理由（ESP-IDFの理由コード、IP喪失は0）
+  };
+  Event events_[EVENT_QUEUE_SIZE];
+  std::atomic<uint8_t> eventHead_;
+  std::atomic<uint8_t> eventTail_;
+  std::atomic<bool> eventsLost_;   // キューが満杯でイベントを捨てた
+
+  struct ListenerEntry {
+    ConnectionListener callback;
+    void* context;
+  };
+  ListenerEntry listeners_[MAX_LISTENERS];
+  uint8_t listenerCount_;
+
+  WiFiStats stats_;
+
+  static WiFiManager* instance_;   // イベントハンドラーから参照するインスタンス
+  static void onWiFiEvent(arduino_event_id_t event, arduino_event_info_t info);
+
+  void pushEvent(EventType type, uint8_t reason);
+  void handleEvent(const Event& event, unsigned long now);
+  void handleGotIp(unsigned long now);
+  void handleDisconnect(uint8_t reason, unsigned long now);
+  void discardEvents();
+  void startAttempt();
+  void onAttemptFailed();
+  void enterBackoff();
+  void saveJoinCache();
+  void notify(bool connected);
 };
 
 #endif // WIFI_MANAGER_H
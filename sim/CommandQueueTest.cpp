@@ -0,0 +1,156 @@
+/**
+ * CommandQueueTest.cpp
+ *
+ * AirConditionerController の送信待ちコマンド（優先度・置き換え）の確認（ホストで実行）
+ * 実機と同じ request() / update() を仮想時計の上で呼び出し、送信された赤外線信号と
+ * 送信待ちの状態が期待どおりかを確認します。
+ *
+ * 実行例:
+ *   pio run -e queuetest && .pio/build/queuetest/program
+ *
+ * 確認に失敗した場合は終了コード 1 を返します。
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include "AirConditionerController.h"
+#include "SimPlatform.h"
+
+namespace {
+
+  constexpr time_t START_EPOCH = 1751328000;  // 2025-07-01 09:00 JST
+
+  int failures = 0;
+
+  void expect(bool condition, const char* name, const char* what) {
+    if (!condition) {
+      printf("NG: %s: %s\n", name, what);
+      failures++;
+    }
+  }
+
+  /**
+   * 仮想時計を送信間隔ぶん進めてから update() を呼ぶ（間隔の待ちで送信が遅れないように）
+   */
+  void step(AirConditionerController& ac) {
+    SimPlatform::advance(AirConditionerController::MIN_FRAME_SPACING_MS);
+    ac.update();
+  }
+
+  /**
+   * 指定したモードを送信済みの状態から始める
+   */
+  void startWith(AirConditionerController& ac, ACMode mode) {
+    SimPlatform::reset(START_EPOCH);
+    ac.begin();
+    ac.request(mode, ACPriority::POLICY);
+    step(ac);
+  }
+
+  /**
+   * 現在のモードと同じ要求が、それより低い優先度の送信待ちに負けない（優先度の逆転がない）
+   */
+  void samePriorityInversion() {
+    const char* name = "現在と同じモードの要求は低い優先度の送信待ちを取り消す";
+    AirConditionerController ac(4, 15);
+    startWith(ac, ACMode::COOLING_20);
+    uint32_t frames = SimPlatform::irFrames();
+    uint32_t coalesced = ac.getQueueStats().coalesced;
+
+    ac.request(ACMode::AUTO_PLUS_1, ACPriority::POLICY);
+    ac.request(ACMode::COOLING_20, ACPriority::USER);  // 利用者が今のモードを維持
+    expect(ac.getQueueStats().depth == 0, name, "送信待ちが残っている");
+    expect(ac.getTargetMode() == ACMode::COOLING_20, name, "送信後のモードが冷房20度でない");
+    step(ac);
+    expect(SimPlatform::irFrames() == frames, name, "信号を送信した");
+    expect(ac.getCurrentMode() == ACMode::COOLING_20, name, "低い優先度のモードに変わった");
+    expect(ac.getQueueStats().coalesced == coalesced + 1, name, "取り消しが数えられていない");
+  }
+
+  /**
+   * 現在のモードと同じ要求は、それより高い優先度の送信待ちは取り消さない
+   */
+  void higherPriorityKept() {
+    const char* name = "現在と同じモードの要求は高い優先度の送信待ちを残す";
+    AirConditionerController ac(4, 15);
+    startWith(ac, ACMode::COOLING_20);
+    uint32_t frames = SimPlatform::irFrames();
+
+    ac.request(ACMode::AUTO_PLUS_1, ACPriority::USER);
+    ac.request(ACMode::COOLING_20, ACPriority::SCHEDULE);
+    expect(ac.getQueueStats().depth == 1, name, "高い優先度の送信待ちが消えた");
+    step(ac);
+    expect(SimPlatform::irFrames() == frames + 1, name, "信号を1回送信していない");
+    expect(ac.getCurrentMode() == ACMode::AUTO_PLUS_1, name, "高い優先度のモードが送信されていない");
+  }
+
+  /**
+   * 同じ優先度の送信待ちは新しい要求で置き換え、現在のモードに戻す要求なら取り消すだけ
+   */
+  void samePriorityReplaced() {
+    const char* name = "同じ優先度の要求は置き換える";
+    AirConditionerController ac(4, 15);
+    startWith(ac, ACMode::COOLING_20);
+    uint32_t frames = SimPlatform::irFrames();
+
+    ac.request(ACMode::AUTO_PLUS_1, ACPriority::POLICY);
+    ac.request(ACMode::DEHUMID_MINUS_1_5, ACPriority::POLICY);
+    step(ac);
+    expect(SimPlatform::irFrames() == frames + 1, name, "信号を1回送信していない");
+    expect(ac.getCurrentMode() == ACMode::DEHUMID_MINUS_1_5, name, "最後の要求が送信されていない");
+
+    frames = SimPlatform::irFrames();
+    ac.request(ACMode::AUTO_PLUS_1, ACPriority::POLICY);
+    ac.request(ACMode::DEHUMID_MINUS_1_5, ACPriority::POLICY);
+    step(ac);
+    expect(SimPlatform::irFrames() == frames, name, "現在のモードに戻す要求で信号を送信した");
+  }
+
+  /**
+   * 停止はどこからの要求でも最も高い優先度になる
+   */
+  void stopWins() {
+    const char* name = "停止は利用者の操作より優先する";
+    AirConditionerController ac(4, 15);
+    startWith(ac, ACMode::COOLING_20);
+
+    ac.request(ACMode::OFF, ACPriority::POLICY);
+    ac.request(ACMode::COOLING_20, ACPriority::USER);
+    expect(ac.getQueueStats().depth == 1, name, "停止の送信待ちが消えた");
+    step(ac);
+    expect(ac.getCurrentMode() == ACMode::OFF, name, "停止が送信されていない");
+  }
+
+  /**
+   * 送信間隔の間に届いた要求は、最後の状態だけを送信する
+   */
+  void spacingCoalesces() {
+    const char* name = "送信間隔の間の要求は最後の状態だけを送信する";
+    AirConditionerController ac(4, 15);
+    startWith(ac, ACMode::COOLING_20);
+    uint32_t frames = SimPlatform::irFrames();
+
+    ac.request(ACMode::AUTO_PLUS_1, ACPriority::POLICY);
+    ac.update();  // 前回の送信から間隔が空いていないため送信しない
+    expect(SimPlatform::irFrames() == frames, name, "間隔を空けずに送信した");
+    ac.request(ACMode::DEHUMID_MINUS_1_5, ACPriority::POLICY);
+    step(ac);
+    expect(SimPlatform::irFrames() == frames + 1, name, "信号を1回送信していない");
+    expect(ac.getCurrentMode() == ACMode::DEHUMID_MINUS_1_5, name, "最後の要求が送信されていない");
+  }
+}
+
+int main() {
+  samePriorityInversion();
+  higherPriorityKept();
+  samePriorityReplaced();
+  stopWins();
+  spacingCoalesces();
+
+  if (failures > 0) {
+    printf("送信待ちコマンド: %d 件の確認に失敗\n", failures);
+    return 1;
+  }
+  printf("送信待ちコマンド: OK\n");
+  return 0;
+}
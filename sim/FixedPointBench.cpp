@@ -0,0 +1,222 @@
+/**
+ * FixedPointBench.cpp
+ *
+ * 固定小数点（FixedPoint.h）のセンサー値・不快指数の計算の確認と計測（ホストで実行）
+ * 以前の実数（float）での計算と比べて、次のことを確認します。
+ *   - 不快指数: DHT22の測定範囲（-40〜80℃、0〜100%、0.1刻み）のすべてで、
+ *     実数で計算して100倍・四捨五入した値との差が丸めの±1以内であること
+ *   - モードの判定: 実数の閾値での判定と一致すること（違うのはDIが閾値から0.005未満の場合だけ）
+ *   - 文字列への変換: snprintf("%.*f") と一致すること（違うのは四捨五入の境界ちょうどの値だけ。
+ *     snprintf は2進数に直した値を丸めるため、26.35 → "26.3" になる）
+ * あわせて、1回あたりの計算時間と SensorData の大きさを表示します。
+ *
+ * 実行例:
+ *   pio run -e fixedbench && .pio/build/fixedbench/program
+ *
+ * 確認に失敗した場合は終了コード 1 を返します。
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include <chrono>
+#include "AirConditionerController.h"
+#include "EnvironmentSensor.h"
+#include "ComfortIndex.h"
+#include "FixedPoint.h"
+
+namespace {
+
+  // DHT22の測定範囲と分解能（0.01単位）
+  constexpr int16_t TEMP_MIN = -4000;
+  constexpr int16_t TEMP_MAX = 8000;
+  constexpr int16_t HUM_MIN = 0;
+  constexpr int16_t HUM_MAX = 10000;
+  constexpr int16_t STEP = 10;
+
+  /**
+   * 以前の SensorData（実数版、大きさの比較用）
+   */
+  struct FloatSensorData {
+    float temperature;
+    float humidity;
+    float discomfortIndex;
+    bool isValid;
+  };
+
+  /**
+   * 以前の AirConditionerController::determineOptimalMode()（実数の閾値）
+   */
+  ACMode floatOptimalMode(float di) {
+    if (di >= 77.0f) return ACMode::COOLING_20;
+    if (di > 75.0f) return ACMode::DEHUMID_MINUS_1_5;
+    return ACMode::AUTO_PLUS_1;  // 70〜75・68未満・68〜70 はいずれも自動+1度
+  }
+
+  /**
+   * 実数のDIがいずれかの閾値から0.005未満か（固定小数点では閾値ちょうどに丸まる）
+   */
+  bool nearThreshold(float di) {
+    const float thresholds[] = { 68.0f, 70.0f, 75.0f, 77.0f };
+    for (float t : thresholds) {
+      if (fabsf(di - t) < 0.005f + 1e-4f) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * snprintf の "-0.0" などを "0.0" に直す（表示では0に符号を付けない）
+   */
+  void stripNegativeZero(char* text) {
+    if (text[0] == '-' && strspn(text + 1, "0.") == strlen(text + 1)) {
+      memmove(text, text + 1, strlen(text));
+    }
+  }
+
+  double nowSec() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+  }
+
+  volatile int32_t sink;  // 計測で計算が省かれないようにする
+
+  /**
+   * 不快指数の比較
+   */
+  bool checkDiscomfortIndex() {
+    uint32_t count = 0;
+    uint32_t differ = 0;
+    int maxDiff = 0;
+    for (int32_t t = TEMP_MIN; t <= TEMP_MAX; t += STEP) {
+      for (int32_t h = HUM_MIN; h <= HUM_MAX; h += STEP) {
+        int16_t fixed = Comfort::discomfortIndex((int16_t)t, (int16_t)h);
+        long reference = lroundf(Comfort::discomfortIndex(t / 100.0f, h / 100.0f) * 100.0f);
+        int diff = abs((int)(fixed - reference));
+        count++;
+        if (diff != 0) {
+          differ++;
+          if (diff > maxDiff) maxDiff = diff;
+        }
+      }
+    }
+    bool ok = maxDiff <= 1;
+    printf("不快指数:   %u 通り / 差あり %u（%.3f%%）/ 最大差 %d（0.01単位）… %s\n",
+           count, differ, 100.0 * differ / count, maxDiff, ok ? "OK" : "NG");
+    return ok;
+  }
+
+  /**
+   * モードの判定の比較
+   */
+  bool checkDecision(AirConditionerController& ac) {
+    uint32_t count = 0;
+    uint32_t differ = 0;
+    uint32_t unexplained = 0;
+    for (int32_t t = TEMP_MIN; t <= TEMP_MAX; t += STEP) {
+      for (int32_t h = HUM_MIN; h <= HUM_MAX; h += STEP) {
+        ACMode fixed = ac.determineOptimalMode((int16_t)t, (int16_t)h);
+        float di = Comfort::discomfortIndex(t / 100.0f, h / 100.0f);
+        count++;
+        if (fixed != floatOptimalMode(di)) {
+          differ++;
+          if (!nearThreshold(di)) {
+            unexplained++;
+          }
+        }
+      }
+    }
+    bool ok = unexplained == 0;
+    printf("モード判定: %u 通り / 不一致 %u（すべて閾値から0.005未満: %s）… %s\n",
+           count, differ, unexplained == 0 ? "はい" : "いいえ", ok ? "OK" : "NG");
+    return ok;
+  }
+
+  /**
+   * 文字列への変換の比較（int16_t のすべての値）
+   */
+  bool checkFormat() {
+    bool ok = true;
+    for (uint8_t decimals = 0; decimals <= 2; decimals++) {
+      int32_t unit = decimals == 0 ? 100 : (decimals == 1 ? 10 : 1);
+      uint32_t differ = 0;
+      uint32_t unexplained = 0;
+      for (int32_t centi = INT16_MIN; centi <= INT16_MAX; centi++) {
+        char fixed[16];
+        char reference[32];
+        Fixed::format(fixed, sizeof(fixed), centi, decimals);
+        snprintf(reference, sizeof(reference), "%.*f", decimals, centi / 100.0);
+        stripNegativeZero(reference);
+        if (strcmp(fixed, reference) != 0) {
+          differ++;
+          if (abs(centi) % unit != unit / 2) {
+            unexplained++;
+          }
+        }
+      }
+      printf("文字列変換: 小数点以下%u桁 / 65536 通り / 不一致 %u（すべて四捨五入の境界ちょうど: %s）\n",
+             decimals, differ, unexplained == 0 ? "はい" : "いいえ");
+      ok = ok && unexplained == 0;
+    }
+    printf("文字列変換: … %s\n", ok ? "OK" : "NG");
+    return ok;
+  }
+
+  /**
+   * 1回あたりの計算時間（センサー値1件: DIの計算と、温度・湿度・DIの文字列への変換）
+   */
+  void measure() {
+    constexpr int ROUNDS = 20;
+    uint32_t calls = 0;
+
+    double start = nowSec();
+    for (int r = 0; r < ROUNDS; r++) {
+      for (int32_t t = 2000; t <= 3500; t += STEP) {
+        for (int32_t h = 3000; h <= 8000; h += STEP) {
+          float temperature = t / 100.0f;
+          float humidity = h / 100.0f;
+          float di = Comfort::discomfortIndex(temperature, humidity);
+          char buf[3][16];
+          snprintf(buf[0], sizeof(buf[0]), "%.1f", temperature);
+          snprintf(buf[1], sizeof(buf[1]), "%.1f", humidity);
+          snprintf(buf[2], sizeof(buf[2]), "%.1f", di);
+          sink = buf[0][1] + buf[1][1] + buf[2][1];
+          calls++;
+        }
+      }
+    }
+    double floatSec = nowSec() - start;
+
+    start = nowSec();
+    for (int r = 0; r < ROUNDS; r++) {
+      for (int32_t t = 2000; t <= 3500; t += STEP) {
+        for (int32_t h = 3000; h <= 8000; h += STEP) {
+          int16_t di = Comfort::discomfortIndex((int16_t)t, (int16_t)h);
+          char buf[3][16];
+          Fixed::format(buf[0], sizeof(buf[0]), t, 1);
+          Fixed::format(buf[1], sizeof(buf[1]), h, 1);
+          Fixed::format(buf[2], sizeof(buf[2]), di, 1);
+          sink = buf[0][1] + buf[1][1] + buf[2][1];
+        }
+      }
+    }
+    double fixedSec = nowSec() - start;
+
+    printf("計算時間:   実数 %.1f ns / 固定小数点 %.1f ns（センサー値1件あたり、%u 件、ホストのCPU）\n",
+           floatSec * 1e9 / calls, fixedSec * 1e9 / calls, calls);
+    printf("SensorData: 実数 %u バイト / 固定小数点 %u バイト\n",
+           (unsigned)sizeof(FloatSensorData), (unsigned)sizeof(SensorData));
+  }
+}
+
+int main() {
+  AirConditionerController airConditioner(4, 15);  // ピン番号は使わない
+
+  bool ok = checkDiscomfortIndex();
+  ok = checkDecision(airConditioner) && ok;
+  ok = checkFormat() && ok;
+  measure();
+  return ok ? 0 : 1;
+}
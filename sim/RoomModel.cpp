@@ -0,0 +1,161 @@
+/**
+ * RoomModel.cpp
+ *
+ * 部屋の温度・湿度モデルの実装
+ */
+
+#include "RoomModel.h"
+
+namespace {
+  constexpr float AIR_HEAT_J_PER_M3K = 1200.0f;   // 空気の容積比熱（J/(m³·K)）
+  constexpr float LATENT_J_PER_G = 2450.0f;       // 水の蒸発潜熱（J/g）
+  constexpr float COIL_DEW_POINT = 12.0f;         // 室内の露点がこれより低いと除湿できない
+  constexpr float AUTO_DEADBAND = 1.0f;           // 自動運転の冷暖房切り替え幅（℃）
+
+  float clampf(float v, float lo, float hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+  }
+
+  /**
+   * 飽和水蒸気圧（hPa、Magnusの式）
+   */
+  float saturationPressure(float temperature) {
+    return 6.112f * expf(17.62f * temperature / (243.12f + temperature));
+  }
+
+  /**
+   * 絶対湿度（g/m³）から露点を求める
+   */
+  float dewPointOf(float vapor, float temperature) {
+    float e = vapor * (temperature + 273.15f) / 216.7f;
+    float x = logf(e / 6.112f);
+    return 243.12f * x / (17.62f - x);
+  }
+}
+
+RoomParams RoomParams::defaults() {
+  RoomParams p;
+  p.heatCapacityKJ = 900.0f;
+  p.conductanceW = 55.0f;
+  p.airChangesPerHour = 0.5f;
+  p.volumeM3 = 24.0f;
+  p.internalGainW = 250.0f;
+  p.solarGainW = 500.0f;
+  p.moistureGainGPerH = 80.0f;
+  p.coolingCapacityW = 2200.0f;
+  p.heatingCapacityW = 2500.0f;
+  p.dryCapacityW = 900.0f;
+  p.gainWPerK = 700.0f;
+  p.coolLatentRatio = 0.25f;
+  p.dryLatentRatio = 0.6f;
+  p.cop = 4.0f;
+  p.standbyW = 20.0f;
+  return p;
+}
+
+RoomModel::RoomModel(const RoomParams& params)
+  : params_(params),
+    temperature_(25.0f),
+    vapor_(12.0f),
+    acPowerW_(0.0f),
+    electricW_(0.0f),
+    autoDirection_(0) {
+}
+
+void RoomModel::reset(float temperature, float humidity) {
+  temperature_ = temperature;
+  vapor_ = saturationDensity(temperature) * humidity / 100.0f;
+  acPowerW_ = 0.0f;
+  electricW_ = 0.0f;
+  autoDirection_ = 0;
+}
+
+float RoomModel::saturationDensity(float temperature) {
+  return 216.7f * saturationPressure(temperature) / (temperature + 273.15f);
+}
+
+float RoomModel::getHumidity() const {
+  return clampf(100.0f * vapor_ / saturationDensity(temperature_), 0.0f, 100.0f);
+}
+
+/**
+ * 時間を進める（陽解法、設定温度付近での発振を避けるため呼び出し側で刻みを小さくする）
+ */
+void RoomModel::step(float seconds, const OutdoorState& outdoor, const DaikinState& ac) {
+  float latentRatio = 0.0f;
+  float acW = acSensibleW(ac, latentRatio);
+
+  // 熱の出入り（W）
+  float ventilationWPerK = params_.airChangesPerHour * params_.volumeM3 * AIR_HEAT_J_PER_M3K / 3600.0f;
+  float heatW = (params_.conductanceW + ventilationWPerK) * (outdoor.temperature - temperature_)
+              + params_.internalGainW
+              + params_.solarGainW * clampf(outdoor.sun, 0.0f, 1.0f)
+              + acW;
+  temperature_ += heatW * seconds / (params_.heatCapacityKJ * 1000.0f);
+
+  // 水蒸気の出入り（g/s）
+  float outdoorVapor = saturationDensity(outdoor.dewPoint);
+  float vaporGs = params_.airChangesPerHour * params_.volumeM3 / 3600.0f * (outdoorVapor - vapor_)
+                + params_.moistureGainGPerH / 3600.0f;
+  if (acW < 0.0f && latentRatio > 0.0f) {
+    // 冷却能力の一部が除湿に使われる（室内の露点が低いほど除湿できない）
+    float dew = dewPointOf(vapor_, temperature_);
+    float effectiveness = clampf((dew - COIL_DEW_POINT) / 4.0f, 0.0f, 1.0f);
+    vaporGs -= (-acW) * latentRatio / (1.0f - latentRatio) / LATENT_J_PER_G * effectiveness;
+  }
+  vapor_ += vaporGs * seconds / params_.volumeM3;
+  float saturation = saturationDensity(temperature_);
+  vapor_ = clampf(vapor_, 0.5f, saturation);
+
+  acPowerW_ = acW;
+  electricW_ = ac.power ? params_.standbyW + fabsf(acW) / (1.0f - latentRatio) / params_.cop : 0.0f;
+}
+
+/**
+ * エアコンの顕熱能力（W、正: 暖房, 負: 冷房）
+ * @param latentRatio 除湿に使われる割合（出力）
+ */
+float RoomModel::acSensibleW(const DaikinState& ac, float& latentRatio) {
+  latentRatio = 0.0f;
+  if (!ac.power) {
+    autoDirection_ = 0;
+    return 0.0f;
+  }
+
+  float error = temperature_ - ac.temp;  // 正: 設定温度より暑い
+  switch (ac.mode) {
+    case kDaikinCool:
+      latentRatio = params_.coolLatentRatio;
+      return -clampf(error * params_.gainWPerK, 0.0f, params_.coolingCapacityW);
+
+    case kDaikinDry:
+      // 除湿運転は能力を絞って冷やしすぎを防ぐ（設定温度より低くても弱く運転を続ける）
+      latentRatio = params_.dryLatentRatio;
+      return -clampf((error + 1.0f) * params_.gainWPerK * 0.5f, 0.0f, params_.dryCapacityW);
+
+    case kDaikinHeat:
+      return clampf(-error * params_.gainWPerK, 0.0f, params_.heatingCapacityW);
+
+    case kDaikinAuto:
+      // 設定温度±AUTO_DEADBANDを超えたら冷房・暖房を切り替え、設定温度に戻るまで続ける
+      if (error > AUTO_DEADBAND) {
+        autoDirection_ = -1;
+      } else if (error < -AUTO_DEADBAND) {
+        autoDirection_ = 1;
+      } else if ((autoDirection_ < 0 && error <= 0.0f) || (autoDirection_ > 0 && error >= 0.0f)) {
+        autoDirection_ = 0;
+      }
+      if (autoDirection_ < 0) {
+        latentRatio = params_.coolLatentRatio;
+        return -clampf(error * params_.gainWPerK, 0.0f, params_.coolingCapacityW);
+      }
+      if (autoDirection_ > 0) {
+        return clampf(-error * params_.gainWPerK, 0.0f, params_.heatingCapacityW);
+      }
+      return 0.0f;
+
+    default:
+      // 送風のみ
+      return 0.0f;
+  }
+}
@@ -0,0 +1,100 @@
+/**
+ * RoomModel.h
+ *
+ * 部屋の温度・湿度モデル（シミュレーター用）
+ * 外気・日射・室内の発熱と、エアコンの運転（受信した設定）から室温・湿度の変化を計算します。
+ */
+
+#ifndef ROOM_MODEL_H
+#define ROOM_MODEL_H
+
+#include <ir_Daikin.h>
+
+/**
+ * 部屋とエアコンのパラメータ（6畳・2.2kW級のエアコンを想定した値が初期値）
+ */
+struct RoomParams {
+  float heatCapacityKJ;       // 熱容量（kJ/K、空気だけでなく家具・内壁の一部を含む）
+  float conductanceW;         // 外気との熱の通りやすさ（W/K、壁・窓）
+  float airChangesPerHour;    // 換気回数（回/時）
+  float volumeM3;             // 容積（m³）
+  float internalGainW;        // 人・家電の発熱（W）
+  float solarGainW;           // 晴天時の日射による発熱の最大値（W、正午）
+  float moistureGainGPerH;    // 人などから出る水蒸気（g/h）
+  float coolingCapacityW;     // 冷房の最大能力（W）
+  float heatingCapacityW;     // 暖房の最大能力（W）
+  float dryCapacityW;         // 除湿運転時の最大冷却能力（W）
+  float gainWPerK;            // 設定温度との差1℃あたりの能力（W/K、インバーターの比例制御）
+  float coolLatentRatio;      // 冷房時の冷却能力のうち除湿に使われる割合
+  float dryLatentRatio;       // 除湿運転時の同割合
+  float cop;                  // 成績係数（消費電力 = 能力 / COP）
+  float standbyW;             // 運転中（圧縮機停止中も含む）の送風・制御の消費電力（W）
+
+  static RoomParams defaults();
+};
+
+/**
+ * 外気の状態
+ */
+struct OutdoorState {
+  float temperature;   // 気温（℃）
+  float dewPoint;      // 露点（℃）
+  float sun;           // 日射の強さ（0: 夜間・雨天 〜 1: 晴天の正午）
+};
+
+/**
+ * 部屋の温度・湿度モデル
+ *
+ * 室温: C dT/dt = UA(T外 - T) + 換気 + 室内の発熱 + 日射 + エアコン
+ * 湿度: 絶対湿度（g/m³）を換気・室内の水蒸気・エアコンの除湿で変化させ、相対湿度に換算
+ *
+ * エアコンは設定温度との差に比例した能力で運転し（最大能力で頭打ち）、
+ * 自動運転は設定温度±1℃を超えた時に冷房・暖房を切り替えます。
+ */
+class RoomModel {
+public:
+  explicit RoomModel(const RoomParams& params);
+
+  /**
+   * 初期状態を設定
+   */
+  void reset(float temperature, float humidity);
+
+  /**
+   * 時間を進める
+   * @param seconds 経過時間（秒、60秒以下を想定）
+   * @param outdoor 外気の状態
+   * @param ac エアコンが受信している設定
+   */
+  void step(float seconds, const OutdoorState& outdoor, const DaikinState& ac);
+
+  float getTemperature() const { return temperature_; }
+  float getHumidity() const;
+
+  /**
+   * 直前のstep()でのエアコンの能力（W、正: 暖房, 負: 冷房）
+   */
+  float getAcPowerW() const { return acPowerW_; }
+
+  /**
+   * 直前のstep()でのエアコンの消費電力（W）
+   */
+  float getElectricW() const { return electricW_; }
+
+  /**
+   * 飽和水蒸気量（g/m³）
+   */
+  static float saturationDensity(float temperature);
+
+private:
+  RoomParams params_;
+  float temperature_;   // 室温（℃）
+  float vapor_;         // 絶対湿度（g/m³）
+  float acPowerW_;
+  float electricW_;
+  int8_t autoDirection_;  // 自動運転の状態（1: 暖房, -1: 冷房, 0: 送風のみ）
+
+  float acSensibleW(const DaikinState& ac, float& latentRatio);
+};
+
+#endif // ROOM_MODEL_H
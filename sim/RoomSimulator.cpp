@@ -0,0 +1,577 @@
+/**
+ * RoomSimulator.cpp
+ *
+ * エアコン制御のシミュレーター（ホストで実行）
+ * 部屋の温度・湿度モデルと外気のシナリオに対して、実機と同じ AirConditionerController・
+ * AutoStopController・ScheduleEngine・TimeManager を仮想時計で動かし、制御方策ごとに
+ * 快適範囲（DI）に収まった時間・赤外線の送信回数・エアコンの運転時間を比較します。
+ *
+ * 実行例:
+ *   pio run -e sim && .pio/build/sim/program
+ *   .pio/build/sim/program --scenario summer --days 30 --policy optimal
+ *   .pio/build/sim/program --weather tokyo_2024_08.csv --param conductanceW=80 --csv
+ *   .pio/build/sim/program --scenario summer --policy optimal --trace sim.bin   # TraceReplay の確認用
+ *   .pio/build/sim/program --fixed-sampling     # センサーを2秒ごとに読む（適応サンプリングとの比較用）
+ *
+ * 仮想時計は実時間を待たずに進むため、1日分を数十ミリ秒程度で計算できます。
+ * 結果は決定的（乱数なし）なので、制御を変更した前後で --csv の出力を比較すれば回帰確認になります。
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "AirConditionerController.h"
+#include "AutoStopController.h"
+#include "ScheduleEngine.h"
+#include "TimeManager.h"
+#include "ComfortIndex.h"
+#include "EnvironmentSensor.h"
+#include "ThermalModel.h"
+#include "TraceFormat.h"
+#include "SimConfig.h"
+#include "SimPlatform.h"
+#include "RoomModel.h"
+#include "WeatherScenario.h"
+
+// ========================================
+// 設定
+// ========================================
+
+namespace RoomConfig {
+  constexpr float START_HUMIDITY = 60.0f;                   // 開始時の室内の湿度（%）
+  constexpr float START_TEMP_ABOVE_OUTDOOR = 2.0f;          // 開始時の室温（外気との差）
+
+  // 快適範囲（AirConditionerController.cpp の DIThreshold::TARGET_MIN / TARGET_MAX）
+  constexpr float COMFORT_MIN = 70.0f;
+  constexpr float COMFORT_MAX = 75.0f;
+}
+
+// ========================================
+// 制御方策
+// ========================================
+
+/**
+ * 制御方策に渡す状態（センサー値と、天気予報から推定した外気温）
+ */
+struct PolicyInput {
+  AirConditionerController& ac;
+  ThermalModel& model;
+  int16_t temperature;  // 室温（0.01℃単位、実機の SensorData と同じ）
+  int16_t humidity;     // 湿度（0.01%単位）
+  float outdoorNow;     // 現在の外気温（天気予報の最高・最低気温から推定）
+  float outdoorLater;   // 予測時間後の外気温（同）
+};
+
+/**
+ * 制御方策（CONTROL_INTERVAL_MSごとに、センサー値からモードを決める）
+ */
+struct Policy {
+  const char* name;
+  const char* description;
+  ACMode (*decide)(const PolicyInput& in);
+};
+
+const Policy POLICIES[] = {
+  { "optimal", "determineOptimalMode()（DIに応じて冷房・除湿・自動を選択）",
+    [](const PolicyInput& in) { return in.ac.determineOptimalMode(in.temperature, in.humidity); } },
+  { "predict", "optimal ＋ 熱モデルの予測で先に冷やす（ThermalModel::anticipate()）",
+    [](const PolicyInput& in) {
+      ACMode reactive = in.ac.determineOptimalMode(in.temperature, in.humidity);
+      return in.model.anticipate(in.ac, reactive, in.temperature, in.humidity, in.ac.getCurrentMode(),
+                                 in.outdoorNow, in.outdoorLater);
+    } },
+  { "auto", "常に自動+1度",
+    [](const PolicyInput&) { return ACMode::AUTO_PLUS_1; } },
+  { "dry", "常に除湿-1.5度",
+    [](const PolicyInput&) { return ACMode::DEHUMID_MINUS_1_5; } },
+  { "off", "エアコンを使わない（比較用）",
+    [](const PolicyInput&) { return ACMode::OFF; } },
+};
+
+// ========================================
+// 部屋のパラメータ（--param 名前=値 で変更）
+// ========================================
+
+const struct {
+  const char* name;
+  float RoomParams::*member;
+} ROOM_PARAMS[] = {
+  { "heatCapacityKJ",    &RoomParams::heatCapacityKJ },
+  { "conductanceW",      &RoomParams::conductanceW },
+  { "airChangesPerHour", &RoomParams::airChangesPerHour },
+  { "volumeM3",          &RoomParams::volumeM3 },
+  { "internalGainW",     &RoomParams::internalGainW },
+  { "solarGainW",        &RoomParams::solarGainW },
+  { "moistureGainGPerH", &RoomParams::moistureGainGPerH },
+  { "coolingCapacityW",  &RoomParams::coolingCapacityW },
+  { "heatingCapacityW",  &RoomParams::heatingCapacityW },
+  { "dryCapacityW",      &RoomParams::dryCapacityW },
+  { "gainWPerK",         &RoomParams::gainWPerK },
+  { "coolLatentRatio",   &RoomParams::coolLatentRatio },
+  { "dryLatentRatio",    &RoomParams::dryLatentRatio },
+  { "cop",               &RoomParams::cop },
+  { "standbyW",          &RoomParams::standbyW },
+};
+
+// ========================================
+// シミュレーション
+// ========================================
+
+struct Options {
+  int days = 14;
+  bool autoStop = true;
+  bool csv = false;
+  bool fixedSampling = false;        // センサーを最短の間隔で読み続ける（適応サンプリングなし）
+  const char* tracePath = nullptr;   // 実機と同じ形式のトレースを書き出す（TraceReplay の確認用）
+};
+
+/**
+ * トレースのファイル出力（実機の TraceRecorder と同じ形式。センサー値・時刻・天気予報・判定結果のみ）
+ */
+class TraceOutput {
+public:
+  TraceOutput() : file_(nullptr), writer_(buffer_, sizeof(buffer_)) {}
+  ~TraceOutput() { close(); }
+
+  bool open(const char* path) {
+    file_ = fopen(path, "wb");
+    if (file_ != nullptr) {
+      writer_.fileHeader();
+    }
+    return file_ != nullptr;
+  }
+
+  void write(const Trace::Record& record) {
+    if (file_ == nullptr) {
+      return;
+    }
+    if (!writer_.hasRoom()) {
+      flush();
+    }
+    writer_.write(record);
+  }
+
+  void close() {
+    if (file_ != nullptr) {
+      flush();
+      fclose(file_);
+      file_ = nullptr;
+    }
+  }
+
+private:
+  FILE* file_;
+  uint8_t buffer_[1024];
+  Trace::Writer writer_;
+
+  void flush() {
+    fwrite(writer_.data(), 1, writer_.length(), file_);
+    writer_.clear();
+  }
+};
+
+/**
+ * 1回のシミュレーションの結果（センサーの読み取り値ではなく部屋の実際の値を、読み取り間隔ごとに集計）
+ */
+struct Result {
+  double seconds = 0;
+  double comfortSec = 0;    // DIが快適範囲内だった時間
+  double hotSec = 0;        // 快適範囲より暑かった時間
+  double coldSec = 0;       // 快適範囲より寒かった時間
+  double excessDiHours = 0; // 快適範囲からのはみ出し（DI×時間）
+  double diSum = 0;         // 平均DI用（DI×秒）
+  float diMin = 1000.0f;
+  float diMax = -1000.0f;
+  double runtimeSec = 0;    // エアコンの電源が入っていた時間
+  double energyWs = 0;      // 消費電力量（W·s）
+  uint32_t irSends = 0;     // 赤外線の送信回数
+  uint32_t modeChanges = 0; // 制御方策がモードを変えた回数（スケジュールによる停止を除く）
+  uint32_t sensorReads = 0; // センサーの読み取り回数
+};
+
+/**
+ * センサーの分解能（DHT22は0.1単位）
+ */
+float quantize(float value) {
+  return roundf(value * 10.0f) / 10.0f;
+}
+
+/**
+ * 現在の日（シナリオの何日目か）
+ */
+int scenarioDay(const WeatherScenario& scenario, time_t epoch) {
+  int day = (int)((epoch - scenario.getStartEpoch()) / 86400);
+  if (day < 0) day = 0;
+  if (day >= scenario.getDays()) day = scenario.getDays() - 1;
+  return day;
+}
+
+Result simulate(const WeatherScenario& scenario, const Policy& policy,
+                const RoomParams& params, const Options& options) {
+  SimPlatform::reset(scenario.getStartEpoch());
+
+  // 実機と同じ制御クラス（ピン番号はシミュレーターでは使わない）
+  AirConditionerController airConditioner(4, 15);
+  TimeManager timeMgr("sim", SimConfig::GMT_OFFSET_SEC, 0);
+  ScheduleEngine scheduler(airConditioner, timeMgr);
+  AutoStopController autoStop(scheduler, SimConfig::AUTO_STOP_HOUR);
+
+  airConditioner.begin();
+  timeMgr.begin();
+  autoStop.begin();
+  if (!options.autoStop) {
+    autoStop.setEnabled(false);
+  }
+  SimPlatform::syncClock();
+
+  TraceOutput trace;
+  if (options.tracePath != nullptr) {
+    if (!trace.open(options.tracePath)) {
+      fprintf(stderr, "トレースを書き出せません: %s\n", options.tracePath);
+    }
+    Trace::Record start = Trace::make(Trace::START, 0);
+    start.sequence = 1;
+    strncpy(start.build, "room_sim", Trace::MAX_BUILD - 1);
+    trace.write(start);
+    Trace::Record clock = Trace::make(Trace::CLOCK, 0);
+    clock.epoch = (uint32_t)SimPlatform::epoch();
+    trace.write(clock);
+  }
+
+  ThermalModel thermalModel(SimConfig::THERMAL_SAMPLE_INTERVAL_SEC, SimConfig::THERMAL_HORIZON_SEC);
+
+  // 実機の EnvironmentSensor と同じ読み取り間隔の決め方
+  AdaptiveSampler sampler(SimConfig::SENSOR_READ_INTERVAL_MS,
+                          options.fixedSampling ? SimConfig::SENSOR_READ_INTERVAL_MS
+                                                : SimConfig::SENSOR_READ_MAX_INTERVAL_MS,
+                          options.fixedSampling ? SimConfig::SENSOR_READ_INTERVAL_MS
+                                                : SimConfig::CONTROL_INTERVAL_MS);
+  ACMode sampledMode = airConditioner.getCurrentMode();
+
+  RoomModel room(params);
+  OutdoorState outdoor = scenario.at(0.0);
+  room.reset(outdoor.temperature + RoomConfig::START_TEMP_ABOVE_OUTDOOR, RoomConfig::START_HUMIDITY);
+
+  Result result;
+  uint64_t endMs = (uint64_t)options.days * 86400000ULL;
+  uint64_t physicsMs = 0;                              // 部屋のモデルを計算済みの時刻
+  uint64_t lastControlMs = 0;
+  int forecastDay = -1;
+  float forecastMax = 0, forecastMin = 0;              // その日の天気予報（実機の予報と同じ0.1℃単位）
+
+  while (SimPlatform::nowMs() < endMs) {
+    // main.cpp の loop() と同じ順序（通信関連を除く）
+    timeMgr.update();
+    scheduler.update();
+    airConditioner.update();  // 赤外線送信中の delay() で仮想時計が進む
+
+    uint64_t now = SimPlatform::nowMs();
+    if (airConditioner.getCurrentMode() != sampledMode) {
+      sampledMode = airConditioner.getCurrentMode();
+      sampler.notifyTransition((unsigned long)now, AirConditionerController::isRunning(sampledMode));
+    }
+    if (sampler.isDue((unsigned long)now)) {
+      // 天気予報（日が変わったら、その日の最高・最低気温）
+      int day = scenarioDay(scenario, timeMgr.epoch());
+      if (day != forecastDay) {
+        forecastDay = day;
+        forecastMax = quantize(scenario.getDay(day).tempMax);
+        forecastMin = quantize(scenario.getDay(day).tempMin);
+        Trace::Record weather = Trace::make(Trace::WEATHER, now);
+        weather.valid = true;
+        weather.tempMax = (int16_t)lroundf(forecastMax * 10.0f);
+        weather.tempMin = (int16_t)lroundf(forecastMin * 10.0f);
+        weather.weatherCode = (int16_t)scenario.getDay(day).weatherCode;
+        trace.write(weather);
+      }
+
+      // 実機の EnvironmentSensor::read() と同じく、センサーの実数値を入口で固定小数点に変換する
+      int16_t temperature = Fixed::fromFloat(quantize(room.getTemperature()));
+      int16_t humidity = Fixed::fromFloat(quantize(room.getHumidity()));
+      Trace::Record sensor = Trace::make(Trace::SENSOR, now);
+      sensor.valid = true;
+      sensor.temperature = temperature;
+      sensor.humidity = humidity;
+      trace.write(sensor);
+      sampler.onSample((unsigned long)now, SensorData(temperature, humidity, true));
+      result.sensorReads++;
+
+      if (now - lastControlMs >= SimConfig::CONTROL_INTERVAL_MS) {
+        lastControlMs = now;
+        // 実機（main.cpp の forecastOutdoor()）と同じく、外気温は天気予報の最高・最低気温からの推定値を使う
+        const struct tm& local = timeMgr.now();
+        float hour = local.tm_hour + local.tm_min / 60.0f;
+        float outdoorNow = ThermalModel::outdoorTemperature(forecastMax, forecastMin, hour);
+        float outdoorLater = ThermalModel::outdoorTemperature(forecastMax, forecastMin,
+                                                              hour + SimConfig::THERMAL_HORIZON_SEC / 3600.0f);
+        thermalModel.update((unsigned long)now, temperature, airConditioner.getCurrentMode(),
+                            outdoorNow, outdoorLater);
+        PolicyInput input = { airConditioner, thermalModel, temperature, humidity, outdoorNow, outdoorLater };
+        ACMode mode = policy.decide(input);
+        Trace::Record decision = Trace::make(Trace::DECISION, now);
+        decision.mode = (uint8_t)mode;
+        trace.write(decision);
+        if (mode != airConditioner.getCurrentMode()) {
+          result.modeChanges++;
+        }
+        airConditioner.request(mode, ACPriority::POLICY);  // 次の loop() で送信
+      }
+    }
+
+    // 次の loop() の目安（最短の読み取り間隔、スケジュールの確認もこの間隔で行う）まで部屋のモデルを進める
+    uint64_t target = SimPlatform::nowMs() + SimConfig::SENSOR_READ_INTERVAL_MS;
+    if (target > endMs) {
+      target = endMs;
+    }
+    if (target < SimPlatform::nowMs()) {
+      target = SimPlatform::nowMs();
+    }
+    while (physicsMs < target) {
+      uint64_t stepMs = target - physicsMs;
+      if (stepMs > SimConfig::SENSOR_READ_INTERVAL_MS) {
+        stepMs = SimConfig::SENSOR_READ_INTERVAL_MS;
+      }
+      float dt = stepMs / 1000.0f;
+      const DaikinState& ac = SimPlatform::acState();
+      room.step(dt, scenario.at(physicsMs / 1000.0), ac);
+      physicsMs += stepMs;
+
+      float di = Comfort::discomfortIndex(room.getTemperature(), room.getHumidity());
+      result.seconds += dt;
+      result.diSum += di * dt;
+      if (di < result.diMin) result.diMin = di;
+      if (di > result.diMax) result.diMax = di;
+      if (di > RoomConfig::COMFORT_MAX) {
+        result.hotSec += dt;
+        result.excessDiHours += (di - RoomConfig::COMFORT_MAX) * dt / 3600.0;
+      } else if (di < RoomConfig::COMFORT_MIN) {
+        result.coldSec += dt;
+        result.excessDiHours += (RoomConfig::COMFORT_MIN - di) * dt / 3600.0;
+      } else {
+        result.comfortSec += dt;
+      }
+      if (ac.power) {
+        result.runtimeSec += dt;
+      }
+      result.energyWs += room.getElectricW() * dt;
+    }
+    if (SimPlatform::nowMs() < target) {
+      SimPlatform::advance((unsigned long)(target - SimPlatform::nowMs()));
+    }
+  }
+
+  result.irSends = airConditioner.getStats().irSendCount;
+  return result;
+}
+
+// ========================================
+// 出力
+// ========================================
+
+/**
+ * 表示幅（全角文字は2桁として数える。表の見出しを揃えるため）
+ */
+int displayWidth(const char* text) {
+  int width = 0;
+  for (const unsigned char* p = (const unsigned char*)text; *p != 0; p++) {
+    if (*p < 0x80) {
+      width += 1;
+    } else if ((*p & 0xC0) != 0x80) {
+      width += (*p == 0xC2) ? 1 : 2;  // U+0080〜U+00FF（「·」など）は半角
+    }
+  }
+  return width;
+}
+
+void printScenario(const WeatherScenario& scenario) {
+  float maxSum = 0, minSum = 0, dewSum = 0;
+  for (int d = 0; d < scenario.getDays(); d++) {
+    maxSum += scenario.getDay(d).tempMax;
+    minSum += scenario.getDay(d).tempMin;
+    dewSum += scenario.getDay(d).dewPoint;
+  }
+  int n = scenario.getDays();
+  time_t start = scenario.getStartEpoch() + SimConfig::GMT_OFFSET_SEC;
+  struct tm date;
+  gmtime_r(&start, &date);
+  printf("\nシナリオ: %s（%04d-%02d-%02d から %d 日、外気の平均 最高 %.1f℃ / 最低 %.1f℃ / 露点 %.1f℃）\n",
+         scenario.getName(), date.tm_year + 1900, date.tm_mon + 1, date.tm_mday, n,
+         maxSum / n, minSum / n, dewSum / n);
+  const char* const headers[] = {
+    "快適(%)", "暑い(%)", "寒い(%)", "超過(DI·h)", "平均DI", "IR送信", "切替", "運転(h)", "電力(kWh)", "読取/h"
+  };
+  const int widths[] = { 8, 8, 8, 10, 8, 8, 8, 9, 9, 8 };
+  printf("  方策    ");
+  for (size_t i = 0; i < sizeof(widths) / sizeof(widths[0]); i++) {
+    printf(" %*s%s", widths[i] - displayWidth(headers[i]), "", headers[i]);
+  }
+  printf("\n");
+}
+
+void printResult(const WeatherScenario& scenario, const Policy& policy, const Result& r, bool csv) {
+  double pct = r.seconds > 0 ? 100.0 / r.seconds : 0.0;
+  double meanDi = r.seconds > 0 ? r.diSum / r.seconds : 0.0;
+  double readsPerHour = r.seconds > 0 ? r.sensorReads * 3600.0 / r.seconds : 0.0;
+  if (csv) {
+    printf("%s,%s,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%lu,%lu,%.2f,%.3f,%.1f\n",
+           scenario.getName(), policy.name, r.comfortSec * pct, r.hotSec * pct, r.coldSec * pct,
+           r.excessDiHours, meanDi, r.diMin, r.diMax, (unsigned long)r.irSends,
+           (unsigned long)r.modeChanges, r.runtimeSec / 3600.0, r.energyWs / 3.6e6, readsPerHour);
+    return;
+  }
+  printf("  %-8s %8.1f %8.1f %8.1f %10.1f %8.1f %8lu %8lu %9.1f %9.2f %8.0f\n",
+         policy.name, r.comfortSec * pct, r.hotSec * pct, r.coldSec * pct, r.excessDiHours, meanDi,
+         (unsigned long)r.irSends, (unsigned long)r.modeChanges, r.runtimeSec / 3600.0, r.energyWs / 3.6e6,
+         readsPerHour);
+}
+
+void printUsage(const char* program) {
+  fprintf(stderr,
+    "使い方: %s [オプション]\n"
+    "  --scenario 名前     組み込みのシナリオ（summer / rainy / autumn / all、デフォルト: all）\n"
+    "  --weather ファイル  外気をCSVから読み込む（YYYY-MM-DD,最高,最低,露点,天気コード）\n"
+    "  --days N            日数（組み込みのシナリオのみ、デフォルト: 14）\n"
+    "  --policy 名前       制御方策（all または下記、デフォルト: all）\n"
+    "  --param 名前=値     部屋・エアコンのパラメータを変更（複数指定可）\n"
+    "  --no-autostop       23時の自動停止を無効にする\n"
+    "  --csv               CSVで出力（回帰確認用）\n"
+    "  --fixed-sampling    センサーを2秒ごとに読む（適応サンプリングとの比較用）\n"
+    "  --trace ファイル    実機と同じ形式のトレースを書き出す（シナリオ・制御方策を1つに絞って指定）\n"
+    "\n制御方策:\n", program);
+  for (const Policy& p : POLICIES) {
+    fprintf(stderr, "  %-8s %s\n", p.name, p.description);
+  }
+  fprintf(stderr, "\nパラメータ（初期値）:\n");
+  RoomParams defaults = RoomParams::defaults();
+  for (const auto& p : ROOM_PARAMS) {
+    fprintf(stderr, "  %-18s %g\n", p.name, defaults.*(p.member));
+  }
+}
+
+// ========================================
+// メイン
+// ========================================
+
+int main(int argc, char** argv) {
+  Options options;
+  RoomParams params = RoomParams::defaults();
+  const char* scenarioName = "all";
+  const char* weatherPath = nullptr;
+  const char* policyName = "all";
+
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (strcmp(arg, "--scenario") == 0 && value) {
+      scenarioName = value; i++;
+    } else if (strcmp(arg, "--weather") == 0 && value) {
+      weatherPath = value; i++;
+    } else if (strcmp(arg, "--days") == 0 && value) {
+      options.days = atoi(value); i++;
+    } else if (strcmp(arg, "--policy") == 0 && value) {
+      policyName = value; i++;
+    } else if (strcmp(arg, "--param") == 0 && value) {
+      const char* eq = strchr(value, '=');
+      bool found = false;
+      for (const auto& p : ROOM_PARAMS) {
+        if (eq != nullptr && strlen(p.name) == (size_t)(eq - value) &&
+            strncmp(p.name, value, eq - value) == 0) {
+          params.*(p.member) = (float)atof(eq + 1);
+          found = true;
+        }
+      }
+      if (!found) {
+        fprintf(stderr, "不明なパラメータ: %s\n", value);
+        return 2;
+      }
+      i++;
+    } else if (strcmp(arg, "--no-autostop") == 0) {
+      options.autoStop = false;
+    } else if (strcmp(arg, "--csv") == 0) {
+      options.csv = true;
+    } else if (strcmp(arg, "--fixed-sampling") == 0) {
+      options.fixedSampling = true;
+    } else if (strcmp(arg, "--trace") == 0 && value) {
+      options.tracePath = value; i++;
+    } else {
+      printUsage(argv[0]);
+      return 2;
+    }
+  }
+  if (options.days < 1) {
+    fprintf(stderr, "--days は1以上を指定してください\n");
+    return 2;
+  }
+
+  // シナリオ
+  std::vector<WeatherScenario> scenarios;
+  if (weatherPath != nullptr) {
+    WeatherScenario scenario;
+    if (!scenario.loadCsv(weatherPath)) {
+      fprintf(stderr, "外気のCSVを読み込めません: %s\n", weatherPath);
+      return 1;
+    }
+    options.days = scenario.getDays();
+    scenarios.push_back(scenario);
+  } else {
+    for (const char* const* name = WeatherScenario::BUILTIN_NAMES; *name != nullptr; name++) {
+      if (strcmp(scenarioName, "all") != 0 && strcmp(scenarioName, *name) != 0) {
+        continue;
+      }
+      WeatherScenario scenario;
+      scenario.loadBuiltin(*name, options.days);
+      scenarios.push_back(scenario);
+    }
+    if (scenarios.empty()) {
+      fprintf(stderr, "不明なシナリオ: %s\n", scenarioName);
+      return 2;
+    }
+  }
+
+  // 制御方策
+  std::vector<const Policy*> policies;
+  for (const Policy& p : POLICIES) {
+    if (strcmp(policyName, "all") == 0 || strcmp(policyName, p.name) == 0) {
+      policies.push_back(&p);
+    }
+  }
+  if (policies.empty()) {
+    fprintf(stderr, "不明な制御方策: %s\n", policyName);
+    return 2;
+  }
+
+  if (options.tracePath != nullptr && scenarios.size() * policies.size() != 1) {
+    fprintf(stderr, "--trace はシナリオ（--scenario / --weather）と制御方策（--policy）を1つに絞って指定してください\n");
+    return 2;
+  }
+
+  if (options.csv) {
+    printf("scenario,policy,comfort_pct,hot_pct,cold_pct,di_excess_h,di_mean,di_min,di_max,"
+           "ir_sends,mode_changes,runtime_h,energy_kwh,reads_per_hour\n");
+  }
+
+  auto wallStart = std::chrono::steady_clock::now();
+  double simulatedSec = 0;
+  for (const WeatherScenario& scenario : scenarios) {
+    if (!options.csv) {
+      printScenario(scenario);
+    }
+    for (const Policy* policy : policies) {
+      Result result = simulate(scenario, *policy, params, options);
+      simulatedSec += result.seconds;
+      printResult(scenario, *policy, result, options.csv);
+    }
+  }
+  double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+  if (!options.csv) {
+    printf("\n快適範囲: DI %.0f〜%.0f / 自動停止: %s\n", RoomConfig::COMFORT_MIN, RoomConfig::COMFORT_MAX,
+           options.autoStop ? "有効" : "無効");
+    printf("計算時間: %.2f 秒（シミュレーション %.0f 日分、実時間の %.0f 倍）\n",
+           wallSec, simulatedSec / 86400.0, wallSec > 0 ? simulatedSec / wallSec : 0.0);
+  }
+  return 0;
+}
@@ -0,0 +1,23 @@
+/**
+ * SimConfig.h
+ *
+ * シミュレーター・トレース再生の共通設定
+ * 実機の main.cpp（TimingConfig・TimeConfig）と同じ値にしてください。
+ */
+
+#ifndef SIM_CONFIG_H
+#define SIM_CONFIG_H
+
+#include <stdint.h>
+
+namespace SimConfig {
+  constexpr unsigned long SENSOR_READ_INTERVAL_MS = 2000;   // センサー読み取りの最短間隔
+  constexpr unsigned long SENSOR_READ_MAX_INTERVAL_MS = 300000; // センサー読み取りの最長間隔
+  constexpr unsigned long CONTROL_INTERVAL_MS = 60000;      // エアコン制御間隔
+  constexpr long GMT_OFFSET_SEC = 9 * 3600;                 // 日本時間
+  constexpr int AUTO_STOP_HOUR = 23;                        // 自動停止する時刻
+  constexpr uint32_t THERMAL_SAMPLE_INTERVAL_SEC = 600;     // 熱モデルの学習区間（PredictConfig）
+  constexpr uint32_t THERMAL_HORIZON_SEC = 1800;            // 熱モデルの予測時間
+}
+
+#endif // SIM_CONFIG_H
@@ -0,0 +1,203 @@
+/**
+ * SimPlatform.cpp
+ *
+ * シミュレーター用の仮想時計・赤外線送信の記録の実装
+ */
+
+#include "SimPlatform.h"
+#include <esp_sntp.h>
+#include <malloc.h>
+#include <chrono>
+#include <random>
+#include <thread>
+
+EspClass ESP;
+
+namespace {
+  uint64_t nowMs_ = 0;
+  bool realTime_ = false;                     // useRealTime() の後は nowMs_ の代わりに実時間を使う
+  std::chrono::steady_clock::time_point realStart_;
+  uint64_t skippedUs_ = 0;                    // 実時間の場合に advance() で進めた時間
+  int64_t wallOffsetMs_ = 0;                  // システム時刻 = 仮想時計 + wallOffsetMs_
+  sntp_sync_time_cb_t syncCallback_ = nullptr;
+  DaikinState acState_ = { false, kDaikinAuto, 25.0f };
+  uint32_t irFrames_ = 0;
+  char tz_[24];
+
+  uint64_t currentUs() {
+    if (realTime_) {
+      return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - realStart_).count() + skippedUs_;
+    }
+    return nowMs_ * 1000;
+  }
+
+  uint64_t currentMs() {
+    return realTime_ ? currentUs() / 1000 : nowMs_;
+  }
+}
+
+// ========================================
+// Arduino / ESP-IDF の置き換え
+// ========================================
+
+unsigned long millis() {
+  return (unsigned long)currentMs();
+}
+
+unsigned long micros() {
+  return (unsigned long)currentUs();
+}
+
+void delay(unsigned long ms) {
+  if (realTime_) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  } else {
+    nowMs_ += ms;
+  }
+}
+
+/**
+ * 受信待ちなどの空転（実時間の場合はCPUを占有しないよう少し待つ）
+ */
+void yield() {
+  if (realTime_) {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+}
+
+uint32_t esp_random() {
+  static std::mt19937 generator(1);  // 実行ごとに同じ列（結果を再現できるように）
+  return generator();
+}
+
+/**
+ * ヒープの空き容量（mallocで確保中のバイト数を仮の全容量から引く。差分だけが意味を持つ）
+ */
+uint32_t EspClass::getFreeHeap() {
+  constexpr size_t HEAP_SIZE = 0x40000000;
+  struct mallinfo2 info = mallinfo2();
+  return info.uordblks < HEAP_SIZE ? (uint32_t)(HEAP_SIZE - info.uordblks) : 0;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t, const char*, uint32_t, void*, UBaseType_t,
+                                   TaskHandle_t* handle, BaseType_t) {
+  if (handle != nullptr) {
+    *handle = nullptr;
+  }
+  return pdFAIL;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) {
+  return 0;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t) {
+  return pdPASS;
+}
+
+/**
+ * タイムゾーンを設定（NTPサーバーは使わない。同期は SimPlatform::syncClock() で行う）
+ */
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char*) {
+  // POSIXのTZは符号が逆（JST = UTC+9 → "SIM-9"）
+  long offsetHours = (gmtOffsetSec + daylightOffsetSec) / 3600;
+  snprintf(tz_, sizeof(tz_), "SIM%+ld", -offsetHours);
+  setenv("TZ", tz_, 1);
+  tzset();
+}
+
+int simGettimeofday(struct timeval* tv, void*) {
+  int64_t wallMs = (int64_t)currentMs() + wallOffsetMs_;
+  tv->tv_sec = (time_t)(wallMs / 1000);
+  tv->tv_usec = (suseconds_t)((wallMs % 1000) * 1000);
+  return 0;
+}
+
+// time() も仮想時計から返す（<ctime> がマクロを解除するため、ライブラリの関数を置き換える）
+extern "C" time_t time(time_t* out) noexcept {
+  time_t now = (time_t)(((int64_t)currentMs() + wallOffsetMs_) / 1000);
+  if (out != nullptr) {
+    *out = now;
+  }
+  return now;
+}
+
+int simSettimeofday(const struct timeval* tv, const void*) {
+  wallOffsetMs_ = (int64_t)tv->tv_sec * 1000 + tv->tv_usec / 1000 - (int64_t)currentMs();
+  return 0;
+}
+
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback) {
+  syncCallback_ = callback;
+}
+
+void sntp_set_sync_interval(uint32_t) {
+}
+
+void IRDaikinESP::send() {
+  SimPlatform::recordSend(state_);
+}
+
+// ========================================
+// 仮想時計
+// ========================================
+
+void SimPlatform::reset(time_t epoch) {
+  nowMs_ = 0;
+  realStart_ = std::chrono::steady_clock::now();
+  skippedUs_ = 0;
+  wallOffsetMs_ = (int64_t)epoch * 1000;
+  acState_ = { false, kDaikinAuto, 25.0f };
+  irFrames_ = 0;
+}
+
+void SimPlatform::syncClock() {
+  if (syncCallback_ == nullptr) {
+    return;
+  }
+  struct timeval tv;
+  simGettimeofday(&tv, nullptr);
+  syncCallback_(&tv);
+}
+
+void SimPlatform::useRealTime() {
+  int64_t wallMs = (int64_t)currentMs() + wallOffsetMs_;
+  realTime_ = true;
+  realStart_ = std::chrono::steady_clock::now();
+  skippedUs_ = 0;
+  wallOffsetMs_ = wallMs;  // システム時刻はそのまま続ける
+}
+
+void SimPlatform::setEpoch(time_t epoch) {
+  wallOffsetMs_ = (int64_t)epoch * 1000 - (int64_t)currentMs();
+}
+
+void SimPlatform::advance(unsigned long ms) {
+  if (realTime_) {
+    skippedUs_ += (uint64_t)ms * 1000;
+  } else {
+    nowMs_ += ms;
+  }
+}
+
+uint64_t SimPlatform::nowMs() {
+  return currentMs();
+}
+
+time_t SimPlatform::epoch() {
+  return (time_t)(((int64_t)currentMs() + wallOffsetMs_) / 1000);
+}
+
+const DaikinState& SimPlatform::acState() {
+  return acState_;
+}
+
+uint32_t SimPlatform::irFrames() {
+  return irFrames_;
+}
+
+void SimPlatform::recordSend(const DaikinState& state) {
+  acState_ = state;
+  irFrames_++;
+}
@@ -0,0 +1,72 @@
+/**
+ * SimPlatform.h
+ *
+ * シミュレーター用の仮想時計・赤外線送信の記録
+ * millis() / delay() / システム時刻はすべてこの仮想時計に従います。
+ */
+
+#ifndef SIM_PLATFORM_H
+#define SIM_PLATFORM_H
+
+#include <Arduino.h>
+#include <ir_Daikin.h>
+
+namespace SimPlatform {
+
+  /**
+   * 仮想時計を0に戻し、システム時刻（壁時計）を設定
+   * TimeManager::begin() の前に呼び出します（リセット前の時刻が残っている状態から起動）。
+   * @param epoch 開始時刻（エポック秒）
+   */
+  void reset(time_t epoch);
+
+  /**
+   * 仮想時計を実時間に従わせる（通信の確認用。以降の delay() は実際に待つ）
+   * ソケットのタイムアウトなど、相手のある処理を確認するプログラムで reset() の後に呼び出します。
+   * advance() は引き続き待たずに時計を進めます（30分後の動作などを待たずに確認できる）。
+   */
+  void useRealTime();
+
+  /**
+   * NTP同期の完了を通知（TimeManagerのSNTPコールバックを呼ぶ）
+   */
+  void syncClock();
+
+  /**
+   * システム時刻を変更（仮想時計はそのまま。NTPによる補正の再現）
+   * @param epoch 現在の時刻（エポック秒）
+   */
+  void setEpoch(time_t epoch);
+
+  /**
+   * 仮想時計を進める
+   */
+  void advance(unsigned long ms);
+
+  /**
+   * 仮想時計（起動からのミリ秒、オーバーフローしない）
+   */
+  uint64_t nowMs();
+
+  /**
+   * 現在のシステム時刻（エポック秒）
+   */
+  time_t epoch();
+
+  /**
+   * エアコンが最後に受信した設定
+   */
+  const DaikinState& acState();
+
+  /**
+   * 赤外線の送信回数（reset() からの累計）
+   */
+  uint32_t irFrames();
+
+  /**
+   * 赤外線の送信を記録（IRDaikinESP::send() から呼ばれる）
+   */
+  void recordSend(const DaikinState& state);
+}
+
+#endif // SIM_PLATFORM_H
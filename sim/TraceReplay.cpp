@@ -0,0 +1,465 @@
+/**
+ * TraceReplay.cpp
+ *
+ * 実機で記録したトレース（TraceRecorder）の再生ツール（ホストで実行）
+ * 記録した入力（センサー値・時刻・外部からの操作）を、実機と同じ AirConditionerController・
+ * AutoStopController・ScheduleEngine・TimeManager に記録どおりの時刻で流し直し、
+ * 制御の判定結果を記録した判定結果と照合します。
+ *
+ * 実行例:
+ *   curl -O http://<ESP32のIP>/trace/0.bin -O http://<ESP32のIP>/trace/1.bin
+ *   pio run -e replay && .pio/build/replay/program 0.bin 1.bin
+ *   .pio/build/replay/program --check 0.bin 1.bin > after.txt && diff before.txt after.txt
+ *
+ * 標準出力には再生した判定・イベントを1行ずつ出力します（乱数・実時間に依存しないため、
+ * 制御を変更した前後の出力を diff すれば、同じ入力に対する振る舞いの差が分かります）。
+ * 集計（件数・照合結果・再生速度）は標準エラーに出力します。
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include "AirConditionerController.h"
+#include "AutoStopController.h"
+#include "ScheduleEngine.h"
+#include "TimeManager.h"
+#include "ComfortIndex.h"
+#include "ThermalModel.h"
+#include "TraceFormat.h"
+#include "SimConfig.h"
+#include "SimPlatform.h"
+
+// ========================================
+// 設定
+// ========================================
+
+namespace ReplayConfig {
+  // 判定結果をエアコンに適用するか（main.cpp の airConditioner.request(optimalMode, ...) と合わせる。--apply で変更）
+  constexpr bool APPLY_DECISIONS = false;
+  // 熱モデルによる先回りを使うか（main.cpp の FEATURE_PREDICT と合わせる）
+  constexpr bool PREDICT = true;
+}
+
+// ========================================
+// トレースのファイル
+// ========================================
+
+struct TraceFile {
+  std::string path;
+  std::vector<uint8_t> data;
+  Trace::Record start;     // 先頭のSTART
+};
+
+/**
+ * ファイルを読み込み、先頭（ヘッダー・START）を確認
+ */
+bool loadTraceFile(const char* path, TraceFile& file) {
+  FILE* fp = fopen(path, "rb");
+  if (fp == nullptr) {
+    fprintf(stderr, "開けません: %s\n", path);
+    return false;
+  }
+  uint8_t chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+    file.data.insert(file.data.end(), chunk, chunk + n);
+  }
+  fclose(fp);
+
+  file.path = path;
+  Trace::Reader reader(file.data.data(), file.data.size());
+  if (!reader.readHeader() || !reader.next(file.start) || file.start.type != Trace::START) {
+    fprintf(stderr, "トレースのファイルではありません（または版数が異なる）: %s\n", path);
+    return false;
+  }
+  return true;
+}
+
+// ========================================
+// 再生
+// ========================================
+
+/**
+ * 1回の起動分の制御クラス（main.cpp のグローバル変数に相当）
+ */
+struct Session {
+  AirConditionerController airConditioner;
+  TimeManager timeMgr;
+  ScheduleEngine scheduler;
+  AutoStopController autoStop;
+  ThermalModel thermalModel;
+
+  Session()
+    : airConditioner(4, 15),  // ピン番号は再生では使わない
+      timeMgr("replay", SimConfig::GMT_OFFSET_SEC, 0),
+      scheduler(airConditioner, timeMgr),
+      autoStop(scheduler, SimConfig::AUTO_STOP_HOUR),
+      thermalModel(SimConfig::THERMAL_SAMPLE_INTERVAL_SEC, SimConfig::THERMAL_HORIZON_SEC) {}
+};
+
+struct ReplayStats {
+  uint32_t files = 0;
+  uint32_t boots = 0;
+  uint32_t records = 0;
+  uint32_t byType[Trace::DECISION + 1] = {};
+  uint32_t decisions = 0;     // 再生で判定した回数
+  uint32_t compared = 0;      // 記録した判定結果と照合した回数
+  uint32_t mismatches = 0;    // 照合で一致しなかった回数
+  uint32_t unmatched = 0;     // 対応する判定がなかった回数（記録の途切れなど）
+  uint32_t scheduled = 0;     // スケジュールを実行した回数
+  uint32_t truncated = 0;     // 途中で切れていたファイル数
+  double seconds = 0;         // 再生した記録の時間（秒）
+};
+
+/**
+ * トレースの再生クラス
+ * main.cpp の loop() と同じ順序で、記録の時刻まで仮想時計を進めながら制御クラスを呼び出します。
+ */
+class Replayer {
+public:
+  Replayer(bool verbose, bool applyDecisions) : verbose_(verbose), applyDecisions_(applyDecisions) {}
+
+  void play(const TraceFile& file) {
+    stats_.files++;
+    Trace::Reader reader(file.data.data(), file.data.size());
+    reader.readHeader();
+    Trace::Record record;
+    while (reader.next(record)) {
+      handle(record, file);
+    }
+    if (reader.error()) {
+      stats_.truncated++;
+      fprintf(stderr, "%s: %zu バイト目以降を読めません（書き込み中の電源断など）\n",
+              file.path.c_str(), reader.position());
+    }
+  }
+
+  void finish() {
+    endBoot();
+  }
+
+  const ReplayStats& stats() const { return stats_; }
+
+private:
+  bool verbose_;
+  bool applyDecisions_;
+  ReplayStats stats_;
+  std::unique_ptr<Session> session_;
+  uint32_t bootId_ = 0;
+  uint64_t bootMs_ = 0;           // 再生中の起動の最初の記録の時刻
+
+  // main.cpp の loop() の状態
+  uint64_t lastControlMs_ = 0;
+  bool phaseKnown_ = false;       // 制御間隔の位相が分かっているか（起動の途中から再生すると不明）
+  Trace::Record lastSensor_;
+  bool hasSensor_ = false;
+  std::deque<ACMode> pending_;    // 記録した判定結果との照合待ち
+  Trace::Record weather_ = Trace::make(Trace::WEATHER, 0);  // 最後に記録された天気予報
+
+  void handle(const Trace::Record& r, const TraceFile& file) {
+    stats_.records++;
+    stats_.byType[r.type]++;
+
+    if (r.type == Trace::START) {
+      if (!session_ || r.bootId != bootId_) {
+        startBoot(r, file);
+      }
+      return;
+    }
+    if (!session_) {
+      return;
+    }
+    if (r.millis > SimPlatform::nowMs()) {
+      SimPlatform::advance((unsigned long)(r.millis - SimPlatform::nowMs()));
+    }
+
+    // 入力を反映してから loop() の前半（時刻・スケジュール）を実行
+    switch (r.type) {
+      case Trace::CLOCK:
+        SimPlatform::setEpoch(r.epoch);
+        SimPlatform::syncClock();
+        event("clock", "%lu", (unsigned long)r.epoch);
+        break;
+      case Trace::COMMAND:
+        applyCommand(r);
+        break;
+      case Trace::IR:
+        event("ir", "protocol=%u bits=%u value=0x%llx", r.protocol, r.bits, (unsigned long long)r.value);
+        break;
+      case Trace::WIFI:
+        event("wifi", "%s", r.connected ? "connected" : "disconnected");
+        break;
+      case Trace::WEATHER:
+        weather_ = r;
+        if (r.valid) {
+          event("weather", "max=%.1f min=%.1f code=%d", r.tempMax / 10.0, r.tempMin / 10.0, r.weatherCode);
+        } else {
+          event("weather", "invalid");
+        }
+        break;
+      default:
+        break;
+    }
+    runSchedule();
+
+    if (r.type == Trace::SENSOR) {
+      handleSensor(r);
+    } else if (r.type == Trace::DECISION) {
+      handleDecision((ACMode)r.mode);
+    }
+  }
+
+  /**
+   * 新しい起動の再生を開始（制御クラスを作り直す）
+   */
+  void startBoot(const Trace::Record& r, const TraceFile& file) {
+    endBoot();
+    stats_.boots++;
+    bootId_ = r.bootId;
+    bootMs_ = r.millis;
+
+    // 再起動前の時刻を残したまま起動する（TimeManager がRTCメモリから復元する場合と同じ）
+    SimPlatform::reset(r.epoch != 0 ? (time_t)(r.epoch - r.millis / 1000) : 0);
+    SimPlatform::advance((unsigned long)r.millis);
+    session_.reset();
+    session_.reset(new Session());
+    session_->airConditioner.begin();
+    session_->timeMgr.begin();
+    session_->autoStop.begin();
+    if (r.epoch != 0) {
+      SimPlatform::syncClock();
+    }
+
+    lastControlMs_ = 0;
+    weather_ = Trace::make(Trace::WEATHER, r.millis);
+    phaseKnown_ = r.millis < SimConfig::CONTROL_INTERVAL_MS;
+    hasSensor_ = false;
+    event("boot", "%s #%lu build=\"%s\"%s", file.path.c_str(), (unsigned long)r.sequence, r.build,
+          phaseKnown_ ? "" : "（起動の途中から）");
+  }
+
+  void endBoot() {
+    if (session_) {
+      stats_.seconds += (SimPlatform::nowMs() - bootMs_) / 1000.0;
+    }
+    stats_.unmatched += pending_.size();
+    pending_.clear();
+  }
+
+  void applyCommand(const Trace::Record& r) {
+    const char* source = r.source == Trace::SOURCE_MQTT ? "mqtt"
+                       : r.source == Trace::SOURCE_RESTORE ? "restore" : "web";
+    if (r.command == Trace::COMMAND_MODE) {
+      ACMode mode = (ACMode)r.mode;
+      if (r.source == Trace::SOURCE_RESTORE) {
+        session_->airConditioner.restoreMode(mode);
+      } else {
+        session_->airConditioner.request(mode, ACPriority::USER);
+      }
+      event("command", "%s mode=%s", source, AirConditionerController::modeToKey(mode));
+    } else if (r.command == Trace::COMMAND_AUTO_STOP) {
+      session_->autoStop.setEnabled(r.mode != 0);
+      event("command", "%s autoStop=%s", source, r.mode != 0 ? "true" : "false");
+    }
+  }
+
+  void runSchedule() {
+    time_t lastFired = session_->scheduler.getLastFireTime();
+    session_->timeMgr.update();
+    session_->scheduler.update();
+    session_->airConditioner.update();
+    if (session_->scheduler.getLastFireTime() != lastFired) {
+      stats_.scheduled++;
+      event("schedule", "mode=%s", AirConditionerController::modeToKey(session_->airConditioner.getCurrentMode()));
+    }
+  }
+
+  void handleSensor(const Trace::Record& r) {
+    lastSensor_ = r;
+    hasSensor_ = r.valid;
+    if (!r.valid) {
+      event("sensor", "invalid");
+      return;
+    }
+    if (verbose_) {
+      int16_t temperature = (int16_t)r.temperature;
+      int16_t humidity = (int16_t)r.humidity;
+      event("sensor", "temp=%s hum=%s di=%s", Fixed::Text(temperature, 2).c_str(),
+            Fixed::Text(humidity, 2).c_str(),
+            Fixed::Text(Comfort::discomfortIndex(temperature, humidity), 1).c_str());
+    }
+    if (phaseKnown_ && r.millis - lastControlMs_ >= SimConfig::CONTROL_INTERVAL_MS) {
+      lastControlMs_ = r.millis;
+      decide();
+    }
+  }
+
+  void handleDecision(ACMode recorded) {
+    if (!phaseKnown_ && hasSensor_) {
+      // 起動の途中から再生した場合は、最初に記録された判定から制御間隔の位相を合わせる
+      phaseKnown_ = true;
+      lastControlMs_ = lastSensor_.millis;
+      decide();
+    }
+    if (pending_.empty()) {
+      stats_.unmatched++;
+      event("mismatch", "replay=- recorded=%s", AirConditionerController::modeToKey(recorded));
+      return;
+    }
+    ACMode replayed = pending_.front();
+    pending_.pop_front();
+    stats_.compared++;
+    if (replayed != recorded) {
+      stats_.mismatches++;
+      event("mismatch", "replay=%s recorded=%s", AirConditionerController::modeToKey(replayed),
+            AirConditionerController::modeToKey(recorded));
+    }
+  }
+
+  void decide() {
+    // トレースは SensorData と同じ1/100単位なので、実機と同じ整数のまま判定する
+    int16_t temperature = (int16_t)lastSensor_.temperature;
+    int16_t humidity = (int16_t)lastSensor_.humidity;
+    ACMode mode = session_->airConditioner.determineOptimalMode(temperature, humidity);
+
+    // main.cpp と同じく、天気予報と時刻が分かっていれば熱モデルを学習して先回り
+    float outdoorNow, outdoorLater;
+    if (ReplayConfig::PREDICT && forecastOutdoor(outdoorNow, outdoorLater)) {
+      ThermalModel& model = session_->thermalModel;
+      ACMode current = session_->airConditioner.getCurrentMode();
+      model.update((unsigned long)lastSensor_.millis, temperature, current, outdoorNow, outdoorLater);
+      ACMode reactive = mode;
+      mode = model.anticipate(session_->airConditioner, reactive, temperature, humidity, current,
+                              outdoorNow, outdoorLater);
+      if (mode != reactive) {
+        event("predict", "%s -> %s", AirConditionerController::modeToKey(reactive),
+              AirConditionerController::modeToKey(mode));
+      }
+    }
+    stats_.decisions++;
+    pending_.push_back(mode);
+    event("decision", "%s temp=%s hum=%s di=%s", AirConditionerController::modeToKey(mode),
+          Fixed::Text(temperature, 2).c_str(), Fixed::Text(humidity, 2).c_str(),
+          Fixed::Text(Comfort::discomfortIndex(temperature, humidity), 1).c_str());
+    if (applyDecisions_) {
+      session_->airConditioner.request(mode, ACPriority::POLICY);
+    }
+  }
+
+  /**
+   * 天気予報から推定した外気温（main.cpp の forecastOutdoor() と同じ）
+   */
+  bool forecastOutdoor(float& now, float& later) {
+    if (!session_->timeMgr.isTimeValid() || !weather_.valid) {
+      return false;
+    }
+    const struct tm& local = session_->timeMgr.now();
+    float hour = local.tm_hour + local.tm_min / 60.0f;
+    float tempMax = weather_.tempMax / 10.0f;
+    float tempMin = weather_.tempMin / 10.0f;
+    now = ThermalModel::outdoorTemperature(tempMax, tempMin, hour);
+    later = ThermalModel::outdoorTemperature(tempMax, tempMin, hour + SimConfig::THERMAL_HORIZON_SEC / 3600.0f);
+    return true;
+  }
+
+  /**
+   * 1行出力（現地時刻・起動からの経過時間・種類・内容）
+   */
+  void event(const char* kind, const char* format, ...) {
+    char local[24] = "---------- --:--:--";
+    if (session_ && session_->timeMgr.isTimeValid()) {
+      snprintf(local, sizeof(local), "%s", session_->timeMgr.getFormattedTime("%Y-%m-%d %H:%M:%S").c_str());
+    }
+    char detail[160];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(detail, sizeof(detail), format, args);
+    va_end(args);
+    printf("%s +%10.3f %-8s %s\n", local, SimPlatform::nowMs() / 1000.0, kind, detail);
+  }
+};
+
+// ========================================
+// メイン
+// ========================================
+
+void printUsage(const char* program) {
+  fprintf(stderr,
+    "使い方: %s [オプション] トレース...\n"
+    "  --verbose   センサー値もすべて出力する\n"
+    "  --check     記録した判定結果と一致しなければ終了コード1を返す\n"
+    "  --apply     判定結果をエアコンに適用する（main.cpp で request() を有効にしている場合）\n"
+    "\nトレースは複数指定できます（/trace/0.bin と /trace/1.bin など。記録順に並べ替えて再生）。\n",
+    program);
+}
+
+int main(int argc, char** argv) {
+  bool verbose = false;
+  bool check = false;
+  bool apply = ReplayConfig::APPLY_DECISIONS;
+  std::vector<TraceFile> files;
+
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    if (strcmp(arg, "--verbose") == 0) {
+      verbose = true;
+    } else if (strcmp(arg, "--check") == 0) {
+      check = true;
+    } else if (strcmp(arg, "--apply") == 0) {
+      apply = true;
+    } else if (arg[0] == '-') {
+      printUsage(argv[0]);
+      return 2;
+    } else {
+      TraceFile file;
+      if (!loadTraceFile(arg, file)) {
+        return 1;
+      }
+      files.push_back(file);
+    }
+  }
+  if (files.empty()) {
+    printUsage(argv[0]);
+    return 2;
+  }
+
+  // 通し番号は起動をまたいで増えるため、番号順に並べれば記録順になる
+  std::sort(files.begin(), files.end(), [](const TraceFile& a, const TraceFile& b) {
+    return a.start.sequence < b.start.sequence;
+  });
+
+  auto wallStart = std::chrono::steady_clock::now();
+  Replayer replayer(verbose, apply);
+  for (const TraceFile& file : files) {
+    replayer.play(file);
+  }
+  replayer.finish();
+  double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+  const ReplayStats& s = replayer.stats();
+  static const char* const TYPE_NAMES[] = {
+    "", "start", "clock", "sensor", "ir", "weather", "wifi", "command", "decision"
+  };
+  fprintf(stderr, "\nファイル %lu / 起動 %lu / レコード %lu（",
+          (unsigned long)s.files, (unsigned long)s.boots, (unsigned long)s.records);
+  for (int t = Trace::START; t <= Trace::DECISION; t++) {
+    fprintf(stderr, "%s%s %lu", t == Trace::START ? "" : ", ", TYPE_NAMES[t], (unsigned long)s.byType[t]);
+  }
+  fprintf(stderr, "）\n");
+  fprintf(stderr, "判定 %lu 回 / 照合 %lu 回 / 不一致 %lu 回 / 対応なし %lu 回 / スケジュール %lu 回\n",
+          (unsigned long)s.decisions, (unsigned long)s.compared, (unsigned long)s.mismatches,
+          (unsigned long)s.unmatched, (unsigned long)s.scheduled);
+  fprintf(stderr, "再生時間: %.3f 秒（記録 %.1f 時間分、%.0f レコード/秒、実時間の %.0f 倍）\n",
+          wallSec, s.seconds / 3600.0, wallSec > 0 ? s.records / wallSec : 0.0,
+          wallSec > 0 ? s.seconds / wallSec : 0.0);
+
+  return check && s.mismatches > 0 ? 1 : 0;
+}
@@ -0,0 +1,164 @@
+/**
+ * WeatherScenario.cpp
+ *
+ * シミュレーター用の外気のシナリオの実装
+ */
+
+#include "WeatherScenario.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+  constexpr long JST_OFFSET_SEC = 9 * 3600;
+  constexpr float HOUR_MIN = 5.0f;    // 最低気温の時刻
+  constexpr float HOUR_MAX = 14.0f;   // 最高気温の時刻
+
+  /**
+   * 組み込みのシナリオ（平年値に近い値を基準に、数日周期で変動させる）
+   */
+  const struct {
+    const char* name;
+    int year, month, day;
+    float tempMax, tempMin, dewPoint;
+    float swing;            // 日ごとの変動幅（℃）
+    int codes[7];           // 1週間の天気コードの並び
+  } BUILTIN[] = {
+    { "summer", 2025, 8, 1,  32.5f, 25.5f, 23.5f, 2.0f, { 0, 1, 1, 2, 3, 0, 61 } },
+    { "rainy",  2025, 6, 15, 26.5f, 20.0f, 19.5f, 1.5f, { 61, 63, 3, 61, 2, 3, 63 } },
+    { "autumn", 2025, 10, 1, 24.0f, 17.0f, 14.5f, 2.5f, { 1, 0, 2, 3, 61, 1, 0 } },
+  };
+
+  /**
+   * 天気コードから日射の係数
+   */
+  float sunFactor(int weatherCode) {
+    if (weatherCode <= 1) return 1.0f;    // 快晴・晴れ
+    if (weatherCode == 2) return 0.7f;    // 一部曇り
+    if (weatherCode == 3) return 0.4f;    // 曇り
+    if (weatherCode < 50) return 0.3f;    // 霧
+    return 0.15f;                         // 雨・雪
+  }
+
+  /**
+   * 日付からUNIX日数（1970-01-01からの日数）を求める
+   */
+  long daysFromCivil(int y, int m, int d) {
+    y -= m <= 2;
+    long era = (y >= 0 ? y : y - 399) / 400;
+    long yoe = y - era * 400;
+    long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+  }
+}
+
+const char* const WeatherScenario::BUILTIN_NAMES[] = { "summer", "rainy", "autumn", nullptr };
+
+bool WeatherScenario::setStart(int year, int month, int day) {
+  if (month < 1 || month > 12 || day < 1 || day > 31) {
+    return false;
+  }
+  startEpoch_ = (time_t)(daysFromCivil(year, month, day) * 86400L - JST_OFFSET_SEC);
+  return true;
+}
+
+bool WeatherScenario::loadBuiltin(const char* name, int days) {
+  for (const auto& b : BUILTIN) {
+    if (strcmp(b.name, name) != 0) {
+      continue;
+    }
+    snprintf(name_, sizeof(name_), "%s", b.name);
+    setStart(b.year, b.month, b.day);
+    days_.clear();
+    for (int d = 0; d < days; d++) {
+      // 周期の異なる2つの正弦で、暑い日・涼しい日が数日ずつ続くようにする（乱数は使わない）
+      float anomaly = b.swing * (0.7f * (float)sin(2.0 * M_PI * d / 6.3) + 0.3f * (float)sin(2.0 * M_PI * d / 2.7));
+      WeatherDay day;
+      day.weatherCode = b.codes[d % 7];
+      float cloud = 1.0f - sunFactor(day.weatherCode);
+      day.tempMax = b.tempMax + anomaly - 3.0f * cloud;   // 雨の日は最高気温が上がらない
+      day.tempMin = b.tempMin + anomaly * 0.6f;
+      day.dewPoint = b.dewPoint + anomaly * 0.4f + 1.0f * cloud;
+      if (day.dewPoint > day.tempMin) {
+        day.dewPoint = day.tempMin;
+      }
+      days_.push_back(day);
+    }
+    return true;
+  }
+  return false;
+}
+
+bool WeatherScenario::loadCsv(const char* path) {
+  FILE* file = fopen(path, "r");
+  if (file == nullptr) {
+    return false;
+  }
+
+  const char* base = strrchr(path, '/');
+  snprintf(name_, sizeof(name_), "%s", base != nullptr ? base + 1 : path);
+  days_.clear();
+
+  char line[128];
+  bool first = true;
+  bool ok = true;
+  while (fgets(line, sizeof(line), file) != nullptr) {
+    if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') {
+      continue;
+    }
+    int y, m, d;
+    WeatherDay day;
+    if (sscanf(line, "%d-%d-%d,%f,%f,%f,%d", &y, &m, &d,
+               &day.tempMax, &day.tempMin, &day.dewPoint, &day.weatherCode) != 7) {
+      fprintf(stderr, "%s: 読み込めない行: %s", path, line);
+      ok = false;
+      break;
+    }
+    if (first && !setStart(y, m, d)) {
+      fprintf(stderr, "%s: 不正な日付: %s", path, line);
+      ok = false;
+      break;
+    }
+    first = false;
+    days_.push_back(day);
+  }
+  fclose(file);
+  return ok && !days_.empty();
+}
+
+/**
+ * 指定時刻の外気の状態
+ * 前日の最高気温→当日の最低気温→当日の最高気温→翌日の最低気温の順に余弦で補間します。
+ */
+OutdoorState WeatherScenario::at(double secondsFromStart) const {
+  OutdoorState state;
+  int last = (int)days_.size() - 1;
+  int index = (int)(secondsFromStart / 86400.0);
+  if (index < 0) index = 0;
+  if (index > last) index = last;
+  float hour = (float)(secondsFromStart / 3600.0 - index * 24.0);
+
+  const WeatherDay& today = days_[index];
+  const WeatherDay& yesterday = days_[index > 0 ? index - 1 : 0];
+  const WeatherDay& tomorrow = days_[index < last ? index + 1 : last];
+
+  float from, to, phase;
+  if (hour < HOUR_MIN) {
+    from = yesterday.tempMax; to = today.tempMin;
+    phase = (hour + 24.0f - HOUR_MAX) / (24.0f - HOUR_MAX + HOUR_MIN);
+  } else if (hour < HOUR_MAX) {
+    from = today.tempMin; to = today.tempMax;
+    phase = (hour - HOUR_MIN) / (HOUR_MAX - HOUR_MIN);
+  } else {
+    from = today.tempMax; to = tomorrow.tempMin;
+    phase = (hour - HOUR_MAX) / (24.0f - HOUR_MAX + HOUR_MIN);
+  }
+  state.temperature = from + (to - from) * (1.0f - (float)cos(M_PI * phase)) * 0.5f;
+
+  state.dewPoint = today.dewPoint < state.temperature ? today.dewPoint : state.temperature;
+
+  float daylight = (hour > 6.0f && hour < 18.0f) ? (float)sin(M_PI * (hour - 6.0f) / 12.0f) : 0.0f;
+  state.sun = daylight * sunFactor(today.weatherCode);
+  return state;
+}
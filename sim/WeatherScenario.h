@@ -0,0 +1,72 @@
+/**
+ * WeatherScenario.h
+ *
+ * シミュレーター用の外気のシナリオ
+ * 日ごとの天気（最高・最低気温、露点、天気コード）から、時刻ごとの外気の状態を作ります。
+ */
+
+#ifndef WEATHER_SCENARIO_H
+#define WEATHER_SCENARIO_H
+
+#include <time.h>
+#include <vector>
+#include "RoomModel.h"
+
+/**
+ * 1日分の天気（WeatherForecastと同じく天気コードはWMO形式）
+ */
+struct WeatherDay {
+  float tempMax;
+  float tempMin;
+  float dewPoint;
+  int weatherCode;
+};
+
+/**
+ * 外気のシナリオ
+ *
+ * 気温は最低気温（5時）と最高気温（14時）を余弦で結び、露点はその日の値で一定とします。
+ * 日射は6〜18時の正弦に、天気コードに応じた係数（晴れ1.0〜雨0.15）を掛けたものです。
+ */
+class WeatherScenario {
+public:
+  /**
+   * 組み込みのシナリオを作成
+   * @param name "summer"（8月・猛暑日を含む）/ "rainy"（6月・梅雨）/ "autumn"（10月・自動停止あり）
+   * @param days 日数
+   * @return 成功したか（不明な名前の場合はfalse）
+   */
+  bool loadBuiltin(const char* name, int days);
+
+  /**
+   * CSVファイルから読み込む
+   * 形式: 1行1日で "YYYY-MM-DD,最高気温,最低気温,露点,天気コード"（#で始まる行は無視）
+   * 最初の行の日付が開始日になります。
+   */
+  bool loadCsv(const char* path);
+
+  const char* getName() const { return name_; }
+  time_t getStartEpoch() const { return startEpoch_; }
+  int getDays() const { return (int)days_.size(); }
+  const WeatherDay& getDay(int index) const { return days_[index]; }
+
+  /**
+   * 指定時刻の外気の状態
+   * @param secondsFromStart 開始日0時（日本時間）からの経過秒数
+   */
+  OutdoorState at(double secondsFromStart) const;
+
+  /**
+   * 組み込みのシナリオ名（nullptrで終わる）
+   */
+  static const char* const BUILTIN_NAMES[];
+
+private:
+  char name_[32];
+  time_t startEpoch_;
+  std::vector<WeatherDay> days_;
+
+  bool setStart(int year, int month, int day);
+};
+
+#endif // WEATHER_SCENARIO_H
@@ -0,0 +1,449 @@
+/**
+ * MqttBridgeTest.cpp
+ *
+ * MqttBridge の確認（ホストで実行、ローカルのMQTTブローカーに実際に接続する）
+ * MqttBridge と同じブローカーに確認用のクライアントを接続して aircon/<デバイスID>/# を購読し、
+ * 送信された内容とコマンドの反映を確認します。
+ *   - 接続時の status（online）と state（retain）
+ *   - センサー値をまとめた telemetry（件数・経過秒・値）
+ *   - cmd トピックのコマンド（モード・自動停止）の反映と、解釈できないコマンドの数
+ *   - 送信待ちの上限を超えたセンサー値の数
+ *   - health（稼働状況）
+ *   - 接続が切れた時の Last Will（status が offline になる）
+ *   - 後から購読したクライアントに届く retain の state・status（接続中は online、切断後は offline）
+ * 送信にかかった時間と、ブローカー経由で確認用のクライアントに届くまでの時間を表示します。
+ *
+ * 実行例（ブローカーは mosquitto など）:
+ *   mosquitto -p 1883 &
+ *   pio run -e mqtttest && .pio/build/mqtttest/program --host localhost --port 1883
+ *
+ * ブローカーに接続できない場合・確認に失敗した場合は終了コード 1 を返します。
+ */
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <WiFi.h>
+#include <PubSubClient.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include "MqttBridge.h"
+#include "AirConditionerController.h"
+#include "AutoStopController.h"
+#include "ScheduleEngine.h"
+#include "TimeManager.h"
+#include "SimConfig.h"
+#include "SimPlatform.h"
+#include "NetPlatform.h"
+
+namespace {
+
+  constexpr time_t START_EPOCH = 1751328000;  // 2025-07-01 09:00 JST
+  constexpr unsigned long WAIT_MS = 5000;     // 1つの確認で待つ上限（実時間）
+  constexpr unsigned long SAMPLE_INTERVAL_MS = 2000;
+
+  int failures = 0;
+
+  void expect(bool condition, const char* name, const char* what) {
+    if (!condition) {
+      printf("NG: %s: %s\n", name, what);
+      failures++;
+    }
+  }
+
+  /**
+   * 確認用のクライアントが受信したメッセージ
+   */
+  struct Message {
+    std::string topic;
+    std::string payload;
+    unsigned long receivedUs;
+  };
+
+  std::vector<Message> received;
+
+  void onObserved(char* topic, uint8_t* payload, unsigned int length) {
+    Message message;
+    message.topic = topic;
+    message.payload.assign((const char*)payload, length);
+    message.receivedUs = micros();
+    received.push_back(message);
+  }
+
+  /**
+   * 後から購読したクライアントが受信したメッセージ（retain の確認用）
+   */
+  std::vector<Message> lateReceived;
+
+  void onLateObserved(char* topic, uint8_t* payload, unsigned int length) {
+    Message message;
+    message.topic = topic;
+    message.payload.assign((const char*)payload, length);
+    message.receivedUs = micros();
+    lateReceived.push_back(message);
+  }
+
+  // 確認用のクライアントが受信した中から、指定したトピックの from 番目以降で最初のメッセージ
+  // （contains を指定した場合はそれを含むもの。なければ nullptr）
+  const Message* findTopic(const std::string& name, size_t from, const char* contains = nullptr) {
+    for (size_t i = from; i < received.size(); i++) {
+      if (received[i].topic == name &&
+          (contains == nullptr || received[i].payload.find(contains) != std::string::npos)) {
+        return &received[i];
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * 試験の対象（MqttBridge と操作されるクラス）と確認用のクライアント
+   * 確認用のクライアントは MqttBridge を破棄した後も使う（Last Will の確認）ため外から渡す
+   */
+  struct Harness {
+    AirConditionerController ac;
+    TimeManager timeMgr;
+    ScheduleEngine schedule;
+    AutoStopController autoStop;
+    MqttBridge bridge;
+    PubSubClient& observer;
+    char base[48];
+
+    Harness(const char* host, uint16_t port, const char* deviceId, PubSubClient& observerClient)
+      : ac(4, 15),
+        timeMgr("sim", SimConfig::GMT_OFFSET_SEC, 0),
+        schedule(ac, timeMgr),
+        autoStop(schedule),
+        bridge(ac, autoStop, timeMgr, host, port, deviceId),
+        observer(observerClient) {
+      snprintf(base, sizeof(base), "aircon/%s", deviceId);
+    }
+
+    // 1回分の loop() に相当する処理
+    void step() {
+      bridge.update();
+      ac.update();
+      observer.loop();
+      delay(2);
+    }
+
+    template <typename Condition>
+    bool waitFor(Condition done) {
+      unsigned long start = millis();
+      while (!done()) {
+        if (millis() - start >= WAIT_MS) {
+          return false;
+        }
+        step();
+      }
+      return true;
+    }
+
+    std::string topic(const char* suffix) const {
+      return std::string(base) + "/" + suffix;
+    }
+
+    const Message* find(const char* suffix, size_t from, const char* contains = nullptr) const {
+      return findTopic(topic(suffix), from, contains);
+    }
+
+    void command(const char* payload) {
+      observer.publish(topic("cmd").c_str(), payload);
+    }
+  };
+
+  SensorData sample(uint32_t i) {
+    return SensorData((int16_t)(2650 + i), (int16_t)(5520 - i * 3), (int16_t)(7512 + i), true);
+  }
+
+  void connectAndState(Harness& h) {
+    const char* name = "接続時に online と状態を送信する";
+    size_t from = received.size();
+    expect(h.waitFor([&]() { return h.bridge.isConnected() && h.find("state", from) != nullptr; }),
+           name, "接続・状態の送信が届かない");
+    const Message* status = h.find("status", from);
+    expect(status != nullptr && status->payload == "online", name, "status が online ではない");
+    const Message* state = h.find("state", from);
+    expect(state != nullptr && state->payload.find("\"autoStop\":true") != std::string::npos,
+           name, "state に自動停止の状態がない");
+  }
+
+  void telemetryBatch(Harness& h) {
+    const char* name = "センサー値をまとめて送信する";
+    const uint32_t count = 5;
+    h.bridge.setFlushInterval(count * SAMPLE_INTERVAL_MS);
+    size_t from = received.size();
+    uint32_t batches = h.bridge.getStats().batchCount;
+
+    for (uint32_t i = 0; i < count; i++) {
+      h.bridge.addSample(sample(i));
+      h.step();
+      SimPlatform::advance(SAMPLE_INTERVAL_MS);
+    }
+    expect(h.bridge.getStats().batchCount == batches, name, "flushInterval より前に送信した");
+    expect(h.bridge.getQueueDepth() == count, name, "送信待ちの件数が一致しない");
+
+    unsigned long flushUs = micros();
+    expect(h.waitFor([&]() { return h.find("telemetry", from) != nullptr; }), name, "telemetry が届かない");
+    const Message* telemetry = h.find("telemetry", from);
+    if (telemetry == nullptr) {
+      return;
+    }
+    expect(h.bridge.getQueueDepth() == 0, name, "送信後も送信待ちが残っている");
+
+    JsonDocument doc;
+    expect(!deserializeJson(doc, telemetry->payload), name, "telemetry がJSONではない");
+    JsonArray offsets = doc["off"];
+    JsonArray temps = doc["temp"];
+    JsonArray hums = doc["hum"];
+    JsonArray dis = doc["di"];
+    uint32_t n = doc["n"];
+    uint32_t ts = doc["ts"];
+    bool match = n == count && offsets.size() == count && temps.size() == count &&
+                 hums.size() == count && dis.size() == count && ts >= (uint32_t)START_EPOCH;
+    for (uint32_t i = 0; match && i < count; i++) {
+      SensorData expected = sample(i);
+      match = offsets[i].as<uint32_t>() == i * SAMPLE_INTERVAL_MS / 1000 &&
+              temps[i].as<int>() == expected.temperature &&
+              hums[i].as<int>() == expected.humidity &&
+              dis[i].as<int>() == expected.discomfortIndex;
+    }
+    expect(match, name, "telemetry の内容が一致しない");
+    printf("  telemetry %u 件: %u バイト、ブローカー経由で届くまで %lu us\n",
+           (unsigned)count, (unsigned)telemetry->payload.size(), telemetry->receivedUs - flushUs);
+  }
+
+  void commands(Harness& h) {
+    const char* name = "cmd トピックのコマンドを反映する";
+    size_t from = received.size();
+    h.command("{\"mode\":\"cool_20\"}");
+    expect(h.waitFor([&]() { return h.ac.getCurrentMode() == ACMode::COOLING_20; }), name, "モードが変わらない");
+    expect(h.waitFor([&]() { return h.find("state", from, "\"mode\":\"cool_20\"") != nullptr; }),
+           name, "変更後の state が届かない");
+
+    from = received.size();
+    h.command("{\"autoStop\":false}");
+    expect(h.waitFor([&]() { return !h.autoStop.isEnabled(); }), name, "自動停止が無効にならない");
+    expect(h.waitFor([&]() { return h.find("state", from, "\"autoStop\":false") != nullptr; }),
+           name, "変更後の state が届かない");
+  }
+
+  void rejectedCommands(Harness& h) {
+    const char* name = "解釈できないコマンドを数える";
+    MqttStats before = h.bridge.getStats();
+    const char* invalid[] = {"not json", "{\"mode\":\"heat\"}", "{\"autoStop\":\"no\"}", "{}"};
+    const uint32_t count = sizeof(invalid) / sizeof(invalid[0]);
+    for (uint32_t i = 0; i < count; i++) {
+      h.command(invalid[i]);
+    }
+    expect(h.waitFor([&]() { return h.bridge.getStats().commandsReceived == before.commandsReceived + count; }),
+           name, "コマンドが届かない");
+    expect(h.bridge.getStats().commandsRejected == before.commandsRejected + count, name, "拒否した数が一致しない");
+    expect(h.ac.getCurrentMode() == ACMode::COOLING_20 && !h.autoStop.isEnabled(), name, "拒否したコマンドで状態が変わった");
+  }
+
+  void overflow(Harness& h) {
+    const char* name = "送信待ちの上限を超えたセンサー値を数える";
+    const uint32_t extra = 5;
+    uint32_t dropped = h.bridge.getStats().samplesDropped;
+    size_t from = received.size();
+
+    // update() を呼ばずに溜める（接続が詰まって送信できない間に相当）
+    uint32_t accepted = 0;
+    for (uint32_t i = 0; i < MqttBridge::MAX_BATCH + extra; i++) {
+      if (h.bridge.addSample(sample(i))) {
+        accepted++;
+      }
+    }
+    expect(accepted == MqttBridge::MAX_BATCH, name, "上限を超えて受け付けた");
+    expect(h.bridge.getStats().samplesDropped == dropped + extra, name, "捨てた件数が一致しない");
+    expect(h.bridge.getStats().maxQueueDepth == MqttBridge::MAX_BATCH, name, "送信待ちの最大件数が一致しない");
+
+    expect(h.waitFor([&]() { return h.find("telemetry", from) != nullptr; }), name, "上限に達しても送信しない");
+    char full[16];
+    snprintf(full, sizeof(full), "\"n\":%u,", (unsigned)MqttBridge::MAX_BATCH);
+    expect(h.find("telemetry", from, full) != nullptr, name, "上限の件数をまとめて送信していない");
+  }
+
+  void health(Harness& h) {
+    const char* name = "稼働状況を送信する";
+    h.bridge.setHealthInterval(1000);
+    size_t from = received.size();
+    SimPlatform::advance(1000);
+    expect(h.waitFor([&]() { return h.find("health", from) != nullptr; }), name, "health が届かない");
+    const Message* message = h.find("health", from);
+    expect(message != nullptr && message->payload.find("\"queue\":") != std::string::npos &&
+           message->payload.find("\"dropped\":") != std::string::npos &&
+           message->payload.find("\"publishUs\":") != std::string::npos,
+           name, "health の項目が足りない");
+  }
+
+  /**
+   * 接続が切れた時にブローカーが Last Will（status: offline）を送信するか
+   * （MqttBridge を破棄するとDISCONNECTを送らずにソケットが閉じる。電源断と同じ）
+   */
+  void lastWill(Harness* h, PubSubClient& observer, const std::string& statusTopic) {
+    const char* name = "接続が切れたら status が offline になる";
+    size_t from = received.size();
+    delete h;
+    unsigned long start = millis();
+    while (findTopic(statusTopic, from) == nullptr && millis() - start < WAIT_MS) {
+      observer.loop();
+      delay(2);
+    }
+    const Message* status = findTopic(statusTopic, from);
+    expect(status != nullptr && status->payload == "offline", name, "offline が届かない");
+  }
+
+  /**
+   * 新しく接続したクライアントで購読し、ブローカーが retain している state・status を受け取る
+   * （MqttBridge の送信を見ていないクライアントにも最新の状態が届くか）
+   * @return state・status の両方が届いたら true
+   */
+  bool readRetained(const char* host, uint16_t port, const std::string& base, std::string& state, std::string& status) {
+    lateReceived.clear();
+    WiFiClient net;
+    PubSubClient late(net);
+    char clientId[48];
+    snprintf(clientId, sizeof(clientId), "simtest-%ld-late", (long)getpid());
+    late.setServer(host, port);
+    late.setCallback(onLateObserved);
+    late.setBufferSize(2048);
+    if (!late.connect(clientId)) {
+      return false;
+    }
+    late.subscribe((base + "/#").c_str(), 1);
+
+    bool found = false;
+    unsigned long start = millis();
+    while (!found && millis() - start < WAIT_MS) {
+      late.loop();
+      delay(2);
+      state.clear();
+      status.clear();
+      bool hasState = false;
+      bool hasStatus = false;
+      for (const Message& message : lateReceived) {
+        if (message.topic == base + "/state") {
+          state = message.payload;
+          hasState = true;
+        } else if (message.topic == base + "/status") {
+          status = message.payload;
+          hasStatus = true;
+        }
+      }
+      found = hasState && hasStatus;
+    }
+    late.disconnect();
+    return found;
+  }
+
+  void retainedOnline(Harness& h, const char* host, uint16_t port) {
+    const char* name = "後から購読しても接続中の状態が届く（retain）";
+    std::string state;
+    std::string status;
+    expect(readRetained(host, port, h.base, state, status), name, "retain の state・status が届かない");
+    expect(status == "online", name, "status が online ではない");
+    // commands() で変更し、rejectedCommands() で変わらなかった状態
+    expect(state.find("\"mode\":\"cool_20\"") != std::string::npos &&
+           state.find("\"autoStop\":false") != std::string::npos,
+           name, "state が最後に送信した状態ではない");
+  }
+
+  void retainedOffline(const char* host, uint16_t port, const std::string& base) {
+    const char* name = "切断後に購読すると status が offline（Last Will の retain）";
+    std::string state;
+    std::string status;
+    expect(readRetained(host, port, base, state, status), name, "retain の state・status が届かない");
+    expect(status == "offline", name, "status が offline ではない");
+    expect(state.find("\"mode\":\"cool_20\"") != std::string::npos, name, "切断後に state の retain が消えた");
+  }
+
+  /**
+   * 試験で残した retain のメッセージを消す（ブローカーに古い値を残さない）
+   */
+  void clearRetained(PubSubClient& observer, const std::string& base) {
+    observer.publish((base + "/state").c_str(), (const uint8_t*)"", 0, true);
+    observer.publish((base + "/status").c_str(), (const uint8_t*)"", 0, true);
+    observer.loop();
+  }
+
+  void usage(const char* program) {
+    printf("使い方: %s [--host ブローカー] [--port ポート]\n", program);
+  }
+}
+
+int main(int argc, char** argv) {
+  const char* host = "localhost";
+  uint16_t port = 1883;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--host") == 0 && i + 1 < argc) {
+      host = argv[++i];
+    } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+      port = (uint16_t)atoi(argv[++i]);
+    } else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+
+  SimPlatform::reset(START_EPOCH);
+  SimPlatform::useRealTime();
+  SimNet::setWiFiConnected(true);
+
+  // 実行ごとに別のデバイスIDを使う（他の実行の retain と混ざらない）
+  char deviceId[32];
+  snprintf(deviceId, sizeof(deviceId), "simtest-%ld", (long)getpid());
+
+  WiFiClient observerNet;
+  PubSubClient observer(observerNet);
+  char observerId[48];
+  snprintf(observerId, sizeof(observerId), "%s-observer", deviceId);
+  observer.setServer(host, port);
+  observer.setCallback(onObserved);
+  observer.setBufferSize(2048);
+  if (!observer.connect(observerId)) {
+    printf("ブローカー %s:%u に接続できません（mosquitto -p %u などで起動してください）\n",
+           host, (unsigned)port, (unsigned)port);
+    return 1;
+  }
+
+  Harness* h = new Harness(host, port, deviceId, observer);
+  std::string base = h->base;
+  observer.subscribe((base + "/#").c_str(), 1);
+
+  h->timeMgr.begin();
+  SimPlatform::syncClock();
+  h->ac.begin();
+  h->bridge.setHealthInterval(3600000);
+  h->bridge.begin();
+
+  connectAndState(*h);
+  if (h->bridge.isConnected()) {
+    telemetryBatch(*h);
+    commands(*h);
+    rejectedCommands(*h);
+    overflow(*h);
+    health(*h);
+    retainedOnline(*h, host, port);
+  }
+
+  const MqttStats stats = h->bridge.getStats();
+  printf("  送信 %lu 回（失敗 %lu 回）、送信時間 直近 %lu us / 最長 %lu us、送信待ちの最大 %u 件\n",
+         (unsigned long)stats.publishCount, (unsigned long)stats.publishFailures,
+         stats.lastPublishUs, stats.maxPublishUs, (unsigned)stats.maxQueueDepth);
+
+  lastWill(h, observer, base + "/status");
+  retainedOffline(host, port, base);
+  clearRetained(observer, base);
+  observer.disconnect();
+
+  if (failures > 0) {
+    printf("MQTT: %d 件の確認に失敗\n", failures);
+    return 1;
+  }
+  printf("MQTT: OK\n");
+  return 0;
+}
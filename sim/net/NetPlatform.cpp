@@ -0,0 +1,632 @@
+/**
+ * NetPlatform.cpp
+ *
+ * 通信・保存のクラスの確認用の置き換えの実装
+ * WiFiClient・HTTPClient はホストのTCPソケット、LittleFS はホストのディレクトリ、
+ * Preferences はメモリ上の表で動作します。
+ */
+
+#include "NetPlatform.h"
+#include <WiFi.h>
+#include <HTTPClient.h>
+#include <Preferences.h>
+#include <LittleFS.h>
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <errno.h>
+#include <ftw.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <map>
+#include <string>
+#include <vector>
+
+WiFiClass WiFi;
+LittleFSFS LittleFS;
+
+namespace {
+  bool wifiConnected_ = true;
+  std::string flashRoot_;
+
+  constexpr size_t RX_BUFFER_SIZE = 1436;   // ESP32の WiFiClient と同じく、TCPセグメント1つ分ずつ受信する
+  constexpr int CONNECT_TIMEOUT_SEC = 5;
+
+  /**
+   * ソケットごとの受信バッファ（recv() を1バイトごとに呼ばないため）
+   */
+  struct RxBuffer {
+    uint8_t data[RX_BUFFER_SIZE];
+    size_t pos;
+    size_t length;
+  };
+  std::map<int, RxBuffer> rxBuffers_;
+
+  // 受信バッファが空なら、受信済みの分を読み込む（待たない）
+  RxBuffer* fill(int fd) {
+    RxBuffer& buffer = rxBuffers_[fd];
+    if (buffer.pos < buffer.length) {
+      return &buffer;
+    }
+    ssize_t n = recv(fd, buffer.data, sizeof(buffer.data), MSG_DONTWAIT);
+    buffer.pos = 0;
+    buffer.length = n > 0 ? (size_t)n : 0;
+    return buffer.length > 0 ? &buffer : nullptr;
+  }
+
+  typedef std::map<std::string, std::vector<uint8_t>> PreferenceTable;
+  std::map<std::string, PreferenceTable>& preferences() {
+    static std::map<std::string, PreferenceTable> store;
+    return store;
+  }
+
+  bool equalsIgnoreCase(const std::string& a, const char* b) {
+    return strcasecmp(a.c_str(), b) == 0;
+  }
+
+  std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t");
+    size_t end = s.find_last_not_of(" \t");
+    return begin == std::string::npos ? std::string() : s.substr(begin, end - begin + 1);
+  }
+
+  std::string hostPath(const char* path) {
+    return flashRoot_ + (path[0] == '/' ? "" : "/") + path;
+  }
+
+  int removeEntry(const char* path, const struct stat*, int, struct FTW*) {
+    return ::remove(path);
+  }
+}
+
+// ========================================
+// SimNet
+// ========================================
+
+void SimNet::setWiFiConnected(bool connected) {
+  wifiConnected_ = connected;
+}
+
+void SimNet::setFlashRoot(const char* directory) {
+  flashRoot_ = directory;
+}
+
+const char* SimNet::useTemporaryFlash() {
+  char pattern[] = "/tmp/simflash-XXXXXX";
+  if (mkdtemp(pattern) == nullptr) {
+    return nullptr;
+  }
+  flashRoot_ = pattern;
+  return flashRoot_.c_str();
+}
+
+void SimNet::removeFlash() {
+  if (!flashRoot_.empty()) {
+    nftw(flashRoot_.c_str(), removeEntry, 8, FTW_DEPTH | FTW_PHYS);
+  }
+}
+
+void SimNet::clearPreferences() {
+  preferences().clear();
+}
+
+// ========================================
+// WiFi / WiFiClient
+// ========================================
+
+wl_status_t WiFiClass::status() {
+  return wifiConnected_ ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+int WiFiClass::hostByName(const char* host, IPAddress& result) {
+  if (!wifiConnected_) {
+    return 0;
+  }
+  if (result.fromString(host)) {
+    return 1;
+  }
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo* info = nullptr;
+  if (getaddrinfo(host, nullptr, &hints, &info) != 0 || info == nullptr) {
+    return 0;
+  }
+  result = IPAddress((uint32_t)((struct sockaddr_in*)info->ai_addr)->sin_addr.s_addr);
+  freeaddrinfo(info);
+  return 1;
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+  stop();
+  if (!wifiConnected_) {
+    return 0;
+  }
+
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return 0;
+  }
+  struct timeval timeout = {CONNECT_TIMEOUT_SEC, 0};
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = (uint32_t)ip;
+  if (::connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+    ::close(fd);
+    return 0;
+  }
+
+  fd_ = fd;
+  rxBuffers_[fd_] = RxBuffer();
+  return 1;
+}
+
+int WiFiClient::connect(const char* host, uint16_t port) {
+  IPAddress ip;
+  if (!WiFi.hostByName(host, ip)) {
+    return 0;
+  }
+  return connect(ip, port);
+}
+
+size_t WiFiClient::write(const uint8_t* buffer, size_t size) {
+  size_t sent = 0;
+  while (fd_ >= 0 && sent < size) {
+    ssize_t n = send(fd_, buffer + sent, size - sent, MSG_NOSIGNAL);
+    if (n <= 0) {
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      stop();
+      break;
+    }
+    sent += (size_t)n;
+  }
+  return sent;
+}
+
+int WiFiClient::available() {
+  if (fd_ < 0) {
+    return 0;
+  }
+  const RxBuffer& buffer = rxBuffers_[fd_];
+  int pending = 0;
+  ioctl(fd_, FIONREAD, &pending);
+  return (int)(buffer.length - buffer.pos) + pending;
+}
+
+int WiFiClient::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::read(uint8_t* out, size_t size) {
+  if (fd_ < 0) {
+    return -1;
+  }
+  RxBuffer* buffer = fill(fd_);
+  if (buffer == nullptr) {
+    return -1;
+  }
+  size_t n = buffer->length - buffer->pos;
+  if (n > size) {
+    n = size;
+  }
+  memcpy(out, buffer->data + buffer->pos, n);
+  buffer->pos += n;
+  return (int)n;
+}
+
+int WiFiClient::peek() {
+  if (fd_ < 0) {
+    return -1;
+  }
+  RxBuffer* buffer = fill(fd_);
+  return buffer != nullptr ? buffer->data[buffer->pos] : -1;
+}
+
+void WiFiClient::stop() {
+  if (fd_ < 0) {
+    return;
+  }
+  rxBuffers_.erase(fd_);
+  ::close(fd_);
+  fd_ = -1;
+}
+
+/**
+ * 接続中か（相手が閉じていても、読み残しがあれば接続中として扱う）
+ */
+uint8_t WiFiClient::connected() {
+  if (fd_ < 0) {
+    return 0;
+  }
+  const RxBuffer& buffer = rxBuffers_[fd_];
+  if (buffer.pos < buffer.length) {
+    return 1;
+  }
+  uint8_t c;
+  ssize_t n = recv(fd_, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+  if (n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))) {
+    return 1;
+  }
+  stop();
+  return 0;
+}
+
+int WiFiClient::setNoDelay(bool enabled) {
+  int flag = enabled ? 1 : 0;
+  return fd_ >= 0 ? setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag)) : -1;
+}
+
+// ========================================
+// HTTPClient
+// ========================================
+
+HTTPClient::HTTPClient()
+  : client_(nullptr),
+    port_(80),
+    reuse_(true),
+    keepAlive_(false),
+    timeoutMs_(5000),
+    size_(-1) {
+}
+
+bool HTTPClient::begin(WiFiClient& client, const String& host, uint16_t port, const String& uri, bool) {
+  client_ = &client;
+  host_ = host.c_str();
+  port_ = port;
+  uri_ = uri.c_str();
+  keepAlive_ = false;
+  size_ = -1;
+  requestHeaders_.clear();
+  for (Header& header : responseHeaders_) {
+    header.value.clear();
+  }
+  return true;
+}
+
+/**
+ * リクエストの終了（接続を維持できない場合だけ切断する）
+ */
+void HTTPClient::end() {
+  if (client_ != nullptr && (!reuse_ || !keepAlive_)) {
+    client_->stop();
+  }
+  client_ = nullptr;
+}
+
+void HTTPClient::addHeader(const String& name, const String& value, bool first, bool replace) {
+  if (replace) {
+    for (Header& header : requestHeaders_) {
+      if (equalsIgnoreCase(header.name, name.c_str())) {
+        header.value = value.c_str();
+        return;
+      }
+    }
+  }
+  Header header = {name.c_str(), value.c_str()};
+  if (first) {
+    requestHeaders_.insert(requestHeaders_.begin(), header);
+  } else {
+    requestHeaders_.push_back(header);
+  }
+}
+
+void HTTPClient::collectHeaders(const char* headerKeys[], const size_t headerKeysCount) {
+  responseHeaders_.clear();
+  for (size_t i = 0; i < headerKeysCount; i++) {
+    Header header = {headerKeys[i], ""};
+    responseHeaders_.push_back(header);
+  }
+}
+
+String HTTPClient::header(const char* name) {
+  for (const Header& header : responseHeaders_) {
+    if (equalsIgnoreCase(header.name, name)) {
+      return String(header.value);
+    }
+  }
+  return String();
+}
+
+int HTTPClient::sendRequest(const char* method, uint8_t* payload, size_t size) {
+  if (client_ == nullptr) {
+    return HTTPC_ERROR_NOT_CONNECTED;
+  }
+  if (!client_->connected() && !client_->connect(host_.c_str(), port_)) {
+    return HTTPC_ERROR_CONNECTION_REFUSED;
+  }
+
+  std::string request = std::string(method) + " " + uri_ + " HTTP/1.1\r\n";
+  request += "Host: " + host_ + (port_ != 80 ? ":" + std::to_string(port_) : std::string()) + "\r\n";
+  request += "User-Agent: ESP32HTTPClient\r\n";
+  request += reuse_ ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+  request += "Accept-Encoding: identity;q=1,chunked;q=0.1,*;q=0\r\n";
+  for (const Header& header : requestHeaders_) {
+    request += header.name + ": " + header.value + "\r\n";
+  }
+  if (payload != nullptr || strcmp(method, "POST") == 0 || strcmp(method, "PUT") == 0) {
+    request += "Content-Length: " + std::to_string(payload != nullptr ? size : 0) + "\r\n";
+  }
+  request += "\r\n";
+
+  if (client_->write((const uint8_t*)request.data(), request.size()) != request.size()) {
+    return HTTPC_ERROR_SEND_HEADER_FAILED;
+  }
+  if (payload != nullptr && size > 0 && client_->write(payload, size) != size) {
+    return HTTPC_ERROR_SEND_PAYLOAD_FAILED;
+  }
+  return readResponseHeaders();
+}
+
+/**
+ * ステータス行とヘッダーを読む（ボディは読まない）
+ * @return HTTPステータス、負数は通信エラー
+ */
+int HTTPClient::readResponseHeaders() {
+  client_->setTimeout(timeoutMs_);
+
+  std::string line;
+  if (!readLine(line)) {
+    return client_->connected() ? HTTPC_ERROR_READ_TIMEOUT : HTTPC_ERROR_CONNECTION_LOST;
+  }
+  if (line.compare(0, 5, "HTTP/") != 0 || line.find(' ') == std::string::npos) {
+    return HTTPC_ERROR_NO_HTTP_SERVER;
+  }
+  int status = atoi(line.c_str() + line.find(' ') + 1);
+  keepAlive_ = line.compare(0, 8, "HTTP/1.0") != 0;  // HTTP/1.1 は既定で接続を維持する
+  size_ = -1;
+
+  for (;;) {
+    if (!readLine(line)) {
+      return HTTPC_ERROR_READ_TIMEOUT;
+    }
+    if (line.empty()) {
+      break;
+    }
+    size_t colon = line.find(':');
+    if (colon == std::string::npos) {
+      continue;
+    }
+    std::string name = trim(line.substr(0, colon));
+    std::string value = trim(line.substr(colon + 1));
+
+    if (equalsIgnoreCase(name, "Content-Length")) {
+      size_ = atoi(value.c_str());
+    } else if (equalsIgnoreCase(name, "Connection")) {
+      keepAlive_ = equalsIgnoreCase(value, "keep-alive");
+    }
+    for (Header& header : responseHeaders_) {
+      if (equalsIgnoreCase(header.name, name.c_str())) {
+        header.value = value;
+      }
+    }
+  }
+
+  if (equalsIgnoreCase(header("Transfer-Encoding").c_str(), "chunked")) {
+    size_ = -1;
+  }
+  return status;
+}
+
+// CRLFまでの1行を読む（タイムアウト・切断は false）
+bool HTTPClient::readLine(std::string& line) {
+  line.clear();
+  for (;;) {
+    char c;
+    if (client_->readBytes(&c, 1) != 1) {
+      return false;
+    }
+    if (c == '\n') {
+      return true;
+    }
+    if (c != '\r') {
+      line += c;
+    }
+  }
+}
+
+// ========================================
+// Preferences
+// ========================================
+
+bool Preferences::begin(const char* name, bool readOnly) {
+  if (readOnly && preferences().find(name) == preferences().end()) {
+    return false;  // NVSと同じく、読み取り専用では存在しない名前空間を開けない
+  }
+  namespace_ = name;
+  readOnly_ = readOnly;
+  started_ = true;
+  preferences()[namespace_];
+  return true;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t length) {
+  if (!started_ || readOnly_) {
+    return 0;
+  }
+  const uint8_t* bytes = static_cast<const uint8_t*>(value);
+  preferences()[namespace_][key].assign(bytes, bytes + length);
+  return length;
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t maxLength) {
+  if (!started_) {
+    return 0;
+  }
+  PreferenceTable& table = preferences()[namespace_];
+  PreferenceTable::const_iterator it = table.find(key);
+  if (it == table.end() || it->second.size() > maxLength) {
+    return 0;
+  }
+  memcpy(buffer, it->second.data(), it->second.size());
+  return it->second.size();
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+  if (!started_) {
+    return 0;
+  }
+  PreferenceTable& table = preferences()[namespace_];
+  PreferenceTable::const_iterator it = table.find(key);
+  return it != table.end() ? it->second.size() : 0;
+}
+
+bool Preferences::remove(const char* key) {
+  return started_ && !readOnly_ && preferences()[namespace_].erase(key) > 0;
+}
+
+bool Preferences::clear() {
+  if (!started_ || readOnly_) {
+    return false;
+  }
+  preferences()[namespace_].clear();
+  return true;
+}
+
+// ========================================
+// LittleFS
+// ========================================
+
+struct fs::File::Impl {
+  std::string path;       // LittleFS 上のパス
+  std::string name;
+  FILE* file;
+  DIR* dir;
+
+  Impl() : file(nullptr), dir(nullptr) {}
+  ~Impl() {
+    if (file != nullptr) {
+      fclose(file);
+    }
+    if (dir != nullptr) {
+      closedir(dir);
+    }
+  }
+};
+
+size_t fs::File::write(const uint8_t* buffer, size_t size) {
+  return impl_ != nullptr && impl_->file != nullptr ? fwrite(buffer, 1, size, impl_->file) : 0;
+}
+
+int fs::File::available() {
+  if (impl_ == nullptr || impl_->file == nullptr) {
+    return 0;
+  }
+  long pos = ftell(impl_->file);
+  return pos >= 0 ? (int)(size() - (size_t)pos) : 0;
+}
+
+int fs::File::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int fs::File::peek() {
+  if (impl_ == nullptr || impl_->file == nullptr) {
+    return -1;
+  }
+  int c = fgetc(impl_->file);
+  if (c != EOF) {
+    ungetc(c, impl_->file);
+  }
+  return c == EOF ? -1 : c;
+}
+
+size_t fs::File::read(uint8_t* buffer, size_t size) {
+  return impl_ != nullptr && impl_->file != nullptr ? fread(buffer, 1, size, impl_->file) : 0;
+}
+
+size_t fs::File::size() const {
+  if (impl_ == nullptr || impl_->file == nullptr) {
+    return 0;
+  }
+  fflush(impl_->file);
+  struct stat info;
+  return fstat(fileno(impl_->file), &info) == 0 ? (size_t)info.st_size : 0;
+}
+
+const char* fs::File::name() const {
+  return impl_ != nullptr ? impl_->name.c_str() : "";
+}
+
+const char* fs::File::path() const {
+  return impl_ != nullptr ? impl_->path.c_str() : "";
+}
+
+bool fs::File::isDirectory() const {
+  return impl_ != nullptr && impl_->dir != nullptr;
+}
+
+fs::File fs::File::openNextFile() {
+  if (impl_ == nullptr || impl_->dir == nullptr) {
+    return File();
+  }
+  while (struct dirent* entry = readdir(impl_->dir)) {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+      continue;
+    }
+    std::string child = impl_->path + (impl_->path == "/" ? "" : "/") + entry->d_name;
+    return LittleFS.open(child.c_str(), FILE_READ);
+  }
+  return File();
+}
+
+fs::File fs::FS::open(const char* path, const char* mode) {
+  std::string target = hostPath(path);
+  std::shared_ptr<File::Impl> impl(new File::Impl());
+  impl->path = path;
+  const char* slash = strrchr(path, '/');
+  impl->name = slash != nullptr ? slash + 1 : path;
+
+  struct stat info;
+  if (stat(target.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) {
+    impl->dir = opendir(target.c_str());
+    return impl->dir != nullptr ? File(impl) : File();
+  }
+
+  const char* hostMode = strcmp(mode, FILE_WRITE) == 0 ? "wb" : strcmp(mode, FILE_APPEND) == 0 ? "ab" : "rb";
+  impl->file = fopen(target.c_str(), hostMode);
+  return impl->file != nullptr ? File(impl) : File();
+}
+
+bool fs::FS::exists(const char* path) {
+  struct stat info;
+  return stat(hostPath(path).c_str(), &info) == 0;
+}
+
+bool fs::FS::remove(const char* path) {
+  return unlink(hostPath(path).c_str()) == 0;
+}
+
+bool fs::FS::mkdir(const char* path) {
+  return ::mkdir(hostPath(path).c_str(), 0755) == 0;
+}
+
+bool fs::FS::rmdir(const char* path) {
+  return ::rmdir(hostPath(path).c_str()) == 0;
+}
+
+bool LittleFSFS::begin(bool formatOnFail, const char*, uint8_t, const char*) {
+  if (flashRoot_.empty() && SimNet::useTemporaryFlash() == nullptr) {
+    return false;
+  }
+  struct stat info;
+  if (stat(flashRoot_.c_str(), &info) != 0) {
+    if (!formatOnFail) {
+      return false;  // 未フォーマット
+    }
+    ::mkdir(flashRoot_.c_str(), 0755);
+  }
+  return stat(flashRoot_.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
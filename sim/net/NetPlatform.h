@@ -0,0 +1,42 @@
+/**
+ * NetPlatform.h
+ *
+ * 通信・保存のクラスの確認用の置き換え（WiFi・HTTPClient・Preferences・LittleFS）の操作
+ * 通信はホストのTCPソケットで実際に行うため、SimPlatform::useRealTime() と組み合わせて使います。
+ */
+
+#ifndef SIM_NET_PLATFORM_H
+#define SIM_NET_PLATFORM_H
+
+#include <Arduino.h>
+
+namespace SimNet {
+
+  /**
+   * WiFiの接続状態を切り替える（WiFi.status() と新しいTCP接続の可否に反映。既存の接続は切らない）
+   */
+  void setWiFiConnected(bool connected);
+
+  /**
+   * LittleFS のルートにするホストのディレクトリを指定（LittleFS.begin() の前に呼び出す）
+   */
+  void setFlashRoot(const char* directory);
+
+  /**
+   * 一時ディレクトリを作って LittleFS のルートにする
+   * @return 作成したディレクトリ（失敗した場合は nullptr）
+   */
+  const char* useTemporaryFlash();
+
+  /**
+   * LittleFS のルートのディレクトリを中身ごと削除（終了時の後始末）
+   */
+  void removeFlash();
+
+  /**
+   * Preferences に保存した内容をすべて消去
+   */
+  void clearPreferences();
+}
+
+#endif // SIM_NET_PLATFORM_H
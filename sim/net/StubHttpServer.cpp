@@ -0,0 +1,210 @@
+/**
+ * StubHttpServer.cpp
+ *
+ * 確認用のHTTPサーバーの実装
+ */
+
+#include "StubHttpServer.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+  constexpr int POLL_MS = 100;   // 終了の確認間隔
+
+  const char* reasonPhrase(int status) {
+    switch (status) {
+      case 200: return "OK";
+      case 204: return "No Content";
+      case 400: return "Bad Request";
+      case 404: return "Not Found";
+      case 500: return "Internal Server Error";
+      case 503: return "Service Unavailable";
+      default: return "Status";
+    }
+  }
+}
+
+StubHttpServer::StubHttpServer(Handler handler, void* context)
+  : handler_(handler),
+    context_(context),
+    listenFd_(-1),
+    port_(0),
+    running_(false),
+    connections_(0),
+    requests_(0) {
+}
+
+StubHttpServer::~StubHttpServer() {
+  stop();
+}
+
+bool StubHttpServer::start() {
+  listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+  if (listenFd_ < 0) {
+    return false;
+  }
+  int reuse = 1;
+  setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = 0;  // 空いているポート
+  socklen_t length = sizeof(address);
+  if (bind(listenFd_, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+      listen(listenFd_, 4) != 0 ||
+      getsockname(listenFd_, (struct sockaddr*)&address, &length) != 0) {
+    close(listenFd_);
+    listenFd_ = -1;
+    return false;
+  }
+  port_ = ntohs(address.sin_port);
+
+  running_ = true;
+  thread_ = std::thread(&StubHttpServer::run, this);
+  return true;
+}
+
+void StubHttpServer::stop() {
+  if (!running_) {
+    return;
+  }
+  running_ = false;
+  thread_.join();
+  close(listenFd_);
+  listenFd_ = -1;
+}
+
+void StubHttpServer::run() {
+  while (running_) {
+    struct pollfd fds = {listenFd_, POLLIN, 0};
+    if (poll(&fds, 1, POLL_MS) <= 0) {
+      continue;
+    }
+    int fd = accept(listenFd_, nullptr, nullptr);
+    if (fd < 0) {
+      continue;
+    }
+    connections_++;
+    // chunked の小さな書き込みが遅延ACKで待たされないようにする（取得時間の計測を歪めない）
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    while (running_ && serve(fd)) {
+    }
+    close(fd);
+  }
+}
+
+/**
+ * 1件のリクエストに応答
+ * @return true: 同じ接続で次のリクエストを待つ, false: 接続を閉じる
+ */
+bool StubHttpServer::serve(int fd) {
+  Request request;
+  if (!readRequest(fd, request)) {
+    return false;
+  }
+  requests_++;
+  Response response = handler_(request, context_);
+
+  char head[256];
+  snprintf(head, sizeof(head), "HTTP/1.1 %d %s\r\nContent-Type: %s\r\n%s",
+           response.status, reasonPhrase(response.status), response.contentType.c_str(),
+           response.close ? "Connection: close\r\n" : "");
+  std::string out = head;
+  if (response.chunkSize == 0) {
+    out += "Content-Length: " + std::to_string(response.body.size()) + "\r\n\r\n" + response.body;
+    if (!sendAll(fd, out)) {
+      return false;
+    }
+  } else {
+    out += "Transfer-Encoding: chunked\r\n\r\n";
+    if (!sendAll(fd, out)) {
+      return false;
+    }
+    // チャンクごとに送信する（受信側は途中までしか届いていない状態を何度も経験する）
+    for (size_t pos = 0; pos < response.body.size(); pos += response.chunkSize) {
+      std::string chunk = response.body.substr(pos, response.chunkSize);
+      char size[16];
+      snprintf(size, sizeof(size), "%zx\r\n", chunk.size());
+      if (!sendAll(fd, size + chunk + "\r\n")) {
+        return false;
+      }
+    }
+    if (!sendAll(fd, "0\r\n\r\n")) {
+      return false;
+    }
+  }
+  return !response.close;
+}
+
+/**
+ * リクエスト行・ヘッダー・ボディ（Content-Length の分）を読む
+ * @return false: 相手が接続を閉じた、または待ち受けを終了する
+ */
+bool StubHttpServer::readRequest(int fd, Request& request) {
+  std::string data;
+  size_t headerEnd = std::string::npos;
+  size_t contentLength = 0;
+
+  for (;;) {
+    if (headerEnd == std::string::npos) {
+      headerEnd = data.find("\r\n\r\n");
+      if (headerEnd != std::string::npos) {
+        const char* found = strcasestr(data.c_str(), "\r\nContent-Length:");
+        if (found != nullptr && (size_t)(found - data.c_str()) < headerEnd) {
+          contentLength = strtoul(found + 17, nullptr, 10);
+        }
+      }
+    }
+    if (headerEnd != std::string::npos && data.size() >= headerEnd + 4 + contentLength) {
+      break;
+    }
+
+    struct pollfd fds = {fd, POLLIN, 0};
+    int ready = poll(&fds, 1, POLL_MS);
+    if (ready == 0) {
+      if (!running_) {
+        return false;
+      }
+      continue;
+    }
+    char buffer[2048];
+    ssize_t n = ready > 0 ? recv(fd, buffer, sizeof(buffer), 0) : -1;
+    if (n <= 0) {
+      return false;
+    }
+    data.append(buffer, (size_t)n);
+  }
+
+  size_t methodEnd = data.find(' ');
+  size_t pathEnd = data.find(' ', methodEnd + 1);
+  if (methodEnd == std::string::npos || pathEnd == std::string::npos) {
+    return false;
+  }
+  request.method = data.substr(0, methodEnd);
+  request.path = data.substr(methodEnd + 1, pathEnd - methodEnd - 1);
+  request.body = data.substr(headerEnd + 4, contentLength);
+  return true;
+}
+
+bool StubHttpServer::sendAll(int fd, const std::string& data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n <= 0) {
+      return false;
+    }
+    sent += (size_t)n;
+  }
+  return true;
+}
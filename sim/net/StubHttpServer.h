@@ -0,0 +1,78 @@
+/**
+ * StubHttpServer.h
+ *
+ * 確認用のHTTPサーバー（127.0.0.1 の空いているポートで待ち受け、別スレッドで応答）
+ * 応答は呼び出し側の関数が決めます。同じ接続で続けて送られたリクエスト（keep-alive）にも順に応答し、
+ * 受け付けた接続数を数えるため、接続の再利用も確認できます。
+ */
+
+#ifndef SIM_STUB_HTTP_SERVER_H
+#define SIM_STUB_HTTP_SERVER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <thread>
+
+class StubHttpServer {
+public:
+  struct Request {
+    std::string method;
+    std::string path;
+    std::string body;
+  };
+
+  struct Response {
+    int status;
+    std::string contentType;
+    std::string body;
+    size_t chunkSize;     // 0: Content-Length で送信, それ以外: この大きさずつ chunked で送信
+    bool close;           // 応答後に接続を閉じる
+
+    Response() : status(200), contentType("application/json"), chunkSize(0), close(false) {}
+  };
+
+  /**
+   * 応答を決める関数（サーバーのスレッドから呼ばれる）
+   * @param context 呼び出し側が指定した任意のポインタ
+   */
+  typedef Response (*Handler)(const Request& request, void* context);
+
+  StubHttpServer(Handler handler, void* context);
+  ~StubHttpServer();
+
+  /**
+   * 待ち受けを開始
+   * @return false: ソケットを作成できなかった
+   */
+  bool start();
+
+  /**
+   * 待ち受けを終了（接続中の応答が終わるまで待つ）
+   */
+  void stop();
+
+  uint16_t port() const { return port_; }
+  uint32_t connections() const { return connections_; }
+  uint32_t requests() const { return requests_; }
+
+private:
+  Handler handler_;
+  void* context_;
+  int listenFd_;
+  uint16_t port_;
+  std::thread thread_;
+  std::atomic<bool> running_;
+  std::atomic<uint32_t> connections_;
+  std::atomic<uint32_t> requests_;
+
+  void run();
+  bool serve(int fd);
+  bool readRequest(int fd, Request& request);
+  static bool sendAll(int fd, const std::string& data);
+
+  StubHttpServer(const StubHttpServer&) = delete;
+  StubHttpServer& operator=(const StubHttpServer&) = delete;
+};
+
+#endif // SIM_STUB_HTTP_SERVER_H
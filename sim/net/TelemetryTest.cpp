@@ -0,0 +1,468 @@
+/**
+ * TelemetryTest.cpp
+ *
+ * TelemetryBuffer の確認（ホストで実行、ローカルの収集サーバーに実際にPOSTする）
+ * StubHttpServer を収集サーバーとして起動し、HttpSession 経由で届いたセグメントを復号して、
+ * 追加したレコードが欠けず・重複せず・順番どおりに届くかを確認します。
+ *   - 接続中: flushInterval ごとに送信
+ *   - 切断中: セグメント単位でフラッシュ（ホストの一時ディレクトリ）に蓄積し、接続回復後にまとめて送信
+ *   - 切断中に件数が少なくても MAX_HOLD_MS 経てば蓄積
+ *   - 収集サーバーのエラー: 蓄積してバックオフ後に再送
+ *   - 再起動: 蓄積済みのセグメントを数え直して送信（壊れたファイルは削除）
+ *   - 送信前に壊れたセグメント: 削除して未送信の件数を正しく保つ
+ *   - 蓄積の上限: 最も古いセグメントから捨てる
+ *
+ * 実行例:
+ *   pio run -e telemetrytest && .pio/build/telemetrytest/program
+ *
+ * 確認に失敗した場合は終了コード 1 を返します。
+ */
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <LittleFS.h>
+#include <stdio.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "TelemetryBuffer.h"
+#include "HttpSession.h"
+#include "TimeManager.h"
+#include "SimConfig.h"
+#include "SimPlatform.h"
+#include "NetPlatform.h"
+#include "StubHttpServer.h"
+
+namespace {
+
+  constexpr time_t START_EPOCH = 1751328000;  // 2025-07-01 09:00 JST
+  const char* PATH = "/telemetry?device=sim";
+  constexpr unsigned long FLUSH_INTERVAL_MS = 1000;
+  constexpr unsigned long STEP_MS = 100;        // update() ごとに進める時計（待たずに進める）
+  constexpr int MAX_STEPS = 5000;
+
+  int failures = 0;
+
+  void expect(bool condition, const char* name, const char* what) {
+    if (!condition) {
+      printf("NG: %s: %s\n", name, what);
+      failures++;
+    }
+  }
+
+  /**
+   * 収集サーバー（受け取ったセグメントを復号してレコードを保存）
+   */
+  struct Collector {
+    std::mutex lock;
+    std::vector<TelemetryRecord> records;
+    uint32_t posts;
+    size_t maxBody;
+    bool malformed;
+    int failStatus;   // 0以外ならこのステータスで拒否する
+
+    void reset() {
+      std::lock_guard<std::mutex> guard(lock);
+      records.clear();
+      posts = 0;
+      maxBody = 0;
+      malformed = false;
+      failStatus = 0;
+    }
+
+    void setFailStatus(int status) {
+      std::lock_guard<std::mutex> guard(lock);
+      failStatus = status;
+    }
+
+    std::vector<TelemetryRecord> received() {
+      std::lock_guard<std::mutex> guard(lock);
+      return records;
+    }
+  };
+
+  // zigzag符号化した可変長整数を読む
+  bool getVarint(const std::string& data, size_t& pos, int32_t& value) {
+    uint32_t v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+      if (pos >= data.size()) {
+        return false;
+      }
+      uint8_t b = (uint8_t)data[pos++];
+      v |= (uint32_t)(b & 0x7F) << shift;
+      if ((b & 0x80) == 0) {
+        value = (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * セグメントの連結を復号（TelemetryBuffer.h の送信形式）
+   */
+  bool decode(const std::string& body, std::vector<TelemetryRecord>& out) {
+    size_t pos = 0;
+    while (pos < body.size()) {
+      if (body.size() - pos < 3 || body[pos] != 'T' || body[pos + 1] != '1') {
+        return false;
+      }
+      uint8_t count = (uint8_t)body[pos + 2];
+      pos += 3;
+      int32_t previous[5] = {0, 0, 0, 0, 0};
+      for (uint8_t i = 0; i < count; i++) {
+        int32_t values[5];
+        for (int k = 0; k < 5; k++) {
+          int32_t delta;
+          if (!getVarint(body, pos, delta)) {
+            return false;
+          }
+          values[k] = (int32_t)((uint32_t)previous[k] + (uint32_t)delta);
+          previous[k] = values[k];
+        }
+        TelemetryRecord record;
+        record.time = (uint32_t)values[0];
+        record.temperature = (int16_t)values[1];
+        record.humidity = (uint16_t)values[2];
+        record.discomfortIndex = (int16_t)values[3];
+        record.mode = (uint8_t)values[4];
+        out.push_back(record);
+      }
+    }
+    return true;
+  }
+
+  StubHttpServer::Response handle(const StubHttpServer::Request& request, void* context) {
+    Collector* collector = static_cast<Collector*>(context);
+    StubHttpServer::Response response;
+    response.contentType = "text/plain";
+
+    std::lock_guard<std::mutex> guard(collector->lock);
+    if (request.method != "POST" || request.path != PATH) {
+      response.status = 404;
+      return response;
+    }
+    if (collector->failStatus != 0) {
+      response.status = collector->failStatus;
+      return response;
+    }
+    std::vector<TelemetryRecord> records;
+    if (!decode(request.body, records)) {
+      collector->malformed = true;
+      response.status = 400;
+      return response;
+    }
+    collector->records.insert(collector->records.end(), records.begin(), records.end());
+    collector->posts++;
+    collector->maxBody = std::max(collector->maxBody, request.body.size());
+    response.status = 204;
+    return response;
+  }
+
+  /**
+   * i番目に追加するセンサー値とモード（値が毎回少しずつ変わる）
+   */
+  SensorData sample(uint32_t i) {
+    return SensorData((int16_t)(2500 + (int)(i * 37 % 300) - 150), (int16_t)(5000 + i * 53 % 1000),
+                      (int16_t)(7000 + i * 11 % 500), true);
+  }
+
+  ACMode sampleMode(uint32_t i) {
+    static const ACMode MODES[] = {ACMode::OFF, ACMode::COOLING_20, ACMode::AUTO_PLUS_1, ACMode::DEHUMID_MINUS_1_5};
+    return MODES[(i / 50) % 4];
+  }
+
+  /**
+   * 受け取ったレコードが from 番目からの count 件と一致するか（時刻は0でなく、減らないこと）
+   */
+  bool matches(const std::vector<TelemetryRecord>& records, size_t offset, uint32_t from, uint32_t count) {
+    if (records.size() < offset + count) {
+      return false;
+    }
+    uint32_t lastTime = 0;
+    for (uint32_t i = 0; i < count; i++) {
+      const TelemetryRecord& record = records[offset + i];
+      SensorData expected = sample(from + i);
+      if (record.temperature != expected.temperature || record.humidity != (uint16_t)expected.humidity ||
+          record.discomfortIndex != expected.discomfortIndex || record.mode != (uint8_t)sampleMode(from + i) ||
+          record.time == 0 || record.time < lastTime) {
+        printf("    %u 件目が一致しません\n", (unsigned)(offset + i));
+        return false;
+      }
+      lastTime = record.time;
+    }
+    return true;
+  }
+
+  void add(TelemetryBuffer& buffer, uint32_t from, uint32_t count) {
+    for (uint32_t i = from; i < from + count; i++) {
+      buffer.add(sample(i), sampleMode(i));
+      buffer.update();
+    }
+  }
+
+  /**
+   * 時計を進めながら update() を繰り返す（送信は実際に行うため実時間もかかる）
+   * @return 条件を満たした場合 true
+   */
+  template <typename Condition>
+  bool pump(TelemetryBuffer& buffer, Condition done) {
+    for (int i = 0; i < MAX_STEPS; i++) {
+      if (done()) {
+        return true;
+      }
+      SimPlatform::advance(STEP_MS);
+      buffer.update();
+    }
+    return done();
+  }
+
+  // 蓄積したセグメントのファイル（ホスト上のパス、書き込み順）
+  std::vector<std::string> segmentFiles(const std::string& root) {
+    std::vector<std::string> files;
+    std::string dir = root + "/tlm";
+    DIR* handle = opendir(dir.c_str());
+    if (handle == nullptr) {
+      return files;
+    }
+    while (struct dirent* entry = readdir(handle)) {
+      if (entry->d_name[0] != '.') {
+        files.push_back(dir + "/" + entry->d_name);
+      }
+    }
+    closedir(handle);
+    std::sort(files.begin(), files.end());
+    return files;
+  }
+
+  /**
+   * 各確認の共通の環境（収集サーバー・接続・フラッシュ）
+   */
+  struct Fixture {
+    Collector& collector;
+    HttpSession http;
+    TimeManager& timeMgr;
+    std::string flashRoot;
+
+    Fixture(Collector& c, uint16_t port, TimeManager& t) : collector(c), http("127.0.0.1", port), timeMgr(t) {
+      collector.reset();
+      SimNet::setWiFiConnected(true);
+      const char* root = SimNet::useTemporaryFlash();
+      flashRoot = root != nullptr ? root : "";
+    }
+    ~Fixture() {
+      http.close();
+      SimNet::removeFlash();
+    }
+  };
+
+  void onlineFlush(Collector& collector, uint16_t port, TimeManager& timeMgr) {
+    const char* name = "接続中は flushInterval ごとに送信する";
+    Fixture fx(collector, port, timeMgr);
+    TelemetryBuffer buffer(fx.http, timeMgr, PATH);
+    buffer.setFlushInterval(FLUSH_INTERVAL_MS);
+    expect(buffer.begin(), name, "フラッシュをマウントできない");
+
+    add(buffer, 0, 10);
+    expect(collector.received().empty(), name, "flushInterval より前に送信した");
+    expect(pump(buffer, [&]() { return buffer.getPendingRecords() == 0; }), name, "送信が終わらない");
+
+    std::vector<TelemetryRecord> records = collector.received();
+    expect(records.size() == 10 && matches(records, 0, 0, 10), name, "届いたレコードが一致しない");
+    expect(buffer.getStats().segmentsWritten == 0, name, "接続中にフラッシュへ書き込んだ");
+    expect(buffer.getStats().recordsSent == 10, name, "送信件数が一致しない");
+  }
+
+  void offlineBackfill(Collector& collector, uint16_t port, TimeManager& timeMgr) {
+    const char* name = "切断中はセグメント単位で蓄積し、接続回復後にまとめて送信する";
+    Fixture fx(collector, port, timeMgr);
+    TelemetryBuffer buffer(fx.http, timeMgr, PATH);
+    buffer.setFlushInterval(FLUSH_INTERVAL_MS);
+    buffer.begin();
+
+    SimNet::setWiFiConnected(false);
+    const uint32_t total = TelemetryBuffer::SEGMENT_RECORDS * 5 + 10;
+    add(buffer, 0, total);
+    expect(buffer.getStats().segmentsWritten == 5, name, "書き込み回数がセグメント数と一致しない");
+    expect(buffer.getStoredSegments() == 5, name, "蓄積したセグメント数が一致しない");
+    expect(buffer.getPendingRecords() == total, name, "未送信の件数が一致しない");
+    uint32_t storedBytes = buffer.getStoredBytes();
+    expect(storedBytes > 0 && storedBytes < TelemetryBuffer::SEGMENT_RECORDS * 5 * sizeof(TelemetryRecord),
+           name, "蓄積したバイト数が圧縮されていない");
+
+    SimNet::setWiFiConnected(true);
+    expect(pump(buffer, [&]() { return buffer.getPendingRecords() == 0; }), name, "送信が終わらない");
+
+    std::vector<TelemetryRecord> records = collector.received();
+    expect(records.size() == total && matches(records, 0, 0, total), name, "届いたレコードが一致しない");
+    expect(buffer.getStats().uploads == 2, name, "蓄積ぶんが1回のPOSTにまとまっていない");
+    expect(buffer.getStoredBytes() == 0 && buffer.getStoredSegments() == 0, name, "送信後も蓄積が残っている");
+    printf("  切断中の蓄積: %u レコード → %u バイト（1件 %.1f バイト）、まとめて送信 %lu バイト/秒\n",
+           (unsigned)(total - 10), (unsigned)storedBytes, storedBytes / (double)(total - 10),
+           (unsigned long)buffer.getStats().lastBytesPerSec);
+  }
+
+  void holdLimit(Collector& collector, uint16_t port, TimeManager& timeMgr) {
+    const char* name = "切断中も MAX_HOLD_MS 経てば件数によらず蓄積する";
+    Fixture fx(collector, port, timeMgr);
+    TelemetryBuffer buffer(fx.http, timeMgr, PATH);
+    buffer.setFlushInterval(FLUSH_INTERVAL_MS);
+    buffer.begin();
+
+    SimNet::setWiFiConnected(false);
+    add(buffer, 0, 5);
+    SimPlatform::advance(TelemetryBuffer::MAX_HOLD_MS - STEP_MS);
+    buffer.update();
+    expect(buffer.getStats().segmentsWritten == 0, name, "MAX_HOLD_MS より前に書き込んだ");
+    SimPlatform::advance(STEP_MS);
+    buffer.update();
+    expect(buffer.getStats().segmentsWritten == 1, name, "MAX_HOLD_MS 経っても書き込まない");
+    expect(buffer.getStoredSegments() == 1 && buffer.getPendingRecords() == 5, name, "蓄積した件数が一致しない");
+
+    SimNet::setWiFiConnected(true);
+    expect(pump(buffer, [&]() { return buffer.getPendingRecords() == 0; }), name, "送信が終わらない");
+    std::vector<TelemetryRecord> records = collector.received();
+    expect(records.size() == 5 && matches(records, 0, 0, 5), name, "届いたレコードが一致しない");
+  }
+
+  void collectorError(Collector& collector, uint16_t port, TimeManager& timeMgr) {
+    const char* name = "収集サーバーのエラー時は蓄積して再送する";
+    Fixture fx(collector, port, timeMgr);
+    TelemetryBuffer buffer(fx.http, timeMgr, PATH);
+    buffer.setFlushInterval(FLUSH_INTERVAL_MS);
+    buffer.begin();
+
+    collector.setFailStatus(503);
+    add(buffer, 0, 10);
+    expect(pump(buffer, [&]() { return buffer.getStats().uploadFailures > 0; }), name, "送信を試みない");
+    expect(buffer.getStoredSegments() == 1 && buffer.getPendingRecords() == 10, name, "失敗したセグメントを蓄積していない");
+    add(buffer, 10, 10);
+
+    collector.setFailStatus(0);
+    expect(pump(buffer, [&]() { return buffer.getPendingRecords() == 0; }), name, "再送が終わらない");
+    std::vector<TelemetryRecord> records = collector.received();
+    expect(records.size() == 20 && matches(records, 0, 0, 20), name, "届いたレコードが一致しない（欠落・重複・順序）");
+  }
+
+  void restart(Collector& collector, uint16_t port, TimeManager& timeMgr) {
+    const char* name = "再起動後は蓄積済みのセグメントを数え直して送信する";
+    Fixture fx(collector, port, timeMgr);
+    const uint32_t total = TelemetryBuffer::SEGMENT_RECORDS * 2;
+    {
+      TelemetryBuffer before(fx.http, timeMgr, PATH);
+      before.begin();
+      SimNet::setWiFiConnected(false);
+      add(before, 0, total);
+    }
+    // 書き込み途中で電源が切れたファイル（ヘッダーだけで中身がない）
+    std::vector<std::string> files = segmentFiles(fx.flashRoot);
+    expect(files.size() == 2, name, "蓄積したセグメント数が一致しない");
+    FILE* broken = fopen((fx.flashRoot + "/tlm/00000002").c_str(), "wb");
+    if (broken != nullptr) {
+      fwrite("T1", 1, 2, broken);
+      fclose(broken);
+    }
+
+    TelemetryBuffer buffer(fx.http, timeMgr, PATH);
+    buffer.setFlushInterval(FLUSH_INTERVAL_MS);
+    expect(buffer.begin(), name, "フラッシュをマウントできない");
+    expect(buffer.getStoredSegments() == 2 && buffer.getPendingRecords() == total, name, "数え直した件数が一致しない");
+    expect(segmentFiles(fx.flashRoot).size() == 2, name, "壊れたファイルを削除していない");
+
+    SimNet::setWiFiConnected(true);
+    expect(pump(buffer, [&]() { return buffer.getPendingRecords() == 0; }), name, "送信が終わらない");
+    std::vector<TelemetryRecord> records = collector.received();
+    expect(records.size() == total && matches(records, 0, 0, total), name, "届いたレコードが一致しない");
+  }
+
+  void corruptSegment(Collector& collector, uint16_t port, TimeManager& timeMgr) {
+    const char* name = "送信前に壊れたセグメントは削除し、未送信の件数を正しく保つ";
+    Fixture fx(collector, port, timeMgr);
+    TelemetryBuffer buffer(fx.http, timeMgr, PATH);
+    buffer.setFlushInterval(FLUSH_INTERVAL_MS);
+    buffer.begin();
+
+    const uint32_t segment = TelemetryBuffer::SEGMENT_RECORDS;
+    SimNet::setWiFiConnected(false);
+    add(buffer, 0, segment * 4);
+    std::vector<std::string> files = segmentFiles(fx.flashRoot);
+    expect(files.size() == 4, name, "蓄積したセグメント数が一致しない");
+    if (files.size() == 4) {
+      truncate(files[1].c_str(), 2);   // ヘッダーも読めない（件数が分からない）
+      truncate(files[2].c_str(), 3);   // ヘッダーだけ読める
+    }
+    uint32_t droppedBefore = buffer.getStats().recordsDropped;
+
+    SimNet::setWiFiConnected(true);
+    expect(pump(buffer, [&]() { return buffer.getStoredSegments() == 0; }), name, "送信が終わらない");
+    expect(buffer.getPendingRecords() == 0, name, "送信後も未送信の件数が残っている");
+    expect(buffer.getStoredBytes() == 0, name, "送信後も蓄積のバイト数が残っている");
+    expect(buffer.getStats().recordsDropped == droppedBefore + segment, name, "件数の分かる壊れたセグメントを数えていない");
+    std::vector<TelemetryRecord> records = collector.received();
+    expect(records.size() == segment * 2 && matches(records, 0, 0, segment) && matches(records, segment, segment * 3, segment),
+           name, "壊れていないセグメントが届いていない");
+  }
+
+  void ringLimit(Collector& collector, uint16_t port, TimeManager& timeMgr) {
+    const char* name = "蓄積の上限では最も古いセグメントから捨てる";
+    Fixture fx(collector, port, timeMgr);
+    TelemetryBuffer buffer(fx.http, timeMgr, PATH);
+    buffer.setFlushInterval(FLUSH_INTERVAL_MS);
+    buffer.begin();
+
+    const uint32_t segment = TelemetryBuffer::SEGMENT_RECORDS;
+    const uint32_t limit = TelemetryBuffer::MAX_SEGMENTS;
+    SimNet::setWiFiConnected(false);
+    add(buffer, 0, segment * (limit + 2));
+    expect(buffer.getStoredSegments() == limit, name, "蓄積したセグメント数が上限を超えた");
+    expect(buffer.getStats().recordsDropped == segment * 2, name, "捨てた件数が一致しない");
+    expect(buffer.getPendingRecords() == segment * limit, name, "未送信の件数が一致しない");
+
+    SimNet::setWiFiConnected(true);
+    expect(pump(buffer, [&]() { return buffer.getPendingRecords() == 0; }), name, "送信が終わらない");
+    std::vector<TelemetryRecord> records = collector.received();
+    expect(records.size() == segment * limit && matches(records, 0, segment * 2, segment * limit),
+           name, "届いたレコードが一致しない");
+    printf("  上限まで蓄積したぶんの送信: %u レコード / POST %u 回（最大 %u バイト）\n",
+           (unsigned)records.size(), (unsigned)buffer.getStats().uploads, (unsigned)collector.maxBody);
+  }
+}
+
+int main() {
+  SimPlatform::reset(START_EPOCH);
+  SimPlatform::useRealTime();
+
+  TimeManager timeMgr("sim", SimConfig::GMT_OFFSET_SEC, 0);
+  timeMgr.begin();
+  SimPlatform::syncClock();
+
+  Collector collector;
+  StubHttpServer server(handle, &collector);
+  if (!server.start()) {
+    printf("収集サーバーを起動できません\n");
+    return 1;
+  }
+
+  onlineFlush(collector, server.port(), timeMgr);
+  offlineBackfill(collector, server.port(), timeMgr);
+  holdLimit(collector, server.port(), timeMgr);
+  collectorError(collector, server.port(), timeMgr);
+  restart(collector, server.port(), timeMgr);
+  corruptSegment(collector, server.port(), timeMgr);
+  ringLimit(collector, server.port(), timeMgr);
+
+  server.stop();
+  if (collector.malformed) {
+    printf("NG: 復号できないボディを受け取りました\n");
+    failures++;
+  }
+  if (failures > 0) {
+    printf("テレメトリ: %d 件の確認に失敗\n", failures);
+    return 1;
+  }
+  printf("テレメトリ: OK\n");
+  return 0;
+}
@@ -0,0 +1,149 @@
+/**
+ * TraceRecorderTest.cpp
+ *
+ * TraceRecorder の確認（ホストで実行、フラッシュはホストの一時ディレクトリ）
+ * 同じフラッシュで何度も起動し直し、直前の起動（クラッシュ前など）の記録が次の起動で
+ * 消されずに残るか、書き込みが /trace/0.bin・/trace/1.bin に交互に行われるかを確認します。
+ *
+ * 実行例:
+ *   pio run -e tracetest && .pio/build/tracetest/program
+ *
+ * 確認に失敗した場合は終了コード 1 を返します。
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <string>
+#include "TraceRecorder.h"
+#include "TraceFormat.h"
+#include "WeatherForecast.h"
+#include "HttpSession.h"
+#include "TimeManager.h"
+#include "SimConfig.h"
+#include "SimPlatform.h"
+#include "NetPlatform.h"
+
+namespace {
+
+  constexpr time_t START_EPOCH = 1751328000;  // 2025-07-01 09:00 JST
+  constexpr int BOOTS = 4;
+
+  int failures = 0;
+
+  void expect(bool condition, const char* name, const char* what) {
+    if (!condition) {
+      printf("NG: %s: %s\n", name, what);
+      failures++;
+    }
+  }
+
+  /**
+   * トレースのファイルの中身（STARTの通し番号・センサー値の件数）
+   */
+  struct TraceFile {
+    bool valid;
+    uint32_t sequence;
+    uint32_t sensors;
+    std::string bytes;
+  };
+
+  TraceFile readTrace(const std::string& root, int index) {
+    TraceFile trace = {false, 0, 0, std::string()};
+    std::string path = root + "/trace/" + std::to_string(index) + ".bin";
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+      return trace;
+    }
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+      trace.bytes.append(buffer, n);
+    }
+    fclose(file);
+
+    Trace::Reader reader((const uint8_t*)trace.bytes.data(), trace.bytes.size());
+    Trace::Record record;
+    if (!reader.readHeader() || !reader.next(record) || record.type != Trace::START) {
+      return trace;
+    }
+    trace.valid = true;
+    trace.sequence = record.sequence;
+    while (reader.next(record)) {
+      if (record.type == Trace::SENSOR) {
+        trace.sensors++;
+      }
+    }
+    return trace;
+  }
+
+  /**
+   * 1回分の起動（記録を始めてセンサー値を書き込み、電源断に相当する形で終える）
+   * @param sensors 記録するセンサー値の件数（起動ごとに変えて、どの起動の記録かを区別する）
+   */
+  void boot(TimeManager& timeMgr, WeatherForecast& weather, uint32_t sensors) {
+    TraceRecorder recorder(timeMgr, weather);
+    recorder.begin();
+    for (uint32_t i = 0; i < sensors; i++) {
+      SimPlatform::advance(2000);
+      recorder.recordSensor(SensorData((int16_t)(2600 + i), 5500, 7500, true), millis());
+      recorder.update();
+    }
+    recorder.flush();
+  }
+}
+
+int main() {
+  SimPlatform::reset(START_EPOCH);
+  SimNet::setWiFiConnected(false);
+  const char* root = SimNet::useTemporaryFlash();
+  if (root == nullptr) {
+    printf("一時ディレクトリを作成できません\n");
+    return 1;
+  }
+  std::string flashRoot = root;
+
+  TimeManager timeMgr("sim", SimConfig::GMT_OFFSET_SEC, 0);
+  timeMgr.begin();
+  SimPlatform::syncClock();
+  HttpSession http("api.open-meteo.com");
+  WeatherForecast weather(http, 35.653204f, 139.688272f);
+
+  const char* name = "再起動しても直前の起動の記録が残る";
+  TraceFile previous = {false, 0, 0, std::string()};
+  for (int n = 1; n <= BOOTS; n++) {
+    uint32_t sensors = 10 * n;
+    boot(timeMgr, weather, sensors);
+
+    TraceFile files[2] = {readTrace(flashRoot, 0), readTrace(flashRoot, 1)};
+    int current = (files[0].valid && files[0].sequence == (uint32_t)n) ? 0 :
+                  (files[1].valid && files[1].sequence == (uint32_t)n) ? 1 : -1;
+    char what[96];
+    snprintf(what, sizeof(what), "%d回目の起動の記録（通し番号 %d）が見つからない", n, n);
+    expect(current >= 0, name, what);
+    if (current < 0) {
+      break;
+    }
+    snprintf(what, sizeof(what), "%d回目の起動のセンサー値の件数が一致しない", n);
+    expect(files[current].sensors == sensors, name, what);
+
+    // 1回目の起動は /trace/0.bin、以降は交互に書く
+    snprintf(what, sizeof(what), "%d回目の起動で書いたファイルが交互になっていない", n);
+    expect(current == (n - 1) % 2, name, what);
+
+    // 直前の起動の記録はもう一方のファイルにそのまま残る
+    if (n > 1) {
+      const TraceFile& kept = files[current ^ 1];
+      snprintf(what, sizeof(what), "%d回目の起動で直前の起動の記録を消した", n);
+      expect(kept.valid && kept.sequence == (uint32_t)(n - 1) && kept.bytes == previous.bytes, name, what);
+    }
+    previous = files[current];
+  }
+
+  SimNet::removeFlash();
+  if (failures > 0) {
+    printf("トレース: %d 件の確認に失敗\n", failures);
+    return 1;
+  }
+  printf("トレース: OK（%d 回の起動）\n", BOOTS);
+  return 0;
+}
@@ -0,0 +1,317 @@
+/**
+ * WeatherFetchBench.cpp
+ *
+ * 天気予報の取得の計測（ホストで実行、記録したOpen-Meteoの応答をローカルのHTTPサーバーから返す）
+ * 同じ応答を2つの方法で取得・パースし、取得時間・パース時間・ヒープ使用量を比較します。
+ *   - stream:   WeatherForecast そのもの（HTTPストリームからフィルタ付きで直接パース）
+ *   - buffered: 以前の方法（ボディ全体をStringに溜めてから、フィルタなしでパース）
+ * 応答は Content-Length と chunked の両方で返します。WeatherForecast が取り込んだ日次・時間別の値が
+ * フィルタなしでパースした値と一致しない場合は終了コード 1 を返します。
+ *
+ * 実行例:
+ *   pio run -e weatherbench && .pio/build/weatherbench/program
+ *   .pio/build/weatherbench/program --runs 50 --chunk 128 recorded.json
+ */
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <WiFi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "WeatherForecast.h"
+#include "HttpSession.h"
+#include "SimPlatform.h"
+#include "NetPlatform.h"
+#include "StubHttpServer.h"
+
+namespace {
+
+  constexpr time_t START_EPOCH = 1751328000;           // 2025-07-01 09:00 JST
+  constexpr float LATITUDE = 35.653204f;               // main.cpp の WeatherConfig と同じ
+  constexpr float LONGITUDE = 139.688272f;
+  constexpr unsigned long UPDATE_INTERVAL_MS = 3600000; // WeatherForecast の定期更新の間隔
+  const char* API_PREFIX = "/v1/forecast?";
+  const char* DEFAULT_FILES[] = {"sim/net/data/forecast_2d.json", "sim/net/data/forecast_16d_full.json"};
+
+  /**
+   * 返す応答（計測の合間にだけ切り替える）
+   */
+  struct Served {
+    std::string body;
+    size_t chunkSize;
+  };
+
+  StubHttpServer::Response handle(const StubHttpServer::Request& request, void* context) {
+    const Served* served = static_cast<const Served*>(context);
+    StubHttpServer::Response response;
+    if (request.method != "GET" || request.path.compare(0, strlen(API_PREFIX), API_PREFIX) != 0) {
+      response.status = 404;
+      return response;
+    }
+    response.body = served->body;
+    response.chunkSize = served->chunkSize;
+    return response;
+  }
+
+  bool readFile(const char* path, std::string& out) {
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+      return false;
+    }
+    char buffer[4096];
+    size_t n;
+    out.clear();
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+      out.append(buffer, n);
+    }
+    fclose(file);
+    return true;
+  }
+
+  /**
+   * 1回の取得の計測値
+   */
+  struct Sample {
+    unsigned long fetchMs;
+    unsigned long parseUs;
+    uint32_t heapBytes;
+  };
+
+  /**
+   * 以前の方法での取得（ボディ全体をStringに溜めてからフィルタなしでパース）
+   */
+  struct BufferedJob {
+    JsonDocument* doc;
+    DeserializationError error;
+    unsigned long parseUs;
+    uint32_t heapBytes;
+  };
+
+  bool parseBuffered(int status, Stream& body, void* context) {
+    if (status != 200) {
+      return false;
+    }
+    BufferedJob* job = static_cast<BufferedJob*>(context);
+
+    uint32_t heapBefore = ESP.getFreeHeap();
+    String payload;
+    char buffer[256];
+    size_t length = 0;
+    int c;
+    while ((c = body.read()) >= 0) {
+      buffer[length++] = (char)c;
+      if (length == sizeof(buffer)) {
+        payload.concat(buffer, length);
+        length = 0;
+      }
+    }
+    payload.concat(buffer, length);
+
+    unsigned long parseStart = micros();
+    job->error = deserializeJson(*job->doc, payload);
+    job->parseUs = micros() - parseStart;
+    uint32_t heapAfter = ESP.getFreeHeap();
+    job->heapBytes = (heapBefore > heapAfter) ? heapBefore - heapAfter : 0;
+    return !job->error;
+  }
+
+  bool fetchBuffered(HttpSession& http, const char* path, JsonDocument& doc, Sample& sample) {
+    BufferedJob job = {&doc, DeserializationError(), 0, 0};
+    HttpSession::Request request = {"GET", path, nullptr, nullptr, 0, parseBuffered, &job, 0, 0};
+    unsigned long start = millis();
+    http.execute(&request, 1);
+    sample.fetchMs = millis() - start;
+    sample.parseUs = job.parseUs;
+    sample.heapBytes = job.heapBytes;
+    return request.status == 200 && !job.error;
+  }
+
+  // 実数を0.01単位に変換（WeatherForecast と同じ丸め、欠損は MISSING）
+  int16_t toCenti(JsonVariant value) {
+    if (value.isNull()) {
+      return HourlyForecast::MISSING;
+    }
+    return (int16_t)lroundf(value.as<float>() * 100.0f);
+  }
+
+  /**
+   * WeatherForecast が取り込んだ値とフィルタなしでパースした値を比較
+   * @return 一致しない項目の数
+   */
+  int verify(const WeatherForecast& weather, JsonDocument& reference) {
+    int mismatches = 0;
+    WeatherData data = weather.getData();
+    JsonArray tempMaxArray = reference["daily"]["temperature_2m_max"];
+    JsonArray tempMinArray = reference["daily"]["temperature_2m_min"];
+    JsonArray weatherCodeArray = reference["daily"]["weather_code"];
+    float tempMax = tempMaxArray[0];
+    float tempMin = tempMinArray[0];
+    int weatherCode = weatherCodeArray[0];
+    if (!data.isValid || data.tempMax != tempMax || data.tempMin != tempMin || data.weatherCode != weatherCode) {
+      printf("  NG: 日次の値 %.1f/%.1f/%d（期待値 %.1f/%.1f/%d）\n",
+             data.tempMax, data.tempMin, data.weatherCode, tempMax, tempMin, weatherCode);
+      mismatches++;
+    }
+
+    JsonArray temps = reference["hourly"]["temperature_2m"];
+    JsonArray hums = reference["hourly"]["relative_humidity_2m"];
+    size_t expectedCount = std::min(std::min(temps.size(), hums.size()), (size_t)HourlyForecast::HOURS);
+    if (weather.getHourlyCount() != expectedCount) {
+      printf("  NG: 時間別予報 %u 時間分（期待値 %u）\n", weather.getHourlyCount(), (unsigned)expectedCount);
+      return mismatches + 1;
+    }
+    for (size_t i = 0; i < expectedCount; i++) {
+      int16_t temp = toCenti(temps[i]);
+      int16_t hum = toCenti(hums[i]);
+      HourlySample sample;
+      bool present = weather.getHourly((uint8_t)i, sample);
+      bool missing = (temp == HourlyForecast::MISSING || hum == HourlyForecast::MISSING);
+      if (present == missing ||
+          (present && (lroundf(sample.temperature * 100.0f) != temp || lroundf(sample.humidity * 100.0f) != hum))) {
+        printf("  NG: 時間別予報 %u 時間目が一致しません\n", (unsigned)i);
+        mismatches++;
+      }
+    }
+    return mismatches;
+  }
+
+  unsigned long median(std::vector<unsigned long> values) {
+    if (values.empty()) {
+      return 0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+  }
+
+  void printRow(const char* method, const char* transfer, const std::vector<Sample>& samples) {
+    std::vector<unsigned long> fetchMs;
+    std::vector<unsigned long> parseUs;
+    uint32_t heapMax = 0;
+    for (const Sample& s : samples) {
+      fetchMs.push_back(s.fetchMs);
+      parseUs.push_back(s.parseUs);
+      heapMax = std::max(heapMax, s.heapBytes);
+    }
+    printf("  %-9s %-15s %8lu %10lu %12lu\n", method, transfer, median(fetchMs), median(parseUs),
+           (unsigned long)heapMax);
+  }
+
+  void usage(const char* program) {
+    printf("使い方: %s [--runs 回数] [--chunk バイト数] [応答のJSONファイル...]\n", program);
+  }
+}
+
+int main(int argc, char** argv) {
+  int runs = 20;
+  size_t chunkSize = 256;
+  std::vector<const char*> files;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+      runs = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--chunk") == 0 && i + 1 < argc) {
+      chunkSize = (size_t)atoi(argv[++i]);
+    } else if (argv[i][0] == '-') {
+      usage(argv[0]);
+      return 2;
+    } else {
+      files.push_back(argv[i]);
+    }
+  }
+  if (files.empty()) {
+    files.assign(DEFAULT_FILES, DEFAULT_FILES + sizeof(DEFAULT_FILES) / sizeof(DEFAULT_FILES[0]));
+  }
+  if (runs < 1 || chunkSize == 0) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  SimPlatform::reset(START_EPOCH);
+  SimPlatform::useRealTime();
+  SimNet::setWiFiConnected(true);
+
+  Served served;
+  StubHttpServer server(handle, &served);
+  if (!server.start()) {
+    printf("HTTPサーバーを起動できません\n");
+    return 1;
+  }
+
+  int failures = 0;
+  for (const char* file : files) {
+    std::string body;
+    if (!readFile(file, body)) {
+      printf("%s を読み込めません\n", file);
+      failures++;
+      continue;
+    }
+    served.body = body;
+    printf("%s（%u バイト、%d 回の中央値、ヒープは最大値）\n", file, (unsigned)body.size(), runs);
+    printf("  %-9s %-15s %8s %10s %12s\n", "方法", "転送", "取得ms", "パースus", "ヒープbytes");
+
+    for (int chunked = 0; chunked <= 1; chunked++) {
+      served.chunkSize = chunked ? chunkSize : 0;
+      char transfer[32];
+      if (chunked) {
+        snprintf(transfer, sizeof(transfer), "chunked(%u)", (unsigned)chunkSize);
+      } else {
+        snprintf(transfer, sizeof(transfer), "content-length");
+      }
+
+      // WeatherForecast の取得（取得タスクは作られないため update() 内で取得が完了する）
+      HttpSession http("127.0.0.1", server.port());
+      WeatherForecast weather(http, LATITUDE, LONGITUDE);
+      weather.begin();
+      std::vector<Sample> stream;
+      for (int run = 0; run < runs; run++) {
+        weather.update();
+        const WeatherFetchStats& stats = weather.getFetchStats();
+        stream.push_back(Sample{stats.lastFetchMs, stats.lastParseUs, stats.lastParseHeapBytes});
+        SimPlatform::advance(UPDATE_INTERVAL_MS);
+      }
+      if (weather.getFetchStats().fetchCount != (uint32_t)runs || weather.getFetchStats().failureCount != 0) {
+        printf("  NG: 取得 %lu 回のうち %lu 回失敗\n", (unsigned long)weather.getFetchStats().fetchCount,
+               (unsigned long)weather.getFetchStats().failureCount);
+        failures++;
+      }
+
+      // 以前の方法での取得（同じセッションで取得）
+      std::string path = std::string(API_PREFIX) + "latitude=35.653204&longitude=139.688272";
+      std::vector<Sample> buffered;
+      for (int run = 0; run < runs; run++) {
+        JsonDocument doc;
+        Sample sample;
+        if (!fetchBuffered(http, path.c_str(), doc, sample)) {
+          printf("  NG: 以前の方法での取得に失敗\n");
+          failures++;
+          break;
+        }
+        buffered.push_back(sample);
+      }
+
+      printRow("stream", transfer, stream);
+      printRow("buffered", transfer, buffered);
+
+      // 記録した応答をフィルタなしでパースした値を期待値にする
+      JsonDocument reference;
+      if (deserializeJson(reference, body)) {
+        printf("  NG: 記録した応答をパースできません\n");
+        failures++;
+        continue;
+      }
+      failures += verify(weather, reference);
+    }
+    printf("\n");
+  }
+
+  server.stop();
+  if (failures > 0) {
+    printf("天気予報の取得: %d 件の確認に失敗\n", failures);
+    return 1;
+  }
+  printf("天気予報の取得: OK（取り込んだ値はフィルタなしでパースした値と一致）\n");
+  return 0;
+}
@@ -0,0 +1,274 @@
+/**
+ * Arduino.h（シミュレーター用）
+ *
+ * ホスト（PC）でエアコン制御のクラスをそのままビルドするための最小限の置き換えです。
+ * millis() / delay() / システム時刻は仮想時計（SimPlatform.h）に従い、
+ * delay() は実際には待たずに仮想時計を進めます（SimPlatform::useRealTime() の後は実時間）。
+ * 通信のクラスの確認（sim/net/）向けに String・Stream・Client・IPAddress・ESP も置き換えます。
+ */
+
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+#include <math.h>
+#include <time.h>
+#include <sys/time.h>
+#include <string>
+
+// リセット後もRTCメモリに残す変数（ホストでは通常の変数）
+#define RTC_NOINIT_ATTR
+
+// PubSubClient が使う型とフラッシュ上の定数の読み出し（ホストでは通常のメモリ）
+// pgm_read_byte などをすべて定義すると ArduinoJson がPROGMEM対応を有効にするため、必要なものだけ定義する
+typedef bool boolean;
+#define PROGMEM
+#define pgm_read_byte_near(address) (*(const uint8_t*)(address))
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1);
+uint32_t esp_random();
+
+// システム時刻は仮想時計から返す（ホストの時計を変更しない。time() は SimPlatform.cpp で置き換え）
+int simGettimeofday(struct timeval* tv, void* tz);
+int simSettimeofday(const struct timeval* tv, const void* tz);
+#define gettimeofday simGettimeofday
+#define settimeofday simSettimeofday
+
+/**
+ * Stringの置き換え（制御・通信のクラスが使う範囲のみ）
+ */
+class String {
+public:
+  String() {}
+  String(const char* s) : s_(s != nullptr ? s : "") {}
+  String(const std::string& s) : s_(s) {}
+  explicit String(int value) : s_(std::to_string(value)) {}
+  explicit String(unsigned int value) : s_(std::to_string(value)) {}
+  explicit String(long value) : s_(std::to_string(value)) {}
+  explicit String(unsigned long value) : s_(std::to_string(value)) {}
+  String(float value, unsigned int decimals) : s_(format(value, decimals)) {}
+  String(double value, unsigned int decimals) : s_(format(value, decimals)) {}
+
+  const char* c_str() const { return s_.c_str(); }
+  size_t length() const { return s_.size(); }
+  bool isEmpty() const { return s_.empty(); }
+  bool reserve(size_t size) { s_.reserve(size); return true; }
+  char operator[](size_t index) const { return index < s_.size() ? s_[index] : '\0'; }
+
+  bool concat(const char* s) { s_ += (s != nullptr ? s : ""); return true; }
+  bool concat(const char* s, size_t length) { s_.append(s, length); return true; }
+  bool concat(const String& s) { s_ += s.s_; return true; }
+  bool concat(char c) { s_ += c; return true; }
+  String& operator+=(const String& s) { s_ += s.s_; return *this; }
+  String& operator+=(const char* s) { concat(s); return *this; }
+  String& operator+=(char c) { s_ += c; return *this; }
+
+  bool operator==(const char* s) const { return s_ == (s != nullptr ? s : ""); }
+  bool operator==(const String& s) const { return s_ == s.s_; }
+  bool operator!=(const char* s) const { return !(*this == s); }
+  bool operator!=(const String& s) const { return !(*this == s); }
+  bool equalsIgnoreCase(const String& s) const { return strcasecmp(s_.c_str(), s.s_.c_str()) == 0; }
+  bool startsWith(const String& prefix) const { return s_.compare(0, prefix.s_.size(), prefix.s_) == 0; }
+
+  int indexOf(char c) const {
+    size_t pos = s_.find(c);
+    return pos == std::string::npos ? -1 : (int)pos;
+  }
+  String substring(size_t from) const { return from < s_.size() ? String(s_.substr(from)) : String(); }
+  String substring(size_t from, size_t to) const {
+    return from < s_.size() && from < to ? String(s_.substr(from, to - from)) : String();
+  }
+  long toInt() const { return strtol(s_.c_str(), nullptr, 10); }
+
+  friend String operator+(const String& a, const String& b) { return String(a.s_ + b.s_); }
+  friend String operator+(const String& a, const char* b) { return String(a.s_ + b); }
+  friend String operator+(const char* a, const String& b) { return String(a + b.s_); }
+
+private:
+  std::string s_;
+
+  static std::string format(double value, unsigned int decimals) {
+    char buffer[48];
+    snprintf(buffer, sizeof(buffer), "%.*f", (int)decimals, value);
+    return buffer;
+  }
+};
+
+// 連結の途中結果の型（ArduinoJson が String と並べて文字列として扱うため、名前だけ用意する）
+class StringSumHelper : public String {
+public:
+  StringSumHelper(const String& s) : String(s) {}
+};
+
+/**
+ * Printの置き換え（1バイトの書き込みだけを実装すればよい）
+ */
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (n < size && write(buffer[n]) == 1) {
+      n++;
+    }
+    return n;
+  }
+  size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+  size_t print(const char* s) { return write(s); }
+  size_t print(const String& s) { return write((const uint8_t*)s.c_str(), s.length()); }
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length < 0) {
+      return 0;
+    }
+    return write((const uint8_t*)buffer, (size_t)length < sizeof(buffer) ? (size_t)length : sizeof(buffer) - 1);
+  }
+  virtual void flush() {}
+};
+
+/**
+ * Streamの置き換え（readBytes() はタイムアウトまで実時間で待つ）
+ */
+class Stream : public Print {
+public:
+  Stream() : timeoutMs_(1000) {}
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  void setTimeout(unsigned long timeoutMs) { timeoutMs_ = timeoutMs; }
+  unsigned long getTimeout() const { return timeoutMs_; }
+
+  size_t readBytes(char* buffer, size_t length) { return readBytes((uint8_t*)buffer, length); }
+  size_t readBytes(uint8_t* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+      int c = timedRead();
+      if (c < 0) {
+        break;
+      }
+      buffer[count++] = (uint8_t)c;
+    }
+    return count;
+  }
+
+protected:
+  unsigned long timeoutMs_;
+
+  int timedRead() {
+    unsigned long start = millis();
+    do {
+      int c = read();
+      if (c >= 0) {
+        return c;
+      }
+      yield();
+    } while (millis() - start < timeoutMs_);
+    return -1;
+  }
+};
+
+/**
+ * IPAddressの置き換え（IPv4のみ）
+ */
+class IPAddress {
+public:
+  IPAddress() : address_{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : address_{a, b, c, d} {}
+  IPAddress(uint32_t address) { memcpy(address_, &address, sizeof(address_)); }  // ネットワークバイト順
+
+  operator uint32_t() const {
+    uint32_t address;
+    memcpy(&address, address_, sizeof(address));
+    return address;
+  }
+  bool operator==(const IPAddress& other) const { return memcmp(address_, other.address_, sizeof(address_)) == 0; }
+  uint8_t operator[](int index) const { return address_[index]; }
+  uint8_t* raw_address() { return address_; }
+
+  bool fromString(const char* s) {
+    unsigned int a, b, c, d;
+    char extra;
+    if (sscanf(s, "%u.%u.%u.%u%c", &a, &b, &c, &d, &extra) != 4 || a > 255 || b > 255 || c > 255 || d > 255) {
+      return false;
+    }
+    address_[0] = (uint8_t)a;
+    address_[1] = (uint8_t)b;
+    address_[2] = (uint8_t)c;
+    address_[3] = (uint8_t)d;
+    return true;
+  }
+  String toString() const {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", address_[0], address_[1], address_[2], address_[3]);
+    return String(buffer);
+  }
+
+private:
+  uint8_t address_[4];
+};
+
+/**
+ * Clientの置き換え（PubSubClient などのライブラリが使うインターフェース）
+ */
+class Client : public Stream {
+public:
+  virtual int connect(IPAddress ip, uint16_t port) = 0;
+  virtual int connect(const char* host, uint16_t port) = 0;
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size) = 0;
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int read(uint8_t* buffer, size_t size) = 0;
+  virtual int peek() = 0;
+  virtual void flush() = 0;
+  virtual void stop() = 0;
+  virtual uint8_t connected() = 0;
+  virtual operator bool() = 0;
+
+protected:
+  uint8_t* rawIPAddress(IPAddress& address) { return address.raw_address(); }
+};
+
+/**
+ * ESPの置き換え（ヒープの空き容量はホストのmallocの使用量から求める）
+ */
+class EspClass {
+public:
+  uint32_t getFreeHeap();
+};
+extern EspClass ESP;
+
+// FreeRTOSのタスク（ホストではタスクを作らない。作成は常に失敗し、呼び出し側はloop内で処理する）
+typedef void* TaskHandle_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void (*TaskFunction_t)(void* arg);
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdFAIL 0
+#define pdPASS 1
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFF)
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* name, uint32_t stackDepth, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core);
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+
+#endif // SIM_ARDUINO_H
@@ -0,0 +1,25 @@
+/**
+ * DHT.h（シミュレーター用）
+ *
+ * SensorData・AdaptiveSampler（EnvironmentSensor.h）・センサーの種類（BoardConfig.h）を使うためだけの最小限の定義です。
+ * センサー値はシミュレーターが部屋のモデルから直接作るため、読み取りは常に失敗します。
+ */
+
+#ifndef SIM_DHT_H
+#define SIM_DHT_H
+
+#include <Arduino.h>
+#include <math.h>
+
+#define DHT11 11
+#define DHT22 22
+
+class DHT {
+public:
+  DHT(uint8_t, uint8_t) {}
+  void begin() {}
+  float readHumidity() { return NAN; }
+  float readTemperature() { return NAN; }
+};
+
+#endif // SIM_DHT_H
@@ -0,0 +1,59 @@
+/**
+ * FS.h（シミュレーター用）
+ * ファイルはホストのディレクトリ（SimNet::setFlashRoot()）の下に実際に作ります。
+ */
+
+#ifndef SIM_FS_H
+#define SIM_FS_H
+
+#include <Arduino.h>
+#include <memory>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+  /**
+   * ファイルまたはディレクトリ（コピーしても同じものを指す）
+   */
+  class File : public Stream {
+  public:
+    File() {}
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t read(uint8_t* buffer, size_t size);
+    size_t size() const;
+    const char* name() const;   // ファイル名（ディレクトリを除く）
+    const char* path() const;
+    bool isDirectory() const;
+    File openNextFile();
+    void close() { impl_.reset(); }
+    operator bool() const { return impl_ != nullptr; }
+
+    struct Impl;
+    explicit File(std::shared_ptr<Impl> impl) : impl_(impl) {}
+
+  private:
+    std::shared_ptr<Impl> impl_;
+  };
+
+  class FS {
+  public:
+    File open(const char* path, const char* mode = FILE_READ);
+    bool exists(const char* path);
+    bool remove(const char* path);
+    bool mkdir(const char* path);
+    bool rmdir(const char* path);
+  };
+}
+
+using fs::File;
+using fs::FS;
+
+#endif // SIM_FS_H
@@ -0,0 +1,64 @@
+/**
+ * HTTPClient.h（シミュレーター用）
+ *
+ * ESP32の HTTPClient のうち、HttpSession が使う範囲をホストのソケットで実装します。
+ * ステータス行とヘッダーだけを読み、ボディは呼び出し側が WiFiClient から直接読みます。
+ * setReuse(true) の場合、サーバーが Connection: close を返さなければ end() の後も接続を維持します。
+ */
+
+#ifndef SIM_HTTP_CLIENT_H
+#define SIM_HTTP_CLIENT_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <string>
+#include <vector>
+
+#define HTTP_CODE_OK 200
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_NO_HTTP_SERVER (-7)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+class HTTPClient {
+public:
+  HTTPClient();
+
+  bool begin(WiFiClient& client, const String& host, uint16_t port, const String& uri = "/", bool https = false);
+  void end();
+
+  void setReuse(bool reuse) { reuse_ = reuse; }
+  void setTimeout(uint16_t timeoutMs) { timeoutMs_ = timeoutMs; }
+  void addHeader(const String& name, const String& value, bool first = false, bool replace = true);
+  void collectHeaders(const char* headerKeys[], const size_t headerKeysCount);
+  String header(const char* name);
+
+  int sendRequest(const char* method, uint8_t* payload = nullptr, size_t size = 0);
+  int getSize() const { return size_; }
+  bool connected() { return client_ != nullptr && client_->connected(); }
+
+private:
+  struct Header {
+    std::string name;
+    std::string value;
+  };
+
+  WiFiClient* client_;
+  std::string host_;
+  uint16_t port_;
+  std::string uri_;
+  bool reuse_;
+  bool keepAlive_;              // サーバーが接続の維持を許可した
+  uint16_t timeoutMs_;
+  int size_;                    // Content-Length（chunked・不明は-1）
+  std::vector<Header> requestHeaders_;
+  std::vector<Header> responseHeaders_;  // collectHeaders() で指定したものだけ値が入る
+
+  int readResponseHeaders();
+  bool readLine(std::string& line);
+};
+
+#endif // SIM_HTTP_CLIENT_H
@@ -0,0 +1,32 @@
+/**
+ * IRrecv.h（シミュレーター用）
+ * シミュレーターではリモコン信号を受信しません。
+ */
+
+#ifndef SIM_IRRECV_H
+#define SIM_IRRECV_H
+
+#include <Arduino.h>
+
+enum decode_type_t { UNKNOWN = -1, DAIKIN = 16 };
+
+struct decode_results {
+  decode_type_t decode_type;
+  uint64_t value;
+  uint16_t bits;
+  volatile uint16_t* rawbuf;
+  uint16_t rawlen;
+};
+
+const uint16_t kRawTick = 2;
+
+class IRrecv {
+public:
+  explicit IRrecv(uint16_t) {}
+  void enableIRIn() {}
+  void disableIRIn() {}
+  bool decode(decode_results*) { return false; }
+  void resume() {}
+};
+
+#endif // SIM_IRRECV_H
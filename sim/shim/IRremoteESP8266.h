@@ -0,0 +1,10 @@
+/**
+ * IRremoteESP8266.h（シミュレーター用）
+ */
+
+#ifndef SIM_IRREMOTE_ESP8266_H
+#define SIM_IRREMOTE_ESP8266_H
+
+#include <Arduino.h>
+
+#endif // SIM_IRREMOTE_ESP8266_H
@@ -0,0 +1,14 @@
+/**
+ * IRutils.h（シミュレーター用）
+ */
+
+#ifndef SIM_IRUTILS_H
+#define SIM_IRUTILS_H
+
+#include <IRrecv.h>
+
+inline String typeToString(decode_type_t type, bool = false) {
+  return type == DAIKIN ? "DAIKIN" : "UNKNOWN";
+}
+
+#endif // SIM_IRUTILS_H
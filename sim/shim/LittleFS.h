@@ -0,0 +1,19 @@
+/**
+ * LittleFS.h（シミュレーター用）
+ * マウントはルートのディレクトリを作るだけです（容量の上限はない）。
+ */
+
+#ifndef SIM_LITTLEFS_H
+#define SIM_LITTLEFS_H
+
+#include <FS.h>
+
+class LittleFSFS : public fs::FS {
+public:
+  bool begin(bool formatOnFail = false, const char* basePath = "/littlefs", uint8_t maxOpenFiles = 10,
+             const char* partitionLabel = "spiffs");
+  void end() {}
+};
+extern LittleFSFS LittleFS;
+
+#endif // SIM_LITTLEFS_H
@@ -0,0 +1,32 @@
+/**
+ * Preferences.h（シミュレーター用）
+ * NVSの代わりにメモリ上に保存します（プログラムの終了で消える。SimNet::clearPreferences() で消去）。
+ */
+
+#ifndef SIM_PREFERENCES_H
+#define SIM_PREFERENCES_H
+
+#include <Arduino.h>
+#include <string>
+
+class Preferences {
+public:
+  Preferences() : started_(false), readOnly_(false) {}
+  ~Preferences() { end(); }
+
+  bool begin(const char* name, bool readOnly = false);
+  void end() { started_ = false; }
+
+  size_t putBytes(const char* key, const void* value, size_t length);
+  size_t getBytes(const char* key, void* buffer, size_t maxLength);
+  size_t getBytesLength(const char* key);
+  bool remove(const char* key);
+  bool clear();
+
+private:
+  std::string namespace_;
+  bool started_;
+  bool readOnly_;
+};
+
+#endif // SIM_PREFERENCES_H
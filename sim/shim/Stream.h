@@ -0,0 +1,6 @@
+/**
+ * Stream.h（シミュレーター用）
+ * ライブラリ（ArduinoJson・PubSubClient）が個別に読み込むヘッダー。定義は Arduino.h にあります。
+ */
+
+#include <Arduino.h>
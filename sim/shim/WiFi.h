@@ -0,0 +1,62 @@
+/**
+ * WiFi.h（シミュレーター用）
+ *
+ * WiFiClient はホストのTCPソケットで実際に通信します（接続先はローカルのスタブサーバー・ブローカー）。
+ * WiFiの接続状態は SimNet::setWiFiConnected()（sim/net/NetPlatform.h）で切り替えます。
+ */
+
+#ifndef SIM_WIFI_H
+#define SIM_WIFI_H
+
+#include <Arduino.h>
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+/**
+ * TCPクライアント（受信は待たずに、受信済みの分だけを返す）
+ */
+class WiFiClient : public Client {
+public:
+  WiFiClient() : fd_(-1) {}
+  ~WiFiClient() { stop(); }
+
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(const char* host, uint16_t port) override;
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buffer, size_t size) override;
+  int available() override;
+  int read() override;
+  int read(uint8_t* buffer, size_t size) override;
+  int peek() override;
+  void flush() override {}
+  void stop() override;
+  uint8_t connected() override;
+  operator bool() override { return connected() != 0; }
+  int setNoDelay(bool enabled);
+
+private:
+  int fd_;
+
+  // ソケットを所有するためコピー禁止
+  WiFiClient(const WiFiClient&) = delete;
+  WiFiClient& operator=(const WiFiClient&) = delete;
+};
+
+class WiFiClass {
+public:
+  wl_status_t status();
+  bool isConnected() { return status() == WL_CONNECTED; }
+  int hostByName(const char* host, IPAddress& result);
+  int8_t RSSI() { return isConnected() ? -50 : 0; }
+  IPAddress localIP() { return IPAddress(127, 0, 0, 1); }
+};
+extern WiFiClass WiFi;
+
+#endif // SIM_WIFI_H
@@ -0,0 +1,17 @@
+/**
+ * WiFiClientSecure.h（シミュレーター用）
+ * ホストではTLSを使わず平文で接続します（確認はローカルのスタブサーバーに対して行うため）。
+ */
+
+#ifndef SIM_WIFI_CLIENT_SECURE_H
+#define SIM_WIFI_CLIENT_SECURE_H
+
+#include <WiFi.h>
+
+class WiFiClientSecure : public WiFiClient {
+public:
+  void setCACert(const char*) {}
+  void setInsecure() {}
+};
+
+#endif // SIM_WIFI_CLIENT_SECURE_H
@@ -0,0 +1,16 @@
+/**
+ * esp_sntp.h（シミュレーター用）
+ * 同期の通知は SimPlatform::syncClock() から呼ばれます。
+ */
+
+#ifndef SIM_ESP_SNTP_H
+#define SIM_ESP_SNTP_H
+
+#include <Arduino.h>
+
+typedef void (*sntp_sync_time_cb_t)(struct timeval* tv);
+
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback);
+void sntp_set_sync_interval(uint32_t intervalMs);
+
+#endif // SIM_ESP_SNTP_H
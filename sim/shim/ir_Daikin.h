@@ -0,0 +1,46 @@
+/**
+ * ir_Daikin.h（シミュレーター用）
+ *
+ * 赤外線は送信せず、send() の時点の設定を SimPlatform に記録します。
+ * 部屋のモデルは、最後に送信された設定（電源・運転モード・設定温度）に従って動作します。
+ */
+
+#ifndef SIM_IR_DAIKIN_H
+#define SIM_IR_DAIKIN_H
+
+#include <Arduino.h>
+
+const uint8_t kDaikinAuto = 0;
+const uint8_t kDaikinDry = 2;
+const uint8_t kDaikinCool = 3;
+const uint8_t kDaikinHeat = 4;
+const uint8_t kDaikinFan = 6;
+const uint8_t kDaikinFanAuto = 0xA;
+
+/**
+ * エアコンが受信した設定
+ */
+struct DaikinState {
+  bool power;
+  uint8_t mode;
+  float temp;
+};
+
+class IRDaikinESP {
+public:
+  explicit IRDaikinESP(uint16_t) : state_{false, kDaikinAuto, 25.0f} {}
+  void begin() {}
+  void on() { state_.power = true; }
+  void off() { state_.power = false; }
+  void setMode(uint8_t mode) { state_.mode = mode; }
+  void setTemp(float temp) { state_.temp = temp; }
+  void setFan(uint8_t) {}
+  void setSwingVertical(bool) {}
+  void setSwingHorizontal(bool) {}
+  void send();
+
+private:
+  DaikinState state_;
+};
+
+#endif // SIM_IR_DAIKIN_H
@@ -7,6 +7,7 @@
  * - 温度・湿度から不快指数（DI）を計算
  * - DI値に基づいて最適なエアコンモードを自動選択
  * - 赤外線信号の送受信（ダイキンエアコン用）
+ * - モード変更の要求の調停（優先度・置き換え・送信間隔）
  *
  * 対応モード:
  * - COOLING_20: 冷房20度（DI 77以上の暑い時）
@@ -15,23 +16,19 @@
  */
 
 #include "AirConditionerController.h"
+#include "Log.h"
+#include "ComfortIndex.h"  // 不快指数の計算式（天気予報と共通）
+#include "BoardConfig.h"   // DIの閾値（ボードの構成）
 #include <IRutils.h>  // 赤外線ユーティリティ関数
 
 /**
  * 不快指数（DI）の閾値設定
  * ユーザー希望: DI値 70～75 を保つ（寒がり向け設定）
  *
- * namespaceは名前の衝突を避けるための仕組み
- * DIThreshold::TARGET_MINのように使う
+ * 値はボードの構成（BoardConfig.h の Board::StandardComfort）にあり、
+ * DIThreshold::TARGET_MINのように使う（usingは型に別名を付ける宣言）
  */
-namespace DIThreshold {
-  constexpr float TARGET_MIN = 70.0f;         // 目標DI最小値（これより下がったら暖める）
-  constexpr float TARGET_MAX = 75.0f;         // 目標DI最大値（これより上がったら対策）
-  constexpr float COOLING_THRESHOLD = 77.0f;  // 冷房開始閾値（強力な冷房が必要）
-  constexpr float HEATING_THRESHOLD = 68.0f;  // 暖房開始閾値（肌寒い）
-  // constexprは「コンパイル時定数」を意味するキーワード
-  // この値は実行中に変わらないので、メモリ効率が良い
-}
+using DIThreshold = Board::Current::Comfort;
 
 /**
  * コンストラクタ（オブジェクトを作成する時に呼ばれる特別な関数）
@@ -42,7 +39,9 @@ namespace DIThreshold {
  * メンバ変数を効率的に初期化するC++の記法です
  */
 AirConditionerController::AirConditionerController(uint8_t sendPin, uint8_t recvPin)
-  : daikinAC_(sendPin), irRecv_(recvPin), currentMode_(ACMode::NONE) {
+  : daikinAC_(sendPin), irRecv_(recvPin), currentMode_(ACMode::NONE), stats_(),
+    receiveCallback_(nullptr), receiveContext_(nullptr), pending_(), lastSendMs_(0), hasSent_(false),
+    queueStats_() {
   // コンストラクタの本体（今回は初期化リストで全て完了しているので空）
 }
 
@@ -53,22 +52,134 @@ AirConditionerController::AirConditionerController(uint8_t sendPin, uint8_t recv
 void AirConditionerController::begin() {
   daikinAC_.begin();      // ダイキンエアコン送信ライブラリの初期化
   irRecv_.enableIRIn();   // 赤外線受信機能を有効化
-  Serial.println("[AC] エアコンコントローラー初期化完了");
+  LOG_I("[AC] エアコンコントローラー初期化完了");
 }
 
 /**
- * エアコンの動作モードを設定する
- * @param mode 設定したいモード（COOLING_20、AUTO_PLUS_1、DEHUMID_MINUS_1_5のいずれか）
+ * モードの変更を要求する
+ * @param mode     設定したいモード（OFF、COOLING_20、AUTO_PLUS_1、DEHUMID_MINUS_1_5のいずれか）
+ * @param priority 要求元の優先度（OFFは常に STOP として扱う）
  *
- * 現在のモードと同じ場合は、無駄な信号送信を避けるため何もしない
+ * すぐには送信せず、update() で送信します。その間に同じ優先度の要求が来た場合は新しい方で置き換え、
+ * 最後の状態だけを送信します（制御・スケジュール・Web API・MQTTが同時に要求しても信号は1回）。
  */
-void AirConditionerController::setMode(ACMode mode) {
-  // 既に同じモードの場合は処理をスキップ
+void AirConditionerController::request(ACMode mode, ACPriority priority) {
+  if (mode == ACMode::NONE || (uint8_t)mode > (uint8_t)ACMode::DEHUMID_MINUS_1_5) {
+    LOG_W("[AC] 無効なモード");
+    return;
+  }
+  if (mode == ACMode::OFF) {
+    priority = ACPriority::STOP;
+  }
+
+  PendingCommand& command = pending_[(uint8_t)priority];
+  if (command.pending) {
+    // 送信前の要求を置き換える（現在のモードに戻す要求なら取り消すだけ）
+    queueStats_.coalesced++;
+    command.pending = false;
+  }
   if (mode == currentMode_) {
-    Serial.println("[AC] モード変更なし");
-    return;  // ここで関数を終了
+    // 既に同じモードの場合は、無駄な信号送信を避けるため送信しない。
+    // ただし優先度の低い送信待ちは、このモードを維持する要求に負けるため取り消す
+    // （残すと、優先度の高い要求が捨てられ低い要求が送信される逆転が起きる）
+    for (uint8_t i = 0; i < (uint8_t)priority; i++) {
+      if (pending_[i].pending) {
+        pending_[i].pending = false;
+        queueStats_.coalesced++;
+        LOG_D("[AC] %s の要求（%s）を取り消し", priorityToKey((ACPriority)i), modeToKey(pending_[i].mode));
+      }
+    }
+    LOG_D("[AC] モード変更なし");
+    updateDepth();
+    return;
+  }
+
+  command.mode = mode;
+  command.requestedMs = millis();
+  command.pending = true;
+  queueStats_.requested++;
+  updateDepth();
+}
+
+/**
+ * 送信待ちのコマンドを送信する（loop()から呼ばれる）
+ * 優先度の最も高いコマンドだけを送信し、それより低い優先度の送信待ちは取り消します。
+ */
+void AirConditionerController::update() {
+  if (queueStats_.depth == 0) {
+    return;
+  }
+  if (hasSent_ && millis() - lastSendMs_ < MIN_FRAME_SPACING_MS) {
+    return;  // 前の信号から間隔を空ける（その間の要求は置き換えられ、最後の状態だけを送信）
+  }
+
+  int top = -1;
+  for (int i = PRIORITY_COUNT - 1; i >= 0; i--) {
+    if (!pending_[i].pending) {
+      continue;
+    }
+    if (top < 0) {
+      top = i;
+    } else {
+      pending_[i].pending = false;
+      queueStats_.coalesced++;
+      LOG_D("[AC] %s の要求（%s）を取り消し", priorityToKey((ACPriority)i), modeToKey(pending_[i].mode));
+    }
+  }
+
+  PendingCommand& command = pending_[top];
+  command.pending = false;
+  updateDepth();
+  if (!transmit(command.mode)) {
+    return;
   }
 
+  lastSendMs_ = millis();
+  hasSent_ = true;
+  uint32_t latencyMs = lastSendMs_ - command.requestedMs;
+  queueStats_.sent++;
+  queueStats_.lastLatencyMs = latencyMs;
+  queueStats_.totalLatencyMs += latencyMs;
+  if (latencyMs > queueStats_.maxLatencyMs) {
+    queueStats_.maxLatencyMs = latencyMs;
+  }
+  LOG_D("[AC] %s の要求を送信（受け付けから %lu ms）", priorityToKey((ACPriority)top), (unsigned long)latencyMs);
+}
+
+/**
+ * 送信待ちのコマンドがすべて送信された後のモード
+ */
+ACMode AirConditionerController::getTargetMode() const {
+  for (int i = PRIORITY_COUNT - 1; i >= 0; i--) {
+    if (pending_[i].pending) {
+      return pending_[i].mode;
+    }
+  }
+  return currentMode_;
+}
+
+/**
+ * 送信待ちのコマンド数を数え直す
+ */
+void AirConditionerController::updateDepth() {
+  uint8_t depth = 0;
+  for (const PendingCommand& command : pending_) {
+    if (command.pending) {
+      depth++;
+    }
+  }
+  queueStats_.depth = depth;
+  if (depth > queueStats_.maxDepth) {
+    queueStats_.maxDepth = depth;
+  }
+}
+
+/**
+ * エアコンの動作モードの信号を送信する
+ * @param mode 送信するモード
+ * @return false: 無効なモード（送信しない）
+ */
+bool AirConditionerController::transmit(ACMode mode) {
   // switch文：modeの値に応じて異なる処理を実行
   switch (mode) {
     case ACMode::OFF:                // エアコン停止の場合
@@ -84,19 +195,96 @@ void AirConditionerController::setMode(ACMode mode) {
       sendDehumidMinus1_5();
       break;
     default:  // 上記以外（想定外のモード）の場合
-      Serial.println("[AC] 無効なモード");
-      return;
+      LOG_W("[AC] 無効なモード");
+      return false;
   }
 
   // モード変更が成功したら、現在のモードを更新
   currentMode_ = mode;
+  return true;
+}
+
+/**
+ * 再起動前に送信したモードを復元
+ * エアコン本体は再起動前のモードのままなので、信号は送信しません。
+ * 同じモードへの request() が省かれ、起動直後の制御で同じ信号を送り直さずに済みます。
+ */
+void AirConditionerController::restoreMode(ACMode mode) {
+  switch (mode) {
+    case ACMode::OFF:
+    case ACMode::COOLING_20:
+    case ACMode::AUTO_PLUS_1:
+    case ACMode::DEHUMID_MINUS_1_5:
+      currentMode_ = mode;
+      break;
+    default:  // NONE・想定外の値は復元しない
+      break;
+  }
+}
+
+/**
+ * モードと識別名の対応表
+ * 識別名は外部（MQTTのコマンド・メトリクスのラベル）に公開されるため、変更しないでください
+ */
+namespace {
+  const struct {
+    ACMode mode;
+    const char* key;
+  } MODE_KEYS[] = {
+    { ACMode::NONE,              "unknown" },
+    { ACMode::OFF,               "off" },
+    { ACMode::COOLING_20,        "cool_20" },
+    { ACMode::AUTO_PLUS_1,       "auto_plus_1" },
+    { ACMode::DEHUMID_MINUS_1_5, "dry_minus_1_5" },
+  };
+}
+
+/**
+ * モードの識別名を取得
+ */
+const char* AirConditionerController::modeToKey(ACMode mode) {
+  for (const auto& entry : MODE_KEYS) {
+    if (entry.mode == mode) {
+      return entry.key;
+    }
+  }
+  return "unknown";
+}
+
+/**
+ * 識別名からモードを取得
+ * @return 対応するモード（不明な名前の場合はACMode::NONE）
+ */
+ACMode AirConditionerController::modeFromKey(const char* key) {
+  if (key == nullptr) {
+    return ACMode::NONE;
+  }
+  for (const auto& entry : MODE_KEYS) {
+    if (strcmp(entry.key, key) == 0) {
+      return entry.mode;
+    }
+  }
+  return ACMode::NONE;
+}
+
+/**
+ * 優先度の識別名を取得
+ */
+const char* AirConditionerController::priorityToKey(ACPriority priority) {
+  switch (priority) {
+    case ACPriority::POLICY:   return "policy";
+    case ACPriority::SCHEDULE: return "schedule";
+    case ACPriority::USER:     return "user";
+    case ACPriority::STOP:     return "stop";
+    default:                   return "unknown";
+  }
 }
 
 /**
  * 不快指数（Discomfort Index: DI）を計算
- * @param temperature 温度（摂氏）
- * @param humidity    湿度（%）
- * @return 不快指数（DI値）
+ * @param temperature 温度（0.01℃単位）
+ * @param humidity    湿度（0.01%単位）
+ * @return 不快指数（0.01単位、7500 = DI 75.00）
  *
  * 計算式: DI = 0.81T + 0.01H(0.99T - 14.3) + 46.3
  * DI値の目安:
@@ -109,27 +297,28 @@ void AirConditionerController::setMode(ACMode mode) {
  *   80〜85: 暑くて汗が出る
  *   85〜  : 暑くてたまらない
  */
-float AirConditionerController::calculateDiscomfortIndex(float temperature, float humidity) {
-  // fは「float型の数値」を表す接尾辞（これがないとdouble型になる）
-  float di = 0.81f * temperature + 0.01f * humidity * (0.99f * temperature - 14.3f) + 46.3f;
+int16_t AirConditionerController::calculateDiscomfortIndex(int16_t temperature, int16_t humidity) {
+  // 計算式はComfortIndex.hに共通化（天気予報の時間別DIと同じ式を使う、整数演算のみ）
+  int16_t di = Comfort::discomfortIndex(temperature, humidity);
   return di;  // 計算結果を呼び出し元に返す
 }
 
 /**
  * 温度と湿度から最適なエアコンモードを決定する
- * @param temperature 現在の温度（摂氏）
- * @param humidity    現在の湿度（%）
+ * @param temperature 現在の温度（0.01℃単位）
+ * @param humidity    現在の湿度（0.01%単位）
  * @return 最適なエアコンモード
  *
  * 不快指数（DI）を計算し、その値に応じて最適なモードを選択します。
  * 目標: DI 70〜75を維持（寒がり向けの設定）
  */
-ACMode AirConditionerController::determineOptimalMode(float temperature, float humidity) {
+ACMode AirConditionerController::determineOptimalMode(int16_t temperature, int16_t humidity) {
   // 不快指数（DI）を計算
-  float di = calculateDiscomfortIndex(temperature, humidity);
+  int16_t di = calculateDiscomfortIndex(temperature, humidity);
 
-  // 現在の状態をシリアルモニタに出力（%.1fは小数点以下1桁まで表示）
-  Serial.printf("[AC] 温度:%.1f℃, 湿度:%.1f%%, DI:%.1f\n", temperature, humidity, di);
+  // 現在の状態をシリアルモニタに出力（Fixed::Text は整数を小数点以下1桁の文字列にする）
+  LOG_D("[AC] 温度:%s℃, 湿度:%s%%, DI:%s", Fixed::Text(temperature, 1).c_str(),
+        Fixed::Text(humidity, 1).c_str(), Fixed::Text(di, 1).c_str());
 
   // DI値に基づいてモードを決定
   // 目標: DI 70～75を維持（寒がり向け設定）
@@ -137,29 +326,29 @@ ACMode AirConditionerController::determineOptimalMode(float temperature, float h
   // if-else if-else構文：上から順に条件を評価し、最初に真になった処理を実行
   if (di >= DIThreshold::COOLING_THRESHOLD) {
     // DI 77以上: 暑くて不快 → 冷房20度で強力に冷却
-    Serial.printf("[AC] DI %.1f (暑い) → 冷房20度\n", di);
+    LOG_D("[AC] DI %s (暑い) → 冷房20度", Fixed::Text(di, 1).c_str());
     return ACMode::COOLING_20;  // ここで関数終了、値を返す
   }
   else if (di > DIThreshold::TARGET_MAX) {
     // DI 75～77: やや暑い → 除湿で快適化
-    Serial.printf("[AC] DI %.1f (やや暑い) → 除湿-1.5\n", di);
+    LOG_D("[AC] DI %s (やや暑い) → 除湿-1.5", Fixed::Text(di, 1).c_str());
     return ACMode::DEHUMID_MINUS_1_5;
   }
   else if (di >= DIThreshold::TARGET_MIN && di <= DIThreshold::TARGET_MAX) {
     // DI 70～75: 目標範囲内 → 現状維持（自動モード）
     // &&は「かつ」を意味する論理演算子（両方の条件が真の時に真）
-    Serial.printf("[AC] DI %.1f (快適範囲) → 自動+1度\n", di);
+    LOG_D("[AC] DI %s (快適範囲) → 自動+1度", Fixed::Text(di, 1).c_str());
     return ACMode::AUTO_PLUS_1;
   }
   else if (di < DIThreshold::HEATING_THRESHOLD) {
     // DI 68未満: 肌寒い → 自動モードで暖房も可能に
-    Serial.printf("[AC] DI %.1f (肌寒い) → 自動+1度\n", di);
+    LOG_D("[AC] DI %s (肌寒い) → 自動+1度", Fixed::Text(di, 1).c_str());
     return ACMode::AUTO_PLUS_1;
   }
   else {
     // DI 68～70: わずかに低い → 自動モード
     // どの条件にも当てはまらなかった場合（デフォルト）
-    Serial.printf("[AC] DI %.1f (やや涼しい) → 自動+1度\n", di);
+    LOG_D("[AC] DI %s (やや涼しい) → 自動+1度", Fixed::Text(di, 1).c_str());
     return ACMode::AUTO_PLUS_1;
   }
 }
@@ -175,18 +364,16 @@ void AirConditionerController::handleIRReceive() {
 
   // irRecv_.decode()は信号を受信した時にtrueを返す
   if (irRecv_.decode(&results)) {
-    Serial.println("====================================");
-    Serial.print("[IR] 受信コード: ");
-    // 64ビット整数を16進数で表示（HEXは16進数を意味する）
-    serialPrintUint64(results.value, HEX);
-    Serial.println();
-    Serial.print("[IR] プロトコル: ");
-    Serial.println(typeToString(results.decode_type));  // 例：DAIKIN、NEC等
-    Serial.print("[IR] ビット数: ");
-    Serial.println(results.bits);  // 信号のビット長
+    stats_.irReceiveCount++;
+    // 64ビット整数を16進数で表示、プロトコル名（例：DAIKIN、NEC等）とビット長も表示
+    LOG_I("[IR] 受信コード: 0x%llX, プロトコル: %s, ビット数: %u",
+          (unsigned long long)results.value, typeToString(results.decode_type).c_str(), results.bits);
 
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
     // Raw形式でも出力（生の信号タイミングデータ）
     // これをコピペすれば同じ信号を再送信できる
+    // 数百個の値になるためログのリングバッファを通さず、積まれたログを出し切ってから直接出力する
+    Log::flush();
     Serial.print("uint16_t rawData[");
     Serial.print(results.rawlen - 1);
     Serial.println("] = {");
@@ -198,19 +385,31 @@ void AirConditionerController::handleIRReceive() {
       if (i % 10 == 0) Serial.print("\n  ");  // 10個ごとに改行（見やすくするため）
     }
     Serial.println("\n};");
-    Serial.println("====================================");
+#endif
+
+    if (receiveCallback_ != nullptr) {
+      receiveCallback_(results, receiveContext_);
+    }
 
     // 次の信号を受信できるようにする
     irRecv_.resume();
   }
 }
 
+/**
+ * 赤外線の受信時の通知先を設定
+ */
+void AirConditionerController::onIRReceive(IRReceiveCallback callback, void* context) {
+  receiveCallback_ = callback;
+  receiveContext_ = context;
+}
+
 /**
  * エアコンを停止（電源オフ）
  * 23時の自動停止機能などで使用
  */
 void AirConditionerController::sendOff() {
-  Serial.println("[AC] エアコン停止 送信開始");
+  LOG_D("[AC] エアコン停止 送信開始");
 
   // 受信を無効化（送信中の干渉を防ぐ）
   irRecv_.disableIRIn();
@@ -220,8 +419,9 @@ void AirConditionerController::sendOff() {
 
   // IR信号を実際に送信（ここで赤外線LEDが光る）
   daikinAC_.send();
+  stats_.irSendCount++;
 
-  Serial.println("[AC] エアコン停止 送信完了");
+  LOG_I("[AC] エアコン停止 送信完了");
 
   // 受信を再度有効化
   delay(200);  // 送信完了を待つ
@@ -233,7 +433,7 @@ void AirConditionerController::sendOff() {
  * 暑い時（DI 77以上）に使用する強力な冷房モード
  */
 void AirConditionerController::sendCooling20() {
-  Serial.println("[AC] 冷房20度 送信開始");
+  LOG_D("[AC] 冷房20度 送信開始");
 
   // 受信を無効化（送信中の干渉を防ぐ）
   // 送信と受信を同時に行うと誤動作するため、送信中は受信を止める
@@ -249,8 +449,9 @@ void AirConditionerController::sendCooling20() {
 
   // IR信号を実際に送信（ここで赤外線LEDが光る）
   daikinAC_.send();
+  stats_.irSendCount++;
 
-  Serial.println("[AC] 冷房20度 送信完了");
+  LOG_I("[AC] 冷房20度 送信完了");
 
   // 受信を再度有効化（送信完了後、少し待ってから受信を再開）
   delay(200);  // 200ミリ秒待つ
@@ -263,7 +464,7 @@ void AirConditionerController::sendCooling20() {
  * 自動モードなので、冷房/暖房を自動で切り替えてくれる
  */
 void AirConditionerController::sendAutoPlus1() {
-  Serial.println("[AC] 自動+1度 送信開始");
+  LOG_D("[AC] 自動+1度 送信開始");
 
   // 受信を無効化（送信中の干渉防止）
   irRecv_.disableIRIn();
@@ -278,8 +479,9 @@ void AirConditionerController::sendAutoPlus1() {
 
   // IR信号送信
   daikinAC_.send();
+  stats_.irSendCount++;
 
-  Serial.println("[AC] 自動+1度 送信完了");
+  LOG_I("[AC] 自動+1度 送信完了");
 
   // 受信を再度有効化
   delay(200);  // 送信完了を待つ
@@ -292,7 +494,7 @@ void AirConditionerController::sendAutoPlus1() {
  * 湿度を下げることで体感温度を下げ、快適性を向上させる
  */
 void AirConditionerController::sendDehumidMinus1_5() {
-  Serial.println("[AC] 除湿-1.5 送信開始");
+  LOG_D("[AC] 除湿-1.5 送信開始");
 
   // 受信を無効化（送信中の干渉防止）
   irRecv_.disableIRIn();
@@ -307,8 +509,9 @@ void AirConditionerController::sendDehumidMinus1_5() {
 
   // IR信号送信
   daikinAC_.send();
+  stats_.irSendCount++;
 
-  Serial.println("[AC] 除湿-1.5 送信完了");
+  LOG_I("[AC] 除湿-1.5 送信完了");
 
   // 受信を再度有効化
   delay(200);  // 送信完了を待つ
@@ -0,0 +1,139 @@
+/**
+ * BootSequence.cpp
+ *
+ * 起動処理の段階管理クラスの実装
+ */
+
+#include "BootSequence.h"
+#include "Log.h"
+
+/**
+ * コンストラクタ
+ */
+BootSequence::BootSequence()
+  : stageCount_(0),
+    doneMask_(0),
+    finished_(false) {
+}
+
+/**
+ * ステージを追加
+ */
+int BootSequence::addStage(const char* name, StartFunc start, DoneFunc isDone,
+                           uint32_t dependsOn, unsigned long timeoutMs) {
+  if (stageCount_ >= MAX_STAGES) {
+    LOG_W("[Boot] ステージ登録数の上限: %s", name);
+    return -1;
+  }
+
+  Stage& stage = stages_[stageCount_];
+  stage.name = name;
+  stage.start = start;
+  stage.isDone = isDone;
+  stage.dependsOn = dependsOn;
+  stage.timeoutMs = timeoutMs;
+  stage.state = StageState::PENDING;
+  stage.late = false;
+  stage.startedAt = 0;
+  stage.finishedAt = 0;
+  finished_ = false;
+  return stageCount_++;
+}
+
+/**
+ * 実行可能なステージを進める
+ * 依存関係を満たしたステージは同じpoll()内で続けて開始されるため、
+ * 依存のないローカルハードウェアの初期化は最初のpoll()でまとめて完了します。
+ */
+void BootSequence::poll() {
+  if (finished_) {
+    return;
+  }
+
+  bool progressed = true;
+  while (progressed) {
+    progressed = false;
+
+    for (uint8_t i = 0; i < stageCount_; i++) {
+      Stage& stage = stages_[i];
+
+      if (stage.state == StageState::PENDING) {
+        if ((stage.dependsOn & doneMask_) != stage.dependsOn) {
+          continue;
+        }
+        stage.state = StageState::RUNNING;
+        stage.startedAt = millis();
+        if (stage.start != nullptr) {
+          stage.start();
+        }
+      }
+
+      if (stage.state == StageState::RUNNING) {
+        if (stage.isDone == nullptr || stage.isDone()) {
+          finish(i);
+          progressed = true;
+        } else if (!stage.late && stage.timeoutMs > 0 && millis() - stage.startedAt > stage.timeoutMs) {
+          // 期限超過は記録だけにして待ち続ける（依存するステージは完了した時点で開始する）
+          stage.late = true;
+          LOG_W("[Boot] %s 期限超過 (+%lu ms)、バックグラウンドで完了を待ちます", stage.name, millis());
+        }
+      }
+    }
+  }
+
+  if (doneMask_ == (stageCount_ >= 32 ? 0xFFFFFFFFu : (1u << stageCount_) - 1)) {
+    finished_ = true;
+    printReport();
+  }
+}
+
+/**
+ * ステージの状態を取得
+ */
+BootSequence::StageState BootSequence::getState(int stageId) const {
+  if (stageId < 0 || stageId >= stageCount_) {
+    return StageState::PENDING;
+  }
+  return stages_[stageId].state;
+}
+
+/**
+ * ステージが報告期限を過ぎたか
+ */
+bool BootSequence::isLate(int stageId) const {
+  if (stageId < 0 || stageId >= stageCount_) {
+    return false;
+  }
+  return stages_[stageId].late;
+}
+
+/**
+ * 全ステージの所要時間を表示
+ */
+void BootSequence::printReport() const {
+  LOG_I("[Boot] ---- 起動ステージ所要時間 ----");
+  for (uint8_t i = 0; i < stageCount_; i++) {
+    const Stage& stage = stages_[i];
+    if (stage.state != StageState::DONE) {
+      LOG_I("[Boot] %-8s 実行中", stage.name);
+    } else if (stage.late) {
+      LOG_W("[Boot] %-8s 開始 +%5lu ms, 所要 %5lu ms（期限 %lu ms 超過）", stage.name,
+            stage.startedAt, stage.finishedAt - stage.startedAt, stage.timeoutMs);
+    } else {
+      LOG_I("[Boot] %-8s 開始 +%5lu ms, 所要 %5lu ms", stage.name,
+            stage.startedAt, stage.finishedAt - stage.startedAt);
+    }
+  }
+}
+
+/**
+ * ステージを完了にする
+ */
+void BootSequence::finish(uint8_t id) {
+  Stage& stage = stages_[id];
+  stage.state = StageState::DONE;
+  stage.finishedAt = millis();
+  doneMask_ |= bit(id);
+  LOG_I("[Boot] %s 完了 (+%lu ms, 所要 %lu ms)", stage.name,
+        stage.finishedAt, stage.finishedAt - stage.startedAt);
+}
@@ -1,19 +1,23 @@
 #include "DisplayController.h"
+#include "Log.h"
 
-DisplayController::DisplayController(uint8_t width, uint8_t height, TwoWire* wire, int8_t resetPin, uint8_t address)
-  : display_(width, height, wire, resetPin), width_(width), height_(height) {
+template <class Panel>
+DisplayController<Panel>::DisplayController(TwoWire* wire)
+  : display_(Panel::WIDTH, Panel::HEIGHT, wire, Panel::RESET_PIN) {
 }
 
-bool DisplayController::begin() {
-  if (!display_.begin(SSD1306_SWITCHCAPVCC, 0x3C)) {
-    Serial.println("[Display] 初期化失敗");
+template <class Panel>
+bool DisplayController<Panel>::begin() {
+  if (!display_.begin(SSD1306_SWITCHCAPVCC, Panel::ADDRESS)) {
+    LOG_W("[Display] 初期化失敗");
     return false;
   }
-  Serial.println("[Display] ディスプレイ初期化完了");
+  LOG_I("[Display] ディスプレイ初期化完了");
   return true;
 }
 
-void DisplayController::showStartupScreen() {
+template <class Panel>
+void DisplayController<Panel>::showStartupScreen() {
   display_.clearDisplay();
 
   // シンプルなテキストベースのスプラッシュ画面
@@ -21,24 +25,34 @@ void DisplayController::showStartupScreen() {
   display_.setTextColor(SSD1306_WHITE);
 
   // タイトル
-  display_.setCursor(25, 10);
+  display_.setCursor(25, Panel::HEIGHT < 64 ? 0 : 10);
   display_.println("ERNEST");
 
   // サブタイトル
   display_.setTextSize(1);
-  display_.setCursor(10, 35);
-  display_.println("Air Conditioner");
-  display_.setCursor(30, 48);
-  display_.println("Controller");
+  if (Panel::HEIGHT < 64) {
+    display_.setCursor(4, 22);
+    display_.println("AirConditioner Ctrl");
+  } else {
+    display_.setCursor(10, 35);
+    display_.println("Air Conditioner");
+    display_.setCursor(30, 48);
+    display_.println("Controller");
+  }
 
   display_.display();
 }
 
-void DisplayController::showSensorData(const SensorData& data, const String datetime) {
+template <class Panel>
+void DisplayController<Panel>::showSensorData(const SensorData& data, const String datetime) {
   if (!data.isValid) {
     showError("Sensor Error");
     return;
   }
+  if (Panel::HEIGHT < 64) {
+    showCompact(data, datetime, nullptr);
+    return;
+  }
 
   display_.clearDisplay();
 
@@ -50,7 +64,7 @@ void DisplayController::showSensorData(const SensorData& data, const String date
 
   display_.setTextSize(2);
   display_.setCursor(5, 12);
-  display_.print(data.temperature, 1);
+  printFixed(data.temperature, 1);
   display_.setTextSize(1);
   display_.setCursor(62, 18);
   display_.println("C");
@@ -62,13 +76,13 @@ void DisplayController::showSensorData(const SensorData& data, const String date
 
   display_.setTextSize(2);
   display_.setCursor(75, 12);
-  display_.print(data.humidity, 0);
+  printFixed(data.humidity, 0);
   display_.setTextSize(1);
   display_.setCursor(110, 18);
   display_.println("%");
 
   // 区切り線
-  display_.drawLine(0, 30, width_, 30, SSD1306_WHITE);
+  display_.drawLine(0, 30, Panel::WIDTH, 30, SSD1306_WHITE);
 
   // 現在日付
   display_.setTextSize(1);
@@ -79,29 +93,26 @@ void DisplayController::showSensorData(const SensorData& data, const String date
   display_.setTextSize(1);
   display_.setCursor(0, 46);
   display_.print("DI: ");
-  display_.print(data.discomfortIndex, 1);
+  printFixed(data.discomfortIndex, 1);
 
   // DI値のステータス表示
   display_.setCursor(50, 46);
-  if (data.discomfortIndex >= 77.0f) {
-    display_.print("(Hot)");
-  } else if (data.discomfortIndex >= 75.0f) {
-    display_.print("(Warm)");
-  } else if (data.discomfortIndex >= 70.0f) {
-    display_.print("(Comfy)");
-  } else {
-    display_.print("(Cool)");
-  }
+  display_.print(comfortLabel(data.discomfortIndex));
 
   // 表示実行
   display_.display();
 }
 
-void DisplayController::showSensorDataWithWeather(const SensorData& data, const String datetime, const WeatherData& weather) {
+template <class Panel>
+void DisplayController<Panel>::showSensorDataWithWeather(const SensorData& data, const String datetime, const WeatherData& weather) {
   if (!data.isValid) {
     showError("Sensor Error");
     return;
   }
+  if (Panel::HEIGHT < 64) {
+    showCompact(data, datetime, &weather);
+    return;
+  }
 
   display_.clearDisplay();
 
@@ -112,7 +123,7 @@ void DisplayController::showSensorDataWithWeather(const SensorData& data, const
   display_.print(datetime);
 
   // 区切り線
-  display_.drawLine(0, 10, width_, 10, SSD1306_WHITE);
+  display_.drawLine(0, 10, Panel::WIDTH, 10, SSD1306_WHITE);
 
   // 温度表示（やや小さめに調整）
   display_.setTextSize(1);
@@ -121,7 +132,7 @@ void DisplayController::showSensorDataWithWeather(const SensorData& data, const
 
   display_.setTextSize(2);
   display_.setCursor(5, 24);
-  display_.print(data.temperature, 1);
+  printFixed(data.temperature, 1);
   display_.setTextSize(1);
   display_.setCursor(55, 28);
   display_.println("C");
@@ -133,7 +144,7 @@ void DisplayController::showSensorDataWithWeather(const SensorData& data, const
 
   display_.setTextSize(2);
   display_.setCursor(70, 24);
-  display_.print(data.humidity, 0);
+  printFixed(data.humidity, 0);
   display_.setTextSize(1);
   display_.setCursor(105, 28);
   display_.println("%");
@@ -142,19 +153,11 @@ void DisplayController::showSensorDataWithWeather(const SensorData& data, const
   display_.setTextSize(1);
   display_.setCursor(0, 44);
   display_.print("DI:");
-  display_.print(data.discomfortIndex, 1);
+  printFixed(data.discomfortIndex, 1);
 
   // DI値のステータス表示
   display_.setCursor(48, 44);
-  if (data.discomfortIndex >= 77.0f) {
-    display_.print("(Hot)");
-  } else if (data.discomfortIndex >= 75.0f) {
-    display_.print("(Warm)");
-  } else if (data.discomfortIndex >= 70.0f) {
-    display_.print("(Comfy)");
-  } else {
-    display_.print("(Cool)");
-  }
+  display_.print(comfortLabel(data.discomfortIndex));
 
   // 天気予報表示（画面最下部に配置を最適化）
   display_.setTextSize(1);
@@ -178,10 +181,81 @@ void DisplayController::showSensorDataWithWeather(const SensorData& data, const
   display_.display();
 }
 
-void DisplayController::showError(const char* message) {
+/**
+ * 高さ32ドットのパネル用の表示
+ *   1行目（大きめ）: 温度・湿度
+ *   3行目: DIと状態
+ *   4行目: 天気予報（未取得の場合は日時）
+ */
+template <class Panel>
+void DisplayController<Panel>::showCompact(const SensorData& data, const String datetime,
+                                           const WeatherData* weather) {
+  display_.clearDisplay();
+  display_.setTextColor(SSD1306_WHITE);
+
+  display_.setTextSize(2);
+  display_.setCursor(0, 0);
+  printFixed(data.temperature, 1);
+  display_.print("C ");
+  printFixed(data.humidity, 0);
+  display_.print("%");
+
+  display_.setTextSize(1);
+  display_.setCursor(0, 16);
+  display_.print("DI:");
+  printFixed(data.discomfortIndex, 1);
+  display_.print(" ");
+  display_.print(comfortLabel(data.discomfortIndex));
+
+  display_.setCursor(0, 24);
+  if (weather != nullptr && weather->isValid) {
+    display_.print(weather->weatherString);
+    display_.print(" ");
+    display_.print(weather->tempMin, 0);
+    display_.print("/");
+    display_.print(weather->tempMax, 0);
+    display_.print("C");
+  } else {
+    display_.print(datetime);
+  }
+
+  display_.display();
+}
+
+/**
+ * DIの状態の表示（閾値は DisplayController の表示用で、モードの判定とは別）
+ */
+template <class Panel>
+const char* DisplayController<Panel>::comfortLabel(int16_t discomfortIndex) {
+  if (discomfortIndex >= 7700) {
+    return "(Hot)";
+  } else if (discomfortIndex >= 7500) {
+    return "(Warm)";
+  } else if (discomfortIndex >= 7000) {
+    return "(Comfy)";
+  }
+  return "(Cool)";
+}
+
+/**
+ * 1/100単位の整数を小数点以下 decimals 桁で表示（整数演算のみで文字列にする）
+ */
+template <class Panel>
+void DisplayController<Panel>::printFixed(int16_t centi, uint8_t decimals) {
+  char buf[8];
+  Fixed::format(buf, sizeof(buf), centi, decimals);
+  display_.print(buf);
+}
+
+template <class Panel>
+void DisplayController<Panel>::showError(const char* message) {
   display_.clearDisplay();
   display_.setTextSize(2);
-  display_.setCursor(20, 25);
+  display_.setCursor(20, Panel::HEIGHT < 64 ? 8 : 25);
   display_.println(message);
   display_.display();
 }
+
+// BoardConfig.h のパネルごとの実体化（使われないパネルの分はリンク時に除去される）
+template class DisplayController<Board::Ssd1306_128x64>;
+template class DisplayController<Board::Ssd1306_128x32>;
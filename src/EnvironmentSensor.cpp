@@ -1,29 +1,108 @@
 #include "EnvironmentSensor.h"
+#include "ComfortIndex.h"
+#include "Log.h"
+
+AdaptiveSampler::AdaptiveSampler(unsigned long minMs, unsigned long maxMs, unsigned long activeMaxMs)
+  : minMs_(0), maxMs_(0), activeMaxMs_(0), ceilingMs_(0), intervalMs_(0), lastSampleMs_(0),
+    transitionMs_(0), holding_(false), hasLast_(false), lastTemperature_(0), lastDiscomfortIndex_(0),
+    stats_() {
+  setLimits(minMs, maxMs, activeMaxMs);
+}
+
+void AdaptiveSampler::setLimits(unsigned long minMs, unsigned long maxMs, unsigned long activeMaxMs) {
+  minMs_ = minMs;
+  maxMs_ = maxMs > minMs ? maxMs : minMs;
+  activeMaxMs_ = activeMaxMs > minMs ? activeMaxMs : minMs;
+  ceilingMs_ = maxMs_;
+  intervalMs_ = minMs_;
+}
+
+void AdaptiveSampler::onSample(unsigned long nowMs, const SensorData& data) {
+  // 実際の間隔の指数移動平均（1/8ずつ追従）
+  unsigned long actualMs = nowMs - lastSampleMs_;
+  if (stats_.samples == 0) {
+    stats_.averageIntervalMs = intervalMs_;
+  } else {
+    long average = (long)stats_.averageIntervalMs;
+    stats_.averageIntervalMs = average + ((long)actualMs - average) / 8;
+  }
+  lastSampleMs_ = nowMs;
+  stats_.samples++;
+
+  if (!data.isValid) {
+    intervalMs_ = minMs_;
+    return;
+  }
+
+  if (holding_ && nowMs - transitionMs_ >= HOLD_MS) {
+    holding_ = false;
+  }
+
+  int16_t di = Comfort::discomfortIndex(data.temperature, data.humidity);
+  if (hasLast_) {
+    int temperatureChange = abs(data.temperature - lastTemperature_);
+    int diChange = abs(di - lastDiscomfortIndex_);
+    if (temperatureChange >= FAST_TEMPERATURE || diChange >= FAST_DI) {
+      if (intervalMs_ > minMs_) {
+        intervalMs_ = intervalMs_ / 2 > minMs_ ? intervalMs_ / 2 : minMs_;
+        stats_.shortened++;
+        LOG_D("[Sensor] 変化が速いため読み取り間隔を短縮: %lu ms", intervalMs_);
+      }
+    } else if (!holding_ && temperatureChange <= STEADY_TEMPERATURE && diChange <= STEADY_DI) {
+      if (intervalMs_ < ceilingMs_) {
+        intervalMs_ = intervalMs_ * 3 / 2 < ceilingMs_ ? intervalMs_ * 3 / 2 : ceilingMs_;
+        stats_.lengthened++;
+        LOG_D("[Sensor] 安定しているため読み取り間隔を延長: %lu ms", intervalMs_);
+      }
+    }
+  }
+  hasLast_ = true;
+  lastTemperature_ = data.temperature;
+  lastDiscomfortIndex_ = di;
+}
+
+void AdaptiveSampler::notifyTransition(unsigned long nowMs, bool running) {
+  ceilingMs_ = running ? activeMaxMs_ : maxMs_;
+  transitionMs_ = nowMs;
+  holding_ = true;
+  stats_.transitions++;
+  if (intervalMs_ > minMs_) {
+    intervalMs_ = minMs_;
+    LOG_D("[Sensor] モード変更のため読み取り間隔を最短に: %lu ms", intervalMs_);
+  }
+}
 
 EnvironmentSensor::EnvironmentSensor(uint8_t pin, uint8_t type, float tempOffset, float humOffset)
-  : dht_(pin, type), temperatureOffset_(tempOffset), humidityOffset_(humOffset) {
+  : dht_(pin, type), temperatureOffset_(Fixed::fromFloat(tempOffset)),
+    humidityOffset_(Fixed::fromFloat(humOffset)), stats_(), sampler_(2000, 2000, 2000) {
 }
 
 void EnvironmentSensor::begin() {
   dht_.begin();
-  Serial.println("[Sensor] 環境センサー初期化完了");
+  LOG_I("[Sensor] 環境センサー初期化完了");
 }
 
 SensorData EnvironmentSensor::read() {
   float humidity = dht_.readHumidity();
   float temperature = dht_.readTemperature();
+  stats_.readCount++;
 
   // 読み取りエラーチェック
   if (isnan(humidity) || isnan(temperature)) {
-    Serial.println("[Sensor] 読み取りエラー");
-    return SensorData(0.0f, 0.0f, false);
+    stats_.readErrors++;
+    LOG_E("[Sensor] 読み取りエラー");
+    sampler_.onSample(millis(), SensorData(0, 0, false));
+    return SensorData(0, 0, false);
   }
 
-  // オフセット適用
-  temperature += temperatureOffset_;
-  humidity += humidityOffset_;
+  // DHTライブラリの実数値はここで固定小数点に変換し、以降は整数で扱う
+  int16_t centiTemperature = Fixed::fromFloat(temperature) + temperatureOffset_;
+  int16_t centiHumidity = Fixed::fromFloat(humidity) + humidityOffset_;
 
-  Serial.printf("[Sensor] 温度: %.1f°C, 湿度: %.1f%%\n", temperature, humidity);
+  LOG_D("[Sensor] 温度: %s°C, 湿度: %s%%",
+        Fixed::Text(centiTemperature, 1).c_str(), Fixed::Text(centiHumidity, 1).c_str());
 
-  return SensorData(temperature, humidity, true);
+  lastData_ = SensorData(centiTemperature, centiHumidity, true);
+  sampler_.onSample(millis(), lastData_);
+  return lastData_;
 }
@@ -0,0 +1,348 @@
+/**
+ * HttpSession.cpp
+ *
+ * HTTP接続共有クラスの実装
+ */
+
+#include "HttpSession.h"
+#include "Log.h"
+
+namespace {
+
+/**
+ * レスポンスボディ読み取り用ストリーム
+ * Content-Length / chunked転送のどちらでもボディの終端を正しく判定し、
+ * 読み取ったバイト数を数えます。終端まで読み切ることで接続を再利用できます。
+ */
+class BodyStream : public Stream {
+public:
+  BodyStream(Stream& inner, bool chunked, int contentLength)
+    : inner_(inner),
+      chunked_(chunked),
+      remaining_(contentLength),
+      finished_(!chunked && contentLength == 0),
+      bytesRead_(0) {
+    if (chunked_) {
+      remaining_ = 0;  // 最初のチャンクヘッダーから読む
+    }
+  }
+
+  int available() override {
+    if (finished_) {
+      return 0;
+    }
+    int avail = inner_.available();
+    if (remaining_ > 0 && avail > remaining_) {
+      avail = remaining_;
+    }
+    return avail;
+  }
+
+  int read() override {
+    if (!prepare()) {
+      return -1;
+    }
+    int c = timedRead();
+    if (c < 0) {
+      finished_ = true;  // タイムアウトまたは切断
+      return -1;
+    }
+    bytesRead_++;
+    if (remaining_ > 0) {
+      remaining_--;
+      if (!chunked_ && remaining_ == 0) {
+        finished_ = true;
+      }
+    }
+    return c;
+  }
+
+  int peek() override {
+    if (!prepare()) {
+      return -1;
+    }
+    return inner_.peek();
+  }
+
+  size_t write(uint8_t) override { return 0; }
+
+  // 残りのボディを読み捨てる（次のリクエストに備える）
+  void drain() {
+    while (read() >= 0) {
+    }
+  }
+
+  uint32_t bytesRead() const { return bytesRead_; }
+
+private:
+  Stream& inner_;
+  bool chunked_;
+  int remaining_;     // 現在のチャンク（またはボディ）の残りバイト数、-1は長さ不明
+  bool finished_;
+  uint32_t bytesRead_;
+
+  int timedRead() {
+    uint8_t c;
+    return inner_.readBytes(&c, 1) == 1 ? c : -1;
+  }
+
+  // 次に読むべきデータバイトの直前まで進める
+  bool prepare() {
+    if (finished_) {
+      return false;
+    }
+    if (!chunked_ || remaining_ > 0) {
+      return true;
+    }
+    return readChunkHeader();
+  }
+
+  // チャンクヘッダー（16進サイズ行）を読む。前のチャンク末尾のCRLFも読み飛ばす
+  bool readChunkHeader() {
+    char line[20];
+    size_t length = 0;
+    while (length == 0) {
+      if (!readLine(line, sizeof(line), length)) {
+        finished_ = true;
+        return false;
+      }
+    }
+
+    long size = strtol(line, nullptr, 16);  // ";" 以降のチャンク拡張は無視される
+    if (size <= 0) {
+      // 最終チャンク: トレーラー（空行まで）を読み飛ばして終了
+      while (readLine(line, sizeof(line), length) && length > 0) {
+      }
+      finished_ = true;
+      return false;
+    }
+    remaining_ = (int)size;
+    return true;
+  }
+
+  // CRLFまでの1行を読む（バッファに入りきらない部分は切り捨て）
+  bool readLine(char* buffer, size_t size, size_t& length) {
+    length = 0;
+    for (;;) {
+      int c = timedRead();
+      if (c < 0) {
+        return false;
+      }
+      if (c == '\n') {
+        break;
+      }
+      if (c != '\r' && length + 1 < size) {
+        buffer[length++] = (char)c;
+      }
+    }
+    buffer[length] = '\0';
+    return true;
+  }
+};
+
+}  // namespace
+
+/**
+ * コンストラクタ
+ */
+HttpSession::HttpSession(const char* host, uint16_t port, bool secure)
+  : host_(host),
+    port_(port),
+    secure_(secure),
+    rootCA_(nullptr),
+    secureClient_(nullptr),
+    client_(&plainClient_),
+    dnsResolvedAt_(0),
+    dnsCached_(false),
+    stats_() {
+  // TLSクライアントは内部でmbedTLSのコンテキストを確保するため、必要な場合のみ生成する
+  if (secure_) {
+    secureClient_ = new WiFiClientSecure();
+    client_ = secureClient_;
+  }
+}
+
+HttpSession::~HttpSession() {
+  close();
+  delete secureClient_;
+}
+
+/**
+ * GETリクエストを送信
+ */
+int HttpSession::get(const char* path, BodyHandler handler, void* context) {
+  Request request = {"GET", path, nullptr, nullptr, 0, handler, context, 0, 0};
+  execute(&request, 1);
+  return request.status;
+}
+
+/**
+ * POSTリクエストを送信
+ */
+int HttpSession::post(const char* path, const char* contentType, const uint8_t* body, size_t length,
+                      BodyHandler handler, void* context) {
+  Request request = {"POST", path, contentType, body, length, handler, context, 0, 0};
+  execute(&request, 1);
+  return request.status;
+}
+
+/**
+ * 複数のリクエストを1回の接続でまとめて実行
+ */
+size_t HttpSession::execute(Request* requests, size_t count) {
+  size_t succeeded = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (perform(requests[i])) {
+      succeeded++;
+    }
+  }
+  return succeeded;
+}
+
+/**
+ * 接続を閉じる
+ */
+void HttpSession::close() {
+  http_.end();
+  client_->stop();
+}
+
+/**
+ * 1件のリクエストを実行
+ * 再利用した接続がサーバー側で閉じられていた場合は、新しい接続で1回だけ再送します。
+ */
+bool HttpSession::perform(Request& request) {
+  stats_.requests++;
+  request.status = HTTPC_ERROR_CONNECTION_REFUSED;
+  request.bytesReceived = 0;
+
+  for (int attempt = 0; attempt < 2; attempt++) {
+    bool reused = false;
+    if (!ensureConnected(reused)) {
+      break;
+    }
+
+    http_.setReuse(true);
+    http_.setTimeout(TIMEOUT_MS);
+    http_.begin(*client_, host_, port_, request.path, secure_);
+    const char* headerKeys[] = {"Transfer-Encoding"};
+    http_.collectHeaders(headerKeys, 1);
+
+    int status;
+    if (request.body != nullptr) {
+      if (request.contentType != nullptr) {
+        http_.addHeader("Content-Type", request.contentType);
+      }
+      status = http_.sendRequest(request.method, const_cast<uint8_t*>(request.body),
+                                 request.bodyLength);
+    } else {
+      status = http_.sendRequest(request.method);
+    }
+
+    if (status < 0 && reused && attempt == 0) {
+      // keep-alive接続が切れていた: 新しい接続でやり直す
+      http_.end();
+      client_->stop();
+      continue;
+    }
+
+    request.status = status;
+    if (status <= 0) {
+      http_.end();
+      break;
+    }
+
+    if (request.body != nullptr) {
+      stats_.bytesSent += request.bodyLength;
+    }
+
+    bool chunked = http_.header("Transfer-Encoding").equalsIgnoreCase("chunked");
+    BodyStream body(*client_, chunked, http_.getSize());
+    bool handled = (request.handler == nullptr) || request.handler(status, body, request.context);
+    body.drain();  // 読み残しがあると次のレスポンスと混ざるため必ず読み切る
+
+    request.bytesReceived = body.bytesRead();
+    stats_.bytesReceived += body.bytesRead();
+    http_.end();  // setReuse(true) のため、サーバーが許せば接続は維持される
+
+    bool ok = handled && status >= 200 && status < 300;
+    if (!ok) {
+      stats_.errors++;
+    }
+    return ok;
+  }
+
+  stats_.errors++;
+  return false;
+}
+
+/**
+ * 接続を確立（既に接続中なら再利用）
+ */
+bool HttpSession::ensureConnected(bool& reused) {
+  if (client_->connected()) {
+    reused = true;
+    stats_.reusedConnections++;
+    return true;
+  }
+  reused = false;
+
+  if (WiFi.status() != WL_CONNECTED) {
+    return false;
+  }
+
+  unsigned long start = millis();
+  int result;
+  if (secure_) {
+    // TLSはSNIと証明書検証にホスト名が必要なため、名前で接続する
+    if (rootCA_ == nullptr) {
+      LOG_W("[HTTP] %s: ルートCA証明書が未設定です", host_);
+      return false;
+    }
+    secureClient_->setCACert(rootCA_);
+    result = secureClient_->connect(host_, port_);
+  } else {
+    IPAddress ip;
+    if (!resolve(ip)) {
+      return false;
+    }
+    result = plainClient_.connect(ip, port_);
+    if (!result) {
+      dnsCached_ = false;  // アドレスが変わった可能性があるため次回は再解決
+    }
+  }
+
+  if (!result) {
+    LOG_W("[HTTP] %s:%u への接続失敗", host_, port_);
+    return false;
+  }
+
+  client_->setNoDelay(true);
+  stats_.connects++;
+  stats_.lastConnectMs = millis() - start;
+  stats_.totalConnectMs += stats_.lastConnectMs;
+  return true;
+}
+
+/**
+ * ホスト名を解決（キャッシュが有効ならそれを使う）
+ */
+bool HttpSession::resolve(IPAddress& ip) {
+  if (dnsCached_ && millis() - dnsResolvedAt_ < DNS_TTL_MS) {
+    stats_.dnsCacheHits++;
+    ip = cachedIp_;
+    return true;
+  }
+
+  stats_.dnsLookups++;
+  if (!WiFi.hostByName(host_, ip)) {
+    LOG_W("[HTTP] DNS解決失敗: %s", host_);
+    dnsCached_ = false;
+    return false;
+  }
+
+  cachedIp_ = ip;
+  dnsResolvedAt_ = millis();
+  dnsCached_ = true;
+  return true;
+}
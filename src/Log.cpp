@@ -0,0 +1,471 @@
+/**
+ * Log.cpp
+ *
+ * ログ出力の実装
+ *
+ * リングバッファの構造:
+ * - 1件 = ヘッダー(4) + 時刻(4) + 書式文字列のアドレス + 引数、次の件は4バイト境界から始める
+ * - ヘッダーは 長さ(bit0-15、パディングを含まない) | レベル(bit16-23) | 切り詰めフラグ(bit24)、
+ *   0は「書き込み中」
+ * - 書き込み側は reservePos をCASで進めて領域を確保し、本体を書いてから最後にヘッダーを書く
+ *   （複数タスクから同時に書き込んでもロック不要）
+ * - 出力タスクはヘッダーが書かれた件から順に取り出し、その件の領域（パディングを含む）をすべて0に
+ *   戻してから readPos を進める。リングが一周した後、次の件のヘッダー位置が前の件の本体の途中に
+ *   重なっても、書き込み中の件のヘッダーが必ず0に見えるようにするため
+ */
+
+#include "Log.h"
+#include <atomic>
+
+namespace {
+  constexpr uint32_t RING_SIZE = 4096;          // 2のべき乗（位置の折り返しを剰余で扱うため）
+  constexpr uint32_t HEADER_SIZE = 4;
+  constexpr uint32_t TRUNCATED_FLAG = 1u << 24;
+  constexpr uint32_t MIN_RECORD_SIZE = HEADER_SIZE + sizeof(uint32_t) + sizeof(const char*);  // ヘッダー + 時刻 + 書式
+  constexpr unsigned long DRAIN_INTERVAL_MS = 10;
+  constexpr unsigned long FLUSH_TIMEOUT_MS = 1000;
+  constexpr size_t LINE_SIZE = 256;
+
+  // 引数の型タグ
+  constexpr uint8_t ARG_INT32 = 'i';
+  constexpr uint8_t ARG_INT64 = 'I';
+  constexpr uint8_t ARG_FLOAT = 'f';
+  constexpr uint8_t ARG_STRING = 's';
+  constexpr uint8_t ARG_POINTER = 'p';
+
+  alignas(4) uint8_t ring[RING_SIZE];
+  std::atomic<uint32_t> reservePos(0);  // 書き込み側が確保した位置（単調増加、2^32で折り返し）
+  std::atomic<uint32_t> readPos(0);     // 出力タスクが読み終えた位置
+  std::atomic<uint32_t> writtenCount(0);
+  std::atomic<uint32_t> droppedCount(0);
+  std::atomic<uint32_t> truncatedCount(0);
+  std::atomic<uint32_t> highWater(0);
+  TaskHandle_t drainTaskHandle = nullptr;
+
+  void copyToRing(uint32_t pos, const uint8_t* src, size_t len) {
+    uint32_t offset = pos % RING_SIZE;
+    size_t first = RING_SIZE - offset;
+    if (first > len) {
+      first = len;
+    }
+    memcpy(ring + offset, src, first);
+    memcpy(ring, src + first, len - first);
+  }
+
+  void copyFromRing(uint32_t pos, uint8_t* dst, size_t len) {
+    uint32_t offset = pos % RING_SIZE;
+    size_t first = RING_SIZE - offset;
+    if (first > len) {
+      first = len;
+    }
+    memcpy(dst, ring + offset, first);
+    memcpy(dst + first, ring, len - first);
+  }
+
+  uint32_t paddedLength(uint32_t len) {
+    return (len + 3) & ~3u;
+  }
+
+  uint32_t* headerAt(uint32_t pos) {
+    return reinterpret_cast<uint32_t*>(ring + (pos % RING_SIZE));
+  }
+
+  void zeroRing(uint32_t pos, size_t len) {
+    uint32_t offset = pos % RING_SIZE;
+    size_t first = RING_SIZE - offset;
+    if (first > len) {
+      first = len;
+    }
+    memset(ring + offset, 0, first);
+    memset(ring, 0, len - first);
+  }
+
+  // 長さ・レベル・未使用ビットが正しいヘッダーか
+  bool isValidHeader(uint32_t header) {
+    uint32_t len = header & 0xFFFF;
+    uint32_t level = (header >> 16) & 0xFF;
+    return len >= MIN_RECORD_SIZE && len <= Log::Record::MAX_SIZE &&
+           level >= 1 && level <= 4 && (header & ~(TRUNCATED_FLAG | 0xFFFFFFu)) == 0;
+  }
+
+  /**
+   * 記録された引数を先頭から順に読み出す
+   */
+  class ArgReader {
+  public:
+    ArgReader(const uint8_t* data, const uint8_t* end) : p_(data), end_(end) {}
+
+    bool next(uint8_t& type, int64_t& i, double& d, const char*& s, size_t& slen) {
+      if (p_ >= end_) {
+        return false;
+      }
+      type = *p_++;
+      switch (type) {
+        case ARG_INT32: {
+          int32_t v;
+          if (!take(&v, sizeof(v))) return false;
+          i = v;
+          d = v;
+          return true;
+        }
+        case ARG_INT64:
+          if (!take(&i, sizeof(i))) return false;
+          d = (double)i;
+          return true;
+        case ARG_FLOAT: {
+          float v;
+          if (!take(&v, sizeof(v))) return false;
+          d = v;
+          i = (int64_t)v;
+          return true;
+        }
+        case ARG_STRING:
+          if (p_ >= end_) return false;
+          slen = *p_++;
+          if (p_ + slen > end_) return false;
+          s = reinterpret_cast<const char*>(p_);
+          p_ += slen;
+          return true;
+        case ARG_POINTER: {
+          const void* v;
+          if (!take(&v, sizeof(v))) return false;
+          i = (int64_t)(uintptr_t)v;
+          return true;
+        }
+        default:
+          return false;
+      }
+    }
+
+  private:
+    const uint8_t* p_;
+    const uint8_t* end_;
+
+    bool take(void* dst, size_t len) {
+      if (p_ + len > end_) {
+        return false;
+      }
+      memcpy(dst, p_, len);
+      p_ += len;
+      return true;
+    }
+  };
+
+  /**
+   * 1件のログを文字列に整形
+   * 書式指定子ごとに記録された引数を1つずつsnprintfに渡します（長さ修飾子は記録した型に合わせて付け直す）。
+   */
+  size_t formatRecord(const uint8_t* rec, size_t len, char* out, size_t outSize) {
+    static const char LEVEL_CHARS[] = "?EWID";
+
+    uint32_t header;
+    uint32_t timestamp;
+    const char* format;
+    memcpy(&header, rec, sizeof(header));
+    memcpy(&timestamp, rec + HEADER_SIZE, sizeof(timestamp));
+    memcpy(&format, rec + HEADER_SIZE + sizeof(timestamp), sizeof(format));
+    size_t argsOffset = HEADER_SIZE + sizeof(timestamp) + sizeof(format);
+
+    uint8_t level = (header >> 16) & 0xFF;
+    size_t limit = outSize - 1;  // 改行の分
+    int n = snprintf(out, limit, "%c (%lu) ", LEVEL_CHARS[level <= 4 ? level : 0],
+                     (unsigned long)timestamp);
+    size_t pos = (n > 0 && (size_t)n < limit) ? n : 0;
+
+    // snprintfの戻り値（切り詰め前の長さ）から、実際に書き込んだ分だけ進める
+    auto advance = [&](int written) {
+      if (written > 0) {
+        size_t avail = limit - pos;
+        pos += ((size_t)written < avail) ? (size_t)written : avail - 1;
+      }
+    };
+
+    ArgReader reader(rec + argsOffset, rec + len);
+    const char* f = format;
+
+    while (*f != '\0' && pos < limit) {
+      if (*f != '%') {
+        out[pos++] = *f++;
+        continue;
+      }
+      if (f[1] == '%') {
+        out[pos++] = '%';
+        f += 2;
+        continue;
+      }
+
+      // 書式指定子を取り出す（フラグ・幅・精度はそのまま、長さ修飾子は捨てる）
+      char spec[16];
+      size_t specLen = 0;
+      spec[specLen++] = *f++;
+      while (*f != '\0' && strchr("-+ #0123456789.", *f) != nullptr) {
+        if (specLen < 10) {
+          spec[specLen++] = *f;
+        }
+        f++;
+      }
+      while (*f != '\0' && strchr("hlLqjzt", *f) != nullptr) {
+        f++;
+      }
+      char conv = *f;
+      if (conv == '\0') {
+        break;
+      }
+      f++;
+
+      uint8_t type = 0;
+      int64_t i = 0;
+      double d = 0;
+      const char* s = nullptr;
+      size_t slen = 0;
+      if (!reader.next(type, i, d, s, slen)) {
+        n = snprintf(out + pos, limit - pos, "<?>");
+      } else {
+        switch (conv) {
+          case 'd': case 'i':
+            spec[specLen++] = 'l'; spec[specLen++] = 'l'; spec[specLen++] = conv; spec[specLen] = '\0';
+            n = snprintf(out + pos, limit - pos, spec, (long long)i);
+            break;
+          case 'u': case 'x': case 'X': case 'o':
+            spec[specLen++] = 'l'; spec[specLen++] = 'l'; spec[specLen++] = conv; spec[specLen] = '\0';
+            n = snprintf(out + pos, limit - pos, spec, (unsigned long long)i);
+            break;
+          case 'c':
+            spec[specLen++] = conv; spec[specLen] = '\0';
+            n = snprintf(out + pos, limit - pos, spec, (int)i);
+            break;
+          case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            spec[specLen++] = conv; spec[specLen] = '\0';
+            n = snprintf(out + pos, limit - pos, spec, d);
+            break;
+          case 's': {
+            // 記録した文字列は終端なしなので、一時バッファにコピーして終端を付ける
+            char str[Log::Record::MAX_STRING + 1];
+            if (type == ARG_STRING) {
+              memcpy(str, s, slen);
+              str[slen] = '\0';
+            } else {
+              str[0] = '\0';
+            }
+            spec[specLen++] = conv; spec[specLen] = '\0';
+            n = snprintf(out + pos, limit - pos, spec, str);
+            break;
+          }
+          case 'p':
+            n = snprintf(out + pos, limit - pos, "%p", (void*)(uintptr_t)i);
+            break;
+          default:
+            n = 0;
+            break;
+        }
+      }
+      advance(n);
+    }
+
+    if ((header & TRUNCATED_FLAG) && pos + 1 < limit) {
+      advance(snprintf(out + pos, limit - pos, " ..."));
+    }
+    out[pos++] = '\n';
+    return pos;
+  }
+
+  /**
+   * 積まれているログを取り出して出力
+   */
+  void drain() {
+    static uint32_t reportedDrops = 0;
+    static uint32_t corruptWords = 0;
+    static uint32_t reportedCorrupt = 0;
+    uint8_t rec[Log::Record::MAX_SIZE];
+    char line[LINE_SIZE];
+
+    for (;;) {
+      uint32_t pos = readPos.load(std::memory_order_relaxed);
+      if (pos == reservePos.load(std::memory_order_acquire)) {
+        break;
+      }
+      uint32_t header = __atomic_load_n(headerAt(pos), __ATOMIC_ACQUIRE);
+      if (header == 0) {
+        break;  // 書き込み中
+      }
+
+      if (!isValidHeader(header)) {
+        // 壊れたヘッダー（書式のアドレスも信用できないため出力しない）: 次の4バイト境界から探し直す
+        __atomic_store_n(headerAt(pos), 0u, __ATOMIC_RELAXED);
+        readPos.store(pos + HEADER_SIZE, std::memory_order_release);
+        corruptWords++;
+        continue;
+      }
+
+      uint32_t len = header & 0xFFFF;
+      copyFromRing(pos, rec, len);
+      zeroRing(pos, paddedLength(len));
+      readPos.store(pos + paddedLength(len), std::memory_order_release);
+
+      size_t n = formatRecord(rec, len, line, sizeof(line));
+      Serial.write(reinterpret_cast<const uint8_t*>(line), n);
+    }
+
+    uint32_t drops = droppedCount.load(std::memory_order_relaxed);
+    if (drops != reportedDrops) {
+      int n = snprintf(line, sizeof(line), "W (%lu) [Log] バッファ不足で %lu 件のログを破棄\n",
+                       millis(), (unsigned long)(drops - reportedDrops));
+      Serial.write(reinterpret_cast<const uint8_t*>(line), n);
+      reportedDrops = drops;
+    }
+    if (corruptWords != reportedCorrupt) {
+      int n = snprintf(line, sizeof(line), "W (%lu) [Log] 不正なヘッダーを検出し %lu ワードを読み飛ばし\n",
+                       millis(), (unsigned long)(corruptWords - reportedCorrupt));
+      Serial.write(reinterpret_cast<const uint8_t*>(line), n);
+      reportedCorrupt = corruptWords;
+    }
+  }
+
+  void drainTask(void*) {
+    for (;;) {
+      drain();
+      vTaskDelay(pdMS_TO_TICKS(DRAIN_INTERVAL_MS));
+    }
+  }
+}
+
+namespace Log {
+
+  void begin() {
+    if (drainTaskHandle != nullptr) {
+      return;
+    }
+    // loop() と別のコア（コア0）で優先度を低くして出力する
+    xTaskCreatePinnedToCore(drainTask, "log", 3072, nullptr, 1, &drainTaskHandle, 0);
+  }
+
+  void flush() {
+    if (drainTaskHandle == nullptr) {
+      drain();
+      return;
+    }
+    unsigned long start = millis();
+    while (readPos.load(std::memory_order_acquire) != reservePos.load(std::memory_order_acquire) &&
+           millis() - start < FLUSH_TIMEOUT_MS) {
+      delay(1);
+    }
+    Serial.flush();
+  }
+
+  Stats getStats() {
+    Stats stats;
+    stats.written = writtenCount.load(std::memory_order_relaxed);
+    stats.dropped = droppedCount.load(std::memory_order_relaxed);
+    stats.truncated = truncatedCount.load(std::memory_order_relaxed);
+    stats.highWater = highWater.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+  // ========================================
+  // Record
+  // ========================================
+
+  Record::Record(Level level, const char* format)
+    : level_(level),
+      length_(HEADER_SIZE),
+      truncated_(false) {
+    uint32_t timestamp = millis();
+    memcpy(data_ + length_, &timestamp, sizeof(timestamp));
+    length_ += sizeof(timestamp);
+    memcpy(data_ + length_, &format, sizeof(format));
+    length_ += sizeof(format);
+  }
+
+  bool Record::reserve(size_t bytes) {
+    if (length_ + bytes > MAX_SIZE) {
+      truncated_ = true;
+      return false;
+    }
+    return true;
+  }
+
+  void Record::addInt(int64_t v) {
+    if (v >= INT32_MIN && v <= INT32_MAX) {
+      if (!reserve(1 + sizeof(int32_t))) return;
+      int32_t v32 = (int32_t)v;
+      data_[length_++] = ARG_INT32;
+      memcpy(data_ + length_, &v32, sizeof(v32));
+      length_ += sizeof(v32);
+    } else {
+      if (!reserve(1 + sizeof(int64_t))) return;
+      data_[length_++] = ARG_INT64;
+      memcpy(data_ + length_, &v, sizeof(v));
+      length_ += sizeof(v);
+    }
+  }
+
+  void Record::addDouble(double v) {
+    if (!reserve(1 + sizeof(float))) return;
+    float f = (float)v;
+    data_[length_++] = ARG_FLOAT;
+    memcpy(data_ + length_, &f, sizeof(f));
+    length_ += sizeof(f);
+  }
+
+  void Record::add(const char* v) {
+    if (v == nullptr) {
+      v = "(null)";
+    }
+    size_t len = strlen(v);
+    if (len > MAX_STRING) {
+      len = MAX_STRING;
+      truncated_ = true;
+    }
+    if (length_ + 2 > MAX_SIZE) {
+      truncated_ = true;
+      return;
+    }
+    if (length_ + 2 + len > MAX_SIZE) {
+      len = MAX_SIZE - length_ - 2;
+      truncated_ = true;
+    }
+    data_[length_++] = ARG_STRING;
+    data_[length_++] = (uint8_t)len;
+    memcpy(data_ + length_, v, len);
+    length_ += len;
+  }
+
+  void Record::add(const void* v) {
+    if (!reserve(1 + sizeof(v))) return;
+    data_[length_++] = ARG_POINTER;
+    memcpy(data_ + length_, &v, sizeof(v));
+    length_ += sizeof(v);
+  }
+
+  /**
+   * リングバッファにコピー（空きがなければ捨てて件数を記録）
+   */
+  void Record::commit() {
+    uint32_t total = paddedLength(length_);
+    uint32_t header = (uint32_t)length_ | ((uint32_t)level_ << 16);
+    if (truncated_) {
+      header |= TRUNCATED_FLAG;
+      truncatedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint32_t pos = reservePos.load(std::memory_order_relaxed);
+    uint32_t used;
+    do {
+      used = pos + total - readPos.load(std::memory_order_acquire);
+      if (used > RING_SIZE) {
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+    } while (!reservePos.compare_exchange_weak(pos, pos + total, std::memory_order_acq_rel,
+                                               std::memory_order_relaxed));
+
+    // 本体（ヘッダー以外）を書いてから、最後にヘッダーを書いて出力タスクに公開する
+    copyToRing(pos + HEADER_SIZE, data_ + HEADER_SIZE, length_ - HEADER_SIZE);
+    __atomic_store_n(headerAt(pos), header, __ATOMIC_RELEASE);
+
+    writtenCount.fetch_add(1, std::memory_order_relaxed);
+    if (used > highWater.load(std::memory_order_relaxed)) {
+      highWater.store(used, std::memory_order_relaxed);  // 概算（競合時に小さい値で上書きされることがある）
+    }
+  }
+}
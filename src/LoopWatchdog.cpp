@@ -0,0 +1,269 @@
+/**
+ * LoopWatchdog.cpp
+ *
+ * 制御ループの停止の監視と処理段階の足跡の実装
+ */
+
+#include "LoopWatchdog.h"
+#include "Log.h"
+#include <esp_task_wdt.h>
+#include <esp_system.h>
+
+/**
+ * 処理段階の足跡（RTCメモリ、ソフトリセット・ウォッチドッグ・パニック後も保持）
+ * 書き込みは loop() のタスクだけで行い、タイマーは aliveMs・overrunStage だけを書きます。
+ * 電源投入直後は内容が不定のため、magic・段階の一覧のハッシュ・位置の範囲を確かめてから使います。
+ */
+namespace Breadcrumbs {
+  constexpr uint32_t MAGIC = 0x4C574431;  // "LWD1"
+
+  enum Event : uint8_t {
+    ENTER = 1,
+    EXIT = 2
+  };
+
+  struct Crumb {
+    uint32_t atMs;         // 記録した時刻（millis）
+    uint8_t stage;
+    uint8_t event;         // Event
+    uint16_t durationMs;   // 所要時間（EXITのみ、65535で頭打ち）
+  };
+
+  struct Ring {
+    uint32_t magic;
+    uint32_t layout;        // 段階の一覧のハッシュ（ファームウェアが変わったら前回の足跡を使わない）
+    uint32_t aliveMs;       // 最後にタイマーが確認した時刻（リセット直前の目安）
+    uint32_t openSinceMs;   // 実行中の段階の開始時刻
+    uint8_t openStage;      // 実行中の段階（NO_STAGE: 段階の外）
+    uint8_t overrunStage;   // 最後にソフトの期限を超えた段階
+    uint8_t head;           // 次に書き込む位置
+    uint8_t count;          // 記録済みの件数
+    Crumb crumbs[LoopWatchdog::HISTORY];
+  };
+
+  RTC_NOINIT_ATTR Ring ring;
+
+  // 報告するリセットの原因（電源投入・意図した再起動・ディープスリープは報告しない）
+  const char* crashCause(esp_reset_reason_t reason) {
+    switch (reason) {
+      case ESP_RST_TASK_WDT: return "タスクウォッチドッグ";
+      case ESP_RST_INT_WDT:  return "割り込みウォッチドッグ";
+      case ESP_RST_WDT:      return "ウォッチドッグ";
+      case ESP_RST_PANIC:    return "パニック";
+      case ESP_RST_BROWNOUT: return "電源電圧の低下";
+      default:               return nullptr;
+    }
+  }
+}
+
+LoopWatchdog::LoopWatchdog(const LoopStage* stages, uint8_t count, uint32_t timeoutSec)
+  : stages_(stages),
+    count_(count < MAX_STAGES ? count : MAX_STAGES),
+    timeoutSec_(timeoutSec),
+    crashStage_(NO_STAGE),
+    timer_(nullptr),
+    current_(NO_STAGE),
+    enteredMs_(0),
+    entry_(0),
+    reportedEntry_(0),
+    enteredUs_(0),
+    stats_() {
+}
+
+/**
+ * 前回のリセットの報告と、タスクウォッチドッグへの登録
+ */
+void LoopWatchdog::begin() {
+  using namespace Breadcrumbs;
+
+  reportPreviousReset();
+
+  // この起動の足跡を記録し始める
+  memset(&ring, 0, sizeof(ring));
+  ring.layout = layoutHash();
+  ring.openStage = NO_STAGE;
+  ring.overrunStage = NO_STAGE;
+  ring.magic = MAGIC;
+
+  // タイムアウトでパニック（→リセット）するように設定し、ループタスク（setup・loopを実行するタスク）を登録
+  esp_task_wdt_init(timeoutSec_, true);
+  esp_task_wdt_add(nullptr);
+
+  // ソフトの期限の確認（esp_timer のタスクで実行されるため、loop() が止まっていても動く）
+  esp_timer_create_args_t args = {};
+  args.callback = onCheckTimer;
+  args.arg = this;
+  args.name = "loop_watchdog";
+  if (esp_timer_create(&args, &timer_) == ESP_OK) {
+    esp_timer_start_periodic(timer_, (uint64_t)CHECK_INTERVAL_MS * 1000);
+  } else {
+    LOG_W("[Watchdog] 期限確認タイマーの作成失敗（期限超過は段階の終了時に記録）");
+  }
+
+  LOG_I("[Watchdog] ループ監視開始（タイムアウト %lu 秒、%u 段階）", (unsigned long)timeoutSec_, count_);
+}
+
+/**
+ * タスクウォッチドッグをリセット
+ */
+void LoopWatchdog::feed() {
+  esp_task_wdt_reset();
+}
+
+/**
+ * 段階の開始
+ */
+void LoopWatchdog::enter(uint8_t stage) {
+  exit();
+  if (stage >= count_) {
+    return;
+  }
+
+  uint32_t now = millis();
+  enteredUs_ = micros();
+  enteredMs_.store(now, std::memory_order_relaxed);
+  entry_.fetch_add(1, std::memory_order_relaxed);
+  current_.store(stage, std::memory_order_release);
+
+  Breadcrumbs::ring.openSinceMs = now;
+  Breadcrumbs::ring.openStage = stage;
+  record(stage, Breadcrumbs::ENTER, 0);
+}
+
+/**
+ * 実行中の段階の終了
+ */
+void LoopWatchdog::exit() {
+  uint8_t stage = current_.load(std::memory_order_relaxed);
+  if (stage == NO_STAGE) {
+    return;
+  }
+  current_.store(NO_STAGE, std::memory_order_release);
+
+  uint32_t elapsedUs = micros() - enteredUs_;
+  StageStats& stats = stats_[stage];
+  if (elapsedUs > stats.maxUs) {
+    stats.maxUs = elapsedUs;
+  }
+
+  // タイマーの確認より先に終わった期限超過（確認間隔より短い超過）はここで記録
+  uint32_t elapsedMs = elapsedUs / 1000;
+  if (elapsedMs > stages_[stage].softDeadlineMs) {
+    reportOverrun(entry_.load(std::memory_order_relaxed), stage, elapsedMs);
+  }
+
+  Breadcrumbs::ring.openStage = NO_STAGE;
+  record(stage, Breadcrumbs::EXIT, elapsedMs);
+}
+
+/**
+ * 足跡を1件記録（古いものから上書き）
+ */
+void LoopWatchdog::record(uint8_t stage, uint8_t event, uint32_t durationMs) {
+  Breadcrumbs::Ring& ring = Breadcrumbs::ring;
+  Breadcrumbs::Crumb& crumb = ring.crumbs[ring.head];
+  crumb.atMs = millis();
+  crumb.stage = stage;
+  crumb.event = event;
+  crumb.durationMs = durationMs > 0xFFFF ? 0xFFFF : (uint16_t)durationMs;
+  ring.head = (uint8_t)((ring.head + 1) % HISTORY);
+  if (ring.count < HISTORY) {
+    ring.count++;
+  }
+}
+
+/**
+ * 期限超過の記録（同じ段階の実行中に1回だけ。タイマーと loop() のどちらからも呼ばれる）
+ */
+void LoopWatchdog::reportOverrun(uint32_t entry, uint8_t stage, uint32_t elapsedMs) {
+  uint32_t reported = reportedEntry_.load(std::memory_order_relaxed);
+  if (reported == entry || !reportedEntry_.compare_exchange_strong(reported, entry)) {
+    return;
+  }
+  stats_[stage].overruns++;
+  Breadcrumbs::ring.overrunStage = stage;
+  LOG_W("[Watchdog] %s が期限を超過: %lu ms（期限 %lu ms）",
+        stages_[stage].name, (unsigned long)elapsedMs, (unsigned long)stages_[stage].softDeadlineMs);
+}
+
+/**
+ * 前回のリセットがウォッチドッグ・パニックによるものなら、直前の足跡を表示
+ */
+void LoopWatchdog::reportPreviousReset() {
+  using namespace Breadcrumbs;
+
+  const char* cause = crashCause(esp_reset_reason());
+  if (cause == nullptr) {
+    return;
+  }
+  if (ring.magic != MAGIC || ring.layout != layoutHash() ||
+      ring.head >= HISTORY || ring.count > HISTORY || ring.count == 0) {
+    LOG_E("[Watchdog] 前回は%sでリセット（足跡なし）", cause);
+    return;
+  }
+
+  crashStage_ = ring.openStage < count_ ? ring.openStage : NO_STAGE;
+  if (crashStage_ != NO_STAGE) {
+    long stalledMs = (long)(ring.aliveMs - ring.openSinceMs);
+    LOG_E("[Watchdog] 前回は%sでリセット: 実行中の段階 %s（開始から %ld ms 以上）",
+          cause, stages_[crashStage_].name, stalledMs > 0 ? stalledMs : 0L);
+  } else {
+    LOG_E("[Watchdog] 前回は%sでリセット: 段階の外（loop() の処理の合間）", cause);
+  }
+  if (ring.overrunStage < count_ && ring.overrunStage != crashStage_) {
+    LOG_W("[Watchdog] 最後に期限を超えた段階: %s", stages_[ring.overrunStage].name);
+  }
+
+  // 直前の足跡（古い順、時刻は最後の足跡からの差）
+  uint8_t n = ring.count < REPORT ? ring.count : REPORT;
+  uint32_t lastMs = ring.crumbs[(ring.head + HISTORY - 1) % HISTORY].atMs;
+  LOG_W("[Watchdog] 直前の足跡（%u 件、最後の足跡 = 起動から %lu ms）", n, (unsigned long)lastMs);
+  for (uint8_t i = 0; i < n; i++) {
+    const Crumb& crumb = ring.crumbs[(ring.head + HISTORY - n + i) % HISTORY];
+    const char* name = crumb.stage < count_ ? stages_[crumb.stage].name : "?";
+    long offsetMs = -(long)(lastMs - crumb.atMs);
+    if (crumb.event == EXIT) {
+      LOG_W("[Watchdog]   %ld ms %s 終了（%u ms）", offsetMs, name, crumb.durationMs);
+    } else {
+      LOG_W("[Watchdog]   %ld ms %s 開始", offsetMs, name);
+    }
+  }
+}
+
+/**
+ * 段階の一覧のハッシュ（FNV-1a、名前と順序）
+ */
+uint32_t LoopWatchdog::layoutHash() const {
+  uint32_t h = 2166136261u;
+  for (uint8_t i = 0; i < count_; i++) {
+    for (const char* p = stages_[i].name; *p != '\0'; p++) {
+      h ^= (uint8_t)*p;
+      h *= 16777619u;
+    }
+    h ^= 0xFF;  // 名前の区切り
+    h *= 16777619u;
+  }
+  return h;
+}
+
+void LoopWatchdog::onCheckTimer(void* arg) {
+  static_cast<LoopWatchdog*>(arg)->check();
+}
+
+/**
+ * 実行中の段階のソフトの期限を確認（esp_timer のタスク）
+ */
+void LoopWatchdog::check() {
+  uint32_t now = millis();
+  Breadcrumbs::ring.aliveMs = now;
+
+  uint8_t stage = current_.load(std::memory_order_acquire);
+  if (stage == NO_STAGE) {
+    return;
+  }
+  uint32_t entry = entry_.load(std::memory_order_relaxed);
+  uint32_t elapsedMs = now - enteredMs_.load(std::memory_order_relaxed);
+  if (elapsedMs > stages_[stage].softDeadlineMs) {
+    reportOverrun(entry, stage, elapsedMs);
+  }
+}
@@ -0,0 +1,312 @@
+/**
+ * MetricsServer.cpp
+ *
+ * メトリクス公開サーバーの実装
+ */
+
+#include "MetricsServer.h"
+#include "Log.h"
+
+// ========================================
+// MetricsWriter
+// ========================================
+
+MetricsWriter::MetricsWriter(char* buffer, size_t capacity, FlushFunc flush, void* context)
+  : buffer_(buffer),
+    capacity_(capacity),
+    length_(0),
+    total_(0),
+    overflow_(false),
+    failed_(false),
+    flush_(flush),
+    flushContext_(context) {
+  if (capacity_ > 0) {
+    buffer_[0] = '\0';
+  }
+}
+
+void MetricsWriter::header(const char* name, const char* help, const char* type) {
+  append("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+void MetricsWriter::sample(const char* name, const char* labels, double value) {
+  if (labels != nullptr) {
+    append("%s{%s} %.6g\n", name, labels, value);
+  } else {
+    append("%s %.6g\n", name, value);
+  }
+}
+
+void MetricsWriter::sample(const char* name, const char* labels, uint32_t value) {
+  if (labels != nullptr) {
+    append("%s{%s} %lu\n", name, labels, (unsigned long)value);
+  } else {
+    append("%s %lu\n", name, (unsigned long)value);
+  }
+}
+
+void MetricsWriter::gauge(const char* name, const char* help, double value) {
+  header(name, help, "gauge");
+  sample(name, nullptr, value);
+}
+
+void MetricsWriter::counter(const char* name, const char* help, uint32_t value) {
+  header(name, help, "counter");
+  sample(name, nullptr, value);
+}
+
+/**
+ * バッファに追記
+ * 収まらない場合はバッファを送出して書き直します。空のバッファにも収まらない行は捨てて
+ * overflowを記録します（行の途中で切れないようにする）。送出関数がなければ以降はすべて捨てます。
+ */
+void MetricsWriter::append(const char* format, ...) {
+  if (failed_ || (overflow_ && flush_ == nullptr)) {
+    return;
+  }
+
+  for (;;) {
+    size_t remaining = capacity_ - length_;
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(buffer_ + length_, remaining, format, args);
+    va_end(args);
+
+    if (written >= 0 && (size_t)written < remaining) {
+      length_ += written;
+      total_ += written;
+      return;
+    }
+
+    buffer_[length_] = '\0';
+    if (flush_ == nullptr || length_ == 0 || written < 0) {
+      overflow_ = true;
+      return;
+    }
+    if (!finish()) {
+      return;
+    }
+  }
+}
+
+bool MetricsWriter::finish() {
+  if (failed_) {
+    return false;
+  }
+  if (flush_ == nullptr || length_ == 0) {
+    return true;
+  }
+  if (!flush_(buffer_, length_, flushContext_)) {
+    failed_ = true;
+    return false;
+  }
+  length_ = 0;
+  buffer_[0] = '\0';
+  return true;
+}
+
+// ========================================
+// MetricsServer
+// ========================================
+
+/**
+ * コンストラクタ
+ */
+MetricsServer::MetricsServer(uint16_t port)
+  : server_(port),
+    port_(port),
+    started_(false),
+    collectorCount_(0),
+    loopCount_(0),
+    loopTotalUs_(0),
+    loopMaxUs_(0),
+    stats_(),
+    requestLength_(0),
+    acceptedAt_(0) {
+}
+
+/**
+ * 待ち受けを開始
+ */
+void MetricsServer::begin() {
+  if (started_) {
+    return;
+  }
+  server_.begin();
+  server_.setNoDelay(true);
+  started_ = true;
+  LOG_I("[Metrics] http://%s:%u/metrics で待ち受け開始",
+        WiFi.localIP().toString().c_str(), port_);
+}
+
+/**
+ * 収集関数を登録
+ */
+bool MetricsServer::addCollector(Collector collector, void* context) {
+  if (collectorCount_ >= MAX_COLLECTORS) {
+    LOG_W("[Metrics] 収集関数の登録数が上限に達しました");
+    return false;
+  }
+  collectors_[collectorCount_].callback = collector;
+  collectors_[collectorCount_].context = context;
+  collectorCount_++;
+  return true;
+}
+
+/**
+ * ループ1回の処理時間を記録
+ */
+void MetricsServer::recordLoop(unsigned long durationUs) {
+  loopCount_++;
+  loopTotalUs_ += durationUs;
+  if (durationUs > loopMaxUs_) {
+    loopMaxUs_ = durationUs;
+  }
+}
+
+/**
+ * リクエストがあれば応答する
+ * リクエスト行が揃っていなければ、読めた分だけ保持して次回に続きを読みます。
+ */
+void MetricsServer::handle() {
+  if (!started_) {
+    return;
+  }
+
+  if (!client_) {
+    client_ = server_.available();
+    if (!client_) {
+      return;
+    }
+    requestLength_ = 0;
+    acceptedAt_ = millis();
+  }
+
+  if (readRequestLine()) {
+    respond();
+    client_.stop();
+    return;
+  }
+
+  // 切断された、または期限内にリクエスト行が揃わなかった接続は閉じる
+  if (!client_.connected() || millis() - acceptedAt_ > REQUEST_TIMEOUT_MS) {
+    client_.stop();
+  }
+}
+
+/**
+ * 揃ったリクエスト行に応答する
+ */
+void MetricsServer::respond() {
+  // 残りのリクエストヘッダーは読み捨てる（待たない）
+  while (client_.available()) {
+    client_.read();
+  }
+
+  char head[128];
+  int headLen;
+  if (strncmp(requestLine_, "GET /metrics", 12) == 0 && (requestLine_[12] == ' ' || requestLine_[12] == '?')) {
+    // 本文の長さは生成し終えるまで分からないため、chunked転送でバッファが満杯になるたびに送る
+    headLen = snprintf(head, sizeof(head),
+                       "HTTP/1.1 200 OK\r\n"
+                       "Content-Type: text/plain; version=0.0.4\r\n"
+                       "Transfer-Encoding: chunked\r\n"
+                       "Connection: close\r\n\r\n");
+    client_.write((const uint8_t*)head, headLen);
+
+    unsigned long startUs = micros();
+    MetricsWriter writer(buffer_, BUFFER_SIZE, writeChunk, &client_);
+    render(writer);
+    bool sent = writer.finish() && client_.write((const uint8_t*)"0\r\n\r\n", 5) == 5;
+
+    if (writer.overflowed()) {
+      stats_.overflows++;
+      LOG_E("[Metrics] %u バイトのバッファに収まらない行があり、出力から欠落しました",
+            (unsigned)BUFFER_SIZE);
+    }
+    if (!sent) {
+      stats_.writeErrors++;
+      LOG_W("[Metrics] 応答の送信に失敗（%u バイト生成済み）", (unsigned)writer.total());
+    }
+    stats_.lastRenderUs = micros() - startUs;
+    stats_.lastBytes = writer.total();
+    stats_.scrapes++;
+  } else {
+    headLen = snprintf(head, sizeof(head),
+                       "HTTP/1.1 404 Not Found\r\n"
+                       "Content-Length: 0\r\n"
+                       "Connection: close\r\n\r\n");
+    client_.write((const uint8_t*)head, headLen);
+    stats_.notFound++;
+  }
+}
+
+/**
+ * 受信済みの分だけリクエスト行（例: "GET /metrics HTTP/1.1"）を読み進める（待たない）
+ * 長すぎる部分は切り捨てます。
+ * @return true: 行が揃った
+ */
+bool MetricsServer::readRequestLine() {
+  while (client_.available()) {
+    int c = client_.read();
+    if (c < 0) {
+      break;
+    }
+    if (c == '\n') {
+      requestLine_[requestLength_] = '\0';
+      if (requestLength_ > 0) {
+        return true;
+      }
+      continue;  // 先頭の空行は読み飛ばす
+    }
+    if (c != '\r' && requestLength_ < REQUEST_LINE_SIZE - 1) {
+      requestLine_[requestLength_++] = (char)c;
+    }
+  }
+  return false;
+}
+
+/**
+ * chunked転送の1チャンクを送信（MetricsWriter の送出関数）
+ */
+bool MetricsServer::writeChunk(const char* data, size_t length, void* context) {
+  WiFiClient* client = static_cast<WiFiClient*>(context);
+  char size[12];
+  int sizeLen = snprintf(size, sizeof(size), "%x\r\n", (unsigned)length);
+  return client->write((const uint8_t*)size, sizeLen) == (size_t)sizeLen &&
+         client->write((const uint8_t*)data, length) == length &&
+         client->write((const uint8_t*)"\r\n", 2) == 2;
+}
+
+/**
+ * 応答本文を生成
+ */
+void MetricsServer::render(MetricsWriter& writer) {
+  writer.gauge("controller_uptime_seconds", "Seconds since boot", millis() / 1000.0);
+
+  writer.gauge("controller_heap_free_bytes", "Free heap", (double)ESP.getFreeHeap());
+  writer.gauge("controller_heap_min_free_bytes", "Lowest free heap since boot",
+               (double)ESP.getMinFreeHeap());
+  writer.gauge("controller_heap_largest_block_bytes", "Largest allocatable heap block",
+               (double)ESP.getMaxAllocHeap());
+
+  writer.header("controller_loop_duration_seconds", "Main loop iteration time", "summary");
+  writer.sample("controller_loop_duration_seconds_sum", nullptr, loopTotalUs_ / 1e6);
+  writer.sample("controller_loop_duration_seconds_count", nullptr, loopCount_);
+  writer.gauge("controller_loop_duration_max_seconds",
+               "Longest main loop iteration since the previous scrape", loopMaxUs_ / 1e6);
+  loopMaxUs_ = 0;
+
+  for (uint8_t i = 0; i < collectorCount_; i++) {
+    collectors_[i].callback(writer, collectors_[i].context);
+  }
+
+  // 本文の最後に出力する（metrics_check.py はこれが揃っていることで本文が完全だと判定する）
+  writer.counter("controller_metrics_overflows_total", "Scrapes that lost lines because a line exceeded the buffer",
+                 stats_.overflows);
+  writer.counter("controller_metrics_write_errors_total", "Scrapes whose response could not be sent",
+                 stats_.writeErrors);
+  writer.gauge("controller_metrics_body_bytes", "Body size of the previous scrape", (double)stats_.lastBytes);
+  writer.gauge("controller_metrics_render_seconds", "Time spent rendering and sending the previous scrape",
+               stats_.lastRenderUs / 1e6);
+}
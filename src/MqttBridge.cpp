@@ -0,0 +1,383 @@
+/**
+ * MqttBridge.cpp
+ *
+ * MQTT連携クラスの実装
+ */
+
+#include "MqttBridge.h"
+#include <ArduinoJson.h>
+#include <stdarg.h>
+#include "Log.h"
+
+MqttBridge* MqttBridge::instance_ = nullptr;
+
+namespace {
+  /**
+   * バッファに追記（収まらない場合はfalse）
+   */
+  bool appendf(char* buffer, size_t capacity, size_t& length, const char* format, ...)
+    __attribute__((format(printf, 4, 5)));
+
+  bool appendf(char* buffer, size_t capacity, size_t& length, const char* format, ...) {
+    if (length >= capacity) {
+      return false;
+    }
+    size_t remaining = capacity - length;
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(buffer + length, remaining, format, args);
+    va_end(args);
+    if (written < 0 || (size_t)written >= remaining) {
+      return false;
+    }
+    length += written;
+    return true;
+  }
+}
+
+/**
+ * コンストラクタ
+ */
+MqttBridge::MqttBridge(AirConditionerController& airConditioner, AutoStopController& autoStop,
+                       TimeManager& timeManager, const char* host, uint16_t port, const char* deviceId)
+  : airConditioner_(airConditioner),
+    autoStop_(autoStop),
+    timeManager_(timeManager),
+    client_(net_),
+    host_(host),
+    port_(port),
+    deviceId_(deviceId),
+    user_(nullptr),
+    password_(nullptr),
+    sampleCount_(0),
+    batchStartMs_(0),
+    batchStartEpoch_(0),
+    flushIntervalMs_(30000),
+    healthIntervalMs_(60000),
+    lastHealthMs_(0),
+    nextConnectMs_(0),
+    backoffMs_(BACKOFF_BASE_MS),
+    started_(false),
+    overflowLogged_(false),
+    publishedMode_(ACMode::NONE),
+    publishedAutoStop_(false),
+    stateDirty_(true),
+    stats_() {
+  baseTopic_[0] = '\0';
+  topic_[0] = '\0';
+  payload_[0] = '\0';
+}
+
+/**
+ * 認証情報を設定
+ */
+void MqttBridge::setCredentials(const char* user, const char* password) {
+  user_ = (user != nullptr && user[0] != '\0') ? user : nullptr;
+  password_ = (user_ != nullptr) ? password : nullptr;
+}
+
+/**
+ * 初期化
+ */
+void MqttBridge::begin() {
+  instance_ = this;
+  snprintf(baseTopic_, sizeof(baseTopic_), "aircon/%s", deviceId_);
+
+  client_.setServer(host_, port_);
+  client_.setCallback(onMessage);
+  client_.setSocketTimeout(2);
+  // バッファは1回だけ確保される（送信のたびに確保しない）
+  if (!client_.setBufferSize(PAYLOAD_SIZE + TOPIC_SIZE + 8)) {
+    LOG_E("[MQTT] 送受信バッファの確保に失敗しました");
+  }
+
+  started_ = true;
+  LOG_I("[MQTT] ブローカー: %s:%u, トピック: %s/#", host_, port_, baseTopic_);
+}
+
+/**
+ * 接続の維持・コマンド受信・送信処理
+ */
+void MqttBridge::update() {
+  if (!started_ || !WiFi.isConnected()) {
+    return;
+  }
+
+  if (!client_.connected()) {
+    if ((long)(millis() - nextConnectMs_) < 0) {
+      return;
+    }
+    if (!connect()) {
+      return;
+    }
+  }
+
+  // 受信処理（コマンドはこの中でonMessage経由で処理される）
+  client_.loop();
+  if (!client_.connected()) {
+    return;
+  }
+
+  if (stateDirty_ ||
+      airConditioner_.getCurrentMode() != publishedMode_ ||
+      autoStop_.isEnabled() != publishedAutoStop_) {
+    publishState();
+  }
+
+  if (sampleCount_ >= MAX_BATCH ||
+      (sampleCount_ > 0 && millis() - batchStartMs_ >= flushIntervalMs_)) {
+    flushSamples();
+  }
+
+  if (millis() - lastHealthMs_ >= healthIntervalMs_) {
+    publishHealth();
+  }
+}
+
+/**
+ * センサー値を送信待ちに追加
+ */
+bool MqttBridge::addSample(const SensorData& data) {
+  if (!data.isValid) {
+    return false;
+  }
+
+  unsigned long now = millis();
+  if (sampleCount_ == 0) {
+    batchStartMs_ = now;
+    batchStartEpoch_ = timeManager_.epoch();
+  }
+
+  unsigned long offsetSec = (now - batchStartMs_) / 1000;
+  if (sampleCount_ >= MAX_BATCH || offsetSec > 0xFFFF) {
+    stats_.samplesDropped++;
+    if (!overflowLogged_) {
+      LOG_W("[MQTT] 送信待ちが上限（%u件）に達したため、以降のセンサー値を捨てます",
+            (unsigned)MAX_BATCH);
+      overflowLogged_ = true;
+    }
+    return false;
+  }
+
+  Sample& sample = samples_[sampleCount_++];
+  sample.offsetSec = (uint16_t)offsetSec;
+  sample.temperature = data.temperature;  // SensorData も同じ1/100単位
+  sample.humidity = (uint16_t)data.humidity;
+  sample.discomfortIndex = data.discomfortIndex;
+
+  if (sampleCount_ > stats_.maxQueueDepth) {
+    stats_.maxQueueDepth = sampleCount_;
+  }
+  return true;
+}
+
+/**
+ * ブローカーに接続し、コマンドトピックを購読する
+ * @return true: 接続成功, false: 接続失敗（バックオフ後に再試行）
+ */
+bool MqttBridge::connect() {
+  stats_.connectAttempts++;
+
+  // 切断時はブローカーが status に "offline" を送信する
+  bool connected = client_.connect(deviceId_, user_, password_,
+                                   topic("status"), 1, true, "offline");
+  if (!connected) {
+    stats_.connectFailures++;
+    LOG_W("[MQTT] 接続失敗 (state=%d) - %lu秒後に再試行",
+          client_.state(), backoffMs_ / 1000);
+    nextConnectMs_ = millis() + backoffMs_;
+    backoffMs_ *= 2;
+    if (backoffMs_ > BACKOFF_MAX_MS) {
+      backoffMs_ = BACKOFF_MAX_MS;
+    }
+    return false;
+  }
+
+  backoffMs_ = BACKOFF_BASE_MS;
+  client_.subscribe(topic("cmd"), 1);
+  client_.publish(topic("status"), "online", true);
+
+  // 再接続時は状態を送り直す（retainされている値が古い可能性があるため）
+  stateDirty_ = true;
+
+  LOG_I("[MQTT] 接続しました（%u回目）", (unsigned)(stats_.connectAttempts - stats_.connectFailures));
+  return true;
+}
+
+/**
+ * メッセージ受信時のコールバック（client_.loop() の中から呼ばれる）
+ */
+void MqttBridge::onMessage(char* topic, uint8_t* payload, unsigned int length) {
+  (void)topic;  // 購読しているのはコマンドトピックのみ
+  if (instance_ != nullptr) {
+    instance_->handleCommand(payload, length);
+  }
+}
+
+/**
+ * コマンドを処理
+ * 例: {"mode":"cool_20"}, {"autoStop":false}, {"mode":"off","autoStop":true}
+ *
+ * payloadは受信バッファを指しているため、この中では送信しません（状態の送信はupdate()で行う）。
+ */
+void MqttBridge::handleCommand(const uint8_t* payload, unsigned int length) {
+  stats_.commandsReceived++;
+
+  JsonDocument doc;
+  DeserializationError error = deserializeJson(doc, (const char*)payload, length);
+  if (error) {
+    stats_.commandsRejected++;
+    LOG_W("[MQTT] コマンドのJSON解析エラー: %s", error.c_str());
+    return;
+  }
+
+  bool handled = false;
+
+  JsonVariant mode = doc["mode"];
+  if (!mode.isNull()) {
+    ACMode requested = AirConditionerController::modeFromKey(mode.as<const char*>());
+    if (requested == ACMode::NONE) {
+      stats_.commandsRejected++;
+      LOG_W("[MQTT] 不明なモード: %s", mode.as<const char*>() ? mode.as<const char*>() : "(null)");
+      return;
+    }
+    LOG_I("[MQTT] コマンド: モード → %s", AirConditionerController::modeToKey(requested));
+    airConditioner_.request(requested, ACPriority::USER);
+    handled = true;
+  }
+
+  JsonVariant enabled = doc["autoStop"];
+  if (!enabled.isNull()) {
+    if (!enabled.is<bool>()) {
+      stats_.commandsRejected++;
+      LOG_W("[MQTT] autoStop には true/false を指定してください");
+      return;
+    }
+    LOG_I("[MQTT] コマンド: 自動停止 → %s", enabled.as<bool>() ? "有効" : "無効");
+    autoStop_.setEnabled(enabled.as<bool>());
+    handled = true;
+  }
+
+  if (!handled) {
+    stats_.commandsRejected++;
+    LOG_W("[MQTT] 対応するキー（mode, autoStop）がありません");
+    return;
+  }
+  stateDirty_ = true;
+}
+
+/**
+ * 送信待ちのセンサー値をまとめて送信
+ * 例: {"ts":1760000000,"n":3,"off":[0,2,4],"temp":[2650,2651,2651],"hum":[5520,5518,5519],"di":[7512,7513,7513]}
+ */
+void MqttBridge::flushSamples() {
+  size_t len = 0;
+  bool ok = appendf(payload_, PAYLOAD_SIZE, len, "{\"ts\":%lu,\"n\":%u",
+                    (unsigned long)batchStartEpoch_, (unsigned)sampleCount_);
+
+  ok = ok && appendf(payload_, PAYLOAD_SIZE, len, ",\"off\":[");
+  for (uint8_t i = 0; ok && i < sampleCount_; i++) {
+    ok = appendf(payload_, PAYLOAD_SIZE, len, i == 0 ? "%u" : ",%u", (unsigned)samples_[i].offsetSec);
+  }
+  ok = ok && appendf(payload_, PAYLOAD_SIZE, len, "],\"temp\":[");
+  for (uint8_t i = 0; ok && i < sampleCount_; i++) {
+    ok = appendf(payload_, PAYLOAD_SIZE, len, i == 0 ? "%d" : ",%d", (int)samples_[i].temperature);
+  }
+  ok = ok && appendf(payload_, PAYLOAD_SIZE, len, "],\"hum\":[");
+  for (uint8_t i = 0; ok && i < sampleCount_; i++) {
+    ok = appendf(payload_, PAYLOAD_SIZE, len, i == 0 ? "%u" : ",%u", (unsigned)samples_[i].humidity);
+  }
+  ok = ok && appendf(payload_, PAYLOAD_SIZE, len, "],\"di\":[");
+  for (uint8_t i = 0; ok && i < sampleCount_; i++) {
+    ok = appendf(payload_, PAYLOAD_SIZE, len, i == 0 ? "%d" : ",%d", (int)samples_[i].discomfortIndex);
+  }
+  ok = ok && appendf(payload_, PAYLOAD_SIZE, len, "]}");
+
+  if (!ok) {
+    // PAYLOAD_SIZE はMAX_BATCH件が収まる大きさのため通常は発生しない
+    LOG_E("[MQTT] 送信メッセージがバッファに収まりません（%u件）", (unsigned)sampleCount_);
+    stats_.samplesDropped += sampleCount_;
+    sampleCount_ = 0;
+    overflowLogged_ = false;
+    return;
+  }
+
+  if (!publish("telemetry", len, false)) {
+    // 接続が切れている可能性が高いため、切断してバックオフ後に再接続する（センサー値は保持）
+    client_.disconnect();
+    nextConnectMs_ = millis() + backoffMs_;
+    return;
+  }
+
+  stats_.batchCount++;
+  stats_.samplesSent += sampleCount_;
+  LOG_D("[MQTT] センサー値 %u件を送信（%u バイト, %lu us）",
+        (unsigned)sampleCount_, (unsigned)len, stats_.lastPublishUs);
+  sampleCount_ = 0;
+  overflowLogged_ = false;
+}
+
+/**
+ * エアコンの状態を送信（retain）
+ */
+void MqttBridge::publishState() {
+  ACMode mode = airConditioner_.getCurrentMode();
+  bool autoStopEnabled = autoStop_.isEnabled();
+
+  size_t len = 0;
+  appendf(payload_, PAYLOAD_SIZE, len, "{\"mode\":\"%s\",\"autoStop\":%s}",
+          AirConditionerController::modeToKey(mode), autoStopEnabled ? "true" : "false");
+
+  if (publish("state", len, true)) {
+    publishedMode_ = mode;
+    publishedAutoStop_ = autoStopEnabled;
+    stateDirty_ = false;
+  }
+}
+
+/**
+ * 稼働状況を送信
+ */
+void MqttBridge::publishHealth() {
+  lastHealthMs_ = millis();
+
+  size_t len = 0;
+  appendf(payload_, PAYLOAD_SIZE, len,
+          "{\"uptime\":%lu,\"heap\":%lu,\"rssi\":%d,\"queue\":%u,\"dropped\":%lu,"
+          "\"publishUs\":%lu,\"maxPublishUs\":%lu}",
+          lastHealthMs_ / 1000, (unsigned long)ESP.getFreeHeap(), (int)WiFi.RSSI(),
+          (unsigned)sampleCount_, (unsigned long)stats_.samplesDropped,
+          stats_.lastPublishUs, stats_.maxPublishUs);
+
+  publish("health", len, false);
+}
+
+/**
+ * payload_ の内容を <base>/<suffix> に送信し、所要時間を記録
+ */
+bool MqttBridge::publish(const char* suffix, size_t length, bool retained) {
+  unsigned long startUs = micros();
+  bool ok = client_.publish(topic(suffix), (const uint8_t*)payload_, length, retained);
+  unsigned long elapsedUs = micros() - startUs;
+
+  stats_.lastPublishUs = elapsedUs;
+  if (elapsedUs > stats_.maxPublishUs) {
+    stats_.maxPublishUs = elapsedUs;
+  }
+
+  if (ok) {
+    stats_.publishCount++;
+  } else {
+    stats_.publishFailures++;
+    LOG_W("[MQTT] 送信失敗: %s/%s", baseTopic_, suffix);
+  }
+  return ok;
+}
+
+/**
+ * <base>/<suffix> のトピック名を組み立てる（次の呼び出しまで有効）
+ */
+const char* MqttBridge::topic(const char* suffix) {
+  snprintf(topic_, sizeof(topic_), "%s/%s", baseTopic_, suffix);
+  return topic_;
+}
@@ -0,0 +1,294 @@
+/**
+ * ScheduleEngine.cpp
+ *
+ * カレンダー型スケジュール実行クラスの実装
+ */
+
+#include "ScheduleEngine.h"
+#include "Log.h"
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+namespace {
+  // ログ表示用（LOG_I が除去されるビルドでは使われない）
+  const char* modeName(ACMode mode) {
+    switch (mode) {
+      case ACMode::OFF:               return "停止";
+      case ACMode::COOLING_20:        return "冷房20度";
+      case ACMode::AUTO_PLUS_1:       return "自動+1度";
+      case ACMode::DEHUMID_MINUS_1_5: return "除湿-1.5度";
+      default:                        return "なし";
+    }
+  }
+}
+#endif
+
+/**
+ * コンストラクタ
+ */
+ScheduleEngine::ScheduleEngine(AirConditionerController& ac, TimeManager& timeMgr)
+  : ac_(ac),
+    timeMgr_(timeMgr),
+    ruleCount_(0),
+    armed_(false),
+    dirty_(false),
+    nextFire_(0),
+    lastFired_(0),
+    lastCheck_(0),
+    catchUpSec_(3600) {
+}
+
+/**
+ * ルールを追加
+ */
+int ScheduleEngine::addRule(const ScheduleRule& rule) {
+  if (ruleCount_ >= MAX_RULES) {
+    LOG_W("[Schedule] ルール登録数の上限");
+    return -1;
+  }
+  if (rule.hour > 23 || rule.minute > 59) {
+    LOG_W("[Schedule] 無効な時刻: %u:%u", rule.hour, rule.minute);
+    return -1;
+  }
+
+  rules_[ruleCount_] = rule;
+  // 起動後の初回計算前なら、初回のupdate()で実行しそびれたイベントも含めて計算する
+  dirty_ = armed_;
+  LOG_I("[Schedule] ルール%u追加: %02u:%02u %s (曜日 0x%02X, 月 0x%03X)",
+        ruleCount_, rule.hour, rule.minute, modeName(rule.mode),
+        rule.daysOfWeek, rule.months);
+  return ruleCount_++;
+}
+
+/**
+ * ルールの有効/無効を設定
+ */
+void ScheduleEngine::setRuleEnabled(int ruleId, bool enabled) {
+  if (ruleId < 0 || ruleId >= ruleCount_) {
+    return;
+  }
+  rules_[ruleId].enabled = enabled;
+  dirty_ = armed_;
+}
+
+/**
+ * ルールを取得
+ */
+const ScheduleRule* ScheduleEngine::getRule(int ruleId) const {
+  if (ruleId < 0 || ruleId >= ruleCount_) {
+    return nullptr;
+  }
+  return &rules_[ruleId];
+}
+
+/**
+ * 実行しそびれたイベントの猶予時間を設定
+ */
+void ScheduleEngine::setCatchUpWindow(uint32_t seconds) {
+  catchUpSec_ = (time_t)seconds;
+  if (catchUpSec_ > SECONDS_PER_DAY) {
+    catchUpSec_ = SECONDS_PER_DAY;
+  }
+}
+
+/**
+ * 再起動前に最後に実行した時刻を復元
+ */
+void ScheduleEngine::restoreLastFireTime(time_t lastFired) {
+  if (lastFired > lastFired_) {
+    lastFired_ = lastFired;
+  }
+}
+
+/**
+ * スケジュールを確認し、時刻になったルールを実行
+ */
+void ScheduleEngine::update() {
+  if (ruleCount_ == 0 || !timeMgr_.isTimeValid()) {
+    return;
+  }
+
+  time_t now = timeMgr_.epoch();
+
+  // ルール変更時は、実行しそびれたイベントを探さずに次回実行時刻だけを再計算
+  if (dirty_) {
+    dirty_ = false;
+    arm(now > lastFired_ ? now : lastFired_);
+    lastCheck_ = now;
+    return;
+  }
+
+  if (armed_) {
+    // 時刻が戻った場合は再計算（実行済みのイベントは再実行しない）
+    if (now + CLOCK_BACK_TOLERANCE_SEC < lastCheck_) {
+      LOG_I("[Schedule] 時刻が%ld秒戻りました: 次回実行時刻を再計算",
+            (long)(lastCheck_ - now));
+      arm(now > lastFired_ ? now : lastFired_);
+      lastCheck_ = now;
+      return;
+    }
+
+    // 次回実行時刻まではここで終了
+    if (nextFire_ == 0 || now < nextFire_) {
+      lastCheck_ = now;
+      return;
+    }
+  }
+
+  // 実行するイベントを決める
+  // - 起動直後: 猶予時間内に実行しそびれたイベントのうち最新のもの
+  // - 通常: 次回実行時刻〜現在のイベントのうち最新のもの（時刻が進んで複数を飛び越えた場合も1件）
+  time_t from = now - catchUpSec_;
+  if (armed_) {
+    if (nextFire_ < from) {
+      printEpoch("[Schedule] 猶予時間を過ぎたイベントをスキップ:", nextFire_);
+    } else {
+      from = nextFire_;
+    }
+  }
+  if (from <= lastFired_) {
+    from = lastFired_ + 1;
+  }
+
+  time_t due = 0;
+  for (uint8_t i = 0; i < ruleCount_; i++) {
+    if (!rules_[i].enabled) {
+      continue;
+    }
+    time_t t = latestFireBetween(rules_[i], from, now);
+    if (t > due) {
+      due = t;
+    }
+  }
+
+  if (due != 0) {
+    fire(due);
+  }
+
+  arm(now);
+  lastCheck_ = now;
+}
+
+/**
+ * 指定時刻より後で最も早い実行時刻を計算
+ */
+void ScheduleEngine::arm(time_t after) {
+  nextFire_ = 0;
+  for (uint8_t i = 0; i < ruleCount_; i++) {
+    if (!rules_[i].enabled) {
+      continue;
+    }
+    time_t t = nextFireAfter(rules_[i], after);
+    if (t != 0 && (nextFire_ == 0 || t < nextFire_)) {
+      nextFire_ = t;
+    }
+  }
+  armed_ = true;
+
+  if (nextFire_ != 0) {
+    printEpoch("[Schedule] 次回実行:", nextFire_);
+  } else {
+    LOG_I("[Schedule] 実行予定のルールなし");
+  }
+}
+
+/**
+ * 指定時刻のイベントを実行（同じ時刻のルールは登録順にすべて実行）
+ */
+void ScheduleEngine::fire(time_t eventTime) {
+  for (uint8_t i = 0; i < ruleCount_; i++) {
+    const ScheduleRule& rule = rules_[i];
+    if (!rule.enabled || latestFireBetween(rule, eventTime, eventTime) != eventTime) {
+      continue;
+    }
+    LOG_I("[Schedule] ========================================");
+    LOG_I("[Schedule] ルール%u: %02u:%02u %s",
+          i, rule.hour, rule.minute, modeName(rule.mode));
+    LOG_I("[Schedule] ========================================");
+    ac_.request(rule.mode, ACPriority::SCHEDULE);
+  }
+  lastFired_ = eventTime;
+}
+
+/**
+ * ルールの、指定時刻より後で最も早い実行時刻（見つからなければ0）
+ */
+time_t ScheduleEngine::nextFireAfter(const ScheduleRule& rule, time_t after) const {
+  int wday0;
+  time_t day0 = startOfDay(after, wday0);
+  time_t offset = rule.hour * 3600 + rule.minute * 60;
+
+  for (int d = 0; d < MAX_SEARCH_DAYS; d++) {
+    time_t candidate = day0 + d * SECONDS_PER_DAY + offset;
+    if (candidate <= after) {
+      continue;
+    }
+    if (matchesDay(rule, candidate, (wday0 + d) % 7)) {
+      return candidate;
+    }
+  }
+  return 0;
+}
+
+/**
+ * ルールの、from〜to の範囲で最も遅い実行時刻（見つからなければ0）
+ */
+time_t ScheduleEngine::latestFireBetween(const ScheduleRule& rule, time_t from, time_t to) const {
+  if (from > to) {
+    return 0;
+  }
+
+  int wday0;
+  time_t day0 = startOfDay(to, wday0);
+  time_t offset = rule.hour * 3600 + rule.minute * 60;
+
+  for (int d = 0; ; d++) {
+    time_t candidate = day0 - d * SECONDS_PER_DAY + offset;
+    if (candidate < from) {
+      return 0;
+    }
+    if (candidate > to) {
+      continue;
+    }
+    if (matchesDay(rule, candidate, ((wday0 - d) % 7 + 7) % 7)) {
+      return candidate;
+    }
+  }
+}
+
+/**
+ * 実行時刻候補がルールの曜日・月に一致するか
+ */
+bool ScheduleEngine::matchesDay(const ScheduleRule& rule, time_t candidate, int wday) const {
+  if (!(rule.daysOfWeek & (1u << wday))) {
+    return false;
+  }
+  struct tm local;
+  localtime_r(&candidate, &local);
+  return (rule.months & Schedule::monthBit(local.tm_mon + 1)) != 0;
+}
+
+/**
+ * 指定時刻を含む日の0時（ローカル時刻）と曜日
+ */
+time_t ScheduleEngine::startOfDay(time_t t, int& wday) {
+  struct tm local;
+  localtime_r(&t, &local);
+  wday = local.tm_wday;
+  return t - (local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec);
+}
+
+/**
+ * エポック秒をローカル時刻で表示
+ */
+void ScheduleEngine::printEpoch(const char* label, time_t t) {
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+  struct tm local;
+  localtime_r(&t, &local);
+  LOG_I("%s %04d/%02d/%02d %02d:%02d", label,
+        local.tm_year + 1900, local.tm_mon + 1, local.tm_mday,
+        local.tm_hour, local.tm_min);
+#else
+  (void)label;
+  (void)t;
+#endif
+}
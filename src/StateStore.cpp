@@ -0,0 +1,213 @@
+/**
+ * StateStore.cpp
+ *
+ * 再起動をまたいで引き継ぐ状態の保存領域の実装
+ */
+
+#include "StateStore.h"
+#include "Log.h"
+#include <Preferences.h>
+#include <atomic>
+
+/**
+ * RTCメモリの記録（2つの枠に交互に書き込む）
+ * 書き込み中は magic を消しておき、内容とチェックサムを書き終えてから magic を書きます。
+ * 途中でリセットされた枠は無効になり、もう一方の枠（1つ前の記録）から復元されます。
+ * NVSには最新の枠をそのまま（データの大きさ分だけ）保存します。
+ */
+namespace StateJournal {
+  const char* KEY = "state";
+  constexpr uint32_t MAGIC = 0x53544A31;  // "STJ1"
+  constexpr uint8_t SLOTS = 2;
+
+  struct Slot {
+    uint32_t magic;
+    uint32_t sequence;   // 通し番号（大きい方が新しい）
+    uint16_t version;    // 呼び出し側の構造体の版数
+    uint16_t size;       // データの大きさ
+    uint32_t checksum;   // sequence〜size とデータのチェックサム
+    uint8_t data[StateStore::MAX_BYTES];
+  };
+
+  RTC_NOINIT_ATTR Slot slots[SLOTS];
+
+  // FNV-1a ハッシュ
+  uint32_t hash(const uint8_t* data, size_t length, uint32_t seed = 2166136261u) {
+    uint32_t h = seed;
+    for (size_t i = 0; i < length; i++) {
+      h ^= data[i];
+      h *= 16777619u;
+    }
+    return h;
+  }
+
+  uint32_t checksumOf(const Slot& slot) {
+    uint32_t h = hash(reinterpret_cast<const uint8_t*>(&slot.sequence),
+                      offsetof(Slot, checksum) - offsetof(Slot, sequence));
+    return hash(slot.data, slot.size, h);
+  }
+
+  bool isValid(const Slot& slot, uint16_t version, size_t size) {
+    // 電源投入直後のRTCメモリは不定のため、大きさを確かめてからチェックサムを計算する
+    return slot.magic == MAGIC && slot.version == version && slot.size == size &&
+           slot.checksum == checksumOf(slot);
+  }
+
+  size_t bytesOf(const Slot& slot) {
+    return offsetof(Slot, data) + slot.size;
+  }
+
+  // 書き込みの順序を保つ（magic を消す → 内容 → magic の順をコンパイラーに入れ替えさせない）
+  void barrier() {
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+  }
+}
+
+StateStore::StateStore(const char* nvsNamespace, uint16_t version, unsigned long nvsIntervalMs)
+  : nvsNamespace_(nvsNamespace),
+    version_(version),
+    nvsIntervalMs_(nvsIntervalMs),
+    activeSlot_(0),
+    sequence_(0),
+    lastNvsWrite_(0),
+    nvsPending_(false),
+    durablePending_(false),
+    restoreSource_(Source::NONE),
+    stats_() {
+}
+
+/**
+ * 保存した状態を読み込む
+ */
+StateStore::Source StateStore::restore(void* data, size_t size) {
+  using namespace StateJournal;
+
+  unsigned long start = micros();
+  restoreSource_ = Source::NONE;
+  if (size > MAX_BYTES) {
+    LOG_E("[State] 保存する状態が大きすぎます: %u バイト", (unsigned)size);
+    return restoreSource_;
+  }
+
+  // RTCメモリ: 有効な枠のうち新しい方
+  int newest = -1;
+  for (uint8_t i = 0; i < SLOTS; i++) {
+    if (!isValid(slots[i], version_, size)) {
+      continue;
+    }
+    if (newest < 0 || (int32_t)(slots[i].sequence - slots[newest].sequence) > 0) {
+      newest = i;
+    }
+  }
+
+  if (newest >= 0) {
+    restoreSource_ = Source::RTC;
+    nvsPending_ = true;  // 前回の起動でNVSに書き込む前の変化があるかもしれない
+  } else {
+    // NVS: 枠0に読み込む（もう一方の枠は無効にしておく）
+    slots[1].magic = 0;
+    Preferences prefs;
+    if (prefs.begin(nvsNamespace_, true)) {
+      size_t length = prefs.getBytes(KEY, &slots[0], sizeof(Slot));
+      prefs.end();
+      if (length == offsetof(Slot, data) + size && isValid(slots[0], version_, size)) {
+        newest = 0;
+        restoreSource_ = Source::NVS;
+      } else {
+        slots[0].magic = 0;
+      }
+    }
+  }
+
+  if (newest >= 0) {
+    memcpy(data, slots[newest].data, size);
+    activeSlot_ = (uint8_t)newest;
+    sequence_ = slots[newest].sequence;
+  }
+
+  stats_.restoreUs = micros() - start;
+  return restoreSource_;
+}
+
+/**
+ * 状態を記録
+ */
+void StateStore::commit(const void* data, size_t size, bool durable) {
+  using namespace StateJournal;
+
+  if (size > MAX_BYTES) {
+    return;
+  }
+
+  const Slot& current = slots[activeSlot_];
+  bool unchanged = sequence_ != 0 && current.size == size && memcmp(current.data, data, size) == 0;
+  if (!unchanged) {
+    // 古い方の枠に書き込む（最新の枠はそのまま残す）
+    uint8_t next = sequence_ == 0 ? 0 : (uint8_t)(activeSlot_ ^ 1);
+    Slot& slot = slots[next];
+    slot.magic = 0;
+    barrier();
+    slot.sequence = sequence_ + 1;
+    slot.version = version_;
+    slot.size = (uint16_t)size;
+    memcpy(slot.data, data, size);
+    slot.checksum = checksumOf(slot);
+    barrier();
+    slot.magic = MAGIC;
+
+    activeSlot_ = next;
+    sequence_ = slot.sequence;
+    nvsPending_ = true;
+    durablePending_ = durablePending_ || durable;
+    stats_.commits++;
+  }
+
+  // NVS: 重要な変化はすぐに、それ以外は nvsIntervalMs_ ごとにまとめて書き込む
+  if (!nvsPending_) {
+    return;
+  }
+  if (!durablePending_ && millis() - lastNvsWrite_ < nvsIntervalMs_) {
+    return;
+  }
+  lastNvsWrite_ = millis();
+  if (writeNvs(activeSlot_)) {
+    nvsPending_ = false;
+    durablePending_ = false;
+  }
+}
+
+/**
+ * 指定した枠をNVSに書き込む
+ * NVSは1件の書き込みが途中で中断されても前回の値が残り、書き込み先のページも分散されます。
+ * 失敗した場合は次回の commit() で再試行します（重要な変化は次回すぐに、それ以外は nvsIntervalMs_ 後）。
+ */
+bool StateStore::writeNvs(uint8_t slot) {
+  using namespace StateJournal;
+
+  const Slot& record = slots[slot];
+  size_t bytes = bytesOf(record);
+
+  Preferences prefs;
+  bool ok = prefs.begin(nvsNamespace_, false) && prefs.putBytes(KEY, &record, bytes) == bytes;
+  prefs.end();
+
+  if (!ok) {
+    stats_.nvsFailures++;
+    LOG_W("[State] NVSへの保存失敗");
+    return false;
+  }
+  stats_.nvsWrites++;
+  LOG_D("[State] NVSに保存: #%lu（%u バイト）", (unsigned long)record.sequence, (unsigned)bytes);
+  return true;
+}
+
+/**
+ * 復元元の名前
+ */
+const char* StateStore::sourceName(Source source) {
+  switch (source) {
+    case Source::RTC: return "rtc";
+    case Source::NVS: return "nvs";
+    default:          return "none";
+  }
+}
@@ -0,0 +1,418 @@
+/**
+ * TelemetryBuffer.cpp
+ *
+ * テレメトリ蓄積送信クラスの実装
+ */
+
+#include "TelemetryBuffer.h"
+#include <WiFi.h>
+#include <LittleFS.h>
+#include "Log.h"
+
+namespace {
+  const char* SEGMENT_DIR = "/tlm";
+  constexpr uint8_t MAGIC = 'T';
+  constexpr uint8_t FORMAT_VERSION = '1';
+  constexpr uint8_t FIELD_COUNT = 5;        // 時刻, 温度, 湿度, DI, モード
+
+  /**
+   * 符号付き整数をzigzag符号化した可変長整数で書き込む
+   * @return 書き込んだバイト数（最大5）
+   */
+  size_t putVarint(uint8_t* out, int32_t value) {
+    uint32_t v = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    size_t n = 0;
+    while (v >= 0x80) {
+      out[n++] = (uint8_t)(v | 0x80);
+      v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+  }
+}
+
+/**
+ * コンストラクタ
+ */
+TelemetryBuffer::TelemetryBuffer(HttpSession& http, TimeManager& timeManager, const char* path)
+  : http_(http),
+    timeManager_(timeManager),
+    path_(path),
+    count_(0),
+    segmentStartMs_(0),
+    mounted_(false),
+    headSeq_(0),
+    tailSeq_(0),
+    storedRecords_(0),
+    storedBytes_(0),
+    flushIntervalMs_(60000),
+    nextUploadMs_(0),
+    lastDrainMs_(0),
+    backoffMs_(BACKOFF_BASE_MS),
+    stats_() {
+}
+
+/**
+ * フラッシュをマウントし、蓄積済みのセグメントを確認
+ */
+bool TelemetryBuffer::begin() {
+  // 初回（未フォーマット）はフォーマットしてからマウント
+  if (!LittleFS.begin(true)) {
+    LOG_E("[Telemetry] フラッシュのマウントに失敗しました（蓄積なしで動作）");
+    return false;
+  }
+  mounted_ = true;
+
+  if (!LittleFS.exists(SEGMENT_DIR)) {
+    LittleFS.mkdir(SEGMENT_DIR);
+  }
+
+  // 蓄積済みのセグメントの番号の範囲・件数・バイト数を求める（壊れたファイルは削除）
+  bool found = false;
+  uint32_t minSeq = 0;
+  uint32_t maxSeq = 0;
+  File dir = LittleFS.open(SEGMENT_DIR);
+  File file = dir.openNextFile();
+  while (file) {
+    const char* name = file.name();
+    const char* slash = strrchr(name, '/');
+    uint32_t seq = strtoul(slash != nullptr ? slash + 1 : name, nullptr, 16);
+    size_t size = file.size();
+
+    uint8_t header[HEADER_BYTES];
+    bool valid = size > HEADER_BYTES &&
+                 file.read(header, HEADER_BYTES) == HEADER_BYTES &&
+                 header[0] == MAGIC && header[1] == FORMAT_VERSION && header[2] > 0;
+    file.close();
+
+    if (valid) {
+      storedRecords_ += header[2];
+      storedBytes_ += size;
+      if (!found || seq < minSeq) minSeq = seq;
+      if (!found || seq > maxSeq) maxSeq = seq;
+      found = true;
+    } else {
+      char path[24];
+      segmentPath(seq, path, sizeof(path));
+      LittleFS.remove(path);
+      LOG_W("[Telemetry] 壊れたセグメントを削除: %s", path);
+    }
+    file = dir.openNextFile();
+  }
+  dir.close();
+
+  if (found) {
+    headSeq_ = minSeq;
+    tailSeq_ = maxSeq + 1;
+    LOG_I("[Telemetry] 未送信のセグメント: %lu件（%lu レコード, %lu バイト）",
+          (unsigned long)getStoredSegments(), (unsigned long)storedRecords_,
+          (unsigned long)storedBytes_);
+  }
+  return true;
+}
+
+/**
+ * センサー値を追加
+ */
+void TelemetryBuffer::add(const SensorData& data, ACMode mode) {
+  if (!data.isValid) {
+    return;
+  }
+  // update() が呼ばれずに一杯になった場合
+  if (count_ >= SEGMENT_RECORDS) {
+    seal();
+  }
+  if (count_ == 0) {
+    segmentStartMs_ = millis();
+  }
+
+  TelemetryRecord& record = records_[count_++];
+  record.time = (uint32_t)timeManager_.epoch();
+  record.temperature = data.temperature;  // SensorData も同じ1/100単位
+  record.humidity = (uint16_t)data.humidity;
+  record.discomfortIndex = data.discomfortIndex;
+  record.mode = (uint8_t)mode;
+  stats_.recordsAdded++;
+}
+
+/**
+ * 送信・蓄積・バックフィルを進める
+ */
+void TelemetryBuffer::update() {
+  // セグメントが一杯になったら、送信または蓄積
+  // 接続中は件数が少なくても flushInterval ごとに送信
+  // 切断中は一杯になるか MAX_HOLD_MS 経つまで書き込まない（読み取り間隔が長い時にRAMだけに長く残さない）
+  unsigned long heldMs = millis() - segmentStartMs_;
+  if (count_ >= SEGMENT_RECORDS ||
+      (count_ > 0 && canUpload() && heldMs >= flushIntervalMs_) ||
+      (count_ > 0 && heldMs >= MAX_HOLD_MS)) {
+    seal();
+  }
+
+  // 蓄積済みのセグメントを古い順に送信
+  // 1回のPOSTごとに DRAIN_INTERVAL_MS 空けて、loop()の他の処理を止め続けないようにする
+  if (getStoredSegments() > 0 && WiFi.isConnected() &&
+      (long)(millis() - nextUploadMs_) >= 0 &&
+      millis() - lastDrainMs_ >= DRAIN_INTERVAL_MS) {
+    lastDrainMs_ = millis();
+    drainStored();
+  }
+}
+
+/**
+ * RAM上のセグメントを直接送信できるか
+ * 蓄積済みのセグメントがある間は、順序を保つため蓄積側に回す
+ */
+bool TelemetryBuffer::canUpload() const {
+  return WiFi.isConnected() && getStoredSegments() == 0 &&
+         (long)(millis() - nextUploadMs_) >= 0;
+}
+
+/**
+ * RAM上のレコードを圧縮してセグメントにし、送信または蓄積する
+ */
+void TelemetryBuffer::seal() {
+  uint8_t records = count_;
+  size_t length = encodeSegment(batch_);
+  count_ = 0;
+
+  if (canUpload() && upload(batch_, length, records)) {
+    return;
+  }
+  spill(batch_, length, records);
+}
+
+/**
+ * RAM上のレコードをセグメント形式で書き込む
+ * @return 書き込んだバイト数（最大 HEADER_BYTES + SEGMENT_RECORDS × 25）
+ */
+size_t TelemetryBuffer::encodeSegment(uint8_t* out) {
+  size_t pos = 0;
+  out[pos++] = MAGIC;
+  out[pos++] = FORMAT_VERSION;
+  out[pos++] = count_;
+
+  int32_t previous[FIELD_COUNT] = {0, 0, 0, 0, 0};
+  for (uint8_t i = 0; i < count_; i++) {
+    const TelemetryRecord& record = records_[i];
+    int32_t values[FIELD_COUNT] = {
+      (int32_t)record.time, record.temperature, record.humidity, record.discomfortIndex, record.mode
+    };
+    for (uint8_t k = 0; k < FIELD_COUNT; k++) {
+      // 時刻の差分がint32を超えても復号側で同じ値に戻るよう、符号なしで引く
+      pos += putVarint(out + pos, (int32_t)((uint32_t)values[k] - (uint32_t)previous[k]));
+      previous[k] = values[k];
+    }
+  }
+  return pos;
+}
+
+/**
+ * セグメントをフラッシュに1ファイルとして書き込む
+ */
+void TelemetryBuffer::spill(const uint8_t* data, size_t length, uint8_t records) {
+  if (!mounted_) {
+    stats_.recordsDropped += records;
+    return;
+  }
+
+  if (getStoredSegments() >= MAX_SEGMENTS) {
+    dropOldest();
+  }
+
+  char path[24];
+  segmentPath(tailSeq_, path, sizeof(path));
+  File file = LittleFS.open(path, FILE_WRITE);
+  if (!file || file.write(data, length) != length) {
+    if (file) {
+      file.close();
+      LittleFS.remove(path);
+    }
+    stats_.recordsDropped += records;
+    LOG_E("[Telemetry] フラッシュへの書き込みに失敗: %s", path);
+    return;
+  }
+  file.close();
+
+  tailSeq_++;
+  storedRecords_ += records;
+  storedBytes_ += length;
+  stats_.segmentsWritten++;
+  LOG_D("[Telemetry] セグメントを蓄積: %s（%u レコード, %u バイト）",
+        path, (unsigned)records, (unsigned)length);
+}
+
+/**
+ * 最も古いセグメントを削除（蓄積の上限に達した場合）
+ */
+void TelemetryBuffer::dropOldest() {
+  char path[24];
+  segmentPath(headSeq_, path, sizeof(path));
+
+  uint8_t header[HEADER_BYTES] = {0, 0, 0};
+  size_t size = 0;
+  File file = LittleFS.open(path, FILE_READ);
+  if (file) {
+    size = file.size();
+    file.read(header, HEADER_BYTES);
+    file.close();
+  }
+  LittleFS.remove(path);
+  headSeq_++;
+
+  forget(size, header[2]);
+  stats_.recordsDropped += header[2];
+  LOG_W("[Telemetry] 蓄積が上限に達したため、最も古いセグメントを削除（%u レコード）",
+        (unsigned)header[2]);
+}
+
+/**
+ * 蓄積済みのセグメントを送信バッファに収まるだけまとめて送信し、成功したら削除
+ */
+void TelemetryBuffer::drainStored() {
+  size_t length = 0;
+  uint32_t records = 0;
+  uint32_t seq = headSeq_;
+  bool lostCount = false;   // 件数の分からないセグメントを削除した
+  char path[24];
+
+  while (seq != tailSeq_) {
+    segmentPath(seq, path, sizeof(path));
+    File file = LittleFS.open(path, FILE_READ);
+    if (!file) {
+      // 削除済み（前回の送信後の削除が中断された場合など）
+      seq++;
+      continue;
+    }
+    size_t size = file.size();
+    if (length + size > BATCH_SIZE) {
+      file.close();
+      break;
+    }
+    size_t read = file.read(batch_ + length, size);
+    file.close();
+
+    if (read != size || size <= HEADER_BYTES || batch_[length] != MAGIC) {
+      LOG_W("[Telemetry] 読み取れないセグメントを削除: %s", path);
+      LittleFS.remove(path);
+      // ヘッダーが読めれば件数も差し引く（読めなければ後で残りのセグメントから数え直す）
+      if (read >= HEADER_BYTES && batch_[length] == MAGIC && batch_[length + 1] == FORMAT_VERSION) {
+        forget(size, batch_[length + 2]);
+        stats_.recordsDropped += batch_[length + 2];
+      } else {
+        forget(size, 0);
+        lostCount = true;
+      }
+      seq++;
+      continue;
+    }
+    records += batch_[length + 2];
+    length += size;
+    seq++;
+  }
+
+  if (lostCount) {
+    recount();
+  }
+
+  if (length == 0) {
+    headSeq_ = seq;
+    return;
+  }
+
+  if (!upload(batch_, length, records)) {
+    return;
+  }
+
+  // 送信済みのセグメントを削除
+  for (uint32_t s = headSeq_; s != seq; s++) {
+    segmentPath(s, path, sizeof(path));
+    LittleFS.remove(path);
+  }
+  headSeq_ = seq;
+  forget(length, records);
+
+  if (getStoredSegments() == 0) {
+    LOG_I("[Telemetry] 蓄積していたテレメトリの送信が完了しました");
+  }
+}
+
+/**
+ * 収集サーバーへPOST
+ * @return true: 2xx, false: 失敗（バックオフして再試行）
+ */
+bool TelemetryBuffer::upload(const uint8_t* body, size_t length, uint32_t records) {
+  unsigned long startMs = millis();
+  int status = http_.post(path_, "application/octet-stream", body, length);
+  unsigned long elapsedMs = millis() - startMs;
+
+  if (status < 200 || status >= 300) {
+    stats_.uploadFailures++;
+    LOG_W("[Telemetry] 送信失敗 (%d) - %lu秒後に再試行", status, backoffMs_ / 1000);
+    nextUploadMs_ = millis() + backoffMs_;
+    backoffMs_ *= 2;
+    if (backoffMs_ > BACKOFF_MAX_MS) {
+      backoffMs_ = BACKOFF_MAX_MS;
+    }
+    return false;
+  }
+
+  unsigned long divisorMs = elapsedMs > 0 ? elapsedMs : 1;
+  stats_.uploads++;
+  stats_.recordsSent += records;
+  stats_.bytesSent += length;
+  stats_.rawBytesSent += records * sizeof(TelemetryRecord);
+  stats_.lastUploadMs = elapsedMs;
+  stats_.lastBytesPerSec = (uint32_t)((uint64_t)length * 1000 / divisorMs);
+  stats_.lastRecordsPerSec = (uint32_t)((uint64_t)records * 1000 / divisorMs);
+
+  backoffMs_ = BACKOFF_BASE_MS;
+  nextUploadMs_ = millis();
+  LOG_D("[Telemetry] %lu レコードを送信（%u バイト, %lu ms）",
+        (unsigned long)records, (unsigned)length, elapsedMs);
+  return true;
+}
+
+/**
+ * 蓄積量の集計から差し引く
+ */
+void TelemetryBuffer::forget(size_t bytes, uint32_t records) {
+  storedBytes_ = storedBytes_ > bytes ? storedBytes_ - bytes : 0;
+  storedRecords_ = storedRecords_ > records ? storedRecords_ - records : 0;
+  if (getStoredSegments() == 0) {
+    storedBytes_ = 0;
+    storedRecords_ = 0;
+  }
+}
+
+/**
+ * 蓄積量の集計をフラッシュ上のセグメントから数え直す（件数の分からないセグメントを削除した場合）
+ */
+void TelemetryBuffer::recount() {
+  uint32_t records = 0;
+  uint32_t bytes = 0;
+  char path[24];
+  for (uint32_t seq = headSeq_; seq != tailSeq_; seq++) {
+    segmentPath(seq, path, sizeof(path));
+    File file = LittleFS.open(path, FILE_READ);
+    if (!file) {
+      continue;
+    }
+    uint8_t header[HEADER_BYTES];
+    if (file.read(header, HEADER_BYTES) == HEADER_BYTES &&
+        header[0] == MAGIC && header[1] == FORMAT_VERSION) {
+      records += header[2];
+    }
+    bytes += file.size();
+    file.close();
+  }
+  storedRecords_ = records;
+  storedBytes_ = bytes;
+}
+
+/**
+ * セグメントのファイル名（番号の16進表記。名前順 = 書き込み順）
+ */
+void TelemetryBuffer::segmentPath(uint32_t seq, char* path, size_t size) {
+  snprintf(path, size, "%s/%08lx", SEGMENT_DIR, (unsigned long)seq);
+}
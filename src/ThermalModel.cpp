@@ -0,0 +1,301 @@
+/**
+ * ThermalModel.cpp
+ *
+ * 部屋の熱モデルのオンライン学習と予測の実装
+ */
+
+#include "ThermalModel.h"
+#include "ComfortIndex.h"
+#include "Log.h"
+
+namespace {
+  constexpr float FORGETTING = 0.998f;          // 忘却係数（10分区間で約3日分の重み）
+  constexpr float INITIAL_COVARIANCE = 100.0f;  // 初期の誤差共分散（係数が分からない状態）
+  constexpr float MAX_COVARIANCE_TRACE = 1.0e4f; // 誤差共分散の上限（同じモードが続いても発散させない）
+  constexpr float ERROR_ALPHA = 0.1f;           // 予測誤差の指数移動平均の重み
+  constexpr uint32_t MIN_SAMPLES = 18;          // 予測に使うまでのサンプル数（10分区間で3時間）
+  constexpr uint32_t MIN_HORIZON_CHECKS = 3;    // 同じく予測時間先の答え合わせの回数
+  constexpr float MAX_HORIZON_ERROR_C = 0.5f;   // 予測に使う予測誤差の上限（℃）
+  constexpr uint32_t PREDICT_STEP_SEC = 300;    // 予測の積分の刻み（秒）
+
+  // 外気温の日変化（最低・最高になる時刻）
+  constexpr float COLDEST_HOUR = 5.0f;
+  constexpr float WARMEST_HOUR = 14.0f;
+
+  /**
+   * どれだけ強く冷やすモードか（自動 < 除湿 < 冷房、停止・不明は-1）
+   */
+  int coolingLevel(ACMode mode) {
+    switch (mode) {
+      case ACMode::AUTO_PLUS_1:       return 0;
+      case ACMode::DEHUMID_MINUS_1_5: return 1;
+      case ACMode::COOLING_20:        return 2;
+      default:                        return -1;
+    }
+  }
+
+  /**
+   * 飽和水蒸気圧（hPa、Magnusの式）
+   */
+  float saturationPressure(float temperature) {
+    return 6.112f * expf(17.62f * temperature / (243.12f + temperature));
+  }
+}
+
+/**
+ * コンストラクタ
+ */
+ThermalModel::ThermalModel(uint32_t sampleIntervalSec, uint32_t horizonSec)
+  : sampleMs_(sampleIntervalSec * 1000),
+    horizonSec_(horizonSec) {
+  reset();
+}
+
+/**
+ * 学習した係数を捨てて初期状態に戻す
+ */
+void ThermalModel::reset() {
+  for (uint8_t i = 0; i < PARAMS; i++) {
+    theta_[i] = 0.0f;
+    for (uint8_t j = 0; j < PARAMS; j++) {
+      p_[i][j] = (i == j) ? INITIAL_COVARIANCE : 0.0f;
+    }
+  }
+  hasStart_ = false;
+  hasPending_ = false;
+  stats_ = ThermalStats();
+}
+
+/**
+ * 学習した状態を取得
+ */
+void ThermalModel::save(Snapshot& out) const {
+  memcpy(out.theta, theta_, sizeof(theta_));
+  memcpy(out.p, p_, sizeof(p_));
+  out.stats = stats_;
+}
+
+/**
+ * 保存した学習の状態を復元
+ */
+bool ThermalModel::restore(const Snapshot& snapshot) {
+  for (uint8_t i = 0; i < PARAMS; i++) {
+    if (!isfinite(snapshot.theta[i])) {
+      return false;
+    }
+    for (uint8_t j = 0; j < PARAMS; j++) {
+      if (!isfinite(snapshot.p[i][j])) {
+        return false;
+      }
+    }
+  }
+  memcpy(theta_, snapshot.theta, sizeof(theta_));
+  memcpy(p_, snapshot.p, sizeof(p_));
+  stats_ = snapshot.stats;
+  hasStart_ = false;
+  hasPending_ = false;
+  return true;
+}
+
+/**
+ * センサー値を渡して学習
+ */
+void ThermalModel::update(unsigned long nowMs, int16_t centiTemperature, ACMode mode,
+                          float outdoorNow, float outdoorLater) {
+  float temperature = Fixed::toFloat(centiTemperature);
+
+  // 予測時間先の予測の答え合わせ（途中でモードが変わった予測は前提が違うため捨てる）
+  if (hasPending_ && mode != pendingMode_) {
+    hasPending_ = false;
+  }
+  if (hasPending_ && nowMs - pendingMs_ >= horizonSec_ * 1000UL) {
+    float error = temperature - pendingTemperature_;
+    stats_.horizonErrorC = stats_.horizonChecks == 0
+      ? fabsf(error)
+      : sqrtf((1.0f - ERROR_ALPHA) * stats_.horizonErrorC * stats_.horizonErrorC + ERROR_ALPHA * error * error);
+    stats_.horizonChecks++;
+    hasPending_ = false;
+  }
+
+  if (!hasStart_) {
+    restart(nowMs, temperature, mode, outdoorNow);
+    return;
+  }
+  if (mode == ACMode::NONE || mode != startMode_) {
+    // モードが変わった区間は、どちらのモードの効果か分けられないため捨てる
+    stats_.skipped++;
+    restart(nowMs, temperature, mode, outdoorNow);
+    return;
+  }
+  unsigned long elapsedMs = nowMs - startMs_;
+  if (elapsedMs < sampleMs_) {
+    return;
+  }
+
+  // 区間の平均の変化率（℃/時）を、区間の始点の状態で説明する
+  float hours = elapsedMs / 3600000.0f;
+  float x[PARAMS];
+  regressors(startTemperature_, mode, (startOutdoor_ + outdoorNow) * 0.5f, x);
+  learn(x, (temperature - startTemperature_) / hours, hours);
+  restart(nowMs, temperature, mode, outdoorNow);
+
+  if (!hasPending_ && stats_.samples >= MIN_SAMPLES) {
+    pendingTemperature_ = predict(temperature, mode, outdoorNow, outdoorLater, horizonSec_);
+    pendingMs_ = nowMs;
+    pendingMode_ = mode;
+    hasPending_ = true;
+  }
+}
+
+/**
+ * 予測に使えるだけ学習したか
+ */
+bool ThermalModel::isReady() const {
+  return stats_.samples >= MIN_SAMPLES &&
+         stats_.horizonChecks >= MIN_HORIZON_CHECKS &&
+         stats_.horizonErrorC <= MAX_HORIZON_ERROR_C;
+}
+
+/**
+ * 同じモードを続けた場合の室温を予測（外気温は現在から horizonSec_ 後まで直線で補間）
+ */
+float ThermalModel::predict(float temperature, ACMode mode, float outdoorNow, float outdoorLater,
+                            uint32_t seconds) const {
+  float t = temperature;
+  uint32_t elapsed = 0;
+  while (elapsed < seconds) {
+    uint32_t step = seconds - elapsed < PREDICT_STEP_SEC ? seconds - elapsed : PREDICT_STEP_SEC;
+    float ratio = horizonSec_ > 0 ? (elapsed + step * 0.5f) / horizonSec_ : 0.0f;
+    float outdoor = outdoorNow + (outdoorLater - outdoorNow) * ratio;
+    float x[PARAMS];
+    regressors(t, mode, outdoor, x);
+    float rate = 0.0f;
+    for (uint8_t i = 0; i < PARAMS; i++) {
+      rate += theta_[i] * x[i];
+    }
+    t += rate * (step / 3600.0f);
+    elapsed += step;
+  }
+  return t;
+}
+
+/**
+ * 予測した室温でもう一度モードを判定
+ */
+ACMode ThermalModel::anticipate(AirConditionerController& ac, ACMode reactive,
+                                int16_t centiTemperature, int16_t centiHumidity,
+                                ACMode current, float outdoorNow, float outdoorLater) {
+  if (!isReady()) {
+    return reactive;
+  }
+  float temperature = Fixed::toFloat(centiTemperature);
+  float humidity = Fixed::toFloat(centiHumidity);
+  float predicted = predict(temperature, current, outdoorNow, outdoorLater, horizonSec_);
+  if (predicted <= temperature) {
+    return reactive;
+  }
+
+  // 水蒸気の量は変わらないとして、室温が上がった時の相対湿度を求める
+  // 判定はセンサー値と同じ固定小数点に戻して、現在の室温と同じ閾値・丸めで行う
+  int16_t aheadTemperature = Fixed::fromFloat(predicted);
+  int16_t aheadHumidity = Fixed::fromFloat(humidity * saturationPressure(temperature) / saturationPressure(predicted));
+  ACMode ahead = ac.determineOptimalMode(aheadTemperature, aheadHumidity);
+  if (coolingLevel(ahead) <= coolingLevel(reactive)) {
+    return reactive;
+  }
+
+  stats_.anticipations++;
+  LOG_I("[Thermal] %lu分後の予測 %s℃（DI %s）→ %s を先に選択",
+        (unsigned long)(horizonSec_ / 60), Fixed::Text(aheadTemperature, 1).c_str(),
+        Fixed::Text(Comfort::discomfortIndex(aheadTemperature, aheadHumidity), 1).c_str(),
+        AirConditionerController::modeToKey(ahead));
+  return ahead;
+}
+
+/**
+ * 天気予報の最高・最低気温から外気温を推定
+ * 5時→14時は最低から最高へ、14時→翌5時は最高から最低へ、それぞれ余弦曲線で変化させます。
+ */
+float ThermalModel::outdoorTemperature(float tempMax, float tempMin, float hour) {
+  hour = fmodf(hour, 24.0f);
+  float rising = WARMEST_HOUR - COLDEST_HOUR;
+  float phase;  // 0: 最低、1: 最高
+  if (hour >= COLDEST_HOUR && hour < WARMEST_HOUR) {
+    phase = (1.0f - cosf((float)M_PI * (hour - COLDEST_HOUR) / rising)) * 0.5f;
+  } else {
+    float sinceWarmest = hour >= WARMEST_HOUR ? hour - WARMEST_HOUR : hour + 24.0f - WARMEST_HOUR;
+    phase = (1.0f + cosf((float)M_PI * sinceWarmest / (24.0f - rising))) * 0.5f;
+  }
+  return tempMin + (tempMax - tempMin) * phase;
+}
+
+/**
+ * 説明変数（外気との差、モードごとの指示変数、定数項）
+ */
+void ThermalModel::regressors(float temperature, ACMode mode, float outdoor, float (&x)[PARAMS]) const {
+  x[0] = outdoor - temperature;
+  x[1] = mode == ACMode::COOLING_20 ? 1.0f : 0.0f;
+  x[2] = mode == ACMode::DEHUMID_MINUS_1_5 ? 1.0f : 0.0f;
+  x[3] = mode == ACMode::AUTO_PLUS_1 ? 1.0f : 0.0f;
+  x[4] = 1.0f;
+}
+
+/**
+ * 逐次最小二乗法で係数を更新（忘却係数つき）
+ * @param y 区間の室温の変化率（℃/時）
+ * @param hours 区間の長さ（時間、予測誤差を℃に換算するため）
+ */
+void ThermalModel::learn(const float (&x)[PARAMS], float y, float hours) {
+  // 更新前の係数での予測誤差
+  float error = y;
+  for (uint8_t i = 0; i < PARAMS; i++) {
+    error -= theta_[i] * x[i];
+  }
+
+  // ゲイン K = P x / (λ + xᵀ P x)
+  float px[PARAMS];
+  float denom = FORGETTING;
+  for (uint8_t i = 0; i < PARAMS; i++) {
+    px[i] = 0.0f;
+    for (uint8_t j = 0; j < PARAMS; j++) {
+      px[i] += p_[i][j] * x[j];
+    }
+    denom += x[i] * px[i];
+  }
+
+  for (uint8_t i = 0; i < PARAMS; i++) {
+    theta_[i] += px[i] / denom * error;
+  }
+
+  // P = (P - K xᵀ P) / λ（対称性を保つため上三角を計算して写す）
+  // 変化のない方向（使っていないモードなど）の共分散が際限なく増えないよう、上限を超えたら忘却しない
+  float trace = 0.0f;
+  for (uint8_t i = 0; i < PARAMS; i++) {
+    trace += p_[i][i];
+  }
+  float scale = trace < MAX_COVARIANCE_TRACE ? 1.0f / FORGETTING : 1.0f;
+  for (uint8_t i = 0; i < PARAMS; i++) {
+    for (uint8_t j = i; j < PARAMS; j++) {
+      float value = (p_[i][j] - px[i] * px[j] / denom) * scale;
+      p_[i][j] = value;
+      p_[j][i] = value;
+    }
+  }
+
+  float errorC = error * hours;
+  stats_.stepErrorC = stats_.samples == 0
+    ? fabsf(errorC)
+    : sqrtf((1.0f - ERROR_ALPHA) * stats_.stepErrorC * stats_.stepErrorC + ERROR_ALPHA * errorC * errorC);
+  stats_.samples++;
+}
+
+/**
+ * 学習する区間の始点を設定
+ */
+void ThermalModel::restart(unsigned long nowMs, float temperature, ACMode mode, float outdoor) {
+  hasStart_ = true;
+  startMs_ = nowMs;
+  startTemperature_ = temperature;
+  startOutdoor_ = outdoor;
+  startMode_ = mode;
+}
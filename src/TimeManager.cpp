@@ -5,6 +5,26 @@
  */
 
 #include "TimeManager.h"
+#include "Log.h"
+#include <esp_sntp.h>
+
+TimeManager* TimeManager::instance_ = nullptr;
+
+/**
+ * リセット後に時刻を復元するためのRTCメモリ上の記録
+ * ソフトリセット・ディープスリープでは保持され、電源断で失われます。
+ */
+namespace RtcClock {
+  constexpr uint32_t MAGIC = 0x52544331;  // "RTC1"
+
+  struct Record {
+    uint32_t magic;
+    uint32_t epoch;   // 最後に確認した時刻（エポック秒）
+    uint32_t check;   // epochの検査値
+  };
+
+  RTC_NOINIT_ATTR Record record;
+}
 
 /**
  * コンストラクタ
@@ -13,78 +33,191 @@
 TimeManager::TimeManager(const char* ntpServer, long gmtOffsetSec, int daylightOffsetSec)
   : ntpServer_(ntpServer),
     gmtOffsetSec_(gmtOffsetSec),
-    daylightOffsetSec_(daylightOffsetSec) {
+    daylightOffsetSec_(daylightOffsetSec),
+    cached_(),
+    timeValid_(false),
+    baseEpoch_(0),
+    baseMillis_(0),
+    nextMinuteEpoch_(0),
+    lastCheckMillis_(0),
+    source_(TimeSource::NONE),
+    syncCount_(0),
+    lastDriftMs_(0),
+    driftPpm_(0.0f),
+    lastSyncMillis_(0),
+    lastSyncEpochMs_(0),
+    syncCallback_(nullptr),
+    syncContext_(nullptr),
+    syncPending_(false),
+    syncMillis_(0),
+    syncEpochMs_(0) {
 }
 
 /**
- * NTPサーバーから時刻を同期
- * WiFi接続後に呼び出してください。
+ * 初期化
+ * configTime() はSNTPを開始するだけで同期完了を待たないため、ここではブロックしません。
  */
-bool TimeManager::syncTime() {
-  Serial.println("[Time] NTP時刻同期を開始...");
+void TimeManager::begin() {
+  instance_ = this;
+  sntp_set_time_sync_notification_cb(onSntpSync);
+  sntp_set_sync_interval(RESYNC_INTERVAL_MS);
 
-  // NTPサーバーと接続して時刻を設定
-  // configTime(GMTオフセット秒, サマータイムオフセット秒, NTPサーバー)
+  // タイムゾーン設定とSNTP開始（WiFi接続後に自動で同期される）
   configTime(gmtOffsetSec_, daylightOffsetSec_, ntpServer_);
 
-  // 時刻同期が完了するまで待機（最大10秒）
-  int retryCount = 0;
-  struct tm timeinfo;
-  while (!getLocalTime(&timeinfo) && retryCount < 10) {
-    Serial.print(".");
-    delay(1000);
-    retryCount++;
+  // システム時刻がリセットを越えて残っていればそのまま使い、失われていればRTCメモリから復元
+  invalidateCache();
+  if (isTimeValid()) {
+    source_ = TimeSource::RESTORED;
+    LOG_I("[Time] リセット前のシステム時刻を継続");
+    printCurrentTime();
+  } else if (restoreFromRtc()) {
+    source_ = TimeSource::RESTORED;
+    LOG_I("[Time] RTCメモリから時刻を復元（NTP同期待ち）");
+    printCurrentTime();
+  } else {
+    LOG_I("[Time] 時刻未設定（NTP同期待ち）");
   }
+}
 
-  if (retryCount >= 10) {
-    Serial.println("\n[Time] 時刻同期失敗");
-    return false;
+/**
+ * NTP同期をすぐに再実行
+ */
+void TimeManager::startSync() {
+  LOG_I("[Time] NTP時刻同期を開始（バックグラウンド）");
+  configTime(gmtOffsetSec_, daylightOffsetSec_, ntpServer_);
+}
+
+/**
+ * 同期完了の処理
+ */
+void TimeManager::update() {
+  if (!syncPending_) {
+    return;
   }
+  syncPending_ = false;
 
-  // 同期成功：現在の日時を表示
-  Serial.println("\n[Time] 時刻同期成功");
-  printCurrentTime();
+  unsigned long syncMillis = syncMillis_;
+  int64_t syncEpochMs = syncEpochMs_;
 
-  return true;
+  // 前回の同期時刻からmillis()で進めて予測した時刻との差をドリフトとして記録
+  // （システム時刻は同期で既に補正されているため、キャッシュの基準とは比べない）
+  bool firstSync = (source_ != TimeSource::NTP);
+  if (!firstSync) {
+    unsigned long elapsedMs = syncMillis - lastSyncMillis_;
+    int64_t predictedMs = lastSyncEpochMs_ + (int64_t)elapsedMs;
+    lastDriftMs_ = (long)(syncEpochMs - predictedMs);
+    if (elapsedMs != 0) {
+      driftPpm_ = lastDriftMs_ * 1000000.0f / (float)elapsedMs;
+    }
+  }
+
+  source_ = TimeSource::NTP;
+  syncCount_++;
+  lastSyncMillis_ = syncMillis;
+  lastSyncEpochMs_ = syncEpochMs;
+
+  // 時刻が飛んだ可能性があるためキャッシュを作り直す
+  invalidateCache();
+  refresh();
+
+  if (firstSync) {
+    LOG_I("[Time] 時刻同期成功");
+    printCurrentTime();
+  } else {
+    LOG_I("[Time] 再同期: ずれ %ld ms (%.1f ppm)", lastDriftMs_, driftPpm_);
+  }
+
+  if (syncCallback_ != nullptr) {
+    syncCallback_(syncContext_);
+  }
+}
+
+/**
+ * 同期完了時の通知先を設定
+ */
+void TimeManager::onSync(SyncCallback callback, void* context) {
+  syncCallback_ = callback;
+  syncContext_ = context;
+}
+
+/**
+ * SNTP同期完了コールバック（lwIPタスクで実行される）
+ * ここでは値を記録するだけにし、処理はupdate()で行います。
+ */
+void TimeManager::onSntpSync(struct timeval* tv) {
+  TimeManager* self = instance_;
+  if (self == nullptr || tv == nullptr) {
+    return;
+  }
+  self->syncMillis_ = millis();
+  self->syncEpochMs_ = (int64_t)tv->tv_sec * 1000 + tv->tv_usec / 1000;
+  self->syncPending_ = true;
+}
+
+/**
+ * 時刻が有効（NTP同期済み）かどうか
+ */
+bool TimeManager::isTimeValid() {
+  refresh();
+  return timeValid_;
 }
 
 /**
  * 現在の時刻情報を取得
  */
 bool TimeManager::getCurrentTime(struct tm& timeinfo) {
-  return getLocalTime(&timeinfo);
+  refresh();
+  if (!timeValid_) {
+    return false;
+  }
+  timeinfo = cached_;
+  return true;
+}
+
+/**
+ * 現在の時刻情報への参照を取得
+ */
+const struct tm& TimeManager::now() {
+  refresh();
+  return cached_;
+}
+
+/**
+ * 現在のエポック秒を取得
+ */
+time_t TimeManager::epoch() {
+  refresh();
+  if (!timeValid_) {
+    return 0;
+  }
+  return baseEpoch_ + (time_t)((millis() - baseMillis_) / 1000);
 }
 
 /**
  * 現在の時（0-23）を取得
  */
 int TimeManager::getCurrentHour() {
-  struct tm timeinfo;
-  if (!getCurrentTime(timeinfo)) {
-    return -1;  // 取得失敗
-  }
-  return timeinfo.tm_hour;
+  refresh();
+  return cached_.tm_hour;
 }
 
 /**
  * 現在の月（1-12）を取得
  */
 int TimeManager::getCurrentMonth() {
-  struct tm timeinfo;
-  if (!getCurrentTime(timeinfo)) {
-    return -1;  // 取得失敗
-  }
-  return timeinfo.tm_mon + 1;  // tm_monは0-11なので+1する
+  refresh();
+  return cached_.tm_mon + 1;  // tm_monは0-11なので+1する
 }
 
 /**
  * 7〜9月（夏季）かどうかを判定
  */
 bool TimeManager::isSummerSeason() {
-  int month = getCurrentMonth();
-  if (month == -1) {
-    return false;  // 時刻取得失敗時はfalse
+  if (!isTimeValid()) {
+    return false;  // 時刻未同期時はfalse
   }
+  int month = cached_.tm_mon + 1;
   return (month >= 7 && month <= 9);
 }
 
@@ -94,29 +227,119 @@ bool TimeManager::isSummerSeason() {
 void TimeManager::printCurrentTime() {
   struct tm timeinfo;
   if (!getCurrentTime(timeinfo)) {
-    Serial.println("[Time] 時刻取得失敗");
+    LOG_I("[Time] 時刻未同期");
     return;
   }
 
-  Serial.printf("[Time] 現在時刻: %04d/%02d/%02d %02d:%02d:%02d\n",
-                timeinfo.tm_year + 1900,  // 年（1900年からの経過年数）
-                timeinfo.tm_mon + 1,       // 月（0-11なので+1）
-                timeinfo.tm_mday,          // 日
-                timeinfo.tm_hour,          // 時
-                timeinfo.tm_min,           // 分
-                timeinfo.tm_sec);          // 秒
+  LOG_I("[Time] 現在時刻: %04d/%02d/%02d %02d:%02d:%02d",
+        timeinfo.tm_year + 1900,  // 年（1900年からの経過年数）
+        timeinfo.tm_mon + 1,       // 月（0-11なので+1）
+        timeinfo.tm_mday,          // 日
+        timeinfo.tm_hour,          // 時
+        timeinfo.tm_min,           // 分
+        timeinfo.tm_sec);          // 秒
 }
 
 /**
  * フォーマットされた日時文字列を取得
  */
 String TimeManager::getFormattedTime(const char* format) {
-  struct tm timeinfo;
-  if (!getCurrentTime(timeinfo)) {
-    return "";  // 時刻取得失敗時は空文字列を返す
+  refresh();
+  if (!timeValid_) {
+    return "";  // 時刻未同期時は空文字列を返す
   }
 
   char buffer[64];
-  strftime(buffer, sizeof(buffer), format, &timeinfo);
+  strftime(buffer, sizeof(buffer), format, &cached_);
   return String(buffer);
 }
+
+/**
+ * キャッシュを破棄
+ */
+void TimeManager::invalidateCache() {
+  timeValid_ = false;
+  lastCheckMillis_ = millis() - INVALID_RETRY_MS;  // 次回アクセスで即座に読み直す
+}
+
+/**
+ * キャッシュを現在時刻に進める（O(1)、ブロックしない）
+ * 分の境界をまたいだ時だけシステム時刻から暦を作り直します。
+ */
+void TimeManager::refresh() {
+  unsigned long nowMillis = millis();
+
+  if (!timeValid_) {
+    // 未同期の間は1秒に1回だけシステム時刻を確認する
+    if (nowMillis - lastCheckMillis_ < INVALID_RETRY_MS) {
+      return;
+    }
+    lastCheckMillis_ = nowMillis;
+    reloadFromSystem();
+    return;
+  }
+
+  time_t nowEpoch = baseEpoch_ + (time_t)((nowMillis - baseMillis_) / 1000);
+  if (nowEpoch >= nextMinuteEpoch_) {
+    reloadFromSystem();
+    return;
+  }
+
+  // 同じ分の中では秒だけを更新
+  int second = (int)(nowEpoch - (nextMinuteEpoch_ - 60));
+  if (second != cached_.tm_sec) {
+    cached_.tm_sec = second;
+    saveToRtc(nowEpoch);
+  }
+}
+
+/**
+ * システム時刻（gettimeofday）から暦を作り直す
+ * getLocalTime() と違い、未同期でも待たずに戻ります。
+ */
+void TimeManager::reloadFromSystem() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  unsigned long nowMillis = millis();
+
+  if (tv.tv_sec < VALID_EPOCH_MIN) {
+    timeValid_ = false;
+    return;
+  }
+
+  localtime_r(&tv.tv_sec, &cached_);
+  baseEpoch_ = tv.tv_sec;
+  baseMillis_ = nowMillis - (unsigned long)(tv.tv_usec / 1000);  // 秒の境界に合わせる
+  nextMinuteEpoch_ = tv.tv_sec - cached_.tm_sec + 60;
+  timeValid_ = true;
+  saveToRtc(tv.tv_sec);
+}
+
+/**
+ * 現在時刻をRTCメモリに記録（RAMへの書き込みのみで軽量）
+ */
+void TimeManager::saveToRtc(time_t epoch) {
+  RtcClock::record.magic = RtcClock::MAGIC;
+  RtcClock::record.epoch = (uint32_t)epoch;
+  RtcClock::record.check = ~(uint32_t)epoch;
+}
+
+/**
+ * RTCメモリに記録した時刻をシステム時刻に設定
+ * リセットにかかった時間（通常1秒未満）は補正されません。NTP同期で正確な時刻に戻ります。
+ */
+bool TimeManager::restoreFromRtc() {
+  const RtcClock::Record& record = RtcClock::record;
+  if (record.magic != RtcClock::MAGIC || record.check != ~record.epoch ||
+      (time_t)record.epoch < VALID_EPOCH_MIN) {
+    return false;
+  }
+
+  struct timeval tv;
+  tv.tv_sec = (time_t)record.epoch;
+  tv.tv_usec = 0;
+  settimeofday(&tv, nullptr);
+
+  invalidateCache();
+  return isTimeValid();
+}
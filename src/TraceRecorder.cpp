@@ -0,0 +1,262 @@
+/**
+ * TraceRecorder.cpp
+ *
+ * 制御ループのトレース記録クラスの実装
+ */
+
+#include "TraceRecorder.h"
+#include <LittleFS.h>
+#include "Log.h"
+
+namespace {
+  const char* TRACE_DIR = "/trace";
+  const char* BUILD_ID = __DATE__ " " __TIME__;   // 再生時にどのファームウェアの記録かを表示する
+  constexpr uint32_t NO_VERSION = 0xFFFFFFFF;
+}
+
+/**
+ * コンストラクタ
+ */
+TraceRecorder::TraceRecorder(TimeManager& timeManager, WeatherForecast& weather)
+  : timeManager_(timeManager),
+    weather_(weather),
+    writer_(buffer_, BUFFER_SIZE),
+    recording_(false),
+    fileIndex_(0),
+    sequence_(0),
+    bootId_(0),
+    fileBytes_(0),
+    truncatePending_(false),
+    firstPendingMs_(0),
+    clockKnown_(false),
+    lastEpoch_(0),
+    lastEpochMs_(0),
+    weatherVersion_(NO_VERSION),
+    stats_() {
+}
+
+/**
+ * フラッシュをマウントして記録を開始
+ */
+bool TraceRecorder::begin() {
+  if (!LittleFS.begin(true)) {
+    LOG_E("[Trace] フラッシュのマウントに失敗しました（記録しない）");
+    return false;
+  }
+  if (!LittleFS.exists(TRACE_DIR)) {
+    LittleFS.mkdir(TRACE_DIR);
+  }
+
+  // 通し番号が古い方のファイルから書き始める（新しい方は直前の起動の記録として残す）
+  uint32_t seq0 = readSequence(0);
+  uint32_t seq1 = readSequence(1);
+  fileIndex_ = seq0 > seq1 ? 1 : 0;
+  sequence_ = seq0 > seq1 ? seq0 : seq1;
+  bootId_ = esp_random();
+  recording_ = true;
+
+  startFile();
+  LOG_I("[Trace] 記録開始: /trace/%u.bin（#%lu）", fileIndex_, (unsigned long)sequence_);
+  return true;
+}
+
+/**
+ * 時刻・天気予報の変化の記録と、定期的なフラッシュへの書き込み
+ */
+void TraceRecorder::update() {
+  if (!recording_) {
+    return;
+  }
+
+  // 時刻: millis() から予測した時刻と1秒以上ずれた時（初回・NTP同期・補正）だけ記録
+  if (timeManager_.isTimeValid()) {
+    uint32_t epoch = (uint32_t)timeManager_.epoch();
+    unsigned long now = millis();
+    uint32_t predicted = lastEpoch_ + (uint32_t)((now - lastEpochMs_) / 1000);
+    if (!clockKnown_ || epoch + 1 < predicted || epoch > predicted + 1) {
+      Trace::Record record = Trace::make(Trace::CLOCK, now);
+      record.epoch = epoch;
+      if (append(record)) {
+        clockKnown_ = true;
+        lastEpoch_ = epoch;
+        lastEpochMs_ = now;
+      }
+    }
+  }
+
+  // 天気予報: 取得（試行）の完了ごとに記録（WeatherDataのコピーはStringを含むため毎回は行わない）
+  uint32_t version = weather_.getDataVersion();
+  if (version != weatherVersion_) {
+    weatherVersion_ = version;
+    WeatherData data = weather_.getData();
+    Trace::Record record = Trace::make(Trace::WEATHER, millis());
+    record.valid = data.isValid;
+    record.tempMax = (int16_t)lroundf(data.tempMax * 10.0f);
+    record.tempMin = (int16_t)lroundf(data.tempMin * 10.0f);
+    record.weatherCode = (int16_t)data.weatherCode;
+    append(record);
+  }
+
+  if (writer_.length() > 0 && millis() - firstPendingMs_ >= FLUSH_INTERVAL_MS) {
+    flush();
+  }
+}
+
+/**
+ * センサー値を記録
+ */
+void TraceRecorder::recordSensor(const SensorData& data, unsigned long readMs) {
+  Trace::Record record = Trace::make(Trace::SENSOR, readMs);
+  record.valid = data.isValid;
+  if (data.isValid) {
+    record.temperature = data.temperature;  // SensorData も同じ1/100単位
+    record.humidity = data.humidity;
+  }
+  append(record);
+}
+
+/**
+ * 赤外線の受信を記録
+ */
+void TraceRecorder::recordIR(uint16_t protocol, uint16_t bits, uint64_t value) {
+  Trace::Record record = Trace::make(Trace::IR, millis());
+  record.protocol = protocol;
+  record.bits = bits;
+  record.value = value;
+  append(record);
+}
+
+/**
+ * WiFiの接続・切断を記録
+ */
+void TraceRecorder::recordWiFi(bool connected) {
+  Trace::Record record = Trace::make(Trace::WIFI, millis());
+  record.connected = connected;
+  append(record);
+}
+
+/**
+ * 外部からの操作を記録
+ */
+void TraceRecorder::recordCommand(Trace::Source source, Trace::Command command, uint8_t value) {
+  Trace::Record record = Trace::make(Trace::COMMAND, millis());
+  record.source = source;
+  record.command = command;
+  record.mode = value;
+  append(record);
+}
+
+/**
+ * 制御の判定結果を記録
+ */
+void TraceRecorder::recordDecision(ACMode mode) {
+  Trace::Record record = Trace::make(Trace::DECISION, millis());
+  record.mode = (uint8_t)mode;
+  append(record);
+}
+
+/**
+ * バッファにレコードを追加（一杯ならフラッシュに書き込んでから）
+ */
+bool TraceRecorder::append(const Trace::Record& record) {
+  if (!recording_) {
+    return false;
+  }
+  if (!writer_.hasRoom()) {
+    flush();
+  }
+  if (writer_.length() == 0) {
+    firstPendingMs_ = millis();
+  }
+  if (!writer_.write(record)) {
+    return false;
+  }
+  stats_.records++;
+  return true;
+}
+
+/**
+ * バッファの内容をフラッシュに書き込む
+ * ファイルが上限に達していれば、もう一方のファイルに切り替えます。
+ */
+void TraceRecorder::flush() {
+  if (!recording_ || writer_.length() == 0) {
+    return;
+  }
+
+  char path[24];
+  filePath(fileIndex_, path, sizeof(path));
+  File file = LittleFS.open(path, truncatePending_ ? FILE_WRITE : FILE_APPEND);
+  size_t length = writer_.length();
+  if (!file || file.write(writer_.data(), length) != length) {
+    if (file) {
+      file.close();
+    }
+    stats_.writeErrors++;
+    LOG_E("[Trace] フラッシュへの書き込みに失敗: %s", path);
+  } else {
+    file.close();
+    truncatePending_ = false;
+    fileBytes_ += length;
+    stats_.bytesWritten += length;
+    stats_.flashWrites++;
+  }
+  writer_.clear();
+
+  if (fileBytes_ >= MAX_FILE_BYTES) {
+    fileIndex_ ^= 1;
+    stats_.fileSwitches++;
+    startFile();
+  }
+}
+
+/**
+ * 新しいファイルの先頭（ヘッダー・START・現在の状態）をバッファに書き込む
+ * 各ファイルは単独で再生できるよう、時刻と天気予報を書き直します。
+ */
+void TraceRecorder::startFile() {
+  sequence_++;
+  fileBytes_ = 0;
+  truncatePending_ = true;
+
+  firstPendingMs_ = millis();
+  writer_.fileHeader();
+  Trace::Record start = Trace::make(Trace::START, millis());
+  start.bootId = bootId_;
+  start.sequence = sequence_;
+  start.epoch = timeManager_.isTimeValid() ? (uint32_t)timeManager_.epoch() : 0;
+  strncpy(start.build, BUILD_ID, Trace::MAX_BUILD - 1);
+  writer_.write(start);
+
+  clockKnown_ = false;
+  weatherVersion_ = NO_VERSION;
+}
+
+/**
+ * ファイルのSTARTに記録した通し番号（ファイルがない・壊れている場合は0）
+ */
+uint32_t TraceRecorder::readSequence(uint8_t index) {
+  char path[24];
+  filePath(index, path, sizeof(path));
+  File file = LittleFS.open(path, FILE_READ);
+  if (!file) {
+    return 0;
+  }
+  uint8_t head[Trace::FILE_HEADER_BYTES + Trace::MAX_RECORD_BYTES];
+  size_t length = file.read(head, sizeof(head));
+  file.close();
+
+  Trace::Reader reader(head, length);
+  Trace::Record record;
+  if (!reader.readHeader() || !reader.next(record) || record.type != Trace::START) {
+    return 0;
+  }
+  return record.sequence;
+}
+
+/**
+ * ファイルのパス
+ */
+void TraceRecorder::filePath(uint8_t index, char* path, size_t size) {
+  snprintf(path, size, "%s/%u.bin", TRACE_DIR, index);
+}
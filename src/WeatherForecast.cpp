@@ -1,12 +1,31 @@
 #include "WeatherForecast.h"
+#include "Log.h"
+#include "ComfortIndex.h"
+#include <Preferences.h>
 
-WeatherForecast::WeatherForecast(float latitude, float longitude)
-  : lastUpdateTime_(0) {
-  // API URLを構築
-  apiUrl_ = "http://api.open-meteo.com/v1/forecast?latitude=" + String(latitude, 6) +
+// NVSキャッシュ設定
+namespace WeatherCache {
+  const char* NAMESPACE = "weather";
+  const char* KEY = "last";
+  constexpr uint32_t MAGIC = 0x57434301;  // "WCC" + バージョン1
+  constexpr time_t VALID_EPOCH = 1600000000;  // これより前の時刻は未同期とみなす
+
+  // NVSに保存するレコード（Stringを含まない固定長）
+  struct Record {
+    uint32_t magic;
+    WeatherSnapshot data;
+  };
+}
+
+WeatherForecast::WeatherForecast(HttpSession& http, float latitude, float longitude)
+  : http_(http), lastUpdateTime_(0), nextAttemptTime_(0), consecutiveFailures_(0), circuitOpen_(false),
+    task_(nullptr), fetching_(false), resultReady_(false), dataVersion_(0), stale_(false) {
+  // APIパスを構築（ホストはHttpSession側で保持）
+  apiPath_ = "/v1/forecast?latitude=" + String(latitude, 6) +
             "&longitude=" + String(longitude, 6) +
             "&daily=weather_code,temperature_2m_max,temperature_2m_min" +
-            "&timezone=Asia/Tokyo&forecast_days=1";
+            "&hourly=temperature_2m,relative_humidity_2m" +
+            "&timezone=Asia/Tokyo&forecast_days=2";
 
   // 天気データを初期化
   weatherData_.isValid = false;
@@ -15,98 +34,487 @@ WeatherForecast::WeatherForecast(float latitude, float longitude)
   weatherData_.weatherCode = 0;
   weatherData_.weatherString = "N/A";
   weatherData_.lastUpdate = 0;
+  weatherData_.fetchedAt = 0;
+
+  hourly_ = HourlyForecast();
+  stats_ = WeatherFetchStats();
+
+  LOG_I("[Weather] WeatherForecast初期化完了");
+  LOG_D("[Weather] API URL: http://%s%s", http_.getHost(), apiPath_.c_str());
+}
+
+bool WeatherForecast::restoreCache() {
+  Preferences prefs;
+  if (!prefs.begin(WeatherCache::NAMESPACE, true)) {
+    return false;
+  }
+
+  WeatherCache::Record record;
+  size_t len = prefs.getBytes(WeatherCache::KEY, &record, sizeof(record));
+  prefs.end();
+
+  if (len != sizeof(record) || record.magic != WeatherCache::MAGIC) {
+    LOG_I("[Weather] キャッシュなし");
+    return false;
+  }
+
+  if (!restoreSnapshot(record.data)) {
+    LOG_I("[Weather] キャッシュが古いため破棄 (取得時刻: %lu)", (unsigned long)record.data.fetchedAt);
+    return false;
+  }
+
+  LOG_I("[Weather] キャッシュ復元: %s %.1f/%.1f°C (取得時刻: %lu)",
+        weatherData_.weatherString.c_str(), weatherData_.tempMin,
+        weatherData_.tempMax, (unsigned long)record.data.fetchedAt);
+  return true;
+}
 
-  Serial.println("[Weather] WeatherForecast初期化完了");
-  Serial.print("[Weather] API URL: ");
-  Serial.println(apiUrl_);
+bool WeatherForecast::getSnapshot(WeatherSnapshot& out) const {
+  // 取得時刻のないデータは再起動後に鮮度を判定できないため保存しない
+  if (!weatherData_.isValid || weatherData_.fetchedAt == 0 || isStale()) {
+    return false;
+  }
+  out.tempMax = weatherData_.tempMax;
+  out.tempMin = weatherData_.tempMin;
+  out.weatherCode = weatherData_.weatherCode;
+  out.fetchedAt = (uint32_t)weatherData_.fetchedAt;
+  return true;
+}
+
+bool WeatherForecast::restoreSnapshot(const WeatherSnapshot& snapshot) {
+  // 取得時刻が不明なもの、時刻同期済みで今日以外に取得したものは復元しない
+  // （時刻未同期の間は仮に表示し、同期後に古いと分かった時点で getData() が無効として扱う）
+  time_t now = time(nullptr);
+  if (snapshot.fetchedAt == 0 ||
+      (now > WeatherCache::VALID_EPOCH && !isSameDay((time_t)snapshot.fetchedAt, now))) {
+    return false;
+  }
+
+  weatherData_.tempMax = snapshot.tempMax;
+  weatherData_.tempMin = snapshot.tempMin;
+  weatherData_.weatherCode = snapshot.weatherCode;
+  weatherData_.weatherString = weatherCodeToString(snapshot.weatherCode);
+  weatherData_.fetchedAt = snapshot.fetchedAt;
+  weatherData_.lastUpdate = millis();
+  weatherData_.isValid = true;
+  dataVersion_++;
+  return true;
 }
 
 bool WeatherForecast::begin() {
-  Serial.println("[Weather] 初回天気予報データ取得開始");
-  return fetchWeatherData();
+  if (task_ == nullptr) {
+    // loop() と別のコア（コア0）で取得する。HTTP待ちの間も制御ループは止まらない
+    if (xTaskCreatePinnedToCore(fetchTask, "weather", TASK_STACK_SIZE, this, 1, &task_, 0) != pdPASS) {
+      task_ = nullptr;
+      LOG_W("[Weather] 取得タスクを作成できません（loop内で取得します）");
+    }
+  }
+
+  LOG_I("[Weather] 初回天気予報データ取得を要求");
+  nextAttemptTime_ = millis();
+  return task_ != nullptr;
+}
+
+void WeatherForecast::fetchTask(void* arg) {
+  WeatherForecast* self = static_cast<WeatherForecast*>(arg);
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    self->fetchWeatherData(self->result_);
+    self->resultReady_.store(true, std::memory_order_release);
+  }
 }
 
 void WeatherForecast::update() {
   unsigned long currentTime = millis();
 
-  // 1時間経過チェック（またはオーバーフロー対策）
-  if (currentTime - lastUpdateTime_ >= UPDATE_INTERVAL_MS ||
-      currentTime < lastUpdateTime_) {
-    Serial.println("[Weather] 定期更新: 天気予報データ取得開始");
-    fetchWeatherData();
+  // 取得タスクの結果を反映（天気データの更新はloop側だけで行う）
+  if (resultReady_.load(std::memory_order_acquire)) {
+    applyResult(result_);
+    resultReady_.store(false, std::memory_order_relaxed);
+    fetching_ = false;
+  }
+
+  // 日付が変わって getData() が無効になったことも版の変化として知らせる
+  bool stale = isStale();
+  bool becameStale = stale && !stale_;
+  if (stale != stale_) {
+    stale_ = stale;
+    dataVersion_++;
+  }
+
+  if (fetching_) {
+    return;
+  }
+
+  // 時刻同期前に取得したデータは、同期後に経過時間から取得時刻を補う
+  time_t now = time(nullptr);
+  if (weatherData_.isValid && weatherData_.fetchedAt == 0 && now > WeatherCache::VALID_EPOCH) {
+    weatherData_.fetchedAt = now - (time_t)((currentTime - weatherData_.lastUpdate) / 1000);
+    saveCache();
+  }
+
+  // 日付が変わって予報が古くなった時点で1回だけ、定期更新を待たずに取得する（休止中は除く）
+  // 失敗した後の再試行は scheduleNextAttempt() のバックオフに従う
+  if (!circuitOpen_ && becameStale && (long)(currentTime - nextAttemptTime_) < 0) {
+    LOG_I("[Weather] 予報が前日のものになったため再取得します");
+    nextAttemptTime_ = currentTime;
+  }
+
+  // 次回取得時刻に達していなければ何もしない（符号付き差分でオーバーフロー対策）
+  if ((long)(currentTime - nextAttemptTime_) < 0) {
+    return;
+  }
+
+  if (circuitOpen_) {
+    LOG_I("[Weather] 休止期間終了: 試験的に取得を再開");
+  } else if (consecutiveFailures_ > 0) {
+    LOG_I("[Weather] 再試行 (%u回目)", consecutiveFailures_);
+  } else {
+    LOG_I("[Weather] 定期更新: 天気予報データ取得開始");
+  }
+
+  startFetch();
+}
+
+void WeatherForecast::startFetch() {
+  stats_.fetchCount++;
+  if (task_ == nullptr) {
+    // 取得タスクがない場合はその場で取得する（完了までブロックする）
+    fetchWeatherData(result_);
+    applyResult(result_);
+    return;
+  }
+  fetching_ = true;
+  xTaskNotifyGive(task_);
+}
+
+void WeatherForecast::requestRefresh() {
+  if (consecutiveFailures_ > 0 || !weatherData_.isValid || isStale()) {
+    nextAttemptTime_ = millis();
   }
 }
 
 WeatherData WeatherForecast::getData() const {
-  return weatherData_;
+  WeatherData data = weatherData_;
+  if (isStale()) {
+    data.isValid = false;  // 前日以前の予報を今日の予報として表示しない
+  }
+  return data;
+}
+
+bool WeatherForecast::isStale() const {
+  if (!weatherData_.isValid || weatherData_.fetchedAt == 0) {
+    return false;
+  }
+  time_t now = time(nullptr);
+  if (now <= WeatherCache::VALID_EPOCH) {
+    return false;  // 時刻未同期の間は判定できない
+  }
+  return !isSameDay(weatherData_.fetchedAt, now);
+}
+
+bool WeatherForecast::isSameDay(time_t a, time_t b) {
+  struct tm ta;
+  struct tm tb;
+  localtime_r(&a, &ta);
+  localtime_r(&b, &tb);
+  return ta.tm_year == tb.tm_year && ta.tm_yday == tb.tm_yday;
+}
+
+void WeatherForecast::scheduleNextAttempt(bool success) {
+  unsigned long now = millis();
+
+  if (success) {
+    consecutiveFailures_ = 0;
+    circuitOpen_ = false;
+    nextAttemptTime_ = now + UPDATE_INTERVAL_MS;
+    return;
+  }
+
+  if (consecutiveFailures_ < 255) {
+    consecutiveFailures_++;
+  }
+
+  // 連続失敗が続く場合はサーキットブレーカーを開き、しばらく取得を休止する
+  // 休止明けの1回（ハーフオープン）で失敗した場合も再び休止する
+  if (circuitOpen_ || consecutiveFailures_ >= CIRCUIT_BREAK_FAILURES) {
+    circuitOpen_ = true;
+    nextAttemptTime_ = now + CIRCUIT_OPEN_MS;
+    LOG_W("[Weather] %u回連続失敗: %lu秒間取得を休止",
+          consecutiveFailures_, CIRCUIT_OPEN_MS / 1000);
+    return;
+  }
+
+  unsigned long delayMs = backoffDelay();
+  nextAttemptTime_ = now + delayMs;
+  LOG_I("[Weather] %lu秒後に再試行", delayMs / 1000);
 }
 
-bool WeatherForecast::fetchWeatherData() {
-  HTTPClient http;
+unsigned long WeatherForecast::backoffDelay() const {
+  // 指数バックオフ: 30秒, 60秒, 120秒, ... 上限15分
+  unsigned long delayMs = RETRY_BASE_MS;
+  for (uint8_t i = 1; i < consecutiveFailures_ && delayMs < RETRY_MAX_MS; i++) {
+    delayMs *= 2;
+  }
+  if (delayMs > RETRY_MAX_MS) {
+    delayMs = RETRY_MAX_MS;
+  }
 
-  Serial.print("[Weather] APIリクエスト送信: ");
-  Serial.println(apiUrl_);
+  // ±20%のジッターを加え、複数台が同時に再試行しないようにする
+  unsigned long jitterRange = delayMs / 5;
+  return delayMs - jitterRange + (esp_random() % (2 * jitterRange + 1));
+}
 
-  http.begin(apiUrl_);
-  int httpResponseCode = http.GET();
+void WeatherForecast::saveCache() const {
+  WeatherCache::Record record;
+  record.magic = WeatherCache::MAGIC;
+  if (!getSnapshot(record.data)) {
+    return;
+  }
 
-  if (httpResponseCode == 200) {
-    String payload = http.getString();
-    Serial.println("[Weather] APIレスポンス受信成功");
+  Preferences prefs;
+  if (!prefs.begin(WeatherCache::NAMESPACE, false)) {
+    LOG_W("[Weather] キャッシュ保存失敗");
+    return;
+  }
+  prefs.putBytes(WeatherCache::KEY, &record, sizeof(record));
+  prefs.end();
+}
 
-    // JSONパース
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, payload);
+namespace {
+  // HTTPストリームからのパース作業（HttpSessionのボディ処理関数に渡す）
+  struct ParseJob {
+    JsonDocument* doc;
+    JsonDocument* filter;
+    DeserializationError error;
+    unsigned long parseUs;
+    uint32_t heapBytes;
+  };
 
-    if (error) {
-      Serial.print("[Weather] JSONパースエラー: ");
-      Serial.println(error.c_str());
-      http.end();
+  bool parseWeatherBody(int status, Stream& body, void* context) {
+    if (status != 200) {
       return false;
     }
+    ParseJob* job = static_cast<ParseJob*>(context);
+
+    // レスポンス全体をStringに溜めず、ストリームから直接パースする
+    uint32_t heapBefore = ESP.getFreeHeap();
+    unsigned long parseStart = micros();
+    job->error = deserializeJson(*job->doc, body, DeserializationOption::Filter(*job->filter));
+    job->parseUs = micros() - parseStart;
+    uint32_t heapAfter = ESP.getFreeHeap();
+    job->heapBytes = (heapBefore > heapAfter) ? heapBefore - heapAfter : 0;
+    return !job->error;
+  }
+}
+
+// 取得タスクで実行される。天気データには触れず、結果は out に書いて applyResult() でloop側から反映する
+void WeatherForecast::fetchWeatherData(FetchResult& out) const {
+  LOG_D("[Weather] APIリクエスト送信: http://%s%s", http_.getHost(), apiPath_.c_str());
+
+  unsigned long fetchStart = millis();
+  out.success = false;
+  out.hourlyValid = false;
+  out.hourly.count = 0;
+  out.parseUs = 0;
+  out.parseHeapBytes = 0;
+  out.payloadBytes = 0;
+
+  // 使用するフィールドのみを残すフィルタ
+  JsonDocument filter;
+  buildFilter(filter);
+
+  JsonDocument doc;
+  ParseJob job = {&doc, &filter, DeserializationError(), 0, 0};
+
+  // 共有HTTPセッション経由で取得（keep-alive接続とDNSキャッシュを再利用）
+  HttpSession::Request request = {"GET", apiPath_.c_str(), nullptr, nullptr, 0,
+                                  parseWeatherBody, &job, 0, 0};
+  http_.execute(&request, 1);
+  out.fetchMs = millis() - fetchStart;
+  out.status = request.status;
+
+  if (request.status != 200) {
+    LOG_E("[Weather] HTTPエラー: %d", request.status);
+    return;
+  }
+
+  LOG_D("[Weather] APIレスポンス受信成功");
+  out.payloadBytes = (int)request.bytesReceived;
+  out.parseUs = job.parseUs;
+  out.parseHeapBytes = job.heapBytes;
+  DeserializationError error = job.error;
+
+  LOG_D("[Weather] パース: %lu us, ヒープ使用: %u bytes, 受信: %d bytes",
+        out.parseUs, out.parseHeapBytes, out.payloadBytes);
+
+  if (error) {
+    LOG_E("[Weather] JSONパースエラー: %s", error.c_str());
+    return;
+  }
+
+  // データ抽出
+  JsonArray weatherCodeArray = doc["daily"]["weather_code"];
+  JsonArray tempMaxArray = doc["daily"]["temperature_2m_max"];
+  JsonArray tempMinArray = doc["daily"]["temperature_2m_min"];
+
+  if (weatherCodeArray.size() == 0 || tempMaxArray.size() == 0 || tempMinArray.size() == 0) {
+    LOG_W("[Weather] JSONデータが不完全です");
+    return;
+  }
+
+  out.weatherCode = weatherCodeArray[0];
+  out.tempMax = tempMaxArray[0];
+  out.tempMin = tempMinArray[0];
+
+  // 時間別予報を固定小数点配列に取り込む（日次データとは独立に扱う）
+  out.hourlyValid = ingestHourly(doc, out.hourly);
+  out.success = true;
+}
+
+// 取得結果を天気データに反映し、次回の取得を予約する（loop側で実行する）
+void WeatherForecast::applyResult(const FetchResult& result) {
+  dataVersion_++;  // 失敗も取得の完了として数える（トレースは試行ごとに記録する）
+  stats_.lastFetchMs = result.fetchMs;
+  if (result.status == 200) {
+    stats_.lastPayloadBytes = result.payloadBytes;
+    stats_.lastParseUs = result.parseUs;
+    stats_.lastParseHeapBytes = result.parseHeapBytes;
+  }
+
+  if (!result.success) {
+    stats_.failureCount++;
+    scheduleNextAttempt(false);
+    return;
+  }
+
+  weatherData_.weatherCode = result.weatherCode;
+  weatherData_.tempMax = result.tempMax;
+  weatherData_.tempMin = result.tempMin;
+  weatherData_.weatherString = weatherCodeToString(weatherData_.weatherCode);
+  weatherData_.isValid = true;
+  weatherData_.lastUpdate = millis();
+  lastUpdateTime_ = millis();
+
+  // 時刻同期済みの場合のみ取得時刻を記録（未同期なら0）
+  time_t now = time(nullptr);
+  weatherData_.fetchedAt = (now > WeatherCache::VALID_EPOCH) ? now : 0;
+
+  // 再起動後すぐに表示できるようNVSに保存
+  saveCache();
 
-    // データ抽出
-    JsonArray timeArray = doc["daily"]["time"];
-    JsonArray weatherCodeArray = doc["daily"]["weather_code"];
-    JsonArray tempMaxArray = doc["daily"]["temperature_2m_max"];
-    JsonArray tempMinArray = doc["daily"]["temperature_2m_min"];
-
-    if (timeArray.size() > 0 && weatherCodeArray.size() > 0 &&
-        tempMaxArray.size() > 0 && tempMinArray.size() > 0) {
-
-      weatherData_.weatherCode = weatherCodeArray[0];
-      weatherData_.tempMax = tempMaxArray[0];
-      weatherData_.tempMin = tempMinArray[0];
-      weatherData_.weatherString = weatherCodeToString(weatherData_.weatherCode);
-      weatherData_.isValid = true;
-      weatherData_.lastUpdate = millis();
-      lastUpdateTime_ = millis();
-
-      Serial.println("[Weather] 天気予報データ更新完了");
-      Serial.print("  - 最高気温: ");
-      Serial.print(weatherData_.tempMax, 1);
-      Serial.println(" °C");
-      Serial.print("  - 最低気温: ");
-      Serial.print(weatherData_.tempMin, 1);
-      Serial.println(" °C");
-      Serial.print("  - 天気コード: ");
-      Serial.println(weatherData_.weatherCode);
-      Serial.print("  - 天気: ");
-      Serial.println(weatherData_.weatherString);
-
-      http.end();
-      return true;
+  hourly_ = result.hourly;
+  if (!result.hourlyValid) {
+    LOG_W("[Weather] 時間別予報データが不完全です");
+  }
+
+  LOG_I("[Weather] 天気予報データ更新完了: %s (コード %d) 最高 %.1f °C / 最低 %.1f °C",
+        weatherData_.weatherString.c_str(), weatherData_.weatherCode,
+        weatherData_.tempMax, weatherData_.tempMin);
+
+  scheduleNextAttempt(true);
+}
+
+void WeatherForecast::buildFilter(JsonDocument& filter) const {
+  filter["daily"]["weather_code"] = true;
+  filter["daily"]["temperature_2m_max"] = true;
+  filter["daily"]["temperature_2m_min"] = true;
+  filter["daily"]["time"] = true;  // 時間別予報の起点日付に使用
+  filter["hourly"]["temperature_2m"] = true;
+  filter["hourly"]["relative_humidity_2m"] = true;
+}
+
+namespace {
+  // 実数を0.01単位のint16に変換（範囲外・欠損はMISSING）
+  int16_t toCenti(JsonVariant value) {
+    if (value.isNull()) {
+      return HourlyForecast::MISSING;
+    }
+    float scaled = value.as<float>() * 100.0f;
+    if (scaled <= -32767.0f || scaled >= 32767.0f) {
+      return HourlyForecast::MISSING;
+    }
+    return (int16_t)lroundf(scaled);
+  }
+
+  // 日付を1970-01-01からの通算日数に変換（うるう年を考慮）
+  long daysFromCivil(int year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    const long era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yoe = (unsigned)(year - era * 400);
+    const unsigned doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (long)doe - 719468;
+  }
+}
+
+bool WeatherForecast::ingestHourly(JsonDocument& doc, HourlyForecast& out) {
+  JsonArray dateArray = doc["daily"]["time"];
+  JsonArray tempArray = doc["hourly"]["temperature_2m"];
+  JsonArray humArray = doc["hourly"]["relative_humidity_2m"];
+
+  // 起点日付（"YYYY-MM-DD"）を解析
+  const char* startDate = dateArray[0];
+  unsigned year, month, day;
+  if (startDate == nullptr || sscanf(startDate, "%4u-%2u-%2u", &year, &month, &day) != 3) {
+    out.count = 0;
+    return false;
+  }
+
+  size_t count = tempArray.size();
+  if (humArray.size() < count) {
+    count = humArray.size();
+  }
+  if (count > HourlyForecast::HOURS) {
+    count = HourlyForecast::HOURS;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    int16_t temp = toCenti(tempArray[i]);
+    int16_t hum = toCenti(humArray[i]);
+    out.temperature[i] = temp;
+    out.humidity[i] = hum;
+
+    // 時間別DIは取得時に一度だけ計算しておく
+    if (temp == HourlyForecast::MISSING || hum == HourlyForecast::MISSING) {
+      out.discomfortIndex[i] = HourlyForecast::MISSING;
     } else {
-      Serial.println("[Weather] JSONデータが不完全です");
-      http.end();
-      return false;
+      out.discomfortIndex[i] = Comfort::discomfortIndex(temp, hum);
     }
-  } else {
-    Serial.print("[Weather] HTTPエラー: ");
-    Serial.println(httpResponseCode);
-    http.end();
+  }
+
+  out.count = (uint8_t)count;
+  out.startYear = (uint16_t)year;
+  out.startMonth = (uint8_t)month;
+  out.startDay = (uint8_t)day;
+
+  LOG_I("[Weather] 時間別予報: %u時間分 (%04u-%02u-%02u 0時から)",
+        out.count, year, month, day);
+  return count > 0;
+}
+
+bool WeatherForecast::getHourly(uint8_t hourIndex, HourlySample& out) const {
+  if (hourIndex >= hourly_.count ||
+      hourly_.discomfortIndex[hourIndex] == HourlyForecast::MISSING) {
     return false;
   }
+  out.temperature = hourly_.temperature[hourIndex] / 100.0f;
+  out.humidity = hourly_.humidity[hourIndex] / 100.0f;
+  out.discomfortIndex = hourly_.discomfortIndex[hourIndex] / 100.0f;
+  return true;
+}
+
+int WeatherForecast::hourIndexFor(const struct tm& timeinfo) const {
+  if (hourly_.count == 0) {
+    return -1;
+  }
+  long dayOffset = daysFromCivil(timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday) -
+                   daysFromCivil(hourly_.startYear, hourly_.startMonth, hourly_.startDay);
+  long index = dayOffset * 24 + timeinfo.tm_hour;
+  if (index < 0 || index >= hourly_.count) {
+    return -1;
+  }
+  return (int)index;
 }
 
 String WeatherForecast::weatherCodeToString(int code) const {
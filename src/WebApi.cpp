@@ -0,0 +1,453 @@
+/**
+ * WebApi.cpp
+ *
+ * Web API・ダッシュボードの実装
+ */
+
+#include "WebApi.h"
+#include <WiFi.h>
+#include <LittleFS.h>
+#include "WebAssets.h"
+#include "Log.h"
+
+namespace {
+  /**
+   * バッファに追記（収まらない場合はfalse）
+   */
+  bool appendf(char* buffer, size_t capacity, size_t& length, const char* format, ...)
+    __attribute__((format(printf, 4, 5)));
+
+  bool appendf(char* buffer, size_t capacity, size_t& length, const char* format, ...) {
+    if (length >= capacity) {
+      return false;
+    }
+    size_t remaining = capacity - length;
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(buffer + length, remaining, format, args);
+    va_end(args);
+    if (written < 0 || (size_t)written >= remaining) {
+      return false;
+    }
+    length += written;
+    return true;
+  }
+
+  /**
+   * 0.1単位で値が変わったか（表示桁数より細かい変化では送信しない）
+   */
+  bool changedTenths(float a, float b) {
+    return lroundf(a * 10.0f) != lroundf(b * 10.0f);
+  }
+
+  /**
+   * 同じく1/100単位の整数（センサー値）の場合（Fixed::format() と同じ丸め）
+   */
+  bool changedTenths(int16_t a, int16_t b) {
+    return Fixed::divRound(a, 10) != Fixed::divRound(b, 10);
+  }
+}
+
+/**
+ * コンストラクタ
+ */
+WebApi::WebApi(AirConditionerController& airConditioner, AutoStopController& autoStop,
+               EnvironmentSensor& sensor, WeatherForecast& weather, uint16_t port)
+  : airConditioner_(airConditioner),
+    autoStop_(autoStop),
+    sensor_(sensor),
+    weather_(weather),
+    server_(port),
+    ws_("/ws"),
+    port_(port),
+    started_(false),
+    snapshot_(),
+    snapshotSeq_(0),
+    pendingMode_(NO_COMMAND),
+    pendingAutoStop_(NO_COMMAND),
+    current_(),
+    pushed_(),
+    seq_(0),
+    weatherVersion_(0),
+    weatherLoaded_(false),
+    lastCleanupMs_(0),
+    stats_() {
+  portMUX_INITIALIZE(&lock_);
+  current_.mode = ACMode::NONE;
+  current_.autoStop = false;
+  current_.weatherValid = false;
+  current_.tempMax = 0.0f;
+  current_.tempMin = 0.0f;
+  current_.weatherCode = 0;
+  current_.weather[0] = '\0';
+  snapshot_ = current_;
+  pushed_ = current_;
+}
+
+/**
+ * ルートを登録して待ち受けを開始
+ */
+void WebApi::begin() {
+  if (started_) {
+    return;
+  }
+  update();
+
+  server_.on("/", HTTP_GET, [this](AsyncWebServerRequest* request) { handleIndex(request); });
+  server_.on("/api/sensor", HTTP_GET, [this](AsyncWebServerRequest* request) { handleSensor(request); });
+  server_.on("/api/ac", HTTP_GET, [this](AsyncWebServerRequest* request) { handleAc(request); });
+  server_.on("/api/ac/mode", HTTP_POST, [this](AsyncWebServerRequest* request) { handleSetMode(request); });
+  server_.on("/api/autostop", HTTP_POST, [this](AsyncWebServerRequest* request) { handleAutoStop(request); });
+  // トレース（TraceRecorder）のファイルをフラッシュから送信
+  server_.serveStatic("/trace/", LittleFS, "/trace/").setCacheControl("no-cache");
+  server_.onNotFound([this](AsyncWebServerRequest* request) { handleNotFound(request); });
+
+  ws_.onEvent([this](AsyncWebSocket*, AsyncWebSocketClient* client, AwsEventType type,
+                     void*, uint8_t*, size_t) { onWsEvent(client, type); });
+  server_.addHandler(&ws_);
+
+  server_.begin();
+  started_ = true;
+  LOG_I("[Web] http://%s:%u/ で待ち受け開始", WiFi.localIP().toString().c_str(), port_);
+}
+
+/**
+ * 受け付けたコマンドの実行とスナップショットの更新（loop()から呼ばれる）
+ */
+void WebApi::update() {
+  int8_t mode = pendingMode_.exchange(NO_COMMAND);
+  if (mode != NO_COMMAND) {
+    LOG_I("[Web] コマンド: モード → %s", AirConditionerController::modeToKey((ACMode)mode));
+    airConditioner_.request((ACMode)mode, ACPriority::USER);
+    stats_.commandsApplied++;
+  }
+
+  int8_t autoStop = pendingAutoStop_.exchange(NO_COMMAND);
+  if (autoStop != NO_COMMAND) {
+    LOG_I("[Web] コマンド: 自動停止 → %s", autoStop ? "有効" : "無効");
+    autoStop_.setEnabled(autoStop != 0);
+    stats_.commandsApplied++;
+  }
+
+  current_.sensor = sensor_.getLastData();
+  current_.mode = airConditioner_.getCurrentMode();
+  current_.autoStop = autoStop_.isEnabled();
+  loadWeather();
+
+  if (started_) {
+    push(current_);
+  }
+
+  // 接続直後の全項目の送信（AsyncTCPタスク）は、この状態と通し番号を使う
+  portENTER_CRITICAL(&lock_);
+  snapshot_ = current_;
+  snapshotSeq_ = seq_;
+  portEXIT_CRITICAL(&lock_);
+
+  if (!started_) {
+    return;
+  }
+
+  // 切断済みクライアントの解放と、上限を超えた接続の切断
+  if (millis() - lastCleanupMs_ >= CLEANUP_INTERVAL_MS) {
+    lastCleanupMs_ = millis();
+    ws_.cleanupClients(MAX_CLIENTS);
+  }
+}
+
+/**
+ * 天気予報が更新されていれば読み込む（WeatherDataのコピーはStringを含むため毎回は行わない）
+ */
+void WebApi::loadWeather() {
+  uint32_t version = weather_.getDataVersion();
+  if (weatherLoaded_ && version == weatherVersion_) {
+    return;
+  }
+  weatherLoaded_ = true;
+  weatherVersion_ = version;
+
+  WeatherData data = weather_.getData();
+  current_.weatherValid = data.isValid;
+  current_.tempMax = data.tempMax;
+  current_.tempMin = data.tempMin;
+  current_.weatherCode = data.weatherCode;
+  snprintf(current_.weather, sizeof(current_.weather), "%s", data.weatherString.c_str());
+}
+
+/**
+ * 前回の送信から変化した項目をWebSocketの全クライアントへ送信
+ * 送信バッファは全クライアントで共有し、キューが一杯のクライアントはライブラリが切断する。
+ */
+void WebApi::push(const Snapshot& latest) {
+  if (ws_.count() == 0) {
+    // 接続時は全項目を送るため、差分の基準だけ更新しておく
+    pushed_ = latest;
+    return;
+  }
+
+  char message[MESSAGE_SIZE];
+  size_t length = buildMessage(message, sizeof(message), seq_ + 1, latest, &pushed_);
+  if (length == 0) {
+    return;
+  }
+  seq_++;
+  pushed_ = latest;
+
+  unsigned long startUs = micros();
+  AsyncWebSocketSharedBuffer buffer =
+    std::make_shared<std::vector<uint8_t>>((const uint8_t*)message, (const uint8_t*)message + length);
+
+  // クライアント一覧はAsyncTCPタスクも変更するため、ライブラリのロックの下でたどる textAll() に任せる
+  AsyncWebSocket::SendStatus status = ws_.textAll(buffer);
+  if (status != AsyncWebSocket::ENQUEUED) {
+    // キューが一杯のクライアントは切断される（ブラウザ側は再接続して全項目を受け取り直す）
+    stats_.wsDroppedClients++;
+    LOG_W("[Web] 受信が追いつかないWebSocketクライアントを切断しました");
+  }
+
+  stats_.lastFanoutUs = micros() - startUs;
+  stats_.wsMessages++;
+  stats_.wsBytes += length;
+}
+
+/**
+ * WebSocketのイベント（AsyncTCPタスクから呼ばれる）
+ */
+void WebApi::onWsEvent(AsyncWebSocketClient* client, AwsEventType type) {
+  if (type == WS_EVT_CONNECT) {
+    stats_.wsConnects++;
+    // 送信キューが一杯になったらライブラリ側で切断する
+    client->setCloseClientOnQueueFull(true);
+    // 接続直後に全項目を送信（以降は差分のみ、loop()の seq_ ではなくスナップショットの番号を使う）
+    uint32_t seq;
+    Snapshot state = readSnapshot(&seq);
+    char message[MESSAGE_SIZE];
+    size_t length = buildMessage(message, sizeof(message), seq, state, nullptr);
+    if (length > 0) {
+      client->text(message, length);
+    }
+    LOG_D("[Web] WebSocket接続: #%lu（%u 台）", (unsigned long)client->id(), (unsigned)ws_.count());
+  } else if (type == WS_EVT_DISCONNECT) {
+    LOG_D("[Web] WebSocket切断: #%lu", (unsigned long)client->id());
+  }
+}
+
+/**
+ * WebSocketで送信するJSONを生成
+ * @param previous 前回送信した状態（nullptrなら全項目）
+ * @return 長さ（変化がない場合・バッファ不足の場合は0）
+ */
+size_t WebApi::buildMessage(char* out, size_t size, uint32_t seq,
+                            const Snapshot& current, const Snapshot* previous) {
+  bool full = previous == nullptr;
+  size_t length = 0;
+  bool ok = appendf(out, size, length, "{\"seq\":%lu", (unsigned long)seq);
+  bool changed = false;
+
+  if (full) {
+    ok = ok && appendf(out, size, length, ",\"full\":true");
+  }
+
+  const SensorData& sensor = current.sensor;
+  if (sensor.isValid) {
+    if (full || !previous->sensor.isValid ||
+        changedTenths(sensor.temperature, previous->sensor.temperature)) {
+      ok = ok && appendf(out, size, length, ",\"temp\":%s", Fixed::Text(sensor.temperature, 1).c_str());
+      changed = true;
+    }
+    if (full || !previous->sensor.isValid ||
+        changedTenths(sensor.humidity, previous->sensor.humidity)) {
+      ok = ok && appendf(out, size, length, ",\"hum\":%s", Fixed::Text(sensor.humidity, 1).c_str());
+      changed = true;
+    }
+    if (full || !previous->sensor.isValid ||
+        changedTenths(sensor.discomfortIndex, previous->sensor.discomfortIndex)) {
+      ok = ok && appendf(out, size, length, ",\"di\":%s", Fixed::Text(sensor.discomfortIndex, 1).c_str());
+      changed = true;
+    }
+  }
+
+  if (full || current.mode != previous->mode) {
+    ok = ok && appendf(out, size, length, ",\"mode\":\"%s\"",
+                       AirConditionerController::modeToKey(current.mode));
+    changed = true;
+  }
+  if (full || current.autoStop != previous->autoStop) {
+    ok = ok && appendf(out, size, length, ",\"autoStop\":%s", current.autoStop ? "true" : "false");
+    changed = true;
+  }
+
+  if (current.weatherValid &&
+      (full || !previous->weatherValid ||
+       current.weatherCode != previous->weatherCode ||
+       changedTenths(current.tempMax, previous->tempMax) ||
+       changedTenths(current.tempMin, previous->tempMin))) {
+    ok = ok && appendf(out, size, length,
+                       ",\"weather\":{\"max\":%.1f,\"min\":%.1f,\"code\":%d,\"text\":\"%s\"}",
+                       current.tempMax, current.tempMin, current.weatherCode, current.weather);
+    changed = true;
+  }
+
+  ok = ok && appendf(out, size, length, "}");
+  if (!ok || (!full && !changed)) {
+    return 0;
+  }
+  return length;
+}
+
+/**
+ * スナップショットのコピーを取得（リクエスト処理から呼ばれる）
+ */
+WebApi::Snapshot WebApi::readSnapshot(uint32_t* seq) {
+  portENTER_CRITICAL(&lock_);
+  Snapshot copy = snapshot_;
+  if (seq != nullptr) {
+    *seq = snapshotSeq_;
+  }
+  portEXIT_CRITICAL(&lock_);
+  return copy;
+}
+
+/**
+ * GET / ダッシュボード
+ * 圧縮済みのHTMLをフラッシュから直接送信（RAMにコピーしない）。
+ * ブラウザのキャッシュと同じ内容（ETag一致）なら本文を送らない。
+ */
+void WebApi::handleIndex(AsyncWebServerRequest* request) {
+  unsigned long startUs = micros();
+
+  const AsyncWebHeader* ifNoneMatch = request->getHeader("If-None-Match");
+  if (ifNoneMatch != nullptr && strcmp(ifNoneMatch->value().c_str(), WebAssets::INDEX_HTML_ETAG) == 0) {
+    request->send(304);
+    stats_.notModified++;
+    finish(startUs);
+    return;
+  }
+
+  AsyncWebServerResponse* response = request->beginResponse(
+    200, "text/html", WebAssets::INDEX_HTML_GZ, WebAssets::INDEX_HTML_GZ_LEN);
+  response->addHeader("Content-Encoding", "gzip");
+  response->addHeader("ETag", WebAssets::INDEX_HTML_ETAG);
+  response->addHeader("Cache-Control", "no-cache");
+  request->send(response);
+  finish(startUs);
+}
+
+/**
+ * GET /api/sensor
+ * 例: {"valid":true,"temperature":26.50,"humidity":55.20,"discomfortIndex":75.12}
+ */
+void WebApi::handleSensor(AsyncWebServerRequest* request) {
+  unsigned long startUs = micros();
+  Snapshot state = readSnapshot();
+
+  char body[128];
+  if (state.sensor.isValid) {
+    snprintf(body, sizeof(body),
+             "{\"valid\":true,\"temperature\":%s,\"humidity\":%s,\"discomfortIndex\":%s}",
+             Fixed::Text(state.sensor.temperature, 2).c_str(), Fixed::Text(state.sensor.humidity, 2).c_str(),
+             Fixed::Text(state.sensor.discomfortIndex, 2).c_str());
+  } else {
+    snprintf(body, sizeof(body), "{\"valid\":false}");
+  }
+  request->send(200, "application/json", body);
+  finish(startUs);
+}
+
+/**
+ * GET /api/ac
+ * 例: {"mode":"cool_20","autoStop":true}
+ */
+void WebApi::handleAc(AsyncWebServerRequest* request) {
+  unsigned long startUs = micros();
+  Snapshot state = readSnapshot();
+
+  char body[64];
+  snprintf(body, sizeof(body), "{\"mode\":\"%s\",\"autoStop\":%s}",
+           AirConditionerController::modeToKey(state.mode), state.autoStop ? "true" : "false");
+  request->send(200, "application/json", body);
+  finish(startUs);
+}
+
+/**
+ * POST /api/ac/mode（mode=cool_20 など）
+ */
+void WebApi::handleSetMode(AsyncWebServerRequest* request) {
+  unsigned long startUs = micros();
+
+  ACMode mode = AirConditionerController::modeFromKey(param(request, "mode"));
+  if (mode == ACMode::NONE) {
+    request->send(400, "application/json",
+                  "{\"error\":\"mode must be off, cool_20, auto_plus_1 or dry_minus_1_5\"}");
+    stats_.badRequests++;
+    finish(startUs);
+    return;
+  }
+
+  pendingMode_.store((int8_t)mode);
+  stats_.commandsQueued++;
+
+  char body[48];
+  snprintf(body, sizeof(body), "{\"queued\":\"%s\"}", AirConditionerController::modeToKey(mode));
+  request->send(202, "application/json", body);
+  finish(startUs);
+}
+
+/**
+ * POST /api/autostop（enabled=true|false）
+ */
+void WebApi::handleAutoStop(AsyncWebServerRequest* request) {
+  unsigned long startUs = micros();
+
+  const char* value = param(request, "enabled");
+  int8_t enabled = NO_COMMAND;
+  if (value != nullptr && strcmp(value, "true") == 0) {
+    enabled = 1;
+  } else if (value != nullptr && strcmp(value, "false") == 0) {
+    enabled = 0;
+  }
+  if (enabled == NO_COMMAND) {
+    request->send(400, "application/json", "{\"error\":\"enabled must be true or false\"}");
+    stats_.badRequests++;
+    finish(startUs);
+    return;
+  }
+
+  pendingAutoStop_.store(enabled);
+  stats_.commandsQueued++;
+  request->send(202, "application/json", enabled ? "{\"queued\":true}" : "{\"queued\":false}");
+  finish(startUs);
+}
+
+/**
+ * 上記以外
+ */
+void WebApi::handleNotFound(AsyncWebServerRequest* request) {
+  unsigned long startUs = micros();
+  request->send(404, "application/json", "{\"error\":\"not found\"}");
+  stats_.notFound++;
+  finish(startUs);
+}
+
+/**
+ * リクエスト数と処理時間を記録
+ */
+void WebApi::finish(unsigned long startUs) {
+  unsigned long elapsedUs = micros() - startUs;
+  stats_.requests++;
+  if (elapsedUs > stats_.maxHandlerUs) {
+    stats_.maxHandlerUs = elapsedUs;
+  }
+}
+
+/**
+ * フォーム（本文）またはクエリのパラメーターを取得
+ * @return 値（リクエスト処理中のみ有効）、なければnullptr
+ */
+const char* WebApi::param(AsyncWebServerRequest* request, const char* name) {
+  const AsyncWebParameter* p = request->getParam(name, true);
+  if (p == nullptr) {
+    p = request->getParam(name, false);
+  }
+  return p != nullptr ? p->value().c_str() : nullptr;
+}
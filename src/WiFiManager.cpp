@@ -5,6 +5,80 @@
  */
 
 #include "WiFiManager.h"
+#include "Log.h"
+#include <Preferences.h>
+
+WiFiManager* WiFiManager::instance_ = nullptr;
+
+/**
+ * 高速再接続用のキャッシュ
+ * RTCメモリ（ソフトリセット・ディープスリープ後も保持）を優先し、
+ * 電源断後はNVSのコピーから復元します。
+ */
+namespace JoinCache {
+  const char* NAMESPACE = "wifi";
+  const char* KEY = "join";
+  constexpr uint32_t MAGIC = 0x574A4301;  // "WJC" + バージョン1
+
+  struct Record {
+    uint32_t magic;
+    uint32_t ssidHash;   // SSIDが変わったらキャッシュを使わない
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t reserved;
+    uint32_t ip;         // 前回のDHCPリース
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+    uint32_t checksum;
+  };
+
+  RTC_DATA_ATTR Record rtcRecord;
+
+  // FNV-1a ハッシュ
+  uint32_t hash(const uint8_t* data, size_t length, uint32_t seed = 2166136261u) {
+    uint32_t h = seed;
+    for (size_t i = 0; i < length; i++) {
+      h ^= data[i];
+      h *= 16777619u;
+    }
+    return h;
+  }
+
+  uint32_t checksumOf(const Record& record) {
+    return hash(reinterpret_cast<const uint8_t*>(&record), offsetof(Record, checksum));
+  }
+
+  bool isValid(const Record& record, uint32_t ssidHash) {
+    return record.magic == MAGIC && record.ssidHash == ssidHash &&
+           record.checksum == checksumOf(record) && record.channel != 0;
+  }
+
+  // 有効なキャッシュを読み込む（RTC → NVS の順）
+  bool load(uint32_t ssidHash, Record& out) {
+    if (isValid(rtcRecord, ssidHash)) {
+      out = rtcRecord;
+      return true;
+    }
+
+    Preferences prefs;
+    if (!prefs.begin(NAMESPACE, true)) {
+      return false;
+    }
+    size_t length = prefs.getBytes(KEY, &out, sizeof(out));
+    prefs.end();
+
+    if (length != sizeof(out) || !isValid(out, ssidHash)) {
+      return false;
+    }
+    rtcRecord = out;
+    return true;
+  }
+
+  void invalidate() {
+    rtcRecord.magic = 0;
+  }
+}
 
 /**
  * コンストラクタ
@@ -13,72 +87,377 @@
 WiFiManager::WiFiManager(const char* ssid, const char* password, unsigned long timeoutMs)
   : ssid_(ssid),
     password_(password),
-    timeoutMs_(timeoutMs) {
+    timeoutMs_(timeoutMs),
+    state_(State::IDLE),
+    attemptStartTime_(0),
+    nextAttemptTime_(0),
+    disconnectedAt_(0),
+    consecutiveFailures_(0),
+    eventsRegistered_(false),
+    reuseLease_(false),
+    attemptIsFast_(false),
+    fastJoinDisabled_(false),
+    eventHead_(0),
+    eventTail_(0),
+    eventsLost_(false),
+    listenerCount_(0),
+    stats_() {
 }
 
 /**
- * WiFiに接続
+ * イベントハンドラーを登録し、接続を開始
  */
-bool WiFiManager::connect() {
-  Serial.println("\n[WiFi] WiFi接続を開始します...");
-  Serial.printf("[WiFi] SSID: %s\n", ssid_);
+void WiFiManager::begin() {
+  if (!eventsRegistered_) {
+    instance_ = this;
+    WiFi.onEvent(onWiFiEvent);
+    eventsRegistered_ = true;
+  }
+
+  if (state_ != State::IDLE) {
+    return;  // 既に開始済み
+  }
+
+  LOG_I("[WiFi] WiFi接続を開始します...");
+  LOG_I("[WiFi] SSID: %s", ssid_);
 
   // WiFiモードをステーションモード（クライアント）に設定
+  // 再接続はこのクラスで管理するため、ライブラリの自動再接続は無効にする
+  // 接続ごとにSDKがフラッシュへ設定を書き込まないようにする（キャッシュは自前で管理）
+  WiFi.persistent(false);
   WiFi.mode(WIFI_STA);
+  WiFi.setAutoReconnect(false);
 
-  // WiFi接続を開始（SSID、パスワードを指定）
-  WiFi.begin(ssid_, password_);
+  startAttempt();
+}
 
-  // 接続試行の開始時刻を記録
-  unsigned long startTime = millis();
+/**
+ * WiFiに接続（接続完了またはタイムアウトまで待機）
+ */
+bool WiFiManager::connect() {
+  begin();
 
   // 接続完了またはタイムアウトまで待機
-  // WiFi.status()がWL_CONNECTEDになるまでループ
-  while (WiFi.status() != WL_CONNECTED) {
-    // タイムアウトチェック
+  unsigned long startTime = millis();
+  while (!checkConnection()) {
     if (millis() - startTime > timeoutMs_) {
-      Serial.println("\n[WiFi] 接続タイムアウト");
-      return false;  // 接続失敗
+      LOG_W("[WiFi] 接続タイムアウト（バックグラウンドで再試行を継続）");
+      return false;
     }
 
-    // 進捗表示（500msごとにドットを表示）
     delay(500);
-    Serial.print(".");
   }
 
-  // 接続成功
-  Serial.println("\n[WiFi] WiFi接続成功！");
-  printConnectionInfo();
-
   return true;
 }
 
 /**
- * WiFi接続状態を確認し、切断時は再接続を試みる
+ * 接続状態を更新し、必要なら再接続を進める
+ * イベントタスクで積んだイベントをここで発生順に処理するため、通知は常にloop側で行われます。
  */
 bool WiFiManager::checkConnection() {
-  // WiFi.status()で現在の接続状態を確認
-  if (WiFi.status() != WL_CONNECTED) {
-    Serial.println("[WiFi] WiFi切断を検出、再接続を試みます...");
-    return connect();  // 再接続を試みる
+  unsigned long now = millis();
+
+  // 1回のloopの間に「IP取得 → 切断」が続いても、両方を順に処理する
+  uint8_t tail = eventTail_.load(std::memory_order_relaxed);
+  while (tail != eventHead_.load(std::memory_order_acquire)) {
+    Event event = events_[tail % EVENT_QUEUE_SIZE];
+    eventTail_.store((uint8_t)(tail + 1), std::memory_order_release);
+    handleEvent(event, now);
+    tail = eventTail_.load(std::memory_order_relaxed);  // startAttempt() で破棄された場合に備えて読み直す
+  }
+
+  // キューがあふれてイベントを捨てた場合は、実際の接続状態に合わせる
+  if (eventsLost_.exchange(false)) {
+    stats_.eventOverflows++;
+    bool linkUp = (WiFi.status() == WL_CONNECTED);
+    LOG_W("[WiFi] イベントキューあふれ: 接続状態を再確認します (%s)", linkUp ? "接続中" : "切断中");
+    if (linkUp && state_ == State::CONNECTING) {
+      handleGotIp(now);
+    } else if (!linkUp && state_ == State::CONNECTED) {
+      handleDisconnect(0, now);
+    }
   }
-  return true;  // 接続中
+
+  switch (state_) {
+    case State::CONNECTING:
+      if (now - attemptStartTime_ > (attemptIsFast_ ? FAST_JOIN_TIMEOUT_MS : timeoutMs_)) {
+        LOG_W("[WiFi] 接続試行タイムアウト");
+        onAttemptFailed();
+      }
+      break;
+    case State::BACKOFF:
+      if ((long)(now - nextAttemptTime_) >= 0) {
+        startAttempt();
+      }
+      break;
+    default:
+      break;
+  }
+
+  return state_ == State::CONNECTED;
 }
 
 /**
  * WiFiが接続中かどうかを確認
  */
 bool WiFiManager::isConnected() {
-  return WiFi.status() == WL_CONNECTED;
+  return state_ == State::CONNECTED && WiFi.status() == WL_CONNECTED;
+}
+
+/**
+ * 接続状態の変化通知先を登録
+ */
+bool WiFiManager::addListener(ConnectionListener listener, void* context) {
+  if (listenerCount_ >= MAX_LISTENERS) {
+    return false;
+  }
+  listeners_[listenerCount_].callback = listener;
+  listeners_[listenerCount_].context = context;
+  listenerCount_++;
+  return true;
 }
 
 /**
  * 接続情報を表示
  */
 void WiFiManager::printConnectionInfo() {
-  Serial.print("[WiFi] IPアドレス: ");
-  Serial.println(WiFi.localIP());  // 取得したIPアドレスを表示
-  Serial.print("[WiFi] 電波強度 (RSSI): ");
-  Serial.print(WiFi.RSSI());       // 電波強度を表示（dBm）
-  Serial.println(" dBm");
+  LOG_I("[WiFi] IPアドレス: %s", WiFi.localIP().toString().c_str());
+  LOG_I("[WiFi] 電波強度 (RSSI): %d dBm", WiFi.RSSI());
+}
+
+/**
+ * WiFiイベントハンドラー（WiFiイベントタスクで実行される）
+ * ここではキューに積むだけにし、実際の処理はcheckConnection()で行います。
+ */
+void WiFiManager::onWiFiEvent(arduino_event_id_t event, arduino_event_info_t info) {
+  WiFiManager* self = instance_;
+  if (self == nullptr) {
+    return;
+  }
+
+  switch (event) {
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+      self->pushEvent(EventType::GOT_IP, 0);
+      break;
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+      self->pushEvent(EventType::DISCONNECTED, info.wifi_sta_disconnected.reason);
+      break;
+    case ARDUINO_EVENT_WIFI_STA_LOST_IP:
+      self->pushEvent(EventType::DISCONNECTED, 0);
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * イベントをキューに積む（WiFiイベントタスクで実行される）
+ * 満杯の場合は捨てて、loop側で実際の接続状態から状態を合わせ直します。
+ */
+void WiFiManager::pushEvent(EventType type, uint8_t reason) {
+  uint8_t head = eventHead_.load(std::memory_order_relaxed);
+  if ((uint8_t)(head - eventTail_.load(std::memory_order_acquire)) >= EVENT_QUEUE_SIZE) {
+    eventsLost_.store(true);
+    return;
+  }
+  events_[head % EVENT_QUEUE_SIZE].type = type;
+  events_[head % EVENT_QUEUE_SIZE].reason = reason;
+  eventHead_.store((uint8_t)(head + 1), std::memory_order_release);
+}
+
+/**
+ * キューから取り出したイベントを1件処理
+ */
+void WiFiManager::handleEvent(const Event& event, unsigned long now) {
+  switch (event.type) {
+    case EventType::GOT_IP:
+      handleGotIp(now);
+      break;
+    case EventType::DISCONNECTED:
+      handleDisconnect(event.reason, now);
+      break;
+  }
+}
+
+/**
+ * IPアドレス取得 → 接続完了
+ */
+void WiFiManager::handleGotIp(unsigned long now) {
+  if (state_ == State::CONNECTED) {
+    return;
+  }
+
+  bool wasReconnect = (disconnectedAt_ != 0);
+  state_ = State::CONNECTED;
+  consecutiveFailures_ = 0;
+  fastJoinDisabled_ = false;
+
+  stats_.lastConnectMs = now - attemptStartTime_;
+  stats_.lastConnectWasFast = attemptIsFast_;
+  LOG_I("[WiFi] WiFi接続成功！ (%lu ms, %s)", stats_.lastConnectMs,
+        attemptIsFast_ ? "高速接続" : "フルスキャン");
+  saveJoinCache();
+  if (wasReconnect) {
+    stats_.reconnectCount++;
+    stats_.lastReconnectMs = now - disconnectedAt_;
+    if (stats_.lastReconnectMs > stats_.maxReconnectMs) {
+      stats_.maxReconnectMs = stats_.lastReconnectMs;
+    }
+    LOG_I("[WiFi] 再接続所要時間: %lu ms", stats_.lastReconnectMs);
+    disconnectedAt_ = 0;
+  }
+  printConnectionInfo();
+  notify(true);
+}
+
+/**
+ * 切断イベント
+ */
+void WiFiManager::handleDisconnect(uint8_t reason, unsigned long now) {
+  stats_.lastDisconnectReason = reason;
+
+  if (state_ == State::CONNECTED) {
+    LOG_W("[WiFi] WiFi切断を検出 (理由: %u)、再接続を試みます...", reason);
+    stats_.disconnectCount++;
+    disconnectedAt_ = now;
+    notify(false);
+    startAttempt();  // 初回は待たずに再接続
+  } else if (state_ == State::CONNECTING) {
+    // 後ろにIP取得が続いていれば、接続前の切断（前の接続の後始末）なので無視する
+    uint8_t head = eventHead_.load(std::memory_order_acquire);
+    for (uint8_t i = eventTail_.load(std::memory_order_relaxed); i != head; i++) {
+      if (events_[i % EVENT_QUEUE_SIZE].type == EventType::GOT_IP) {
+        return;
+      }
+    }
+    onAttemptFailed();  // 接続試行が失敗した
+  }
+  // BACKOFF中の切断イベント（自分で切断したもの）は無視
+}
+
+/**
+ * 未処理のイベントを破棄（loopからのみ呼ぶ）
+ */
+void WiFiManager::discardEvents() {
+  eventTail_.store(eventHead_.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+/**
+ * 接続試行を開始（結果はイベントで受け取る）
+ */
+void WiFiManager::startAttempt() {
+  stats_.connectAttempts++;
+  discardEvents();  // 前回の試行・切断で残ったイベントは破棄
+  state_ = State::CONNECTING;
+  attemptStartTime_ = millis();
+
+  uint32_t ssidHash = JoinCache::hash(reinterpret_cast<const uint8_t*>(ssid_), strlen(ssid_));
+  JoinCache::Record cache;
+  attemptIsFast_ = !fastJoinDisabled_ && JoinCache::load(ssidHash, cache);
+
+  if (attemptIsFast_) {
+    // 前回のAPにチャンネル・BSSIDを指定して直接接続（スキャンを省略）
+    stats_.fastJoinAttempts++;
+    if (reuseLease_ && cache.ip != 0) {
+      WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway), IPAddress(cache.subnet),
+                  IPAddress(cache.dns));
+    }
+    WiFi.begin(ssid_, password_, cache.channel, cache.bssid);
+  } else {
+    // DHCPに戻してフルスキャンで接続
+    WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));
+    WiFi.begin(ssid_, password_);
+  }
+}
+
+/**
+ * 接続試行の失敗を処理
+ * 高速接続が失敗した場合は、バックオフせずにすぐフルスキャンで再試行します。
+ */
+void WiFiManager::onAttemptFailed() {
+  if (attemptIsFast_) {
+    LOG_W("[WiFi] 前回のAPへの高速接続失敗、フルスキャンで再試行");
+    stats_.fastJoinFailures++;
+    fastJoinDisabled_ = true;
+    JoinCache::invalidate();
+
+    // 切断イベントが落ち着くまでわずかに待ってから再試行
+    state_ = State::BACKOFF;
+    nextAttemptTime_ = millis() + FALLBACK_DELAY_MS;
+    WiFi.disconnect();
+    return;
+  }
+  enterBackoff();
+}
+
+/**
+ * 接続失敗: 指数バックオフで次回試行を予約
+ */
+void WiFiManager::enterBackoff() {
+  if (consecutiveFailures_ < 255) {
+    consecutiveFailures_++;
+  }
+
+  // 1秒, 2秒, 4秒, ... 上限60秒
+  unsigned long delayMs = BACKOFF_BASE_MS;
+  for (uint8_t i = 1; i < consecutiveFailures_ && delayMs < BACKOFF_MAX_MS; i++) {
+    delayMs *= 2;
+  }
+  if (delayMs > BACKOFF_MAX_MS) {
+    delayMs = BACKOFF_MAX_MS;
+  }
+
+  state_ = State::BACKOFF;
+  nextAttemptTime_ = millis() + delayMs;
+  WiFi.disconnect();  // 進行中の接続処理を中断
+
+  LOG_W("[WiFi] 接続失敗 (%u回連続)、%lu ms後に再試行", consecutiveFailures_, delayMs);
+}
+
+/**
+ * 接続に成功したAPとIP設定をキャッシュに保存
+ * NVSは内容が変わった場合のみ書き込み、フラッシュの消耗を抑えます。
+ */
+void WiFiManager::saveJoinCache() {
+  const uint8_t* bssid = WiFi.BSSID();
+  if (bssid == nullptr) {
+    return;
+  }
+
+  JoinCache::Record record = {};
+  record.magic = JoinCache::MAGIC;
+  record.ssidHash = JoinCache::hash(reinterpret_cast<const uint8_t*>(ssid_), strlen(ssid_));
+  memcpy(record.bssid, bssid, sizeof(record.bssid));
+  record.channel = (uint8_t)WiFi.channel();
+  record.ip = (uint32_t)WiFi.localIP();
+  record.gateway = (uint32_t)WiFi.gatewayIP();
+  record.subnet = (uint32_t)WiFi.subnetMask();
+  record.dns = (uint32_t)WiFi.dnsIP();
+  record.checksum = JoinCache::checksumOf(record);
+
+  bool changed = memcmp(&record, &JoinCache::rtcRecord, sizeof(record)) != 0;
+  JoinCache::rtcRecord = record;
+  if (!changed) {
+    return;
+  }
+
+  Preferences prefs;
+  if (prefs.begin(JoinCache::NAMESPACE, false)) {
+    JoinCache::Record stored;
+    if (prefs.getBytes(JoinCache::KEY, &stored, sizeof(stored)) != sizeof(stored) ||
+        memcmp(&stored, &record, sizeof(record)) != 0) {
+      prefs.putBytes(JoinCache::KEY, &record, sizeof(record));
+    }
+    prefs.end();
+  }
+}
+
+/**
+ * 接続状態の変化を登録先に通知
+ */
+void WiFiManager::notify(bool connected) {
+  for (uint8_t i = 0; i < listenerCount_; i++) {
+    listeners_[i].callback(connected, listeners_[i].context);
+  }
 }
@@ -12,20 +12,43 @@
 #include "DisplayController.h"
 #include "WiFiManager.h"
 #include "TimeManager.h"
+#include "ScheduleEngine.h"
 #include "AutoStopController.h"
 #include "WeatherForecast.h"
+#include "HttpSession.h"
+#include "BootSequence.h"
+#include "StateStore.h"
+#include "LoopWatchdog.h"
+#include "BoardConfig.h"  // ボードの構成・機能の有効/無効（platformio.ini の環境ごと）
+#if FEATURE_METRICS
+#include "MetricsServer.h"
+#endif
+#if FEATURE_MQTT
+#include "MqttBridge.h"
+#endif
+#if FEATURE_TELEMETRY
+#include "TelemetryBuffer.h"
+#endif
+#if FEATURE_WEB
+#include "WebApi.h"
+#endif
+#if FEATURE_TRACE
+#include "TraceRecorder.h"
+#endif
+#include "TraceFormat.h"  // Trace::Source（トレース記録を除去した場合も traceCommands() の引数に使う）
+#if FEATURE_PREDICT
+#include "ThermalModel.h"
+#endif
+#include "ComfortIndex.h"
+#include "Log.h"
 #include "secrets.h"  // WiFi認証情報（Gitにコミットされない）
 
 // ========================================
 // 設定
 // ========================================
 
-// ハードウェアピン設定
-namespace HardwareConfig {
-  constexpr uint8_t DHT_PIN = 32;
-  constexpr uint8_t IR_RECV_PIN = 18;
-  constexpr uint8_t IR_SEND_PIN = 5;
-}
+// ボード（ピン・センサーの種類・ディスプレイ・DIの閾値）は BoardConfig.h の Board::Current
+using BoardSpec = Board::Current;
 
 // センサーオフセット
 namespace SensorConfig {
@@ -36,6 +59,7 @@ namespace SensorConfig {
 // WiFi設定
 namespace WiFiConfig {
   constexpr unsigned long CONNECT_TIMEOUT_MS = 10000;  // 接続タイムアウト（10秒）
+  constexpr bool REUSE_DHCP_LEASE = false;             // 前回のDHCPリースを静的IPとして再利用
 }
 
 // 時刻設定
@@ -46,49 +70,569 @@ namespace TimeConfig {
   constexpr int AUTO_STOP_HOUR = 23;        // 自動停止する時刻（23時）
 }
 
-// ディスプレイ設定
-namespace DisplayConfig {
-  constexpr uint8_t SCREEN_WIDTH = 128;
-  constexpr uint8_t SCREEN_HEIGHT = 64;
-  constexpr int8_t OLED_RESET = -1;
-  constexpr uint8_t SCREEN_ADDRESS = 0x3C;
-}
-
 // タイミング設定
 namespace TimingConfig {
-  constexpr unsigned long SENSOR_READ_INTERVAL_MS = 2000;   // センサー読み取り間隔
+  constexpr unsigned long SENSOR_READ_INTERVAL_MS = 2000;   // センサー読み取りの最短間隔（変化が速い時・モード変更の直後）
+  constexpr unsigned long SENSOR_READ_MAX_INTERVAL_MS = 300000; // センサー読み取りの最長間隔（エアコン停止中で安定している時、5分）
   constexpr unsigned long CONTROL_INTERVAL_MS = 60000;      // エアコン制御間隔
-  constexpr unsigned long AUTO_STOP_CHECK_INTERVAL_MS = 60000;  // 自動停止チェック間隔
   constexpr unsigned long WEATHER_UPDATE_INTERVAL_MS = 3600000; // 天気予報更新間隔（1時間）
-  constexpr unsigned long STARTUP_DELAY_MS = 2000;          // 起動時の待機時間
+  constexpr unsigned long BOOT_NETWORK_TIMEOUT_MS = 30000;   // 起動時のWiFi接続・NTP同期の報告期限（過ぎても完了を待ち続ける）
 }
 
 // 天気予報設定（東京の座標）
 namespace WeatherConfig {
+  const char* API_HOST = "api.open-meteo.com";
   constexpr float LATITUDE = 35.653204f;
   constexpr float LONGITUDE = 139.688272f;
 }
 
+// Web API・ダッシュボード設定
+namespace WebConfig {
+  constexpr uint16_t PORT = 80;
+}
+
+// メトリクス公開設定（Prometheus）
+namespace MetricsConfig {
+  constexpr uint16_t PORT = 9100;  // node_exporterと同じ慣例のポート
+}
+
+// MQTT設定（ブローカーの接続情報は secrets.h）
+namespace MqttConfig {
+  constexpr uint16_t PORT = 1883;
+  const char* DEVICE_ID = "living";                       // クライアントID・トピック名（aircon/<DEVICE_ID>/...）
+  constexpr unsigned long FLUSH_INTERVAL_MS = 30000;      // センサー値をまとめて送信する間隔
+  constexpr unsigned long HEALTH_INTERVAL_MS = 60000;     // 稼働状況の送信間隔
+}
+
+// テレメトリ収集サーバー設定（切断中はフラッシュに蓄積し、接続回復後にまとめて送信）
+namespace TelemetryConfig {
+  const char* HOST = "192.168.1.10";                      // 収集サーバー（LAN内のPCなど）
+  constexpr uint16_t PORT = 8080;
+  const char* PATH = "/telemetry?device=living";
+  constexpr unsigned long FLUSH_INTERVAL_MS = 60000;      // 接続中にまとめて送信する間隔
+}
+
+// 予測制御設定（部屋の熱モデルを学習し、予測した室温で先にモードを選ぶ。FEATURE_PREDICT）
+namespace PredictConfig {
+  constexpr uint32_t SAMPLE_INTERVAL_SEC = 600;   // 学習する区間の長さ
+  constexpr uint32_t HORIZON_SEC = 1800;          // 何秒先の室温でモードを選ぶか
+}
+
+// 状態の保存設定（再起動後にモード・スケジュールの実行記録・熱モデルなどを引き継ぐ）
+namespace StateConfig {
+  const char* NVS_NAMESPACE = "state";
+  constexpr uint16_t VERSION = 1;                       // PersistedState の形式を変えたら増やす
+  constexpr unsigned long CAPTURE_INTERVAL_MS = 5000;   // センサー値・熱モデルなどをRTCメモリに記録する間隔
+  constexpr unsigned long NVS_INTERVAL_MS = 3600000;    // それらの変化をNVSに書き込む最短の間隔（1時間）
+  constexpr uint32_t SENSOR_MAX_AGE_SEC = 300;          // 復元するセンサー値の古さの上限
+}
+
+// ループの監視設定（段階ごとのソフトの期限は下の LOOP_STAGES）
+namespace WatchdogConfig {
+  constexpr uint32_t TIMEOUT_SEC = 30;   // loop() がこの間戻らなければリセット（最長のHTTP通信より長く）
+}
+
+// loop() の処理段階（LOOP_STAGES と同じ順序。足跡はRTCメモリに残り、リセット後に表示される）
+enum LoopStageId : uint8_t {
+  STAGE_WIFI,
+  STAGE_TIME,
+  STAGE_IR,
+  STAGE_BOOT,
+  STAGE_WEATHER,
+  STAGE_METRICS,
+  STAGE_WEB,
+  STAGE_MQTT,
+  STAGE_TELEMETRY,
+  STAGE_TRACE,
+  STAGE_SCHEDULE,
+  STAGE_COMMAND,
+  STAGE_STATE,
+  STAGE_SENSOR,
+  STAGE_DISPLAY,
+  STAGE_CONTROL,
+  STAGE_COUNT
+};
+
+// 段階の名前とソフトの期限（超えるとログに警告。ハードウェアのウォッチドッグは TIMEOUT_SEC）
+const LoopStage LOOP_STAGES[STAGE_COUNT] = {
+  { "wifi",      200 },    // 再接続の開始（接続待ちはしない）
+  { "time",      50 },
+  { "ir",        50 },     // 赤外線の受信処理
+  { "boot",      1000 },   // 起動ステージ（待ち受けの開始・取得タスクの作成）
+  { "weather",   200 },    // 天気予報の取得要求と結果の反映（HTTP取得は取得タスクで行う）
+  { "metrics",   100 },    // メトリクスの生成と送信（リクエスト行は待たずに次のloopで続きを読む）
+  { "web",       200 },    // Web APIのコマンドの受け付け
+  { "mqtt",      2500 },   // MQTTの接続・送信（ソケットタイムアウト2秒）
+  { "telemetry", 6000 },   // テレメトリの送信（HTTP）
+  { "trace",     300 },    // トレースのフラッシュへの書き込み
+  { "schedule",  300 },    // スケジュールの実行
+  { "command",   600 },    // 送信待ちのコマンドの赤外線送信（送信後の待ち200msを含む）
+  { "state",     100 },    // 状態の記録（NVSへの書き込みを含む）
+  { "sensor",    300 },    // DHT22の読み取り
+  { "display",   100 },    // OLEDの描画（I2C）
+  { "control",   300 },    // モードの判定・熱モデル
+};
+
 // ========================================
 // グローバルオブジェクト
 // ========================================
 
 // デバイス制御
-AirConditionerController airConditioner(HardwareConfig::IR_SEND_PIN, HardwareConfig::IR_RECV_PIN);
-EnvironmentSensor sensor(HardwareConfig::DHT_PIN, DHT22, SensorConfig::TEMP_OFFSET, SensorConfig::HUM_OFFSET);
-DisplayController displayCtrl(DisplayConfig::SCREEN_WIDTH, DisplayConfig::SCREEN_HEIGHT,
-                               &Wire, DisplayConfig::OLED_RESET, DisplayConfig::SCREEN_ADDRESS);
+AirConditionerController airConditioner(BoardSpec::IR_SEND_PIN, BoardSpec::IR_RECV_PIN);
+EnvironmentSensor sensor(BoardSpec::DHT_PIN, BoardSpec::SENSOR_TYPE, SensorConfig::TEMP_OFFSET, SensorConfig::HUM_OFFSET);
+DisplayController<BoardSpec::Display> displayCtrl(&Wire);
 
 // 機能管理クラス
 WiFiManager wifiMgr(WiFiSecrets::SSID, WiFiSecrets::PASSWORD, WiFiConfig::CONNECT_TIMEOUT_MS);
 TimeManager timeMgr(TimeConfig::NTP_SERVER, TimeConfig::GMT_OFFSET_SEC, TimeConfig::DAYLIGHT_OFFSET_SEC);
-AutoStopController autoStop(airConditioner, timeMgr, TimeConfig::AUTO_STOP_HOUR);
-WeatherForecast weatherForecast(WeatherConfig::LATITUDE, WeatherConfig::LONGITUDE);
+ScheduleEngine scheduler(airConditioner, timeMgr);
+AutoStopController autoStop(scheduler, TimeConfig::AUTO_STOP_HOUR);
+
+// 通信（ホストごとに接続を共有）
+HttpSession weatherHttp(WeatherConfig::API_HOST);
+WeatherForecast weatherForecast(weatherHttp, WeatherConfig::LATITUDE, WeatherConfig::LONGITUDE);
+
+#if FEATURE_TELEMETRY
+HttpSession telemetryHttp(TelemetryConfig::HOST, TelemetryConfig::PORT);
+TelemetryBuffer telemetry(telemetryHttp, timeMgr, TelemetryConfig::PATH);
+#endif
+
+// Web API・ダッシュボード
+#if FEATURE_WEB
+WebApi webApi(airConditioner, autoStop, sensor, weatherForecast, WebConfig::PORT);
+#endif
+
+// メトリクス公開
+#if FEATURE_METRICS
+MetricsServer metrics(MetricsConfig::PORT);
+#endif
+
+// トレース記録
+#if FEATURE_TRACE
+TraceRecorder trace(timeMgr, weatherForecast);
+#endif
+
+// 予測制御（部屋の熱モデル）
+#if FEATURE_PREDICT
+ThermalModel thermalModel(PredictConfig::SAMPLE_INTERVAL_SEC, PredictConfig::HORIZON_SEC);
+#endif
+
+// MQTT（テレメトリ送信・コマンド受信）
+#if FEATURE_MQTT
+MqttBridge mqtt(airConditioner, autoStop, timeMgr, MqttSecrets::HOST, MqttConfig::PORT, MqttConfig::DEVICE_ID);
+#endif
+
+// ループの監視（タスクウォッチドッグ・処理段階の足跡）
+LoopWatchdog watchdog(LOOP_STAGES, STAGE_COUNT, WatchdogConfig::TIMEOUT_SEC);
+
+// 状態の保存（RTCメモリ・NVS）
+StateStore stateStore(StateConfig::NVS_NAMESPACE, StateConfig::VERSION, StateConfig::NVS_INTERVAL_MS);
+
+// 起動ステージ
+BootSequence bootSequence;
+int weatherStage = -1;
 
 // タイミング管理
-unsigned long lastSensorReadTime = 0;
 unsigned long lastControlTime = 0;
-unsigned long lastAutoStopCheckTime = 0;
+ACMode lastSampledMode = ACMode::NONE;  // 読み取り間隔を決めた時のエアコンのモード
+SensorData lastReading;                 // 最新の読み取り結果（不快指数付き、エラーを含む）
+long displayedMinute = -1;              // ディスプレイに表示中の時刻（分、-1: 未表示）
+unsigned long lastLoopStartUs = 0;  // メトリクスのループ処理時間（FEATURE_METRICS）
+unsigned long lastStateCaptureTime = 0;
+
+// ========================================
+// トレース記録
+// ========================================
+
+/**
+ * 外部からの操作（Web API・MQTT）によるモード・自動停止の変化をトレースに記録
+ * 各update()の前後の状態を比べるため、操作を受け付けるクラスには手を入れずに済みます。
+ * モードは送信待ちのコマンドを含めて比べます（送信は後の airConditioner.update() で行われるため）。
+ */
+#if FEATURE_TRACE
+void traceCommands(Trace::Source source, ACMode modeBefore, bool autoStopBefore) {
+  ACMode mode = airConditioner.getTargetMode();
+  if (mode != modeBefore) {
+    trace.recordCommand(source, Trace::COMMAND_MODE, (uint8_t)mode);
+  }
+  bool enabled = autoStop.isEnabled();
+  if (enabled != autoStopBefore) {
+    trace.recordCommand(source, Trace::COMMAND_AUTO_STOP, enabled ? 1 : 0);
+  }
+}
+#else
+void traceCommands(Trace::Source, ACMode, bool) {}
+#endif
+
+// ========================================
+// 予測制御
+// ========================================
+
+#if FEATURE_PREDICT
+
+/**
+ * 天気予報（今日の最高・最低気温）から推定した外気温
+ * @param now 現在の外気温
+ * @param later 熱モデルの予測時間後の外気温
+ * @return false: 天気予報・時刻が未取得
+ */
+bool forecastOutdoor(float& now, float& later) {
+  if (!timeMgr.isTimeValid()) {
+    return false;
+  }
+  WeatherData weather = weatherForecast.getData();
+  if (!weather.isValid) {
+    return false;
+  }
+  const struct tm& local = timeMgr.now();
+  float hour = local.tm_hour + local.tm_min / 60.0f;
+  now = ThermalModel::outdoorTemperature(weather.tempMax, weather.tempMin, hour);
+  later = ThermalModel::outdoorTemperature(weather.tempMax, weather.tempMin,
+                                           hour + PredictConfig::HORIZON_SEC / 3600.0f);
+  return true;
+}
+#endif
+
+// ========================================
+// 状態の保存・復元
+// ========================================
+
+/**
+ * 再起動をまたいで引き継ぐ状態（StateStore に固定長のまま保存）
+ * 項目を変えたら StateConfig::VERSION を増やしてください（前の形式の記録は復元されません）。
+ */
+struct PersistedState {
+  uint32_t savedAt;                 // 記録した時刻（エポック秒、時刻未同期時は0）
+  uint32_t scheduleLastFired;       // 最後に実行したスケジュールの時刻（自動停止を二重に実行しない）
+  uint8_t acMode;                   // 最後に送信したモード（ACMode、再起動後に同じ信号を送り直さない）
+  uint8_t autoStopEnabled;          // 自動停止機能の有効/無効（Web API・MQTTで変更した値）
+  uint8_t hasSensor;
+  uint8_t hasWeather;
+  int16_t temperature;              // 最後のセンサー値（0.01単位）
+  int16_t humidity;
+  int16_t discomfortIndex;
+  uint16_t reserved;
+  WeatherSnapshot weather;          // 天気予報（日次）
+#if FEATURE_PREDICT
+  ThermalModel::Snapshot thermal;   // 学習した熱モデル
+#endif
+};
+
+static_assert(sizeof(PersistedState) <= StateStore::MAX_BYTES, "PersistedState が StateStore に収まりません");
+
+PersistedState savedState;  // 最後に記録した状態
+
+/**
+ * 現在の状態を集める（余白も比較されるため、先に全体を0で埋める）
+ */
+void captureState(PersistedState& state) {
+  memset(&state, 0, sizeof(state));
+  state.savedAt = timeMgr.isTimeValid() ? (uint32_t)timeMgr.epoch() : 0;
+  state.scheduleLastFired = (uint32_t)scheduler.getLastFireTime();
+  state.acMode = (uint8_t)airConditioner.getCurrentMode();
+  state.autoStopEnabled = autoStop.isEnabled() ? 1 : 0;
+
+  const SensorData& data = sensor.getLastData();
+  state.hasSensor = data.isValid ? 1 : 0;
+  state.temperature = data.temperature;
+  state.humidity = data.humidity;
+  state.discomfortIndex = data.discomfortIndex;
+
+  state.hasWeather = weatherForecast.getSnapshot(state.weather) ? 1 : 0;
+#if FEATURE_PREDICT
+  thermalModel.save(state.thermal);
+#endif
+}
+
+/**
+ * 状態の記録（loop関数内で毎回呼び出す）
+ * モード・自動停止・スケジュールの実行が変わった時はすぐにNVSまで書き込み、
+ * それ以外（センサー値・天気予報・熱モデル）はCAPTURE_INTERVAL_MSごとにRTCメモリにだけ記録します。
+ */
+void persistState() {
+  bool durable = (uint8_t)airConditioner.getCurrentMode() != savedState.acMode ||
+                 (autoStop.isEnabled() ? 1 : 0) != savedState.autoStopEnabled ||
+                 (uint32_t)scheduler.getLastFireTime() != savedState.scheduleLastFired;
+  unsigned long now = millis();
+  if (!durable && now - lastStateCaptureTime < StateConfig::CAPTURE_INTERVAL_MS) {
+    return;
+  }
+  lastStateCaptureTime = now;
+
+  captureState(savedState);
+  stateStore.commit(&savedState, sizeof(savedState), durable);
+}
+
+/**
+ * 前回の起動の状態を復元（時刻の復元後・最初のスケジュール確認と制御の前）
+ * ソフトリセット後はRTCメモリから、電源断後はNVSから読み込みます。
+ */
+void restoreState() {
+  PersistedState state;
+  StateStore::Source source = stateStore.restore(&state, sizeof(state));
+  if (source == StateStore::Source::NONE) {
+    LOG_I("[State] 保存された状態なし");
+    return;
+  }
+
+  ACMode modeBefore = airConditioner.getTargetMode();
+  bool autoStopBefore = autoStop.isEnabled();
+  airConditioner.restoreMode((ACMode)state.acMode);
+  if ((state.autoStopEnabled != 0) != autoStopBefore) {
+    autoStop.setEnabled(state.autoStopEnabled != 0);
+  }
+  traceCommands(Trace::SOURCE_RESTORE, modeBefore, autoStopBefore);
+  scheduler.restoreLastFireTime((time_t)state.scheduleLastFired);
+
+  // 天気予報はソフトリセット後だけ（NVSには取得ごとに保存した天気予報のキャッシュの方が新しい）
+  if (state.hasWeather && source == StateStore::Source::RTC) {
+    weatherForecast.restoreSnapshot(state.weather);
+  }
+#if FEATURE_PREDICT
+  if (!thermalModel.restore(state.thermal)) {
+    LOG_W("[State] 熱モデルの値が不正なため学習をやり直します");
+  }
+#endif
+
+  // センサー値は記録から間もない場合だけ（最初の読み取りまでの表示・API応答用）
+  uint32_t now = timeMgr.isTimeValid() ? (uint32_t)timeMgr.epoch() : 0;
+  if (state.hasSensor && state.savedAt != 0 && now >= state.savedAt &&
+      now - state.savedAt <= StateConfig::SENSOR_MAX_AGE_SEC) {
+    sensor.restoreLastData(SensorData(state.temperature, state.humidity, state.discomfortIndex, true));
+  }
+
+  savedState = state;
+  LOG_I("[State] 復元: %s（%lu us）モード %s / 自動停止 %s",
+        StateStore::sourceName(source), (unsigned long)stateStore.getStats().restoreUs,
+        AirConditionerController::modeToKey(airConditioner.getCurrentMode()),
+        autoStop.isEnabled() ? "有効" : "無効");
+}
+
+// ========================================
+// メトリクス
+// ========================================
+
+#if FEATURE_METRICS
+void registerMetrics() {
+  // エアコン（赤外線送受信・現在のモード）
+  metrics.addCollector([](MetricsWriter& w, void*) {
+    const ACStats& stats = airConditioner.getStats();
+    w.counter("controller_ir_transmit_total", "IR frames sent to the air conditioner", stats.irSendCount);
+    w.counter("controller_ir_receive_total", "IR frames decoded by the receiver", stats.irReceiveCount);
+
+    const ACQueueStats& queue = airConditioner.getQueueStats();
+    w.gauge("controller_ac_command_queue_depth", "AC commands waiting to be sent", queue.depth);
+    w.gauge("controller_ac_command_queue_max_depth", "Most AC commands waiting at once", queue.maxDepth);
+    w.counter("controller_ac_commands_requested_total", "AC mode changes requested", queue.requested);
+    w.counter("controller_ac_commands_coalesced_total", "AC commands superseded before being sent",
+              queue.coalesced);
+    w.header("controller_ac_command_latency_seconds", "Time from request to end of IR transmission", "summary");
+    w.sample("controller_ac_command_latency_seconds_sum", nullptr, queue.totalLatencyMs / 1000.0);
+    w.sample("controller_ac_command_latency_seconds_count", nullptr, queue.sent);
+    w.gauge("controller_ac_command_latency_max_seconds", "Longest AC command latency",
+            queue.maxLatencyMs / 1000.0);
+
+    static const ACMode MODES[] = {
+      ACMode::NONE, ACMode::OFF, ACMode::COOLING_20, ACMode::AUTO_PLUS_1, ACMode::DEHUMID_MINUS_1_5
+    };
+    ACMode current = airConditioner.getCurrentMode();
+    w.header("controller_ac_mode", "Last mode sent to the air conditioner (1 = current)", "gauge");
+    char label[32];
+    for (ACMode mode : MODES) {
+      snprintf(label, sizeof(label), "mode=\"%s\"", AirConditionerController::modeToKey(mode));
+      w.sample("controller_ac_mode", label, (uint32_t)(mode == current ? 1 : 0));
+    }
+  });
+
+  // 温湿度センサー
+  metrics.addCollector([](MetricsWriter& w, void*) {
+    const SensorStats& stats = sensor.getStats();
+    w.counter("controller_sensor_reads_total", "DHT22 read attempts", stats.readCount);
+    w.counter("controller_sensor_read_errors_total", "DHT22 read failures", stats.readErrors);
+
+    const AdaptiveSampler& sampler = sensor.getSampler();
+    const SamplerStats& samplerStats = sampler.getStats();
+    w.gauge("controller_sensor_interval_seconds", "Current adaptive sensor read interval",
+            sampler.getInterval() / 1000.0f);
+    w.gauge("controller_sensor_samples_per_hour", "Effective sensor read rate (moving average)",
+            sampler.getSamplesPerHour());
+    w.counter("controller_sensor_interval_shortened_total", "Read interval halved on fast change",
+              samplerStats.shortened);
+    w.counter("controller_sensor_interval_lengthened_total", "Read interval lengthened while steady",
+              samplerStats.lengthened);
+    w.counter("controller_sensor_transitions_total", "Read interval reset on an AC mode change",
+              samplerStats.transitions);
+
+    const SensorData& data = sensor.getLastData();
+    if (data.isValid) {
+      w.gauge("controller_temperature_celsius", "Room temperature (offset applied)",
+              Fixed::toFloat(data.temperature));
+      w.gauge("controller_humidity_percent", "Room relative humidity", Fixed::toFloat(data.humidity));
+      w.gauge("controller_discomfort_index", "Discomfort index of the last reading",
+              Fixed::toFloat(Comfort::discomfortIndex(data.temperature, data.humidity)));
+    }
+  });
+
+  // WiFi
+  metrics.addCollector([](MetricsWriter& w, void*) {
+    const WiFiStats& stats = wifiMgr.getStats();
+    bool connected = wifiMgr.isConnected();
+    w.gauge("controller_wifi_connected", "1 if associated and holding an IP address", connected ? 1 : 0);
+    if (connected) {
+      w.gauge("controller_wifi_rssi_dbm", "Received signal strength", WiFi.RSSI());
+    }
+    w.counter("controller_wifi_disconnects_total", "Disconnects while connected", stats.disconnectCount);
+    w.counter("controller_wifi_reconnects_total", "Successful reconnects after a disconnect", stats.reconnectCount);
+    w.gauge("controller_wifi_last_reconnect_seconds", "Duration of the last disconnect",
+            stats.lastReconnectMs / 1000.0);
+    w.counter("controller_wifi_event_overflows_total", "Times the WiFi event queue overflowed and state was resynced",
+              stats.eventOverflows);
+  });
+
+  // ログ
+  metrics.addCollector([](MetricsWriter& w, void*) {
+    Log::Stats stats = Log::getStats();
+    w.counter("controller_log_records_total", "Log records queued", stats.written);
+    w.counter("controller_log_dropped_total", "Log records dropped because the ring buffer was full", stats.dropped);
+  });
+
+#if FEATURE_MQTT
+  // MQTT
+  metrics.addCollector([](MetricsWriter& w, void*) {
+    const MqttStats& stats = mqtt.getStats();
+    w.gauge("controller_mqtt_connected", "1 while connected to the MQTT broker", mqtt.isConnected() ? 1 : 0);
+    w.counter("controller_mqtt_publishes_total", "MQTT messages published", stats.publishCount);
+    w.counter("controller_mqtt_publish_failures_total", "MQTT publish failures", stats.publishFailures);
+    w.gauge("controller_mqtt_publish_seconds", "Duration of the last publish", stats.lastPublishUs / 1e6);
+    w.gauge("controller_mqtt_publish_max_seconds", "Longest publish since boot", stats.maxPublishUs / 1e6);
+    w.gauge("controller_mqtt_queue_depth", "Sensor samples waiting to be published", mqtt.getQueueDepth());
+    w.counter("controller_mqtt_samples_dropped_total", "Sensor samples dropped because the queue was full",
+              stats.samplesDropped);
+    w.counter("controller_mqtt_commands_total", "Commands received on the command topic", stats.commandsReceived);
+    w.counter("controller_mqtt_commands_rejected_total", "Commands that could not be parsed",
+              stats.commandsRejected);
+  });
+#endif
+
+#if FEATURE_TELEMETRY
+  // テレメトリ蓄積送信
+  metrics.addCollector([](MetricsWriter& w, void*) {
+    const TelemetryStats& stats = telemetry.getStats();
+    w.gauge("controller_telemetry_pending_records", "Telemetry records not yet delivered", telemetry.getPendingRecords());
+    w.gauge("controller_telemetry_stored_bytes", "Telemetry bytes buffered in flash", telemetry.getStoredBytes());
+    w.counter("controller_telemetry_sent_records_total", "Telemetry records delivered", stats.recordsSent);
+    w.counter("controller_telemetry_dropped_records_total", "Telemetry records discarded because the flash ring was full",
+              stats.recordsDropped);
+    w.counter("controller_telemetry_flash_writes_total", "Telemetry segments written to flash", stats.segmentsWritten);
+    w.counter("controller_telemetry_upload_failures_total", "Telemetry uploads that failed", stats.uploadFailures);
+    w.counter("controller_telemetry_sent_bytes_total", "Compressed telemetry bytes uploaded", stats.bytesSent);
+    w.gauge("controller_telemetry_drain_bytes_per_second", "Throughput of the last upload", stats.lastBytesPerSec);
+  });
+#endif
+
+#if FEATURE_WEB
+  // Web API
+  metrics.addCollector([](MetricsWriter& w, void*) {
+    const WebApiStats& stats = webApi.getStats();
+    w.counter("controller_web_requests_total", "HTTP requests handled by the web API", stats.requests);
+    w.counter("controller_web_not_found_total", "Web API requests answered with 404", stats.notFound);
+    w.counter("controller_web_bad_requests_total", "Web API requests answered with 400", stats.badRequests);
+    w.counter("controller_web_commands_total", "Commands accepted by the web API", stats.commandsQueued);
+    w.gauge("controller_web_handler_max_seconds", "Longest web API handler since boot", stats.maxHandlerUs / 1e6);
+    w.gauge("controller_ws_clients", "Connected WebSocket clients", webApi.getClientCount());
+    w.counter("controller_ws_messages_total", "State deltas pushed over WebSocket", stats.wsMessages);
+    w.counter("controller_ws_bytes_total", "Bytes of state deltas pushed (once per delta, not per client)", stats.wsBytes);
+    w.counter("controller_ws_dropped_clients_total", "Deltas after which slow WebSocket clients were closed (full send queue)",
+              stats.wsDroppedClients);
+    w.gauge("controller_ws_fanout_seconds", "Time to queue the last delta for all clients", stats.lastFanoutUs / 1e6);
+  });
+#endif
+
+#if FEATURE_PREDICT
+  // 熱モデル（予測誤差・学習した係数）
+  metrics.addCollector([](MetricsWriter& w, void*) {
+    const ThermalStats& stats = thermalModel.getStats();
+    w.counter("controller_thermal_samples_total", "Intervals learned by the room thermal model", stats.samples);
+    w.counter("controller_thermal_skipped_total", "Intervals discarded because the mode changed", stats.skipped);
+    w.gauge("controller_thermal_step_error_celsius", "RMS error of the one-interval-ahead temperature prediction",
+            stats.stepErrorC);
+    w.gauge("controller_thermal_horizon_error_celsius", "RMS error of the horizon-ahead temperature prediction",
+            stats.horizonErrorC);
+    w.gauge("controller_thermal_ready", "1 while predictions are used to pick the mode ahead of time",
+            thermalModel.isReady() ? 1 : 0);
+    w.counter("controller_thermal_anticipations_total", "Decisions escalated by the predicted temperature",
+              stats.anticipations);
+
+    static const char* const TERMS[ThermalModel::PARAMS] = {
+      "outdoor", "cool_20", "dry_minus_1_5", "auto_plus_1", "gain"
+    };
+    w.header("controller_thermal_coefficient", "Learned temperature change rate terms (celsius per hour)", "gauge");
+    char label[32];
+    for (uint8_t i = 0; i < ThermalModel::PARAMS; i++) {
+      snprintf(label, sizeof(label), "term=\"%s\"", TERMS[i]);
+      w.sample("controller_thermal_coefficient", label, (double)thermalModel.coefficient(i));
+    }
+  });
+#endif
+
+#if FEATURE_TRACE
+  // トレース記録
+  metrics.addCollector([](MetricsWriter& w, void*) {
+    const TraceStats& stats = trace.getStats();
+    w.gauge("controller_trace_recording", "1 while the control loop trace is being recorded",
+            trace.isRecording() ? 1 : 0);
+    w.counter("controller_trace_records_total", "Trace records captured", stats.records);
+    w.counter("controller_trace_flash_bytes_total", "Trace bytes written to flash", stats.bytesWritten);
+    w.counter("controller_trace_flash_writes_total", "Trace buffer flushes to flash", stats.flashWrites);
+    w.counter("controller_trace_write_errors_total", "Trace flushes that failed", stats.writeErrors);
+  });
+#endif
+
+  // ループの処理段階（期限超過・最長の所要時間、前回のリセット時に実行中だった段階）
+  metrics.addCollector([](MetricsWriter& w, void*) {
+    char label[32];
+    w.header("controller_loop_stage_overruns_total", "Loop stages that ran past their soft deadline", "counter");
+    for (uint8_t i = 0; i < watchdog.getStageCount(); i++) {
+      snprintf(label, sizeof(label), "stage=\"%s\"", watchdog.stageName(i));
+      w.sample("controller_loop_stage_overruns_total", label, watchdog.getStageStats(i).overruns);
+    }
+    w.header("controller_loop_stage_max_seconds", "Longest run of each loop stage since boot", "gauge");
+    for (uint8_t i = 0; i < watchdog.getStageCount(); i++) {
+      snprintf(label, sizeof(label), "stage=\"%s\"", watchdog.stageName(i));
+      w.sample("controller_loop_stage_max_seconds", label, watchdog.getStageStats(i).maxUs / 1e6);
+    }
+    uint8_t crashStage = watchdog.getCrashStage();
+    if (crashStage != LoopWatchdog::NO_STAGE) {
+      snprintf(label, sizeof(label), "stage=\"%s\"", watchdog.stageName(crashStage));
+      w.header("controller_reset_stage", "Loop stage running when the previous watchdog reset or panic hit", "gauge");
+      w.sample("controller_reset_stage", label, (uint32_t)1);
+    }
+  });
+
+  // 状態の保存
+  metrics.addCollector([](MetricsWriter& w, void*) {
+    const StateStoreStats& stats = stateStore.getStats();
+    w.counter("controller_state_commits_total", "Controller state snapshots written to RTC memory", stats.commits);
+    w.counter("controller_state_nvs_writes_total", "Controller state snapshots written to NVS", stats.nvsWrites);
+    w.counter("controller_state_nvs_failures_total", "Controller state NVS writes that failed", stats.nvsFailures);
+    w.gauge("controller_state_restore_seconds", "Time to restore the controller state at boot",
+            stats.restoreUs / 1e6);
+    w.gauge("controller_state_restored", "1 if the controller state was restored at boot",
+            stateStore.getRestoreSource() != StateStore::Source::NONE ? 1 : 0);
+  });
+
+  // 天気予報
+  metrics.addCollector([](MetricsWriter& w, void*) {
+    const WeatherFetchStats& stats = weatherForecast.getFetchStats();
+    w.counter("controller_weather_fetches_total", "Weather API fetch attempts", stats.fetchCount);
+    w.counter("controller_weather_fetch_failures_total", "Weather API fetch failures", stats.failureCount);
+    w.gauge("controller_weather_fetch_seconds", "Duration of the last fetch including parsing",
+            stats.lastFetchMs / 1000.0);
+    w.gauge("controller_weather_circuit_open", "1 while fetching is suspended after repeated failures",
+            weatherForecast.isCircuitOpen() ? 1 : 0);
+  });
+}
+#endif
 
 // ========================================
 // セットアップ
@@ -97,39 +641,125 @@ unsigned long lastAutoStopCheckTime = 0;
 void setup() {
   // シリアル通信開始
   Serial.begin(115200);
-  Serial.println("\n========================================");
-  Serial.println("エアコン自動制御システム起動");
-  Serial.println("========================================");
-
-  // WiFi接続
-  if (wifiMgr.connect()) {
-    Serial.println("[System] WiFi接続完了");
-    // WiFi接続成功後、時刻を同期
-    timeMgr.syncTime();
-    // 天気予報を取得
-    weatherForecast.begin();
-  } else {
-    Serial.println("[System] WiFi接続失敗 - WiFiなしで継続");
-  }
 
-  // センサー初期化
-  sensor.begin();
+  // ログ出力タスク開始（以降のログはリングバッファ経由で非同期に出力）
+  Log::begin();
 
-  // ディスプレイ初期化
-  if (!displayCtrl.begin()) {
-    Serial.println("[System] ディスプレイ初期化失敗 - 継続");
-  }
-  displayCtrl.showStartupScreen();
-  delay(TimingConfig::STARTUP_DELAY_MS);
+  LOG_I("========================================");
+  LOG_I("エアコン自動制御システム起動");
+  LOG_I("[System] ボード: %s", BoardSpec::NAME);
+  LOG_I("========================================");
 
-  // 起動画面表示後、ディスプレイをクリア
-  Serial.println("[System] スタートアップ完了、ディスプレイをクリア");
+  // ループの監視開始（前回ウォッチドッグ・パニックでリセットされていれば、直前の処理段階を表示）
+  watchdog.begin();
 
-  // エアコンコントローラー初期化
-  airConditioner.begin();
+  // 前回のAP・IP設定を使った高速再接続の設定
+  wifiMgr.setReuseLease(WiFiConfig::REUSE_DHCP_LEASE);
 
-  Serial.println("[System] システム起動完了");
-  Serial.println("========================================\n");
+  // WiFi接続状態の変化を各モジュールに通知（再接続時の時刻同期・天気予報再取得）
+  wifiMgr.addListener([](bool connected, void*) {
+    if (connected) {
+      timeMgr.startSync();
+    }
+  });
+  wifiMgr.addListener([](bool connected, void*) {
+    if (connected) {
+      weatherForecast.requestRefresh();
+    }
+  });
+#if FEATURE_TRACE
+  wifiMgr.addListener([](bool connected, void*) { trace.recordWiFi(connected); });
+
+  // 赤外線の受信をトレースに記録
+  airConditioner.onIRReceive([](const decode_results& results, void*) {
+    trace.recordIR((uint16_t)results.decode_type, results.bits, results.value);
+  });
+#endif
+
+  // スケジュール登録（7月〜9月以外の23時にエアコンを自動停止）
+  autoStop.begin();
+
+#if FEATURE_MQTT
+  // MQTT（接続はloop()のupdate()でWiFi接続後に行う）
+  mqtt.setCredentials(MqttSecrets::USER, MqttSecrets::PASSWORD);
+  mqtt.setFlushInterval(MqttConfig::FLUSH_INTERVAL_MS);
+  mqtt.setHealthInterval(MqttConfig::HEALTH_INTERVAL_MS);
+  mqtt.begin();
+#endif
+
+#if FEATURE_METRICS
+  // メトリクスの収集関数を登録
+  registerMetrics();
+#endif
+
+  // 起動ステージの登録
+  // ローカルハードウェア（赤外線・センサー・ディスプレイ）は依存関係がないため最初のpoll()で即座に完了し、
+  // ネットワーク関連はloop()の中で完了を待つ（WiFi接続を待たずに手動操作・表示が可能）
+  bootSequence.addStage("ir", []() { airConditioner.begin(); });
+  bootSequence.addStage("sensor", []() {
+    // 運転中は制御間隔より長く空けない（DIのしきい値を越えたことに気付くのが遅れるため）
+    sensor.setSampleInterval(TimingConfig::SENSOR_READ_INTERVAL_MS, TimingConfig::SENSOR_READ_MAX_INTERVAL_MS,
+                             TimingConfig::CONTROL_INTERVAL_MS);
+    sensor.begin();
+  });
+  if (BoardSpec::Display::ENABLED) {
+    bootSequence.addStage("display", []() {
+      if (!displayCtrl.begin()) {
+        LOG_W("[System] ディスプレイ初期化失敗 - 継続");
+      }
+      // 起動画面は最初のセンサー読み取り（SENSOR_READ_INTERVAL_MS後）で置き換わる
+      displayCtrl.showStartupScreen();
+    });
+  }
+  // 時刻管理開始（RTCメモリから時刻を復元し、NTP同期はバックグラウンドで行う）
+  bootSequence.addStage("time", []() { timeMgr.begin(); });
+#if FEATURE_TELEMETRY
+  // テレメトリ蓄積用のフラッシュをマウント（前回の未送信分は接続後に送信）
+  bootSequence.addStage("storage", []() { telemetry.begin(); });
+#endif
+#if FEATURE_TRACE
+  // トレース記録の開始（前回の起動の記録はもう一方のファイルに残る）
+  bootSequence.addStage("trace", []() { trace.begin(); });
+#endif
+  // 前回の起動の状態を復元（モード・自動停止・スケジュールの実行記録・天気予報・熱モデル）
+  bootSequence.addStage("state", []() { restoreState(); });
+  // 前回取得した天気予報を復元（RTCメモリから復元済みでない場合。ネットワーク接続を待たずに表示できるようにする）
+  bootSequence.addStage("cache", []() {
+    if (!weatherForecast.getData().isValid) {
+      weatherForecast.restoreCache();
+    }
+  });
+
+  // WiFi接続（ブロックしない）
+  int wifiStage = bootSequence.addStage("wifi",
+    []() { wifiMgr.begin(); },
+    []() { return wifiMgr.isConnected(); },
+    0, TimingConfig::BOOT_NETWORK_TIMEOUT_MS);
+
+  // NTP同期（WiFi接続時にリスナーから開始される。完了を待つのは所要時間の記録のため）
+  bootSequence.addStage("ntp", nullptr,
+    []() { return timeMgr.getTimeSource() == TimeManager::TimeSource::NTP; },
+    BootSequence::bit(wifiStage), TimingConfig::BOOT_NETWORK_TIMEOUT_MS);
+
+#if FEATURE_METRICS
+  // メトリクス公開（WiFi接続後に待ち受け開始）
+  bootSequence.addStage("metrics", []() { metrics.begin(); }, nullptr, BootSequence::bit(wifiStage));
+#endif
+
+#if FEATURE_WEB
+  // Web API・ダッシュボード（WiFi接続後に待ち受け開始）
+  bootSequence.addStage("web", []() { webApi.begin(); }, nullptr, BootSequence::bit(wifiStage));
+#endif
+
+  // 初回の天気予報取得（取得タスクで行い、loop()のupdate()が結果を反映した時点で完了）
+  weatherStage = bootSequence.addStage("weather", []() { weatherForecast.begin(); },
+    []() { return weatherForecast.getFetchStats().fetchCount > 0 && !weatherForecast.isFetching(); },
+    BootSequence::bit(wifiStage));
+
+  bootSequence.poll();
+
+  LOG_I("[System] ローカル初期化完了（ネットワーク接続はバックグラウンドで継続）");
+  LOG_I("========================================");
 }
 
 // ========================================
@@ -137,29 +767,110 @@ void setup() {
 // ========================================
 
 void loop() {
-  // WiFi接続状態の監視（切断時は再接続を試みる）
+  // タスクウォッチドッグのリセット（TIMEOUT_SEC の間ここに戻らなければリセットされる）
+  watchdog.feed();
+
+#if FEATURE_METRICS
+  // ループ処理時間の計測（前回のloop()開始からの経過時間）
+  unsigned long loopStartUs = micros();
+  if (lastLoopStartUs != 0) {
+    metrics.recordLoop(loopStartUs - lastLoopStartUs);
+  }
+  lastLoopStartUs = loopStartUs;
+#endif
+
+  // WiFi接続状態の監視（切断時はブロックせずにバックオフしながら再接続）
+  watchdog.enter(STAGE_WIFI);
   wifiMgr.checkConnection();
 
+  // NTP同期完了の処理（ドリフト計測・キャッシュ更新）
+  watchdog.enter(STAGE_TIME);
+  timeMgr.update();
+
   // 赤外線受信処理（常時監視）
+  watchdog.enter(STAGE_IR);
   airConditioner.handleIRReceive();
 
-  // 天気予報の定期更新（1時間ごと）
-  weatherForecast.update();
+  // 起動ステージの進行（WiFi接続・NTP同期・初回の天気予報取得）
+  watchdog.enter(STAGE_BOOT);
+  bootSequence.poll();
+
+  // 天気予報の定期更新（1時間ごと、失敗時はバックオフして再試行）
+  // 初回取得は起動ステージで行うため、それまでは更新しない
+  if (bootSequence.getState(weatherStage) != BootSequence::StageState::PENDING &&
+      wifiMgr.isConnected()) {
+    watchdog.enter(STAGE_WEATHER);
+    weatherForecast.update();
+  }
+
+#if FEATURE_METRICS
+  // メトリクスの取得要求に応答（接続がなければすぐに戻る）
+  watchdog.enter(STAGE_METRICS);
+  metrics.handle();
+#endif
+
+#if FEATURE_WEB
+  // Web APIで受け付けたコマンドの実行と、API応答用の状態の更新
+  {
+    ACMode modeBefore = airConditioner.getTargetMode();
+    bool autoStopBefore = autoStop.isEnabled();
+    watchdog.enter(STAGE_WEB);
+    webApi.update();
+    traceCommands(Trace::SOURCE_WEB, modeBefore, autoStopBefore);
+  }
+#endif
+
+#if FEATURE_MQTT
+  // MQTT（コマンド受信・状態変化とセンサー値の送信）
+  {
+    ACMode modeBefore = airConditioner.getTargetMode();
+    bool autoStopBefore = autoStop.isEnabled();
+    watchdog.enter(STAGE_MQTT);
+    mqtt.update();
+    traceCommands(Trace::SOURCE_MQTT, modeBefore, autoStopBefore);
+  }
+#endif
+
+#if FEATURE_TELEMETRY
+  // テレメトリの送信・切断中の蓄積・接続回復後のバックフィル
+  watchdog.enter(STAGE_TELEMETRY);
+  telemetry.update();
+#endif
+
+#if FEATURE_TRACE
+  // トレース記録（時刻・天気予報の変化、フラッシュへの定期的な書き込み）
+  watchdog.enter(STAGE_TRACE);
+  trace.update();
+#endif
+
+  // スケジュール実行（次回実行時刻までは時刻比較のみ）
+  watchdog.enter(STAGE_SCHEDULE);
+  scheduler.update();
+
+  // 送信待ちのコマンド（Web API・MQTT・スケジュール・前回の制御）を優先度の高いものだけ送信
+  watchdog.enter(STAGE_COMMAND);
+  airConditioner.update();
+
+  // 状態の記録（モード・自動停止・スケジュールの実行はすぐに、それ以外は一定間隔ごと）
+  watchdog.enter(STAGE_STATE);
+  persistState();
+  watchdog.exit();
 
   // 現在時刻を取得
   unsigned long currentTime = millis();
 
-  // 23時自動停止チェック（1分ごと）
-  if (currentTime - lastAutoStopCheckTime >= TimingConfig::AUTO_STOP_CHECK_INTERVAL_MS) {
-    lastAutoStopCheckTime = currentTime;
-    autoStop.check();  // 7月〜9月以外の23時にエアコンを自動停止
+  // エアコンのモードが変わったら（制御・スケジュール・Web API・MQTTのどれでも）読み取り間隔を最短に戻す
+  ACMode currentMode = airConditioner.getCurrentMode();
+  if (currentMode != lastSampledMode) {
+    lastSampledMode = currentMode;
+    sensor.notifyTransition(AirConditionerController::isRunning(currentMode));
   }
 
-  // センサー読み取りと制御処理
-  if (currentTime - lastSensorReadTime >= TimingConfig::SENSOR_READ_INTERVAL_MS) {
-    lastSensorReadTime = currentTime;
-
+  // センサー読み取り（間隔は部屋の変化の速さに合わせて2秒〜5分、運転中は最長60秒）
+  bool newReading = sensor.isDue(currentTime);
+  if (newReading) {
     // センサーデータ読み取り
+    watchdog.enter(STAGE_SENSOR);
     SensorData sensorData = sensor.read();
 
     // 不快指数（DI）を計算
@@ -170,28 +881,65 @@ void loop() {
       );
     }
 
-    // ディスプレイ更新（天気予報付き）
-    String formattedTime = timeMgr.getFormattedTime("%Y-%m-%d %H:%M");
-    WeatherData weatherData = weatherForecast.getData();
-    displayCtrl.showSensorDataWithWeather(sensorData, formattedTime, weatherData);
+#if FEATURE_TRACE
+    trace.recordSensor(sensorData, currentTime);
+#endif
+
+    // センサー値を送信待ちに追加（FLUSH_INTERVAL_MSごとにまとめて送信）
+#if FEATURE_MQTT
+    mqtt.addSample(sensorData);
+#endif
+#if FEATURE_TELEMETRY
+    telemetry.add(sensorData, currentMode);
+#endif
+    lastReading = sensorData;
+    watchdog.exit();
+  }
 
-    // センサーエラー時は制御スキップ
-    if (!sensorData.isValid) {
-      return;
+  // ディスプレイ更新（天気予報付き、新しい読み取りか表示する時刻（分）が変わった時だけ）
+  if (BoardSpec::Display::ENABLED) {
+    long minute = (long)(timeMgr.epoch() / 60);
+    if (newReading || (displayedMinute >= 0 && minute != displayedMinute)) {
+      displayedMinute = minute;
+      watchdog.enter(STAGE_DISPLAY);
+      String formattedTime = timeMgr.getFormattedTime("%Y-%m-%d %H:%M");
+      WeatherData weatherData = weatherForecast.getData();
+      displayCtrl.showSensorDataWithWeather(lastReading, formattedTime, weatherData);
+      watchdog.exit();
     }
+  }
 
-    // エアコン制御判定（制御間隔チェック）
-    if (currentTime - lastControlTime >= TimingConfig::CONTROL_INTERVAL_MS) {
-      lastControlTime = currentTime;
-
-      // 最適なモードを決定（DI値ベース）
-      ACMode optimalMode = airConditioner.determineOptimalMode(
-        sensorData.temperature,
-        sensorData.humidity
-      );
+  // 制御は新しい読み取りの時だけ判定（センサーエラー時はスキップ）
+  if (!newReading || !lastReading.isValid) {
+    return;
+  }
 
-      // モード設定（変更がある場合のみ送信）
-      // airConditioner.setMode(optimalMode);  // ← 必要に応じてコメント解除
+  // エアコン制御判定（制御間隔チェック）
+  if (currentTime - lastControlTime >= TimingConfig::CONTROL_INTERVAL_MS) {
+    lastControlTime = currentTime;
+    watchdog.enter(STAGE_CONTROL);
+
+    // 最適なモードを決定（DI値ベース）
+    ACMode optimalMode = airConditioner.determineOptimalMode(
+      lastReading.temperature,
+      lastReading.humidity
+    );
+
+#if FEATURE_PREDICT
+    // 熱モデルの学習と、予測した室温による先回り（天気予報・時刻が取得済みの場合）
+    float outdoorNow, outdoorLater;
+    if (forecastOutdoor(outdoorNow, outdoorLater)) {
+      thermalModel.update(currentTime, lastReading.temperature, currentMode, outdoorNow, outdoorLater);
+      optimalMode = thermalModel.anticipate(airConditioner, optimalMode, lastReading.temperature,
+                                            lastReading.humidity, currentMode, outdoorNow, outdoorLater);
     }
+#endif
+#if FEATURE_TRACE
+    trace.recordDecision(optimalMode);
+#endif
+
+    // モード設定（変更がある場合のみ、次の loop() で送信。Web API・MQTT・スケジュールの要求が優先）
+    // airConditioner.request(optimalMode, ACPriority::POLICY);  // ← 必要に応じてコメント解除
+    watchdog.exit();
   }
 }
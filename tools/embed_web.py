@@ -0,0 +1,81 @@
+"""
+embed_web.py
+
+web/ 以下のファイルをgzip圧縮し、include/WebAssets.h にバイト配列として埋め込みます。
+ESP32はフラッシュ上の圧縮済みデータをそのまま送信します（Content-Encoding: gzip）。
+
+PlatformIOのビルド前スクリプト（platformio.ini の extra_scripts）として自動実行されます。
+単体でも実行できます: python3 tools/embed_web.py
+"""
+
+import gzip
+import hashlib
+import os
+
+try:
+    Import("env")  # noqa: F821  PlatformIOから実行された場合
+    ROOT = env.subst("$PROJECT_DIR")  # noqa: F821
+except NameError:
+    ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# (web/ 以下のファイル名, C++の識別子)
+ASSETS = [
+    ("index.html", "INDEX_HTML"),
+]
+
+OUTPUT = os.path.join(ROOT, "include", "WebAssets.h")
+
+
+def embed(name, symbol):
+    with open(os.path.join(ROOT, "web", name), "rb") as f:
+        raw = f.read()
+    # mtime=0: 内容が同じなら出力も同じにする（不要な再ビルドを避ける）
+    data = gzip.compress(raw, compresslevel=9, mtime=0)
+    etag = hashlib.sha1(raw).hexdigest()[:16]
+
+    lines = [
+        "  // %s（%d バイト → gzip %d バイト）" % (name, len(raw), len(data)),
+        '  const char %s_ETAG[] = "\\"%s\\"";' % (symbol, etag),
+        "  const size_t %s_GZ_LEN = %d;" % (symbol, len(data)),
+        "  const uint8_t %s_GZ[] PROGMEM = {" % symbol,
+    ]
+    for i in range(0, len(data), 16):
+        chunk = ", ".join("0x%02x" % b for b in data[i:i + 16])
+        lines.append("    %s," % chunk)
+    lines.append("  };")
+    return "\n".join(lines)
+
+
+def main():
+    body = "\n\n".join(embed(name, symbol) for name, symbol in ASSETS)
+    header = (
+        "/**\n"
+        " * WebAssets.h\n"
+        " *\n"
+        " * ダッシュボードの静的ファイル（gzip圧縮済み）\n"
+        " * tools/embed_web.py が web/ 以下から自動生成します。直接編集しないでください。\n"
+        " */\n"
+        "\n"
+        "#ifndef WEB_ASSETS_H\n"
+        "#define WEB_ASSETS_H\n"
+        "\n"
+        "#include <Arduino.h>\n"
+        "\n"
+        "namespace WebAssets {\n"
+        "%s\n"
+        "}\n"
+        "\n"
+        "#endif // WEB_ASSETS_H\n" % body
+    )
+
+    current = None
+    if os.path.exists(OUTPUT):
+        with open(OUTPUT, "r", encoding="utf-8") as f:
+            current = f.read()
+    if current != header:
+        with open(OUTPUT, "w", encoding="utf-8") as f:
+            f.write(header)
+        print("embed_web: %s を更新しました" % os.path.relpath(OUTPUT, ROOT))
+
+
+main()
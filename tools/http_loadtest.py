@@ -0,0 +1,95 @@
+"""
+http_loadtest.py
+
+Web APIの負荷試験スクリプト（Python 3標準ライブラリのみ）
+複数のクライアントから同時にリクエストを送り、応答時間の分布を表示します。
+
+使い方:
+  python3 tools/http_loadtest.py 192.168.1.100
+  python3 tools/http_loadtest.py 192.168.1.100 --clients 8 --requests 50 --path /api/ac
+  python3 tools/http_loadtest.py 192.168.1.100 --path /api/ac/mode --post "mode=cool_20"
+
+各クライアントはリクエストごとに新しいTCP接続を使います（ブラウザが複数タブで開いた場合に近い条件）。
+"""
+
+import argparse
+import asyncio
+import time
+
+
+async def request(host, port, method, path, body, timeout):
+    """1件のリクエストを送り、(ステータス, 応答時間[秒]) を返す"""
+    start = time.perf_counter()
+    reader, writer = await asyncio.wait_for(asyncio.open_connection(host, port), timeout)
+    try:
+        payload = body.encode() if body else b""
+        head = "%s %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n" % (method, path, host)
+        if payload:
+            head += "Content-Type: application/x-www-form-urlencoded\r\n"
+            head += "Content-Length: %d\r\n" % len(payload)
+        writer.write(head.encode() + b"\r\n" + payload)
+        await writer.drain()
+
+        status_line = await asyncio.wait_for(reader.readline(), timeout)
+        await asyncio.wait_for(reader.read(), timeout)  # 本文を読み切る（Connection: close）
+        status = int(status_line.split()[1])
+    finally:
+        writer.close()
+    return status, time.perf_counter() - start
+
+
+async def client(args, results, errors):
+    method = "POST" if args.post is not None else "GET"
+    for _ in range(args.requests):
+        try:
+            status, elapsed = await request(args.host, args.port, method, args.path, args.post, args.timeout)
+            if 200 <= status < 400:
+                results.append(elapsed)
+            else:
+                errors.append("HTTP %d" % status)
+        except (OSError, asyncio.TimeoutError, ValueError, IndexError) as e:
+            errors.append(type(e).__name__)
+
+
+def percentile(sorted_values, p):
+    if not sorted_values:
+        return float("nan")
+    index = min(len(sorted_values) - 1, int(round(p / 100.0 * (len(sorted_values) - 1))))
+    return sorted_values[index]
+
+
+async def main():
+    parser = argparse.ArgumentParser(description="Web APIの負荷試験")
+    parser.add_argument("host", help="ESP32のIPアドレス")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--path", default="/api/sensor")
+    parser.add_argument("--post", default=None, help="POSTする本文（例: mode=cool_20）。省略時はGET")
+    parser.add_argument("--clients", type=int, default=4, help="同時接続数")
+    parser.add_argument("--requests", type=int, default=25, help="クライアントごとのリクエスト数")
+    parser.add_argument("--timeout", type=float, default=5.0)
+    args = parser.parse_args()
+
+    results = []
+    errors = []
+    start = time.perf_counter()
+    await asyncio.gather(*(client(args, results, errors) for _ in range(args.clients)))
+    total = time.perf_counter() - start
+
+    results.sort()
+    count = len(results)
+    print("%s %s: 同時接続 %d, 成功 %d, 失敗 %d, %.1f 秒"
+          % ("POST" if args.post is not None else "GET", args.path, args.clients, count, len(errors), total))
+    if count:
+        print("スループット: %.1f req/s" % (count / total))
+        print("応答時間(ms): 最小 %.1f / 中央値 %.1f / p90 %.1f / p99 %.1f / 最大 %.1f" % (
+            results[0] * 1000, percentile(results, 50) * 1000, percentile(results, 90) * 1000,
+            percentile(results, 99) * 1000, results[-1] * 1000))
+    if errors:
+        summary = {}
+        for e in errors:
+            summary[e] = summary.get(e, 0) + 1
+        print("失敗の内訳: " + ", ".join("%s × %d" % item for item in sorted(summary.items())))
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
@@ -0,0 +1,133 @@
+"""
+metrics_check.py
+
+/metrics の本文が欠けずに出力されているかの確認スクリプト（Python 3標準ライブラリのみ）
+実機の /metrics を取得し、すべての収集関数の出力が揃っているかを確認します。
+
+使い方:
+  python3 tools/metrics_check.py 192.168.1.100
+  python3 tools/metrics_check.py 192.168.1.100 --port 9100 --require controller_mqtt_connected
+
+確認する内容:
+- 標準の収集関数（main.cpp で常に登録するもの）の代表的なメトリクスがすべてある
+- 本文の最後に MetricsServer が出力する controller_metrics_render_seconds がある（途中で切れていない）
+- TYPE を出力したメトリクスにはすべて値がある（行の欠落がない）
+- controller_metrics_overflows_total が0
+機能フラグで無効にできる収集関数（MQTT・テレメトリ・Web・熱モデル・トレース）は有無だけを表示します。
+問題があれば終了コード1を返します。
+"""
+
+import argparse
+import http.client
+import sys
+
+# 常に登録される収集関数ごとの代表的なメトリクス（main.cpp の登録順）
+REQUIRED = [
+    "controller_uptime_seconds",
+    "controller_loop_duration_seconds",
+    "controller_ir_transmit_total",
+    "controller_sensor_reads_total",
+    "controller_wifi_connected",
+    "controller_log_records_total",
+    "controller_loop_stage_overruns_total",
+    "controller_state_commits_total",
+    "controller_weather_fetches_total",
+    "controller_metrics_overflows_total",
+    "controller_metrics_render_seconds",
+]
+
+# 機能フラグで無効にできる収集関数
+OPTIONAL = {
+    "FEATURE_MQTT": "controller_mqtt_connected",
+    "FEATURE_TELEMETRY": "controller_telemetry_pending_records",
+    "FEATURE_WEB": "controller_web_requests_total",
+    "FEATURE_PREDICT": "controller_thermal_samples_total",
+    "FEATURE_TRACE": "controller_trace_recording",
+}
+
+LAST = "controller_metrics_render_seconds"
+
+
+def fetch(host, port, timeout):
+    """/metrics を取得して (本文, Transfer-Encoding) を返す（chunked はhttp.clientが復元する）"""
+    conn = http.client.HTTPConnection(host, port, timeout=timeout)
+    try:
+        conn.request("GET", "/metrics")
+        response = conn.getresponse()
+        if response.status != 200:
+            raise RuntimeError("HTTP %d" % response.status)
+        body = response.read().decode("utf-8", errors="replace")
+        return body, response.getheader("Transfer-Encoding", "-")
+    finally:
+        conn.close()
+
+
+def parse(body):
+    """本文を (TYPE を出力したメトリクス名の一覧, 値のあるメトリクス名の集合, 最後の値の名前, 値の辞書) に分解"""
+    typed = []
+    sampled = set()
+    values = {}
+    last = None
+    for line in body.splitlines():
+        if not line:
+            continue
+        if line.startswith("# TYPE "):
+            typed.append(line.split()[2])
+            continue
+        if line.startswith("#"):
+            continue
+        name_part, _, value = line.rpartition(" ")
+        name = name_part.split("{", 1)[0]
+        sampled.add(name)
+        values[name] = value
+        last = name
+    return typed, sampled, last, values
+
+
+def has_samples(family, sampled):
+    """summary は _sum/_count、それ以外は同名の値があれば出力済み"""
+    return family in sampled or (family + "_sum") in sampled or (family + "_count") in sampled
+
+
+def main():
+    parser = argparse.ArgumentParser(description="/metrics の本文が完全か確認する")
+    parser.add_argument("host", help="ESP32のIPアドレスまたはホスト名")
+    parser.add_argument("--port", type=int, default=9100)
+    parser.add_argument("--timeout", type=float, default=5.0)
+    parser.add_argument("--require", action="append", default=[],
+                        help="追加で必須とするメトリクス名（複数指定可）")
+    args = parser.parse_args()
+
+    body, encoding = fetch(args.host, args.port, args.timeout)
+    typed, sampled, last, values = parse(body)
+    problems = []
+
+    for family in REQUIRED + args.require:
+        if not has_samples(family, sampled):
+            problems.append("ありません: %s" % family)
+
+    for family in typed:
+        if not has_samples(family, sampled):
+            problems.append("TYPE だけで値がありません: %s" % family)
+
+    if last != LAST:
+        problems.append("本文の最後が %s ではありません（最後の値: %s）" % (LAST, last))
+
+    overflows = values.get("controller_metrics_overflows_total", "0")
+    if float(overflows) != 0:
+        problems.append("controller_metrics_overflows_total = %s（行の欠落あり）" % overflows)
+
+    print("本文: %d バイト, %d メトリクス (Transfer-Encoding: %s)" % (len(body.encode()), len(typed), encoding))
+    for flag, family in sorted(OPTIONAL.items()):
+        print("  %-18s %s" % (flag, "あり" if has_samples(family, sampled) else "なし"))
+
+    if problems:
+        for problem in problems:
+            print("NG: " + problem)
+        return 1
+    print("OK: すべての収集関数の出力が揃っています")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
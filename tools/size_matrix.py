@@ -0,0 +1,84 @@
+"""
+size_matrix.py
+
+ボード・機能の構成（platformio.ini の ESP32向けの環境）ごとのフラッシュ・RAM使用量の一覧
+各環境を pio run でビルドし、最後に表示される使用量を集計します（Python 3標準ライブラリのみ）。
+
+使い方:
+  python3 tools/size_matrix.py                       # ESP32向けの全環境
+  python3 tools/size_matrix.py -e esp32dev -e esp32dev-minimal
+  python3 tools/size_matrix.py --csv > sizes.csv
+
+RAMは静的に確保される分（.data + .bss）で、実行中のヒープ使用量は含みません。
+差分は最初の環境（通常は標準の構成 esp32dev）との比較です。
+"""
+
+import argparse
+import configparser
+import os
+import re
+import subprocess
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# pio run の出力例: "RAM:   [=         ]  14.2% (used 46420 bytes from 327680 bytes)"
+USAGE = re.compile(r"^(RAM|Flash):\s+\[.*\]\s+[\d.]+%\s+\(used (\d+) bytes from (\d+) bytes\)", re.M)
+
+
+def esp32_envs():
+    """platformio.ini から ESP32向け（[esp32] を extends する）環境の一覧を取得"""
+    config = configparser.ConfigParser(interpolation=None, inline_comment_prefixes=(";",))
+    config.read(os.path.join(ROOT, "platformio.ini"), encoding="utf-8")
+    envs = []
+    for section in config.sections():
+        if section.startswith("env:") and config[section].get("extends", "").strip() == "esp32":
+            envs.append(section[len("env:"):])
+    return envs
+
+
+def build(env):
+    """1つの環境をビルドし、{"RAM": (使用量, 容量), "Flash": (使用量, 容量)} を返す"""
+    result = subprocess.run(["pio", "run", "-e", env], cwd=ROOT,
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+    if result.returncode != 0:
+        sys.stderr.write(result.stdout[-2000:])
+        raise RuntimeError("ビルド失敗: %s" % env)
+    usage = {}
+    for kind, used, total in USAGE.findall(result.stdout):
+        usage[kind] = (int(used), int(total))
+    if "RAM" not in usage or "Flash" not in usage:
+        raise RuntimeError("使用量が見つかりません: %s" % env)
+    return usage
+
+
+def main():
+    parser = argparse.ArgumentParser(description="構成ごとのフラッシュ・RAM使用量の一覧")
+    parser.add_argument("-e", "--env", action="append", help="対象の環境（複数指定可、省略時はESP32向けの全環境）")
+    parser.add_argument("--csv", action="store_true", help="CSVで出力")
+    args = parser.parse_args()
+
+    envs = args.env or esp32_envs()
+    rows = []
+    for env in envs:
+        sys.stderr.write("ビルド中: %s\n" % env)
+        usage = build(env)
+        rows.append((env, usage["Flash"], usage["RAM"]))
+
+    if args.csv:
+        print("env,flash_bytes,flash_total,ram_bytes,ram_total")
+        for env, flash, ram in rows:
+            print("%s,%d,%d,%d,%d" % (env, flash[0], flash[1], ram[0], ram[1]))
+        return
+
+    base_flash = rows[0][1][0]
+    base_ram = rows[0][2][0]
+    print("%-22s %12s %8s %10s %10s %8s %10s" % ("環境", "フラッシュ", "(%)", "差分", "RAM", "(%)", "差分"))
+    for env, flash, ram in rows:
+        print("%-22s %12d %7.1f%% %+10d %10d %7.1f%% %+10d" % (
+            env, flash[0], 100.0 * flash[0] / flash[1], flash[0] - base_flash,
+            ram[0], 100.0 * ram[0] / ram[1], ram[0] - base_ram))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,174 @@
+"""
+ws_loadtest.py
+
+WebSocket（/ws）の同時接続試験スクリプト（Python 3標準ライブラリのみ）
+多数のクライアントを同時に接続し、差分の配信（ファンアウト）を計測します。
+
+使い方:
+  python3 tools/ws_loadtest.py 192.168.1.100
+  python3 tools/ws_loadtest.py 192.168.1.100 --clients 8 --duration 60
+  python3 tools/ws_loadtest.py 192.168.1.100 --clients 4 --slow 1
+
+--slow N を指定すると、N台のクライアントは受信を止めたままにします（受信が追いつかないクライアントの再現）。
+ESP32側で切断されれば「切断された」に数えられ、他のクライアントへの配信は続くはずです。
+
+表示する値:
+- クライアントごとの受信数・受信バイト数
+- 全体の受信メッセージ数/秒
+- 同じseqの差分が全クライアントに届くまでの時間差（最初に受信したクライアントとの差）
+"""
+
+import argparse
+import asyncio
+import base64
+import json
+import os
+import time
+
+
+class Closed(Exception):
+    pass
+
+
+async def handshake(reader, writer, host, path, timeout):
+    key = base64.b64encode(os.urandom(16)).decode()
+    head = ("GET %s HTTP/1.1\r\nHost: %s\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+            "Sec-WebSocket-Key: %s\r\nSec-WebSocket-Version: 13\r\n\r\n") % (path, host, key)
+    writer.write(head.encode())
+    await writer.drain()
+    status_line = await asyncio.wait_for(reader.readline(), timeout)
+    parts = status_line.split()
+    if len(parts) < 2 or parts[1] != b"101":
+        raise Closed("handshake: " + status_line.decode(errors="replace").strip())
+    while True:
+        line = await asyncio.wait_for(reader.readline(), timeout)
+        if line in (b"\r\n", b""):
+            break
+
+
+async def read_frame(reader):
+    """1フレームを読み、(opcode, payload) を返す（サーバーからのフレームはマスクなし）"""
+    try:
+        head = await reader.readexactly(2)
+        opcode = head[0] & 0x0F
+        length = head[1] & 0x7F
+        if length == 126:
+            length = int.from_bytes(await reader.readexactly(2), "big")
+        elif length == 127:
+            length = int.from_bytes(await reader.readexactly(8), "big")
+        if head[1] & 0x80:
+            await reader.readexactly(4)
+        payload = await reader.readexactly(length) if length else b""
+    except asyncio.IncompleteReadError:
+        raise Closed("eof")
+    return opcode, payload
+
+
+def send_frame(writer, opcode, payload):
+    """クライアントからのフレームはマスクが必須"""
+    mask = os.urandom(4)
+    head = bytes([0x80 | opcode])
+    if len(payload) < 126:
+        head += bytes([0x80 | len(payload)])
+    else:
+        head += bytes([0x80 | 126]) + len(payload).to_bytes(2, "big")
+    masked = bytes(b ^ mask[i % 4] for i, b in enumerate(payload))
+    writer.write(head + mask + masked)
+
+
+async def client(index, args, arrivals, stats, slow):
+    result = {"messages": 0, "bytes": 0, "full": 0, "closed": None}
+    stats[index] = result
+    try:
+        reader, writer = await asyncio.wait_for(asyncio.open_connection(args.host, args.port), args.timeout)
+    except (OSError, asyncio.TimeoutError) as e:
+        result["closed"] = "connect: " + type(e).__name__
+        return
+    try:
+        await handshake(reader, writer, args.host, args.path, args.timeout)
+        if slow:
+            # 受信せずに待つ（TCPの受信バッファが埋まるとESP32側のキューに溜まる）
+            while True:
+                await asyncio.sleep(1.0)
+                if reader.at_eof():
+                    raise Closed("closed by server")
+        while True:
+            opcode, payload = await read_frame(reader)
+            now = time.perf_counter()
+            if opcode == 0x8:
+                code = int.from_bytes(payload[:2], "big") if len(payload) >= 2 else None
+                raise Closed("close %s" % code)
+            if opcode == 0x9:
+                send_frame(writer, 0xA, payload)
+                continue
+            if opcode != 0x1:
+                continue
+            result["messages"] += 1
+            result["bytes"] += len(payload)
+            try:
+                message = json.loads(payload)
+            except ValueError:
+                continue
+            if message.get("full"):
+                result["full"] += 1
+            else:
+                arrivals.setdefault(message.get("seq"), []).append(now)
+    except asyncio.CancelledError:
+        pass
+    except (Closed, OSError, asyncio.TimeoutError) as e:
+        result["closed"] = str(e) or type(e).__name__
+    finally:
+        writer.close()
+
+
+def percentile(sorted_values, p):
+    if not sorted_values:
+        return float("nan")
+    index = min(len(sorted_values) - 1, int(round(p / 100.0 * (len(sorted_values) - 1))))
+    return sorted_values[index]
+
+
+async def main():
+    parser = argparse.ArgumentParser(description="WebSocketの同時接続試験")
+    parser.add_argument("host", help="ESP32のIPアドレス")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--path", default="/ws")
+    parser.add_argument("--clients", type=int, default=8, help="同時接続数")
+    parser.add_argument("--slow", type=int, default=0, help="受信しないクライアントの数（--clientsの内数）")
+    parser.add_argument("--duration", type=float, default=30.0, help="計測時間（秒）")
+    parser.add_argument("--timeout", type=float, default=5.0)
+    args = parser.parse_args()
+
+    arrivals = {}
+    stats = {}
+    tasks = [asyncio.ensure_future(client(i, args, arrivals, stats, i < args.slow))
+             for i in range(args.clients)]
+    start = time.perf_counter()
+    await asyncio.sleep(args.duration)
+    for task in tasks:
+        task.cancel()
+    await asyncio.gather(*tasks, return_exceptions=True)
+    total = time.perf_counter() - start
+
+    print("%s:%d%s: 同時接続 %d（うち受信しない %d）, %.1f 秒"
+          % (args.host, args.port, args.path, args.clients, args.slow, total))
+    messages = 0
+    for i in range(args.clients):
+        s = stats.get(i, {})
+        messages += s.get("messages", 0)
+        state = "切断された（%s）" % s["closed"] if s.get("closed") else "接続中"
+        print("  #%-2d %s 受信 %d 件 / %d バイト（全項目 %d 件） %s" % (
+            i, "slow" if i < args.slow else "    ", s.get("messages", 0), s.get("bytes", 0),
+            s.get("full", 0), state))
+    print("受信: %.1f msg/s（全クライアント合計）" % (messages / total))
+
+    spreads = sorted((max(times) - min(times)) * 1000 for times in arrivals.values() if len(times) > 1)
+    if spreads:
+        print("配信の時間差(ms): 中央値 %.1f / p90 %.1f / 最大 %.1f（差分 %d 件）" % (
+            percentile(spreads, 50), percentile(spreads, 90), spreads[-1], len(arrivals)))
+    else:
+        print("差分を受信していません（値が変化するまで待つか、--durationを延ばしてください）")
+
+
+if __name__ == "__main__":
+    asyncio.run(main())